@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdio>
+
+/**
+ * @brief Проверки стендов: строка «ok» / «FAIL» на каждую и итог прогона
+ *
+ * Один стенд — одна программа, поэтому счётчик общий на весь процесс.
+ */
+namespace checks {
+    inline int failures = 0;
+
+    inline void check(bool ok, const char *what) {
+        std::printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+        if (!ok) ++failures;
+    }
+
+    /** Итог «OK/FAIL: N failed»; возвращает код возврата main() (0 — все проверки прошли) */
+    inline int finish() {
+        std::printf("%s: %d failed\n", failures ? "FAIL" : "OK", failures);
+        return failures ? 1 : 0;
+    }
+}
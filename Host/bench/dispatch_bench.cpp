@@ -0,0 +1,82 @@
+/**
+ * @file dispatch_bench.cpp
+ * @brief Стоимость Controller::processEvent() по типам событий
+ *
+ * Использование: stm32f0_basic_dispatch_bench[_linear] [повторов]
+ *
+ * Прошивка инициализируется как обычно, затем каждое событие из набора
+ * передаётся контроллеру [повторов] раз подряд; печатается среднее в единицах
+ * host_cycle_stamp(). Вариант _linear собран с CONTROLLER_LINEAR_DISPATCH
+ * (перебор всей таблицы переходов), основной — с Fsm::Table по [состояние][EventType].
+ *
+ * В число тактов входят действия (PWM, индикатор, TimerWheel), поэтому
+ * разница вариантов заметнее на событиях без перехода или с коротким действием.
+ * Строки "BENCH dispatch_<событие> <такты>" — для сравнения между вариантами.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "AppContext.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+
+App app{};
+
+namespace {
+    struct Case {
+        const char *name;
+        Event event;
+    };
+
+    const Case cases[] = {
+            {"none",        {EventType::None, 0}},             // Нет строк в таблице
+            {"beep_done",   {EventType::BeepDone, 0}},         // Нет строк в таблице
+            {"s3_release",  {EventType::ButtonS3, 2}},         // actionBeep без звука
+            {"s4_held",     {EventType::ButtonS4, 1}},         // actionBeep без звука
+            {"tick100ms",   {EventType::Tick100ms, 0}},        // PID-тик, только в Idle/Heating
+            {"display_to",  {EventType::DisplayTimeout, 0}},   // guard отсекает
+            {"temperature", {EventType::TemperatureReady, 350}},
+    };
+}
+
+int main(int argc, char **argv) {
+    const long repeats = argc > 1 ? std::atol(argv[1]) : 100'000;
+
+    host::reset();
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+#if defined CONTROLLER_LINEAR_DISPATCH
+    const char *variant = "linear scan";
+#else
+    const char *variant = "Fsm::Table";
+#endif
+    std::printf("dispatch bench (%s): %ld repeats per event, unit %s\n", variant, repeats, host::cycle_stamp_unit());
+
+    uint64_t total = 0;
+    for (const auto &c: cases) {
+        // Исходное состояние — Heating, как при обычной работе ниже уставки
+        app.ctrl->processEvent({EventType::TemperatureReady, 350});
+
+        const uint32_t start = host_cycle_stamp();
+        for (long i = 0; i < repeats; ++i) {
+            app.ctrl->processEvent(c.event);
+        }
+        const uint32_t cycles = host_cycle_stamp() - start;
+
+        const double avg = static_cast<double>(cycles) / repeats;
+        total += cycles;
+        std::printf("  %-12s %8.1f\n", c.name, avg);
+        std::printf("BENCH dispatch_%s %.1f\n", c.name, avg);
+    }
+
+    std::printf("BENCH dispatch_total %.1f\n", static_cast<double>(total) / repeats);
+    return 0;
+}
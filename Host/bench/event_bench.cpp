@@ -0,0 +1,87 @@
+/**
+ * @file event_bench.cpp
+ * @brief Задержка событий EventQueue при пачках ввода по UART (сборка с EVENT_QUEUE_LATENCY)
+ *
+ * Использование: stm32f0_basic_event_bench[_single] [секунды] [пачка] [квант мкс]
+ *   секунды — модельное время прогона (по умолчанию 10)
+ *   пачка   — сколько клавиш '1'..'4' приходит подряд каждые 250 мс (по умолчанию 12)
+ *   квант   — модельное время одной итерации app_loop (по умолчанию 500, «медленный» цикл,
+ *             за который по UART успевает прийти несколько байт)
+ *
+ * Вариант _single собран с APP_LOOP_SINGLE_DISPATCH (одно событие за проход).
+ * Задержка — от push() до pop() в модельных микросекундах; строки
+ * "BENCH <метрика> <значение>" удобно сравнивать между вариантами и коммитами.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+
+App app{};
+
+namespace {
+    double cycles_to_us(uint64_t cycles) {
+        return static_cast<double>(cycles) * 1e6 / host::CoreClockHz;
+    }
+}
+
+int main(int argc, char **argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const int burst = argc > 2 ? std::atoi(argv[2]) : 12;
+    const uint64_t quantum_us = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 500;
+
+    host::reset();
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+    app.queue->resetStats();
+
+    std::string keys;
+    for (int i = 0; i < burst; ++i) keys.push_back(static_cast<char>('1' + i % 4));
+
+    const auto end_us = static_cast<uint64_t>(seconds * 1e6);
+    uint64_t next_burst_us = 1'000'000;
+    uint64_t iterations = 0;
+
+    while (host::now_us() < end_us) {
+        if (host::now_us() >= next_burst_us) {
+            host::uart_rx(keys.c_str());
+            next_burst_us += 250'000;
+        }
+
+        app_loop(app);
+        ++iterations;
+        host::advance_us(quantum_us);
+    }
+
+    const auto stats = app.queue->stats();
+    const auto &latency = app.queue->latency();
+
+    std::printf("event bench: %.1f s simulated, %llu iterations, burst %d keys / 250 ms, quantum %llu us, "
+                "up to %u events per pass\n",
+                seconds, static_cast<unsigned long long>(iterations), burst,
+                static_cast<unsigned long long>(quantum_us), APP_LOOP_DISPATCH_MAX_EVENTS);
+    std::printf("pushed %u, dropped %u, high watermark %u/%u, UART RX overruns %u\n",
+                stats.pushed, stats.dropped, stats.highWatermark,
+                static_cast<unsigned>(EventQueue::MaxEvents), host::uart_rx_overruns());
+    std::printf("latency us: min %.1f avg %.1f max %.1f (%u events)\n",
+                cycles_to_us(latency.min), cycles_to_us(latency.avg()), cycles_to_us(latency.max), latency.count);
+
+    std::printf("BENCH dropped %u\n", stats.dropped);
+    std::printf("BENCH high_watermark %u\n", stats.highWatermark);
+    std::printf("BENCH latency_avg_us %.1f\n", cycles_to_us(latency.avg()));
+    std::printf("BENCH latency_max_us %.1f\n", cycles_to_us(latency.max));
+
+    return host::iwdg_expired() ? 1 : 0;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file flash_kv_bench.cpp
+ * @brief KvStore на модели flash: журнал, перенос страниц, обрывы питания, работа рядом с 1-Wire
+ *
+ * Использование: stm32f0_basic_flash_kv_bench [обрывов питания]
+ *
+ * 1. Хранилище отдельно: запись, чтение после «сброса», удаление, перенос при заполнении
+ *    страницы, poll(false) ничего не пишет.
+ * 2. Обрывы: случайные записи и удаления, питание пропадает на случайной операции flash
+ *    (полуслово пишется частично, страница стирается частично). После каждого обрыва —
+ *    загрузка заново: каждый ключ равен последнему сохранённому значению, а ключ
+ *    оборванной записи — прежнему или новому. Второй проход обрывает питание именно на
+ *    стирании второй страницы при переносе (случайный обрыв почти никогда на него не попадает):
+ *    метка прежнего поколения на ней не должна пережить частичное стирание.
+ * 3. Прошивка целиком без EEPROM: Settings пишет уставку в KvStore, операции flash идут
+ *    только вне слотов 1-Wire, после «перезагрузки» уставка восстанавливается.
+ *
+ * Печатается:
+ * - flash_kv_put_ms — от put() до сохранения записи в прошивке (ожидание паузы 1-Wire);
+ * - flash_kv_max_stall_us — самая долгая остановка ядра (запись полуслова или стирание);
+ * - flash_kv_fuzz_cuts / flash_kv_fuzz_failures — обрывов и нарушений после них;
+ * - flash_kv_erase_cuts / flash_kv_erase_failures — то же для обрывов на стирании.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+#include "KvStore.hpp"
+
+App app{};
+
+namespace {
+    using Value = std::vector<uint8_t>;
+
+    using checks::check;
+
+    /// Довести запись до конца (или до обрыва питания)
+    void drain(KvStore &kv) {
+        while (!kv.idle() && !host::flash_cut()) kv.poll(true);
+    }
+
+    bool put(KvStore &kv, uint8_t key, const Value &v) {
+        if (!kv.put(key, v.data(), static_cast<uint8_t>(v.size()))) return false;
+        drain(kv);
+        return true;
+    }
+
+    bool holds(const KvStore &kv, uint8_t key, const Value *v) {
+        uint8_t buf[FLASH_KV_VALUE_MAX];
+        const int len = kv.get(key, buf, sizeof(buf));
+        if (!v) return len < 0;
+        return len == static_cast<int>(v->size()) && std::memcmp(buf, v->data(), v->size()) == 0;
+    }
+
+    void check_store() {
+        host::reset();
+        host::flash_erase_all();
+
+        KvStore kv;
+        kv.begin();
+        check(kv.stats().generation == 0 && kv.get(1, nullptr, 0) < 0, "blank flash: empty store");
+
+        const Value a{1, 2, 3}, b{0xAA, 0xBB, 0xCC, 0xDD, 0xEE}, c(FLASH_KV_VALUE_MAX, 0x5C);
+        const bool stored = put(kv, 1, a) && put(kv, 2, b) && put(kv, 3, c);
+        check(stored && holds(kv, 1, &a) && holds(kv, 2, &b) && holds(kv, 3, &c) && kv.stats().generation == 1,
+              "first put creates page generation 1");
+
+        KvStore again;
+        again.begin();
+        check(holds(again, 1, &a) && holds(again, 2, &b) && holds(again, 3, &c), "values survive a reset");
+
+        check(kv.put(1, b.data(), 5) && !kv.put(2, a.data(), 3), "second put is refused while one is in flight");
+        const uint32_t programs = host::flash_stats().programs;
+        for (int i = 0; i < 100; ++i) kv.poll(false);
+        check(host::flash_stats().programs == programs, "poll(false) touches no flash");
+        drain(kv);
+
+        check(kv.remove(2) && (drain(kv), holds(kv, 2, nullptr)), "remove");
+        KvStore removed;
+        removed.begin();
+        check(holds(removed, 2, nullptr) && holds(removed, 1, &b), "removal survives a reset");
+
+        // Перезапись одного ключа до переноса страниц
+        Value v(8, 0);
+        const uint32_t gen = kv.stats().generation, moves = kv.stats().compactions;
+        int n = 0;
+        while (kv.stats().generation == gen && n < 1000) {
+            v[0] = static_cast<uint8_t>(++n);
+            put(kv, 4, v);
+        }
+        KvStore moved;
+        moved.begin();
+        check(kv.stats().compactions == moves + 1 && holds(moved, 4, &v) && holds(moved, 1, &b) && holds(moved, 3, &c) &&
+              holds(moved, 2, nullptr), "page full: live records move to the other page");
+        std::printf("  %d puts of 8 bytes fill a %u-byte page; after the move %u bytes are used\n", n,
+                    FLASH_KV_PAGE_SIZE, kv.stats().used);
+        check(host::flash_stats().errors == 0, "no programming over written cells");
+    }
+
+    /// Обрывы питания на случайной операции (at_erase — на стирании); модель — последние сохранённые значения
+    void fuzz(long cuts, bool at_erase, uint32_t &done, uint32_t &violations, uint32_t &errors) {
+        std::mt19937 rng(at_erase ? 4321 : 1234);
+        std::map<uint8_t, Value> expected;
+        host::flash_erase_all();
+
+        for (long it = 0; it < cuts; ++it) {
+            host::reset();   // Питание вернулось: регистры сброшены, flash — как была
+            KvStore kv;
+            kv.begin();
+            for (const auto &[key, value]: expected) {
+                if (!holds(kv, key, &value)) ++violations;
+            }
+            for (uint8_t key = 1; key <= FLASH_KV_MAX_KEYS + 1; ++key) {
+                if (!expected.count(key) && !holds(kv, key, nullptr)) ++violations;
+            }
+
+            // Обрыв на стирании — когда вторая страница несёт метку прошлого поколения: после
+            // полного переноса в этом проходе (не при создании хранилища)
+            bool armed = !at_erase;
+            if (!at_erase) host::flash_cut_after(rng() % 400, rng());
+            for (;;) {
+                if (!armed && kv.stats().compactions > 0 && kv.stats().generation >= 2) {
+                    host::flash_cut_at_erase(rng());
+                    armed = true;
+                }
+                const auto key = static_cast<uint8_t>(1 + rng() % FLASH_KV_MAX_KEYS);
+                const bool erase = rng() % 8 == 0;
+                Value v(erase ? 0 : 1 + rng() % FLASH_KV_VALUE_MAX);
+                for (auto &byte: v) byte = static_cast<uint8_t>(rng());
+
+                if (!kv.put(key, v.data(), static_cast<uint8_t>(v.size()))) continue;
+                drain(kv);
+                if (!host::flash_cut()) {
+                    if (erase) expected.erase(key);
+                    else expected[key] = v;
+                    continue;
+                }
+
+                // Оборванная запись: после загрузки — прежнее значение или новое
+                errors += host::flash_stats().errors;
+                host::reset();
+                KvStore after;
+                after.begin();
+                const auto old = expected.find(key);
+                const bool was_old = holds(after, key, old == expected.end() ? nullptr : &old->second);
+                const bool is_new = holds(after, key, erase ? nullptr : &v);
+                if (!was_old && !is_new) ++violations;
+                if (is_new && !was_old) {
+                    if (erase) expected.erase(key);
+                    else expected[key] = v;
+                }
+                break;
+            }
+            ++done;
+        }
+    }
+
+    void run_for_ms(uint32_t ms, uint32_t quantum_us = 100) {
+        const uint64_t end_us = host::now_us() + ms * 1000ULL;
+        while (host::now_us() < end_us) {
+            app_loop(app);
+            host::advance_us(quantum_us);
+        }
+    }
+
+    /// Прошивка без EEPROM: уставка в KvStore
+    void check_firmware(double &put_ms, double &stall_us) {
+        host::reset();
+        host::flash_erase_all();
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+        services_init(app);
+
+        run_for_ms(200);
+        check(app.settings->state() == Settings::State::Flash, "no EEPROM: settings go to the flash store");
+
+        // Серия изменений уставки: каждая запись ждёт паузы 1-Wire, ни одна операция не попадает в слоты
+        uint64_t wait_us = 0;
+        uint32_t saves = 0;
+        for (int i = 0; i < 80; ++i) {
+            app.ctrl->setSetpoint(200 + (i % 7) * 5);
+            run_for_ms(SETTINGS_SAVE_DELAY_MS, 1000);
+            for (int ms = 0; app.kv->idle() && ms < 1000; ++ms) run_for_ms(1, 100);
+            const uint64_t t0 = host::now_us();
+            while (!app.kv->idle()) run_for_ms(1, 100);
+            wait_us += host::now_us() - t0;
+            ++saves;
+        }
+        const auto &fs = host::flash_stats();
+        put_ms = wait_us / 1000.0 / saves;
+        stall_us = static_cast<double>(fs.max_stall_cycles) / (host::CoreClockHz / 1'000'000);
+        check(app.kv->stats().compactions >= 1 && app.kv->stats().failures == 0, "setpoint saves wrap the page");
+        check(fs.onewire_conflicts == 0, "no flash operation during 1-Wire slots");
+        check(app.sensor->getSampleCount() > 0 && !host::iwdg_expired(), "sensor keeps sampling, no watchdog reset");
+
+        const int saved = app.ctrl->getSetpoint();
+        app.ctrl->setSetpoint(CONTROLLER_SETPOINT_DEFAULT);
+        KvStore kv;
+        kv.begin();
+        Settings settings(*app.ctrl, &kv);
+        app.settings = &settings;
+        app.kv = &kv;
+        settings.begin();
+        run_for_ms(200);
+        check(settings.stats().restored && app.ctrl->getSetpoint() == saved, "reboot restores the setpoint from flash");
+    }
+}
+
+int main(int argc, char **argv) {
+    const long cuts = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    std::printf("KvStore bench: 2 x %u-byte pages, %u keys up to %u bytes, %ld power cuts\n", FLASH_KV_PAGE_SIZE,
+                FLASH_KV_MAX_KEYS, FLASH_KV_VALUE_MAX, cuts);
+
+    check_store();
+
+    uint32_t done = 0, violations = 0, errors = 0;
+    fuzz(cuts, false, done, violations, errors);
+    char what[80];
+    std::snprintf(what, sizeof(what), "%u power cuts: every key old or new, never lost", done);
+    check(violations == 0 && errors == 0, what);
+
+    uint32_t erase_done = 0, erase_violations = 0, erase_errors = 0;
+    fuzz(cuts / 10 > 200 ? cuts / 10 : 200, true, erase_done, erase_violations, erase_errors);
+    std::snprintf(what, sizeof(what), "%u cuts during the compaction erase: no key lost", erase_done);
+    check(erase_violations == 0 && erase_errors == 0, what);
+
+    double put_ms = 0, stall_us = 0;
+    check_firmware(put_ms, stall_us);
+
+    std::printf("BENCH flash_kv_put_ms %.1f\n", put_ms);
+    std::printf("BENCH flash_kv_max_stall_us %.0f\n", stall_us);
+    std::printf("BENCH flash_kv_fuzz_cuts %u\n", done);
+    std::printf("BENCH flash_kv_fuzz_failures %u\n", violations + errors);
+    std::printf("BENCH flash_kv_erase_cuts %u\n", erase_done);
+    std::printf("BENCH flash_kv_erase_failures %u\n", erase_violations + erase_errors);
+
+    return checks::finish();
+}
@@ -0,0 +1,221 @@
+/**
+ * @file fsm_check.cpp
+ * @brief Проверка шаблона Fsm и обоих автоматов прошивки (Controller, DS18B20) на модели
+ *
+ * Использование: stm32f0_basic_fsm_check
+ *
+ * 1. Проверки таблиц (constexpr): каждая из ошибок, которые Fsm::Table отвергает
+ *    при компиляции, находится на игрушечной таблице, а правильная таблица их не имеет.
+ * 2. Разбор игрушечной таблицы: порядок строк, guard, wildcard и цепочка fallthrough.
+ * 3. Прошивка на модели: DS18B20 выдаёт измерения и греет по PID, при отключении
+ *    датчика Controller выключает нагреватель (SensorError) и возвращается к работе
+ *    после подключения, кнопки '1'/'2' по UART меняют уставку и режим. На стекле модели
+ *    HT1621B: в State::Error мигает надпись `Err`, при правке уставки — её значение.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+#include "Fsm.hpp"
+
+App app{};
+
+namespace {
+    using checks::check;
+
+    //=========================================================================
+    // Игрушечный автомат без события
+    //=========================================================================
+
+    enum class ToyState : uint8_t { A, B, C, Any };
+    enum class ToySignal : uint8_t { Go, Stop, Any };
+
+    struct Toy {
+        bool open = false;
+        std::string log;
+
+        bool isOpen() const { return open; }
+        void toB() { log += 'b'; }
+        void stay() { log += 'a'; }
+        void toC() { log += 'c'; }
+        void reset() { log += 'r'; }
+    };
+
+    using ToyFsm = Fsm<Toy, ToyState, ToySignal>;
+    using S = ToyState;
+    using G = ToySignal;
+
+    constexpr ToyFsm::Row good[] = {
+            {G::Go,  S::A,   &Toy::isOpen, &Toy::toB,   S::B, true},
+            {G::Go,  S::A,   nullptr,      &Toy::stay,  S::A},
+            {G::Go,  S::B,   nullptr,      &Toy::toC,   S::C},
+            {G::Any, S::Any, nullptr,      &Toy::reset, S::A},
+    };
+
+    /// Wildcard без guard выше конкретной строки: строка 1 никогда не сработает
+    constexpr ToyFsm::Row shadowed[] = {
+            {G::Any, S::Any, nullptr, &Toy::reset, S::A},
+            {G::Go,  S::A,   nullptr, &Toy::toB,   S::B},
+            {G::Go,  S::B,   nullptr, &Toy::toC,   S::C},
+    };
+
+    /// Из A не попасть в C: строка 2 недостижима
+    constexpr ToyFsm::Row unreachable[] = {
+            {G::Go,   S::A, nullptr, &Toy::toB,   S::B},
+            {G::Stop, S::B, nullptr, &Toy::reset, S::A},
+            {G::Go,   S::C, nullptr, &Toy::reset, S::A},
+    };
+
+    /// Для C нет строк
+    constexpr ToyFsm::Row missing[] = {
+            {G::Go,   S::A, nullptr, &Toy::toB,   S::B},
+            {G::Stop, S::B, nullptr, &Toy::reset, S::A},
+    };
+
+    /// Цель — wildcard
+    constexpr ToyFsm::Row anyTarget[] = {
+            {G::Go,  S::A,   nullptr, &Toy::toB,   S::Any},
+            {G::Any, S::Any, nullptr, &Toy::reset, S::A},
+    };
+
+    static_assert(ToyFsm::shadowedRow(good) < 0 && ToyFsm::unreachableRow(good, S::A) < 0 &&
+                  ToyFsm::missingState(good) < 0 && ToyFsm::invalidTarget(good) < 0);
+    static_assert(ToyFsm::shadowedRow(shadowed) == 1);
+    static_assert(ToyFsm::unreachableRow(unreachable, S::A) == 2);
+    static_assert(ToyFsm::missingState(missing) == static_cast<int>(S::C));
+    static_assert(ToyFsm::invalidTarget(anyTarget) == 0);
+
+    using ToyTable = ToyFsm::Table<good, S::A>;
+
+    void check_toy() {
+        Toy t;
+        S next = S::Any;
+
+        t.open = true;
+        check(ToyTable::dispatch(t, S::A, G::Go, next) && next == S::C && t.log == "bc",
+              "fallthrough A -> B -> C in one dispatch");
+
+        t.open = false;
+        t.log.clear();
+        check(ToyTable::dispatch(t, S::A, G::Go, next) && next == S::A && t.log == "a",
+              "guard rejects the first row, the next row for A/Go fires");
+
+        t.log.clear();
+        check(ToyTable::dispatch(t, S::C, G::Stop, next) && next == S::A && t.log == "r",
+              "wildcard row catches C/Stop");
+
+        t.log.clear();
+        next = S::B;
+        check(!ToyTable::dispatch(t, S::Any, G::Go, next) && next == S::B && t.log.empty(),
+              "out-of-range state is not dispatched");
+    }
+
+    //=========================================================================
+    // Прошивка на модели
+    //=========================================================================
+
+    void run_for_ms(uint32_t ms) {
+        const uint64_t end_us = host::now_us() + ms * 1000ULL;
+        while (host::now_us() < end_us) {
+            app_loop(app);
+            host::advance_us(100);
+        }
+    }
+
+    bool heater_on() {
+        return TIM3->CCR1 != 0;
+    }
+
+    struct Blink {
+        bool lit = false;    ///< Разряды видели зажжёнными
+        bool dark = false;   ///< ... и погашенными
+    };
+
+    /// Прогон ms с наблюдением за разрядами positions (бит на позицию) на стекле модели
+    Blink watch(uint8_t positions, uint32_t ms) {
+        Blink b;
+        const uint64_t end_us = host::now_us() + ms * 1000ULL;
+        while (host::now_us() < end_us) {
+            app_loop(app);
+            host::advance_us(100);
+
+            bool lit = false;
+            for (uint8_t p = 0; p < 6; ++p) {
+                if (!(positions & (1U << p))) continue;
+                const uint8_t base = (5 - p) * 4;
+                for (uint8_t a = base + 1; a <= base + 4; ++a) {
+                    // У 0x17 сегмент разряда только в бите 0
+                    if (host::lcd_ram()[a] & (a == 0x17 ? 0x01 : 0x0F)) lit = true;
+                }
+            }
+            (lit ? b.lit : b.dark) = true;
+        }
+        return b;
+    }
+
+    void check_firmware() {
+        host::reset();
+        host::ds18b20_set_temperature(CONTROLLER_SETPOINT_DEFAULT - 50);
+
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+        services_init(app);
+
+        run_for_ms(3000);
+        const uint32_t samples = app.sensor->getSampleCount();
+        check(samples >= 2 && host::ds18b20_conversions() >= 2, "DS18B20 machine completes conversions");
+        check(heater_on(), "below setpoint: Controller heats");
+
+        host::ds18b20_attach(false);
+        run_for_ms(1000);
+        const Blink error_label = watch(0b111000, 1000);
+        const Blink error_value = watch(0b000111, 1000);
+        check(!heater_on(), "sensor detached: SensorError cuts the heater off");
+        check(error_label.lit && error_label.dark && !error_value.dark, "State::Error: only the `Err` label blinks");
+
+        host::ds18b20_attach(true);
+        run_for_ms(2000);
+        const Blink label = watch(0b111000, 1000);
+        check(app.sensor->getSampleCount() > samples && heater_on(), "sensor re-attached: heating resumes");
+        check(!label.dark && !app.animator->active(), "back from State::Error: `t1` steady, no frame timer");
+
+        // Чуть выше уставки: S1 опускает уставку (PID сбрасывается) — нагрев не нужен,
+        // два шага S2 вверх поднимают уставку выше температуры — нагрев снова включается
+        host::ds18b20_set_temperature(CONTROLLER_SETPOINT_DEFAULT + 2);
+        host::uart_rx("1");
+        const Blink edit_value = watch(0b000111, 1000);
+        const Blink edit_label = watch(0b111000, 1000);
+        run_for_ms(1000);
+        check(!heater_on(), "button S1 lowers the setpoint below the temperature: Controller idles");
+        check(edit_value.lit && edit_value.dark && !edit_label.dark, "setpoint shown: its value blinks, `t2` steady");
+
+        // Пауза между нажатиями больше BUTTONS_DOUBLE_CLICK_GAP_MS, иначе это двойной клик
+        host::uart_rx("2");
+        run_for_ms(1000);
+        host::uart_rx("2");
+        run_for_ms(3000);
+        check(heater_on(), "button S2 raises the setpoint above the temperature: Controller heats");
+        run_for_ms(500);
+        check(!app.animator->active(), "setpoint display over: blinking stops with the frame timer");
+
+        check(!host::iwdg_expired(), "watchdog never expired");
+    }
+}
+
+int main() {
+    check_toy();
+    check_firmware();
+
+    return checks::finish();
+}
@@ -0,0 +1,232 @@
+/**
+ * @file intfmt_bench.cpp
+ * @brief IntFormat против прежних форматтеров целых (UsartDriver::write_int, itoa_simple, displayTemperature)
+ *
+ * Использование: stm32f0_basic_intfmt_bench [повторов]
+ *
+ * Сначала проверяется, что IntFormat даёт тот же текст, что snprintf (края диапазона
+ * и псевдослучайные значения), а цифры индикатора — те же, что прежний displayTemperature.
+ * Затем каждый вариант форматирует один и тот же набор значений [повторов] раз;
+ * печатается среднее на одно преобразование в единицах host_cycle_stamp().
+ *
+ * На хосте деление аппаратное, поэтому прежние варианты делят через m0_udivmod() —
+ * тот же цикл сдвигов и вычитаний, что __aeabi_uidivmod из libgcc для Cortex-M0
+ * (один вызов на пару / и %, как их объединяет GCC). Число таких вызовов на
+ * преобразование печатается отдельно: на плате каждый стоит десятки тактов.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <etl/string.h>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+#include "IntFormat.hpp"
+
+namespace {
+    uint64_t div_calls = 0;
+    volatile uint32_t sink;   ///< Чтобы результат форматирования не выбросил оптимизатор
+
+    using checks::check;
+
+    /// __aeabi_uidivmod для Thumb-1: выравнивание делителя и цикл сдвиг-вычитание
+    [[gnu::noinline]] uint32_t m0_udivmod(uint32_t n, uint32_t d, uint32_t &rem) {
+        ++div_calls;
+        uint32_t q = 0, bit = 1;
+        while (d < n && !(d & 0x8000'0000U)) {
+            d <<= 1;
+            bit <<= 1;
+        }
+        while (bit) {
+            if (n >= d) {
+                n -= d;
+                q |= bit;
+            }
+            d >>= 1;
+            bit >>= 1;
+        }
+        rem = n;
+        return q;
+    }
+
+    //=========================================================================
+    // Прежние форматтеры (деление — через m0_udivmod)
+    //=========================================================================
+
+    /// UsartDriver::write_int: два etl::string<7> и обратное копирование
+    size_t legacy_write_int(int value, char *out) {
+        etl::string<7> buf;
+        buf.clear();
+        if (value == 0) {
+            buf.push_back('0');
+        } else {
+            int is_negative = 0;
+            unsigned int uvalue = value;
+            if (value < 0) {
+                is_negative = 1;
+                uvalue = -value;
+            }
+            etl::string<7> tmp;
+            while (uvalue) {
+                uint32_t digit;
+                uvalue = m0_udivmod(uvalue, 10, digit);
+                tmp.push_back(static_cast<char>('0' + digit));
+            }
+            if (is_negative) tmp.push_back('-');
+            for (int i = static_cast<int>(tmp.size()) - 1; i >= 0; --i) buf.push_back(tmp[i]);
+        }
+        // Прежний write_str(etl::string) тоже копировал посимвольно
+        size_t n = 0;
+        for (auto c: buf) out[n++] = c;
+        return n;
+    }
+
+    /// itoa_simple из ht1621.cpp
+    size_t legacy_itoa_simple(int value, char *buf) {
+        char tmp[12];
+        int i = 0;
+        bool neg = false;
+        if (value < 0) {
+            neg = true;
+            value = -value;
+        }
+        uint32_t v = static_cast<uint32_t>(value);
+        do {
+            uint32_t digit;
+            v = m0_udivmod(v, 10, digit);
+            tmp[i++] = static_cast<char>('0' + digit);
+        } while (v);
+        char *p = buf;
+        if (neg) *p++ = '-';
+        while (i--) *p++ = tmp[i];
+        *p = '\0';
+        return static_cast<size_t>(p - buf);
+    }
+
+    /// Цифры Controller::displayTemperature: [3], [4], [5] строки "tN xx.x"
+    void legacy_display_digits(int value, char *d) {
+        const bool negative = value < 0;
+        const uint32_t magnitude = static_cast<uint32_t>(negative ? -value : value);
+        uint32_t frac, ones;
+        uint32_t whole = m0_udivmod(magnitude, 10, frac);
+        if (whole > 99) whole = 99;
+        const uint32_t tens = m0_udivmod(whole, 10, ones);
+        d[0] = negative ? '-' : static_cast<char>('0' + tens);
+        d[1] = static_cast<char>('0' + (negative && whole >= 10 ? tens : ones));
+        d[2] = static_cast<char>('0' + frac);
+    }
+
+    /// Те же цифры через IntFormat::div10
+    void display_digits(int value, char *d) {
+        const bool negative = value < 0;
+        const uint32_t magnitude = static_cast<uint32_t>(negative ? -value : value);
+        uint32_t frac, ones;
+        uint32_t whole = IntFormat::div10(magnitude, frac);
+        if (whole > 99) whole = 99;
+        const uint32_t tens = IntFormat::div10(whole, ones);
+        d[0] = negative ? '-' : static_cast<char>('0' + tens);
+        d[1] = static_cast<char>('0' + (negative && whole >= 10 ? tens : ones));
+        d[2] = static_cast<char>('0' + frac);
+    }
+
+    //=========================================================================
+
+    uint32_t lcg = 12345;
+
+    uint32_t next() {
+        lcg = lcg * 1664525U + 1013904223U;
+        return lcg;
+    }
+
+    void check_correctness() {
+        const int32_t edges[] = {0, 1, -1, 9, 10, -10, 99, 100, 999, -999, 65535, 1'000'000'000,
+                                 INT32_MAX, INT32_MIN, INT32_MIN + 1};
+        bool int_ok = true, uint_ok = true, fixed_ok = true;
+        char got[IntFormat::IntBufSize + 2], want[32];
+
+        auto one = [&](int32_t v) {
+            size_t n = IntFormat::formatInt(v, got);
+            std::snprintf(want, sizeof(want), "%d", v);
+            int_ok = int_ok && n == std::strlen(want) && std::strcmp(got, want) == 0;
+
+            n = IntFormat::formatUnsigned(static_cast<uint32_t>(v), got);
+            std::snprintf(want, sizeof(want), "%u", static_cast<uint32_t>(v));
+            uint_ok = uint_ok && n == std::strlen(want) && std::strcmp(got, want) == 0;
+
+            n = IntFormat::formatFixed1(v, got);
+            const int64_t m = v < 0 ? -static_cast<int64_t>(v) : v;
+            std::snprintf(want, sizeof(want), "%s%lld.%lld", v < 0 ? "-" : "",
+                          static_cast<long long>(m / 10), static_cast<long long>(m % 10));
+            fixed_ok = fixed_ok && n == std::strlen(want) && std::strcmp(got, want) == 0;
+        };
+        for (int32_t v: edges) one(v);
+        for (int i = 0; i < 1'000'000; ++i) one(static_cast<int32_t>(next()) >> (i % 32));
+
+        check(int_ok, "formatInt matches snprintf %d");
+        check(uint_ok, "formatUnsigned matches snprintf %u");
+        check(fixed_ok, "formatFixed1 matches x.y");
+
+        bool display_ok = true;
+        for (int v = -99; v <= 999; ++v) {
+            char a[3], b[3];
+            legacy_display_digits(v, a);
+            display_digits(v, b);
+            display_ok = display_ok && std::memcmp(a, b, 3) == 0;
+        }
+        check(display_ok, "display digits match the previous displayTemperature");
+    }
+
+    constexpr size_t ValueCount = 64;
+    int32_t values[ValueCount];
+
+    template<typename F>
+    void bench(const char *name, long repeats, F &&format) {
+        div_calls = 0;
+        const uint32_t start = host_cycle_stamp();
+        for (long r = 0; r < repeats; ++r) {
+            for (int32_t v: values) sink = format(v);
+        }
+        const uint32_t stamp = host_cycle_stamp() - start;
+
+        const double conversions = static_cast<double>(repeats) * ValueCount;
+        std::printf("  %-16s %8.1f per conversion, %.2f libgcc divisions\n", name, stamp / conversions,
+                    div_calls / conversions);
+        std::printf("BENCH intfmt_%s %.1f\n", name, stamp / conversions);
+        std::printf("BENCH intfmt_%s_divcalls %.2f\n", name, div_calls / conversions);
+    }
+}
+
+int main(int argc, char **argv) {
+    const long repeats = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    check_correctness();
+
+    // Значения разной длины в пределах etl::string<7> прежнего write_int: от 1 до 7 символов
+    for (size_t i = 0; i < ValueCount; ++i) {
+        const int32_t v = static_cast<int32_t>(next() % 1'000'000U) >> (i % 20);
+        values[i] = (i & 1) ? -v : v;
+    }
+
+    std::printf("int formatting bench: %ld repeats of %zu values, unit %s\n", repeats, ValueCount,
+                host::cycle_stamp_unit());
+    char buf[IntFormat::IntBufSize];
+    bench("write_int_legacy", repeats, [&](int32_t v) { return legacy_write_int(v, buf); });
+    bench("itoa_legacy", repeats, [&](int32_t v) { return legacy_itoa_simple(v, buf); });
+    bench("format_int", repeats, [&](int32_t v) { return IntFormat::formatInt(v, buf); });
+    bench("format_fixed1", repeats, [&](int32_t v) { return IntFormat::formatFixed1(v, buf); });
+    bench("display_legacy", repeats, [&](int32_t v) {
+        legacy_display_digits(v % 1000, buf);
+        return static_cast<size_t>(buf[1]);
+    });
+    bench("display", repeats, [&](int32_t v) {
+        display_digits(v % 1000, buf);
+        return static_cast<size_t>(buf[1]);
+    });
+
+    return checks::finish();
+}
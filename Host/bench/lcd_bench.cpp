@@ -0,0 +1,236 @@
+/**
+ * @file lcd_bench.cpp
+ * @brief Стоимость обновления индикатора HT1621B: изменённые адреса против всей RAM
+ *
+ * Использование: stm32f0_basic_lcd_bench[_full|_spi] [обновлений]
+ *
+ * Прошивка инициализируется как обычно, затем Controller получает [обновлений]
+ * измерений температуры (случайное блуждание по десятым долям) и столько же нажатий
+ * S1/S2 (показ уставки). Каждое событие — одна перерисовка displayTemperature()
+ * и один HT1621B::Present(). Затем столько же кадров DisplayAnimator: мигание
+ * значения уставки (смена фазы) и бегущая строка (шаг на разряд). Вариант _full собран с HT1621_FULL_FLUSH (все 32 ниббла
+ * отдельными посылками), основной передаёт только изменённые адреса, подряд
+ * идущие — одной посылкой. Вариант _spi (HT1621_SPI) передаёт те же посылки через SPI1
+ * в прерывании: Present() только раскладывает их в слова, событие ждёт конца передачи.
+ *
+ * После каждого обновления RAM модели контроллера сравнивается с полной перезаписью
+ * (Invalidate() + Present(), вне подсчёта): частичный вывод не должен терять изменений.
+ * В конце проверяется, что Show*() не трогают стекло до Present(), Present() без
+ * изменений не занимает шину, а его счётчики посылок и бит сходятся с моделью.
+ *
+ * Печатается на одно обновление: переключения выводов CS/WR/DATA, посылки, биты и
+ * время на плате. На хосте __NOP() ничего не стоит, поэтому время — оценка по коду
+ * WriteBit()/WriteData() для Cortex-M0 на 48 МГц: бит — три записи в GPIO, 13 NOP,
+ * вызов и ветвление (~30 тактов), посылка — CS и четыре NOP (~14 тактов).
+ * Для _spi время ядра — ожидание внутри Present() по модели плюс вызовы SPI1_IRQHandler
+ * (~60 тактов со входом и выходом); отдельно печатается время передачи по линии
+ * (SCK = 187.5 кГц) и число прерываний.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "hardware_init.hpp"
+#include "ht1621_spi.hpp"
+#include "services_init.hpp"
+
+App app{};
+
+namespace {
+    constexpr double BitCycles = 30;
+    constexpr double FrameCycles = 14;
+    constexpr double IrqCycles = 60;
+
+    uint32_t mismatches = 0;
+
+    using checks::check;
+
+    struct Cost {
+        uint64_t toggles = 0;
+        uint64_t bits = 0;
+        uint64_t frames = 0;
+        uint64_t irqs = 0;
+        uint64_t wait_cycles = 0;   ///< Основной цикл стоял внутри события
+        uint64_t wire_cycles = 0;   ///< SPI1 сдвигал слова
+    };
+
+    Cost snapshot() {
+        return {host::lcd_toggles(), host::lcd_bits(), host::lcd_frames(), host::irq_count(SPI1_IRQn),
+                host::now_cycles(), host::spi_stats().busy_cycles};
+    }
+
+    /// Передача в прерывании идёт, пока время модели продвигается
+    void drain() {
+#if defined HT1621_SPI
+        while (Ht1621Spi::busy()) host::advance_us(10);
+#endif
+    }
+
+    /// Стоимость вывода action() прибавляется к total
+    template<typename F>
+    void measure(F &&action, Cost &total) {
+        const Cost before = snapshot();
+        action();
+        const uint64_t returned = host::now_cycles();
+        drain();
+        const Cost after = snapshot();
+        total.toggles += after.toggles - before.toggles;
+        total.bits += after.bits - before.bits;
+        total.frames += after.frames - before.frames;
+        total.irqs += after.irqs - before.irqs;
+        total.wait_cycles += returned - before.wait_cycles;
+        total.wire_cycles += after.wire_cycles - before.wire_cycles;
+
+        uint8_t glass[32];
+        std::memcpy(glass, host::lcd_ram(), sizeof(glass));
+        app.display->Invalidate();
+        app.display->Present();
+        drain();
+        if (std::memcmp(glass, host::lcd_ram(), sizeof(glass)) != 0) ++mismatches;
+    }
+
+    /// Событие контроллеру
+    void update(const Event &e, Cost &total) {
+        measure([&] { app.ctrl->processEvent(e); }, total);
+    }
+
+    /// Кадр анимации: время модели до срока, затем событие DisplayFrame
+    void animate(uint32_t ms, Cost &total) {
+        host::advance_us(ms * 1000ULL);
+        measure([] { app.animator->onFrame(); }, total);
+    }
+
+    void report(const char *name, const Cost &c, long updates) {
+        const double toggles = static_cast<double>(c.toggles) / updates;
+        const double frames = static_cast<double>(c.frames) / updates;
+        const double bits = static_cast<double>(c.bits) / updates;
+        const double mhz = host::CoreClockHz / 1e6;
+#if defined HT1621_SPI
+        const double irqs = static_cast<double>(c.irqs) / updates;
+        const double wire_us = static_cast<double>(c.wire_cycles) / updates / mhz;
+        const double us = (static_cast<double>(c.wait_cycles) / updates + irqs * IrqCycles) / mhz;
+        std::printf("  %-8s %7.1f toggles %5.1f frames %6.1f bits %7.1f us (%5.1f irqs, %7.1f us on the wire)\n",
+                    name, toggles, frames, bits, us, irqs, wire_us);
+        std::printf("BENCH lcd_%s_irqs %.1f\n", name, irqs);
+        std::printf("BENCH lcd_%s_wire_us %.1f\n", name, wire_us);
+#else
+        const double us = (bits * BitCycles + frames * FrameCycles) / mhz;
+        std::printf("  %-8s %7.1f toggles %5.1f frames %6.1f bits %7.1f us\n", name, toggles, frames, bits, us);
+#endif
+        std::printf("BENCH lcd_%s_toggles %.1f\n", name, toggles);
+        std::printf("BENCH lcd_%s_us %.1f\n", name, us);
+    }
+}
+
+int main(int argc, char **argv) {
+    const long updates = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    host::reset();
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+    drain();   // Очистка индикатора из Init()
+    const HT1621B::PresentStats stats_before = app.display->GetStats();
+    const Cost wire_before = snapshot();
+
+#if defined HT1621_FULL_FLUSH
+    const char *variant = "full RAM";
+#elif defined HT1621_SPI
+    const char *variant = "dirty runs, SPI1";
+#else
+    const char *variant = "dirty runs";
+#endif
+    std::printf("lcd bench (%s): %ld updates per case\n", variant, updates);
+
+    // Измерения: температура блуждает на несколько десятых, индикатор показывает t1
+    std::mt19937 rng(1234);
+    int temperature = 350;
+    Cost sample;
+    for (long i = 0; i < updates; ++i) {
+        temperature += static_cast<int>(rng() % 7) - 3;
+        update({EventType::TemperatureReady, temperature}, sample);
+    }
+
+    // Нажатия S2/S1 по очереди: уставка на шаг вверх и обратно, индикатор показывает t2
+    Cost button;
+    for (long i = 0; i < updates; ++i) {
+        update({i & 1 ? EventType::ButtonS1 : EventType::ButtonS2, 2}, button);
+    }
+
+    // Показ уставки после кнопок: значение мигает, кадр — смена фазы
+    constexpr uint32_t BlinkMs = DISPLAY_BLINK_ON_MS > DISPLAY_BLINK_OFF_MS ? DISPLAY_BLINK_ON_MS : DISPLAY_BLINK_OFF_MS;
+    const bool blinking = app.animator->active();
+    Cost blink;
+    for (long i = 0; i < updates; ++i) animate(BlinkMs, blink);
+
+#if !defined HT1621_FULL_FLUSH
+    // Кадр раньше срока (при HT1621_FULL_FLUSH любой кадр шлёт весь образ)
+    const Cost early = snapshot();
+    app.animator->onFrame();
+    drain();
+    check(snapshot().bits == early.bits, "a DisplayFrame before its due time sends nothing");
+#endif
+
+    app.animator->blinkPositions(0);
+    app.animator->marquee("hEAt CoIL oPEn");
+    app.display->Present();
+    drain();
+    Cost marquee;
+    for (long i = 0; i < updates; ++i) animate(DISPLAY_MARQUEE_STEP_MS, marquee);
+    app.animator->stopMarquee();
+
+    report("sample", sample, updates);
+    report("button", button, updates);
+    report("blink", blink, updates);
+    report("marquee", marquee, updates);
+
+    check(mismatches == 0, "glass RAM matches a full rewrite after every update");
+#if !defined HT1621_FULL_FLUSH
+    check(sample.frames <= static_cast<uint64_t>(updates) * 3, "a sample update takes at most 3 frames");
+#endif
+
+    // Кадр собирается в заднем буфере: до Present() стекло прежнее
+    uint8_t glass[32];
+    std::memcpy(glass, host::lcd_ram(), sizeof(glass));
+    app.display->ShowString("PrESEt");
+    check(std::memcmp(glass, host::lcd_ram(), sizeof(glass)) == 0, "Show*() leaves the glass alone until Present()");
+    app.display->Present();
+    drain();
+    check(std::memcmp(glass, host::lcd_ram(), sizeof(glass)) != 0, "Present() shows the composed frame");
+
+    const HT1621B::PresentStats &stats = app.display->GetStats();
+    const Cost wire = snapshot();
+    check(stats.frames - stats_before.frames == wire.frames - wire_before.frames &&
+          stats.bits - stats_before.bits == wire.bits - wire_before.bits,
+          "Present() stats match the frames and bits on the wire");
+#if !defined HT1621_FULL_FLUSH
+    const uint32_t idle_before = stats.idle;
+    app.display->Present();
+    drain();
+    check(snapshot().bits == wire.bits && stats.idle == idle_before + 1, "an unchanged frame does not touch the bus");
+#endif
+
+    check(blinking && blink.frames > 0, "the setpoint blinks while it is shown");
+    check(!app.animator->active(), "no animation, no frame timer");
+#if !defined HT1621_FULL_FLUSH
+    check(blink.frames <= static_cast<uint64_t>(updates), "a blink phase takes one frame");
+    check(marquee.frames <= static_cast<uint64_t>(updates) * 3, "a marquee step takes at most 3 frames");
+    check(blink.bits <= static_cast<uint64_t>(updates) * (12 + 4 * 13), "a blink frame carries only the blinking digits");
+#endif
+#if defined HT1621_SPI
+    check(sample.wait_cycles == 0 && button.wait_cycles == 0, "Present() returns without waiting for the bus");
+    check(sample.toggles == 2 * sample.frames && button.toggles == 2 * button.frames, "the CPU only toggles CS");
+#endif
+
+    return checks::finish();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file loop_bench.cpp
+ * @brief Замер длительности этапов app_loop на хосте (сборка с APP_LOOP_PROFILE)
+ *
+ * Использование: stm32f0_basic_loop_bench [секунды] [квант мкс]
+ *
+ * Прошивка работает на моделях периферии; раз в секунду по UART приходит
+ * нажатие кнопки, датчик выдаёт температуру, Controller ведёт PID. Для каждого
+ * этапа печатаются min/avg/max в единицах host_cycle_stamp() и строки
+ * "BENCH <этап> <min> <avg> <max>" для сравнения между коммитами.
+ *
+ * Числа включают работу моделей регистров, поэтому сравнимы только между
+ * хост-прогонами; на железе ту же таблицу выводит LoopProfiler::report().
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+#include "loop_profiler.hpp"
+
+App app{};
+
+int main(int argc, char **argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 20.0;
+    const uint64_t quantum_us = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20;
+
+    host::reset();
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+    LoopProfiler::reset();
+
+    const auto end_us = static_cast<uint64_t>(seconds * 1e6);
+    uint64_t next_key_us = 1'000'000;
+    uint64_t iterations = 0;
+    static const char keys[] = {'1', '2', '3', '4'};
+
+    while (host::now_us() < end_us) {
+        if (host::now_us() >= next_key_us) {
+            const char key[2] = {keys[(next_key_us / 1'000'000) % 4], '\0'};
+            host::uart_rx(key);
+            next_key_us += 1'000'000;
+        }
+
+        app_loop(app);
+        ++iterations;
+        host::advance_us(quantum_us);
+    }
+
+    std::printf("app_loop bench: %.1f s simulated, %llu iterations, unit: %s\n",
+                seconds, static_cast<unsigned long long>(iterations), host::cycle_stamp_unit());
+    std::printf("%-10s %10s %10s %10s %10s\n", "stage", "min", "avg", "max", "count");
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LoopStage::Count); ++i) {
+        const auto stage = static_cast<LoopStage>(i);
+        const auto &s = LoopProfiler::stats(stage);
+        std::printf("%-10s %10u %10u %10u %10u\n",
+                    LoopProfiler::stage_name(stage), s.min, s.avg(), s.max, s.count);
+    }
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LoopStage::Count); ++i) {
+        const auto stage = static_cast<LoopStage>(i);
+        const auto &s = LoopProfiler::stats(stage);
+        std::printf("BENCH %s %u %u %u\n", LoopProfiler::stage_name(stage), s.min, s.avg(), s.max);
+    }
+
+    return host::iwdg_expired() ? 1 : 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file onewire_bench.cpp
+ * @brief DS18B20 на общей шине: поиск ROM, одно преобразование на всех, чтение по Match ROM
+ *
+ * Использование: stm32f0_basic_onewire_bench [циклов]
+ *
+ * На шине модели 1..DS18B20_MAX_SENSORS + 1 датчиков с разными температурами.
+ * Для каждого числа датчиков драйвер с нуля находит их Search ROM и проводит
+ * [циклов] циклов измерения. Проверяется:
+ * - таблица: каждый код ROM модели найден ровно один раз (лишний датчик сверх
+ *   DS18B20_MAX_SENSORS не попадает в таблицу и не мешает остальным);
+ * - за цикл одна команда Convert T и по событию TemperatureReady на каждый датчик,
+ *   значение — температура датчика с этим кодом ROM;
+ * - цикл длится период опроса DS18B20_SAMPLE_PERIOD_MS (одно преобразование и N чтений
+ *   в него укладываются), а не N преобразований;
+ * - отключённый после поиска датчик даёт SensorError (CRC) только под своим номером;
+ * - без ответа на reset все датчики сообщают об ошибке, после подключения поиск повторяется;
+ * - нет присутствия на втором проходе поиска: код первого прохода остаётся и измеряется;
+ * - датчик 0 (регулирующий) — первый найденный после init(): при повторном поиске он
+ *   остаётся под номером 0, а пропавший с шины даёт ошибку, а не значение другого датчика.
+ *
+ * Печатается время до первого измерения (с поиском и записью разрешения), длительность
+ * установившегося цикла и чтения одного датчика (мс времени модели).
+ * Вариант _skip_rom собран с DS18B20_SKIP_ROM: один датчик, прежний обмен Skip ROM.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+#include "config.h"
+#include "AppContext.hpp"
+#include "hardware_init.hpp"
+#include "ds18b20.hpp"
+#include "Event.hpp"
+
+App app{};
+
+namespace {
+    /// Шаг основного цикла в модели (мкс): задержка реакции poll() на конец операции TIM1
+    constexpr uint64_t PollStepUs = 50;
+    /// Преобразование при 12 битах и период опроса драйвера
+    constexpr double ConversionMs = 750.0;
+    constexpr double PeriodMs = DS18B20_SAMPLE_PERIOD_MS;
+    /// Начало цикла: reset и Skip ROM + Convert T (16 слотов), запас на опрос
+    constexpr double StartMs = 1.0 + 16 * 0.062 + 1.0;
+    /// Одно чтение: reset, Match ROM + Read Scratchpad (80 слотов), 72 слота чтения, запас на опрос
+    constexpr double ReadMaxMs = 1.0 + (80 + 72) * 0.062 + 2.0;
+
+    using checks::check;
+
+    struct Sample {
+        uint64_t us;
+        uint32_t conversions;   ///< Convert T, принятых датчиками к этому событию
+        Event event;
+    };
+
+    int tenths_of(uint8_t device) { return 200 + 37 * device; }
+
+    /// Что вернёт датчик после округления до 1/16 °C (как в модели и decode_temperature())
+    int16_t decoded(int tenths) {
+        const auto raw = static_cast<int16_t>(tenths * 16 / 10);
+        return static_cast<int16_t>((raw * 10) >> 4);
+    }
+
+    /// Цикл: период опроса или работа цикла, если она длиннее; запас на шаг SysTick
+    double cycle_max_ms(uint8_t sensors) {
+        const double busy = StartMs + ConversionMs + sensors * ReadMaxMs;
+        return (busy > PeriodMs ? busy : PeriodMs) + 2.0;
+    }
+
+    /// Основной цикл без app_loop: только драйвер датчика и очередь
+    std::vector<Sample> run(DS18B20 &sensor, double ms) {
+        std::vector<Sample> out;
+        const uint64_t end = host::now_us() + static_cast<uint64_t>(ms * 1000);
+        while (host::now_us() < end) {
+            sensor.poll();
+            while (auto ev = app.queue->pop()) out.push_back({host::now_us(), host::ds18b20_conversions(), *ev});
+            host::advance_us(PollStepUs);
+        }
+        return out;
+    }
+
+#if !defined DS18B20_SKIP_ROM
+    /// Номер датчика модели по коду ROM или -1
+    int device_of(const uint8_t *rom, uint8_t devices) {
+        if (!rom) return -1;
+        for (uint8_t d = 0; d < devices; ++d) {
+            if (std::memcmp(rom, host::ds18b20_rom(d), 8) == 0) return d;
+        }
+        return -1;
+    }
+#endif
+
+    void bus(uint8_t devices, long cycles) {
+        host::reset();
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+
+        host::ds18b20_set_count(devices);
+        for (uint8_t d = 0; d < devices; ++d) host::ds18b20_set_temperature(d, tenths_of(d));
+
+        while (app.queue->pop()) {}
+        DS18B20 sensor{};
+        sensor.init();
+
+        const uint8_t expected = devices < DS18B20_MAX_SENSORS ? devices : DS18B20_MAX_SENSORS;
+        std::printf("%u sensor(s) on the bus:\n", devices);
+
+        // Первый цикл: поиск, запись разрешения, затем сразу преобразование. Циклы отсчитываются
+        // от начала поиска, чтение k-го — не позже k * цикл + работа цикла: окно до середины
+        // преобразования после [циклов]-го
+        const double cycle_max = cycle_max_ms(expected);
+        const uint64_t start = host::now_us();
+        const uint32_t conversions_before = host::ds18b20_conversions();
+        std::vector<Sample> samples = run(sensor, cycles * cycle_max + StartMs + ConversionMs / 2);
+
+        // Таблица: все коды различны и принадлежат датчикам модели
+        bool table_ok = sensor.getSensorCount() == expected;
+        std::vector<bool> seen(devices, false);
+        std::vector<int> device(expected, -1);
+        for (uint8_t i = 0; i < sensor.getSensorCount() && i < expected; ++i) {
+#if defined DS18B20_SKIP_ROM
+            table_ok &= sensor.getRom(i) == nullptr;
+            device[i] = i;
+#else
+            const int d = device_of(sensor.getRom(i), devices);
+            table_ok &= d >= 0 && !seen[d];
+            if (d >= 0) seen[d] = true;
+            device[i] = d;
+#endif
+        }
+        char what[128];
+        std::snprintf(what, sizeof(what), "  search: %u ROM code(s), each bus device at most once", expected);
+        check(table_ok, what);
+
+        // События по номерам датчиков и значения
+        std::vector<std::vector<uint64_t>> times(expected);
+        bool values_ok = true, errors = false, broadcast = true;
+        for (const auto &s: samples) {
+            if (s.event.type == EventType::SensorError) errors = true;
+            if (s.event.type != EventType::TemperatureReady) continue;
+            if (s.event.sensor >= expected || device[s.event.sensor] < 0) {
+                values_ok = false;
+                continue;
+            }
+            times[s.event.sensor].push_back(s.us);
+            // k-е чтение любого датчика — после k-го преобразования и до следующего
+            broadcast &= s.conversions - conversions_before == times[s.event.sensor].size();
+            values_ok &= s.event.value == decoded(tenths_of(static_cast<uint8_t>(device[s.event.sensor])));
+        }
+        bool counts_ok = !errors;
+        for (const auto &t: times) counts_ok &= static_cast<long>(t.size()) == cycles;
+        check(counts_ok, "  one TemperatureReady per sensor per cycle, no errors");
+        check(values_ok, "  each value is the temperature of the sensor with that ROM code");
+        bool stored_ok = true;
+        for (uint8_t i = 0; i < expected; ++i) {
+            stored_ok &= device[i] >= 0 && sensor.getTemperature(i) == decoded(tenths_of(static_cast<uint8_t>(device[i])));
+        }
+        check(stored_ok, "  getTemperature() holds the last value of each sensor");
+        check(broadcast, "  one broadcast Convert T per cycle");
+
+        if (!counts_ok || cycles < 3) return;
+
+        // Времена: первое измерение (вместе с поиском), цикл по датчику 0 без первого (он короче
+        // на время поиска), чтение — между соседними датчиками
+        const double first_ms = (times[0][0] - start) / 1000.0;
+        const double cycle_ms = (times[0][cycles - 1] - times[0][1]) / 1000.0 / (cycles - 2);
+        const double read_ms = expected > 1
+                ? (times[expected - 1][0] - times[0][0]) / 1000.0 / (expected - 1)
+                : 0.0;
+        std::printf("  first sample %.1f ms, cycle %.1f ms, read %.2f ms per sensor\n", first_ms, cycle_ms, read_ms);
+        std::printf("BENCH onewire_%u_first_ms %.1f\n", devices, first_ms);
+        std::printf("BENCH onewire_%u_cycle_ms %.1f\n", devices, cycle_ms);
+        if (expected > 1) std::printf("BENCH onewire_%u_read_ms %.2f\n", devices, read_ms);
+        check(cycle_ms >= PeriodMs - 1.0 && cycle_ms <= cycle_max,
+              "  cycle: the sample period (one conversion + N reads fit in it)");
+
+#if !defined DS18B20_SKIP_ROM
+        // Датчик пропал после поиска: ошибка CRC только под его номером
+        if (expected > 1) {
+            const uint8_t lost = expected - 1;
+            host::ds18b20_attach(static_cast<uint8_t>(device[lost]), false);
+            samples = run(sensor, cycle_max);
+            bool lost_ok = false, others_ok = true;
+            for (const auto &s: samples) {
+                if (s.event.type == EventType::SensorError) {
+                    lost_ok = s.event.sensor == lost && s.event.value == DS18B20::TEMP_ERROR_CRC_FAIL;
+                    others_ok &= s.event.sensor == lost;
+                }
+            }
+            check(lost_ok && others_ok, "  detached sensor: SensorError (CRC) under its index only");
+            host::ds18b20_attach(static_cast<uint8_t>(device[lost]), true);
+        }
+
+        // Шина пуста: ошибка и новый поиск после подключения
+        host::ds18b20_attach(false);
+        samples = run(sensor, 2 * cycle_max);
+        bool no_sensor = false;
+        for (const auto &s: samples) {
+            no_sensor |= s.event.type == EventType::SensorError && s.event.sensor == 0 &&
+                         s.event.value == DS18B20::TEMP_ERROR_NO_SENSOR;
+        }
+        check(no_sensor && sensor.getSensorCount() == 0, "  empty bus: NO_SENSOR and the table is dropped");
+
+        host::ds18b20_attach(true);
+        run(sensor, 2 * cycle_max);
+        check(sensor.getSensorCount() == expected, "  sensors back: the bus is searched again");
+#endif
+    }
+
+#if !defined DS18B20_SKIP_ROM
+    /// Второй проход поиска остался без импульса присутствия: найденный код остаётся в таблице
+    void lost_pass() {
+        constexpr uint8_t devices = 3;
+        host::reset();
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+
+        host::ds18b20_set_count(devices);
+        for (uint8_t d = 0; d < devices; ++d) host::ds18b20_set_temperature(d, tenths_of(d));
+
+        while (app.queue->pop()) {}
+        DS18B20 sensor{};
+        sensor.init();
+        std::printf("%u sensor(s), no presence on the second search pass:\n", devices);
+
+        // reset 1 — первый проход, reset 2 — второй
+        host::ds18b20_drop_presence(2);
+        const std::vector<Sample> samples = run(sensor, 2 * cycle_max_ms(1));
+
+        const int d = device_of(sensor.getRom(0), devices);
+        bool errors = false, measured = false;
+        for (const auto &s: samples) {
+            errors |= s.event.type == EventType::SensorError;
+            measured |= s.event.type == EventType::TemperatureReady && s.event.sensor == 0 && d >= 0 &&
+                        s.event.value == decoded(tenths_of(static_cast<uint8_t>(d)));
+        }
+        check(sensor.getSensorCount() == 1 && d >= 0, "  the ROM of the first pass is kept");
+        check(measured && !errors, "  it is measured, no NO_SENSOR for the whole bus");
+    }
+
+    /// Последнее значение датчика index за прогон: температура, код ошибки или INT32_MIN (событий нет)
+    int last_of(const std::vector<Sample> &samples, uint8_t index) {
+        int value = INT32_MIN;
+        for (const auto &s: samples) {
+            if (s.event.sensor == index && (s.event.type == EventType::TemperatureReady ||
+                                            s.event.type == EventType::SensorError)) {
+                value = s.event.value;
+            }
+        }
+        return value;
+    }
+
+    /// Регулирующий датчик остаётся под номером 0 при повторном поиске
+    void control_probe() {
+        constexpr uint8_t devices = 3;
+        const double cycle_max = cycle_max_ms(devices);
+        host::reset();
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+
+        host::ds18b20_set_count(devices);
+        for (uint8_t d = 0; d < devices; ++d) host::ds18b20_set_temperature(d, tenths_of(d));
+        std::printf("%u sensor(s), the regulating probe across searches:\n", devices);
+
+        // Порядок поиска на полной шине: регулирующим сделаем датчик, найденный последним
+        int control = -1;
+        {
+            while (app.queue->pop()) {}
+            DS18B20 probe{};
+            probe.init();
+            run(probe, cycle_max);
+            control = device_of(probe.getRom(devices - 1), devices);
+        }
+        if (control < 0) {
+            check(false, "  full bus searched");
+            return;
+        }
+        const auto control_device = static_cast<uint8_t>(control);
+        const int control_value = decoded(tenths_of(control_device));
+
+        // Старт с одним этим датчиком, затем шина пропадает и возвращается целиком
+        host::ds18b20_attach(false);
+        host::ds18b20_attach(control_device, true);
+        while (app.queue->pop()) {}
+        DS18B20 sensor{};
+        sensor.init();
+        run(sensor, cycle_max);
+        host::ds18b20_attach(false);
+        run(sensor, 2 * cycle_max);
+        host::ds18b20_attach(true);
+        std::vector<Sample> samples = run(sensor, 2 * cycle_max);
+        check(sensor.getSensorCount() == devices && device_of(sensor.getRom(0), devices) == control &&
+              last_of(samples, 0) == control_value,
+              "  re-search of the full bus: the first probe found stays sensor 0");
+
+        // Регулирующий датчик пропал к повторному поиску: номер 0 — ошибка, а не другой датчик
+        host::ds18b20_attach(false);
+        run(sensor, 2 * cycle_max);
+        host::ds18b20_attach(true);
+        host::ds18b20_attach(control_device, false);
+        samples = run(sensor, 2 * cycle_max);
+        bool others_ok = sensor.getSensorCount() == devices;
+        for (uint8_t i = 1; i < sensor.getSensorCount(); ++i) {
+            const int d = device_of(sensor.getRom(i), devices);
+            others_ok &= d >= 0 && d != control && last_of(samples, i) == decoded(tenths_of(static_cast<uint8_t>(d)));
+        }
+        check(device_of(sensor.getRom(0), devices) == control && last_of(samples, 0) == DS18B20::TEMP_ERROR_CRC_FAIL &&
+              others_ok, "  probe missing from the search: sensor 0 fails, the others are measured");
+
+        host::ds18b20_attach(control_device, true);
+        samples = run(sensor, cycle_max);
+        check(last_of(samples, 0) == control_value, "  probe back: sensor 0 measured without a new search");
+    }
+#endif
+}
+
+int main(int argc, char **argv) {
+    const long cycles = argc > 1 ? std::atol(argv[1]) : 4;
+
+#if defined DS18B20_SKIP_ROM
+    std::printf("onewire bench (Skip ROM): %ld cycles\n", cycles);
+    bus(1, cycles);
+#else
+    std::printf("onewire bench (Search ROM + Match ROM): %ld cycles per bus\n", cycles);
+    for (uint8_t n = 1; n <= DS18B20_MAX_SENSORS + 1; ++n) bus(n, cycles);
+    lost_pass();
+    control_probe();
+#endif
+
+    return checks::finish();
+}
@@ -0,0 +1,318 @@
+/**
+ * @file proto_loopback.cpp
+ * @brief Протокол USART1 на модели: клиент ProtoClient против прошивки в хост-сборке
+ *
+ * Использование: stm32f0_basic_proto_loopback
+ *
+ * Запросы уходят в модель USART1 (host::uart_rx), ответы разбираются из всего,
+ * что прошивка передала (host::uart_tx). Записи журнала восстанавливаются
+ * LogDecoder по секции logfmt этого же процесса.
+ * Проверяются журнал запуска, все команды, коды ошибок, испорченный кадр и восстановление после него,
+ * кадр, пришедший двумя посылками, пачка запросов подряд, клавиши '1'..'4' вне кадров
+ * и телеметрия по подписке: без пропусков номеров, с точными метками времени
+ * и слагаемыми PID, в том числе когда линию одновременно занимают ответы.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+#include "ProtoClient.hpp"
+#include "LogDecoder.hpp"
+#include "Log.hpp"
+
+App app{};
+
+extern "C" const char __start_logfmt[];
+extern "C" const char __stop_logfmt[];
+
+namespace {
+    ProtoClient client;
+    size_t tx_seen = 0;   ///< Сколько байт host::uart_tx() уже отдано клиенту
+
+    using checks::check;
+
+    void step() {
+        app_loop(app);
+        host::advance_us(100);
+
+        const std::string &tx = host::uart_tx();
+        if (tx.size() > tx_seen) {
+            client.feed(reinterpret_cast<const uint8_t *>(tx.data()) + tx_seen, tx.size() - tx_seen);
+            tx_seen = tx.size();
+        }
+    }
+
+    void run_for_ms(uint32_t ms) {
+        const uint64_t end_us = host::now_us() + ms * 1000ULL;
+        while (host::now_us() < end_us) step();
+    }
+
+    void send(const std::vector<uint8_t> &bytes) {
+        host::uart_rx(bytes.data(), bytes.size());
+    }
+
+    /// Дождаться ответа на seq (не дольше timeout_ms модельного времени)
+    std::optional<ProtoClient::Response> wait(uint8_t seq, uint32_t timeout_ms = 200) {
+        const uint64_t end_us = host::now_us() + timeout_ms * 1000ULL;
+        while (host::now_us() < end_us) {
+            if (auto r = client.take(seq)) return r;
+            step();
+        }
+        return client.take(seq);
+    }
+
+    std::optional<ProtoClient::Response> call(ProtoCommand cmd, const std::vector<uint8_t> &args = {}) {
+        uint8_t seq;
+        send(client.request(cmd, args, seq));
+        return wait(seq);
+    }
+
+    bool status_is(const std::optional<ProtoClient::Response> &r, ProtoStatus status) {
+        return r && r->status == status;
+    }
+
+    int16_t setpoint_of(const std::optional<ProtoClient::Response> &r) {
+        if (!r) return INT16_MIN;
+        ProtoReader reader(r->data.data(), r->data.size());
+        return reader.i16();
+    }
+
+    void check_log() {
+        // Длинный тег не вытесняет коммит и не выходит за запись
+        constexpr char LongTag[] = "v1.4.0-rc2-27-gdeadbeefcafe";
+        LOG("Firmware %s, commit %s", LongTag, FW_GIT_HASH);
+        run_for_ms(20);
+
+        const LogDecoder decoder(__start_logfmt, static_cast<size_t>(__stop_logfmt - __start_logfmt));
+        std::vector<std::string> lines;
+        size_t wire = 0, text = 0;
+        for (const auto &l: client.logs()) {
+            lines.push_back(decoder.decode(l));
+            wire += 3 + l.args.size();
+            text += lines.back().size() + 2;
+        }
+
+        const auto has = [&](const std::string &line) {
+            for (const auto &l: lines) if (l == line) return true;
+            return false;
+        };
+        check(has("Firmware " FW_GIT_TAG ", commit " FW_GIT_HASH), "startup log names the firmware tag and commit");
+        check(has("System ready."), "startup log reaches the client");
+        const std::string cut(LongTag, LOG_ARGS_MAX - 2 - LOG_STR_MIN);
+        check(has("Firmware " + cut + ", commit " FW_GIT_HASH), "long tag is cut, the commit after it is kept whole");
+        check(client.text().empty(), "no text outside frames");
+        check(Log::stats().dropped == 0, "no log records dropped");
+
+        std::printf("BENCH log_frame_bytes %zu\n", wire);
+        std::printf("BENCH log_text_bytes %zu\n", text);
+    }
+
+    void check_commands() {
+        // Информация о прошивке (тег и коммит в хост-сборке — "host")
+        auto info = call(ProtoCommand::GetInfo);
+        std::string tag, commit;
+        if (status_is(info, ProtoStatus::Ok) && !info->data.empty()) {
+            const auto &d = info->data;
+            const size_t tag_len = d[0];
+            if (1 + tag_len < d.size()) {
+                tag.assign(d.begin() + 1, d.begin() + 1 + static_cast<long>(tag_len));
+                const size_t commit_len = d[1 + tag_len];
+                if (2 + tag_len + commit_len <= d.size()) {
+                    commit.assign(d.begin() + 2 + static_cast<long>(tag_len),
+                                  d.begin() + 2 + static_cast<long>(tag_len + commit_len));
+                }
+            }
+        }
+        check(tag == FW_GIT_TAG && commit == FW_GIT_HASH, "GetInfo returns the firmware tag and commit");
+
+        check(setpoint_of(call(ProtoCommand::GetSetpoint)) == CONTROLLER_SETPOINT_DEFAULT, "GetSetpoint returns the default");
+
+        auto set = call(ProtoCommand::SetSetpoint, ProtoClient::argsI16(455));
+        check(status_is(set, ProtoStatus::Ok) && setpoint_of(set) == 455, "SetSetpoint 45.5 C");
+        check(setpoint_of(call(ProtoCommand::GetSetpoint)) == 455, "GetSetpoint reads back 45.5 C");
+
+        check(status_is(call(ProtoCommand::SetSetpoint, ProtoClient::argsI16(CONTROLLER_SETPOINT_MAX + 1)),
+                        ProtoStatus::BadValue), "SetSetpoint above the limit is rejected");
+        check(status_is(call(ProtoCommand::SetSetpoint, {1}), ProtoStatus::BadLength), "SetSetpoint with one byte is rejected");
+
+        auto pid = call(ProtoCommand::GetPid);
+        bool pid_ok = status_is(pid, ProtoStatus::Ok) && pid->data.size() == 12;
+        if (pid_ok) {
+            ProtoReader r(pid->data.data(), pid->data.size());
+            pid_ok = r.i32() == CONTROLLER_PID::KP && r.i32() == CONTROLLER_PID::KI && r.i32() == CONTROLLER_PID::KD;
+        }
+        check(pid_ok, "GetPid returns the configured gains");
+
+        check(status_is(call(ProtoCommand::SetPid, ProtoClient::argsPid(30000, 400, 200)), ProtoStatus::Ok), "SetPid");
+        check(app.ctrl->getPid().kp() == 30000 && app.ctrl->getPid().ki() == 400 && app.ctrl->getPid().kd() == 200,
+              "SetPid reaches the controller");
+        check(status_is(call(ProtoCommand::SetPid, ProtoClient::argsPid(-1, 0, 0)), ProtoStatus::BadValue),
+              "SetPid with a negative gain is rejected");
+
+        check(status_is(call(static_cast<ProtoCommand>(0x3F)), ProtoStatus::UnknownCommand), "unknown command");
+    }
+
+    void check_framing() {
+        const uint32_t errors = app.proto->stats().errors;
+
+        // Испорченный байт: кадр отбрасывается без ответа, следующий запрос проходит
+        uint8_t seq;
+        auto frame = client.request(ProtoCommand::GetSetpoint, {}, seq);
+        frame[3] ^= 0x10;
+        send(frame);
+        check(!wait(seq, 50) && app.proto->stats().errors == errors + 1, "corrupted frame is dropped and counted");
+        check(setpoint_of(call(ProtoCommand::GetSetpoint)) == 455, "next frame after a corrupted one is answered");
+
+        // Оборванный кадр (нет конца и закрывающего нуля): следующий кадр всё равно разбирается
+        auto cut = client.request(ProtoCommand::GetSetpoint, {}, seq);
+        cut.resize(cut.size() - 3);
+        send(cut);
+        run_for_ms(5);
+        check(setpoint_of(call(ProtoCommand::GetSetpoint)) == 455, "frame after a truncated one is answered");
+
+        // Одна посылка делится паузой посередине: разбор продолжается с того же места
+        auto split = client.request(ProtoCommand::GetSetpoint, {}, seq);
+        send({split.begin(), split.begin() + static_cast<long>(split.size() / 2)});
+        run_for_ms(10);
+        send({split.begin() + static_cast<long>(split.size() / 2), split.end()});
+        check(setpoint_of(wait(seq)) == 455, "frame split across two bursts");
+
+        // Пачка запросов подряд: ответы ждут места в кольце передачи, но не теряются
+        std::vector<uint8_t> burst;
+        uint8_t seqs[12];
+        for (auto &s: seqs) {
+            const auto f = client.request(ProtoCommand::GetPid, {}, s);
+            burst.insert(burst.end(), f.begin(), f.end());
+        }
+        send(burst);
+        size_t answered = 0;
+        for (uint8_t s: seqs) answered += status_is(wait(s), ProtoStatus::Ok);
+        check(answered == 12, "12 back-to-back requests are all answered");
+    }
+
+    void check_keys() {
+        // '1' вне кадра — нажатие S1: уставка на шаг ниже
+        host::uart_rx("1");
+        run_for_ms(500);
+        check(setpoint_of(call(ProtoCommand::GetSetpoint)) == 450, "key '1' outside frames still presses S1");
+
+        // Одиночный 0x00 (помеха), мусор и 0x00: испорченный кадр, после него '1' — снова клавиша
+        const uint32_t errors = app.proto->stats().errors;
+        const uint8_t noise[] = {0x00, 0x13, 0x37, 0x42, 0x00, '1'};
+        host::uart_rx(noise, sizeof(noise));
+        run_for_ms(500);
+        check(app.proto->stats().errors == errors + 1 && setpoint_of(call(ProtoCommand::GetSetpoint)) == 445,
+              "after a stray 0x00 and garbage, key '1' presses S1 again");
+    }
+
+    void check_telemetry() {
+        check(status_is(call(ProtoCommand::Subscribe, ProtoClient::argsU16(10)), ProtoStatus::BadValue),
+              "Subscribe below the minimum period is rejected");
+
+        client.telemetry().clear();
+        check(status_is(call(ProtoCommand::Subscribe, ProtoClient::argsU16(100)), ProtoStatus::Ok), "Subscribe 100 ms");
+        const uint64_t start_us = host::now_us();
+        run_for_ms(3000);
+        const double seconds = static_cast<double>(host::now_us() - start_us) / 1e6;
+        const size_t frames = client.telemetry().size();
+
+        bool ordered = frames > 0;
+        for (size_t i = 1; i < frames; ++i) {
+            const auto &a = client.telemetry()[i - 1];
+            const auto &b = client.telemetry()[i];
+            ordered = ordered && static_cast<uint16_t>(a.seq + 1) == b.seq && b.ms - a.ms == 100;
+        }
+        check(frames >= 29 && frames <= 31, "about 10 telemetry frames per second");
+        check(ordered && client.stats().telemetryLost == 0, "telemetry numbers and timestamps are consecutive");
+        check(frames && client.telemetry().back().setpoint == 445, "telemetry carries the setpoint");
+
+        // Слагаемые последнего шага PID: сумма P + I + D до ограничения даёт мощность.
+        // Кадр в пути мог разминуться с шагом PID (раз в секунду) — тогда сверяем следующий
+        bool terms_ok = false;
+        for (int n = 0; n < 3 && !client.telemetry().empty() && !terms_ok; ++n) {
+            const auto &t = client.telemetry().back();
+            const auto &pid = app.ctrl->getPid().lastTerms();
+            terms_ok = t.p == pid.p && t.i == pid.i && t.d == pid.d && t.error == pid.error;
+            const size_t seen = client.telemetry().size();
+            for (int ms = 0; !terms_ok && client.telemetry().size() == seen && ms < 200; ++ms) run_for_ms(1);
+        }
+        check(terms_ok, "telemetry carries the PID terms");
+
+        // Пачка запросов занимает линию: снимки ждут в кольце с исходными метками времени
+        check(status_is(call(ProtoCommand::Subscribe, ProtoClient::argsU16(PROTOCOL_TELEMETRY_MIN_PERIOD_MS)),
+                        ProtoStatus::Ok), "Subscribe at the minimum period");
+        client.telemetry().clear();
+        const uint32_t lost = client.stats().telemetryLost;
+        for (int burst = 0; burst < 5; ++burst) {
+            std::vector<uint8_t> requests;
+            uint8_t seq;
+            for (int n = 0; n < 12; ++n) {
+                const auto f = client.request(ProtoCommand::GetInfo, {}, seq);
+                requests.insert(requests.end(), f.begin(), f.end());
+            }
+            send(requests);
+            run_for_ms(200);
+        }
+        const size_t busy = client.telemetry().size();
+        bool exact = busy >= 19;
+        for (size_t i = 1; i < busy; ++i) {
+            const auto &a = client.telemetry()[i - 1];
+            const auto &b = client.telemetry()[i];
+            exact = exact && static_cast<uint16_t>(a.seq + 1) == b.seq && b.ms - a.ms == PROTOCOL_TELEMETRY_MIN_PERIOD_MS;
+        }
+        check(exact && client.stats().telemetryLost == lost && app.telemetry->stats().dropped == 0,
+              "telemetry stays exact while replies fill the line");
+
+        check(status_is(call(ProtoCommand::Subscribe, ProtoClient::argsU16(0)), ProtoStatus::Ok), "Subscribe 0 stops telemetry");
+        client.telemetry().clear();
+        run_for_ms(500);
+        check(client.telemetry().empty(), "no telemetry after unsubscribing");
+
+        std::printf("BENCH telemetry_frames_per_s %.1f\n", frames / seconds);
+    }
+
+    void bench_roundtrip() {
+        // Время от первого байта запроса до последнего байта ответа (модельное)
+        const uint64_t start_us = host::now_us();
+        constexpr int Calls = 20;
+        for (int i = 0; i < Calls; ++i) call(ProtoCommand::GetSetpoint);
+        std::printf("BENCH roundtrip_ms %.2f\n", static_cast<double>(host::now_us() - start_us) / 1000.0 / Calls);
+    }
+}
+
+int main() {
+    host::reset();
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+    run_for_ms(200);
+
+    check_log();
+    check_commands();
+    check_framing();
+    check_keys();
+    check_telemetry();
+    bench_roundtrip();
+
+    const auto &stats = app.proto->stats();
+    std::printf("firmware: %u frames, %u errors, %u replies dropped; client: %u frames, %u errors\n",
+                stats.frames, stats.errors, stats.txDropped, client.stats().frames, client.stats().errors);
+    check(stats.txDropped == 0 && client.stats().errors == 0, "no replies dropped, no corrupted frames from the firmware");
+    check(!host::iwdg_expired(), "watchdog never expired");
+
+    return checks::finish();
+}
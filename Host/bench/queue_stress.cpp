@@ -0,0 +1,118 @@
+/**
+ * @file queue_stress.cpp
+ * @brief Нагрузочная проверка EventQueue: потоки хоста вместо прерываний-источников
+ *
+ * Использование: stm32f0_basic_queue_stress [событий на источник]
+ *   по умолчанию 20000 (доли секунды); долгий прогон — например, 2000000
+ *
+ * Три потока пишут через pushFromIsr() (Usart, Timer, Twi) так же, как это делали бы
+ * обработчики прерываний, основной поток пишет через push() и разбирает очередь pop().
+ * Каждое событие несёт номер в своём источнике; при полном кольце писатель
+ * повторяет попытку. Проверяется, что каждое принятое событие получено ровно
+ * один раз и в порядке отправки, а сумма pushed в счётчиках совпадает с полученным.
+ * Повторы при полном кольце писатели считают сами и печатают отдельно от dropped
+ * очереди (каждый отказ push() очередь учитывает как потерю — числа должны совпасть).
+ *
+ * Код возврата 0 — потерь и повторов нет.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Event.hpp"
+
+namespace {
+    constexpr uint8_t Sources = EventQueue::Sources;
+
+    /// Источник кодируется типом события, номер — значением
+    EventType type_of(uint8_t src) {
+        return static_cast<EventType>(static_cast<uint8_t>(EventType::ButtonS1) + src);
+    }
+
+    EventQueue queue;
+    std::atomic<bool> start{false};
+    /// Повторов push() при полном кольце, по источникам (считают сами писатели)
+    std::atomic<long> retries[Sources] = {};
+}
+
+int main(int argc, char **argv) {
+    const long count = argc > 1 ? std::atol(argv[1]) : 20'000;
+
+    std::vector<std::thread> isrs;
+    for (uint8_t src = 1; src < Sources; ++src) {
+        isrs.emplace_back([src, count] {
+            while (!start.load()) std::this_thread::yield();
+            for (long seq = 0; seq < count; ++seq) {
+                const Event ev{type_of(src), static_cast<int>(seq)};
+                while (!queue.pushFromIsr(static_cast<EventSource>(src), ev)) {
+                    retries[src].fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    long expected[Sources] = {};
+    long errors = 0;
+    long main_sent = 0;
+    long received = 0;
+    const long total = count * Sources;
+
+    start.store(true);
+
+    while (received < total) {
+        // Основной цикл сам тоже пишет в очередь, как TimerWheel и кнопки
+        if (main_sent < count) {
+            if (queue.push({type_of(0), static_cast<int>(main_sent)})) ++main_sent;
+            else retries[0].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto ev = queue.pop();
+        if (!ev) {
+            std::this_thread::yield();   // Очередь пуста — как WFI до следующего прерывания
+            continue;
+        }
+        ++received;
+
+        const auto src = static_cast<uint8_t>(static_cast<uint8_t>(ev->type) - static_cast<uint8_t>(EventType::ButtonS1));
+        if (src >= Sources) {
+            ++errors;
+            continue;
+        }
+        if (ev->value != expected[src]) {
+            if (errors < 10) {
+                std::printf("source %u: got #%d, expected #%ld\n", src, ev->value, expected[src]);
+            }
+            ++errors;
+            expected[src] = ev->value;
+        }
+        ++expected[src];
+    }
+
+    for (auto &t: isrs) t.join();
+
+    const bool leftovers = !queue.empty();
+    const auto stats = queue.stats();
+
+    std::printf("queue stress: %u sources x %ld events, received %ld\n", Sources, count, received);
+    long retries_total = 0;
+    bool counted = true;
+    for (uint8_t src = 0; src < Sources; ++src) {
+        const auto &s = queue.stats(static_cast<EventSource>(src));
+        const long r = retries[src].load();
+        std::printf("  source %u: pushed %u, full-ring retries %ld, dropped %u, high watermark %u\n",
+                    src, s.pushed, r, s.dropped, s.highWatermark);
+        retries_total += r;
+        counted &= s.dropped == static_cast<uint32_t>(r);
+    }
+    std::printf("BENCH queue_stress_retries %ld\n", retries_total);
+    std::printf("BENCH queue_stress_dropped %u\n", stats.dropped);
+    if (!counted) std::printf("dropped in the queue stats differs from the writers' retries\n");
+
+    const bool ok = errors == 0 && !leftovers && counted && stats.pushed == static_cast<uint32_t>(total);
+    std::printf("%s: %ld order errors, %s\n", ok ? "OK" : "FAIL", errors, leftovers ? "events left in queue" : "queue drained");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file render_bench.cpp
+ * @brief Отрисовка строки в RAM HT1621B: таблица глифов и образы против прежнего switch
+ *
+ * Использование: stm32f0_basic_render_bench [повторов]
+ *
+ * Прежний путь (копия кода до таблицы глифов): ClearSegArea(), ShowString() с разбором
+ * символа через switch и записью сегментов по одному, ShowDot(). Новые:
+ * - string — ShowString() (Render() во время выполнения и ShowImage()) и ShowDot();
+ * - image — как Controller::displayTemperature: образ надписи "t1" из компиляции,
+ *   три Put(), Dot() и ShowImage().
+ *
+ * Сначала проверяется, что все три пути дают одинаковую RAM (стекло модели после
+ * Present() сравнивается с копией прежнего кода): температуры -9.9..99.9 и случайные
+ * строки из всех символов таблицы, пробела и символов без глифа. Затем каждый путь
+ * рисует тот же набор температур [повторов] раз; печатается среднее на одну
+ * отрисовку в единицах host_cycle_stamp() (вывод на индикатор — вне замера).
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "ht1621.hpp"
+#include "IntFormat.hpp"
+
+App app{};
+
+namespace {
+    using checks::check;
+
+    //=========================================================================
+    // Прежняя отрисовка HT1621B (switch по символу, сегменты по одному)
+    //=========================================================================
+
+    struct LegacyVram {
+        uint8_t vram[32] = {};
+        uint32_t dirty = 0;
+
+        void store(uint8_t address, uint8_t data) {
+            if (vram[address] == data) return;
+            vram[address] = data;
+            dirty |= 1UL << address;
+        }
+
+        void clearSegArea() {
+            for (uint8_t i = 1; i <= 6 * 4; ++i) {
+                if (i == 0x17)
+                    store(i, vram[i] & ~0b01);
+                else
+                    store(i, 0);
+            }
+        }
+
+        void showDot(uint8_t position) {
+            if (position == 0 || position >= 6) return;
+            const uint8_t addr = static_cast<uint8_t>((5 - position) * 4 + 3);
+            store(addr, vram[addr] | 0x02);
+        }
+
+        void showDigit(uint8_t position, uint8_t digit) {
+            const uint8_t base = (5 - position) * 4;
+            for (const auto &seg: Ht1621Glyphs::Digits[digit]) {
+                if (seg.addr == 0) break;
+                store(seg.addr + base, seg.val);
+            }
+        }
+
+        void showLetter(uint8_t position, char c) {
+            const uint8_t base = (5 - position) * 4;
+            const Ht1621Glyphs::Segment *segs = nullptr;
+            const auto &l = Ht1621Glyphs::Letters;
+            switch (c) {
+                case 'A': segs = l[0]; break;
+                case 'b': segs = l[1]; break;
+                case 'C': segs = l[2]; break;
+                case 'd': segs = l[3]; break;
+                case 'E': segs = l[4]; break;
+                case 'F': segs = l[5]; break;
+                case 'G': segs = l[6]; break;
+                case 'h': segs = l[7]; break;
+                case 'I': segs = l[8]; break;
+                case 'J': segs = l[9]; break;
+                case 'L': segs = l[10]; break;
+                case 'n': segs = l[11]; break;
+                case 'o': segs = l[12]; break;
+                case 'P': segs = l[13]; break;
+                case 'r': segs = l[14]; break;
+                case 't': segs = l[15]; break;
+                case 'U': segs = l[16]; break;
+                case 'X': segs = l[17]; break;
+                case '-': segs = l[18]; break;
+                case '_': segs = l[19]; break;
+                default: return;
+            }
+            for (uint8_t i = 0; i < 4; ++i) {
+                if (segs[i].val) store(segs[i].addr + base, segs[i].val);
+            }
+        }
+
+        void showString(const char *str) {
+            clearSegArea();
+            uint8_t len = 0;
+            while (str[len] && len < 6) len++;
+            for (uint8_t i = 0; i < len; ++i) {
+                const char c = str[len - 1 - i];
+                if (c >= '0' && c <= '9') showDigit(i, c - '0');
+                else showLetter(i, c);
+            }
+        }
+    };
+
+    /// Строка "t1 xx.x" как у Controller::displayTemperature (value в десятых, -99..999)
+    void temperature_text(int value, char *text) {
+        const bool negative = value < 0;
+        const auto magnitude = static_cast<uint32_t>(negative ? -value : value);
+        uint32_t frac, ones;
+        const uint32_t whole = IntFormat::div10(magnitude, frac);
+        const uint32_t tens = IntFormat::div10(whole, ones);
+        text[0] = 't';
+        text[1] = '1';
+        text[2] = ' ';
+        text[3] = negative ? '-' : static_cast<char>('0' + tens);
+        text[4] = static_cast<char>('0' + (negative && whole >= 10 ? tens : ones));
+        text[5] = static_cast<char>('0' + frac);
+        text[6] = '\0';
+    }
+
+    constexpr HT1621B::SegImage LabelT1 = HT1621B::Render("t1    ");
+
+    /// Путь Controller::displayTemperature
+    void show_temperature_image(HT1621B &display, int value) {
+        const bool negative = value < 0;
+        const auto magnitude = static_cast<uint32_t>(negative ? -value : value);
+        uint32_t frac, ones;
+        const uint32_t whole = IntFormat::div10(magnitude, frac);
+        const uint32_t tens = IntFormat::div10(whole, ones);
+
+        HT1621B::SegImage image = LabelT1;
+        if (negative) {
+            image.Put(2, '-');
+            image.Put(1, static_cast<char>('0' + (whole < 10 ? ones : tens)));
+        } else {
+            image.Put(2, static_cast<char>('0' + tens));
+            image.Put(1, static_cast<char>('0' + ones));
+        }
+        image.Put(0, static_cast<char>('0' + frac)).Dot(1);
+        display.ShowImage(image);
+    }
+
+    bool glass_matches(HT1621B &display, const LegacyVram &legacy) {
+        display.Present();
+        return std::memcmp(host::lcd_ram(), legacy.vram, sizeof(legacy.vram)) == 0;
+    }
+
+    void check_correctness(HT1621B &display) {
+        LegacyVram legacy;
+        display.Invalidate();
+        display.FullClear(true);
+
+        bool strings_ok = true, images_ok = true;
+        char text[7];
+        for (int v = -99; v <= 999; ++v) {
+            temperature_text(v, text);
+            legacy.showString(text);
+            legacy.showDot(1);
+
+            display.ShowString(text);
+            display.ShowDot(1, true);
+            strings_ok &= glass_matches(display, legacy);
+
+            display.FullClear();
+            show_temperature_image(display, v);
+            images_ok &= glass_matches(display, legacy);
+        }
+        check(strings_ok, "ShowString(): same RAM as the switch-based renderer for -9.9..99.9");
+        check(images_ok, "compile-time label image: same RAM as ShowString()");
+
+        // Все символы таблицы, пробел, символы без глифа и строки короче 6
+        static constexpr char Alphabet[] = "0123456789AbCdEFGhIJLnoPrtUX-_ ?aZ*";
+        std::mt19937 rng(1234);
+        bool random_ok = true;
+        for (int i = 0; i < 20000; ++i) {
+            const uint8_t len = 1 + rng() % 6;
+            for (uint8_t k = 0; k < len; ++k) text[k] = Alphabet[rng() % (sizeof(Alphabet) - 1)];
+            text[len] = '\0';
+            legacy.showString(text);
+            display.ShowString(text);
+            random_ok &= glass_matches(display, legacy);
+        }
+        check(random_ok, "random strings over the whole glyph set render identically");
+        check(Ht1621Glyphs::of('t') && !Ht1621Glyphs::of(' ') && !Ht1621Glyphs::of('\x80'),
+              "glyph table: letters packed, blanks and non-ASCII are empty");
+    }
+
+    constexpr size_t ValueCount = 64;
+    int values[ValueCount];
+    char texts[ValueCount][7];
+    LegacyVram legacy_bench;   ///< Вне main(): записи в RAM не выбросит оптимизатор
+
+    template<typename F>
+    void bench(const char *name, long repeats, F &&render) {
+        const uint32_t start = host_cycle_stamp();
+        for (long r = 0; r < repeats; ++r) {
+            for (size_t i = 0; i < ValueCount; ++i) render(i);
+        }
+        const uint32_t stamp = host_cycle_stamp() - start;
+
+        const double renders = static_cast<double>(repeats) * ValueCount;
+        std::printf("  %-8s %8.1f per render\n", name, stamp / renders);
+        std::printf("BENCH render_%s %.1f\n", name, stamp / renders);
+    }
+}
+
+int main(int argc, char **argv) {
+    const long repeats = argc > 1 ? std::atol(argv[1]) : 20000;
+
+    host::reset();
+    HT1621B display;
+
+    check_correctness(display);
+
+    std::mt19937 rng(4321);
+    for (size_t i = 0; i < ValueCount; ++i) {
+        values[i] = static_cast<int>(rng() % 1099) - 99;
+        temperature_text(values[i], texts[i]);
+    }
+
+    std::printf("render bench: %ld repeats of %zu temperatures, unit %s\n", repeats, ValueCount,
+                host::cycle_stamp_unit());
+
+    bench("legacy", repeats, [&](size_t i) {
+        legacy_bench.clearSegArea();   // Controller::displayTemperature очищал область и перед ShowString()
+        legacy_bench.showString(texts[i]);
+        legacy_bench.showDot(1);
+    });
+    bench("string", repeats, [&](size_t i) {
+        display.ShowString(texts[i]);
+        display.ShowDot(1, true);
+    });
+    bench("image", repeats, [&](size_t i) { show_temperature_image(display, values[i]); });
+
+    return checks::finish();
+}
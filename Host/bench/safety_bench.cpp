@@ -0,0 +1,141 @@
+/**
+ * @file safety_bench.cpp
+ * @brief Задержка от разбора ответа DS18B20 до отключения нагревателя при потоке кнопок
+ *
+ * Использование: stm32f0_basic_safety_bench[_single_lane] [секунды] [квант мкс] [период мс]
+ *   секунды — модельное время прогона (по умолчанию 30)
+ *   квант   — модельное время одной итерации app_loop (по умолчанию 1000: медленный
+ *             цикл, за который по UART приходит больше нажатий, чем разбирается за проход)
+ *   период  — период измерений DS18B20 (по умолчанию 1003: не кратен 10 мс пачек кнопок,
+ *             фаза разбора сдвигается на 3 мс за измерение)
+ *
+ * По UART без пауз идут клавиши '3'/'4' (ButtonS3/S4: только звук), так что
+ * обычные кольца EventQueue заполнены. Температура датчика каждые 2 с
+ * переключается между «нагрев» (уставка - 5 °C) и «перегрев» (уставка + 5 °C).
+ * Для каждого перехода в перегрев замеряется время от прохода app_loop, в котором
+ * драйвер разобрал первое горячее измерение, до прохода, после которого TIM3->CCR1 = 0.
+ *
+ * Вариант _single_lane собран с EVENT_QUEUE_SINGLE_LANE (TemperatureReady в общем
+ * кольце наравне с кнопками). Строки "BENCH <метрика> <значение>" — для сравнения.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+
+App app{};
+
+namespace {
+    bool heater_off() {
+        return TIM3->CCR1 == 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 30.0;
+    const uint64_t quantum_us = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    const auto period_ms = static_cast<uint32_t>(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1003);
+
+    host::reset();
+
+    const int normal = CONTROLLER_SETPOINT_DEFAULT - 50;
+    const int overheat = CONTROLLER_SETPOINT_DEFAULT + 50;
+    host::ds18b20_set_temperature(normal);
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+    // Период не кратен пачкам кнопок: разбор измерения каждый раз в другой фазе пачки,
+    // в том числе при полном обычном кольце (с кратным периодом — всегда в одной и той же)
+    app.sensor->setSamplePeriod(period_ms);
+    app.queue->resetStats();
+
+    std::string flood;
+    for (int i = 0; i < 100; ++i) flood.push_back(i % 2 ? '4' : '3');
+
+    const auto end_us = static_cast<uint64_t>(seconds * 1e6);
+    uint64_t next_flood_us = 0;
+    uint64_t next_switch_us = 2'000'000;
+    bool hot = false;
+
+    // Текущий замер: какое по счёту разобранное измерение первым увидит перегрев
+    uint32_t conversions_at_switch = 0;
+    uint32_t hot_sample = 0;          ///< 0 — ещё не известно
+    uint64_t decoded_us = 0;
+    bool waiting_decode = false;
+    bool waiting_cutoff = false;
+
+    uint32_t trials = 0;
+    uint64_t worst_us = 0;
+    uint64_t total_us = 0;
+
+    while (host::now_us() < end_us) {
+        if (host::now_us() >= next_flood_us) {
+            host::uart_rx(flood.c_str());
+            next_flood_us += 10'000;
+        }
+
+        if (host::now_us() >= next_switch_us) {
+            hot = !hot;
+            host::ds18b20_set_temperature(hot ? overheat : normal);
+            next_switch_us += 2'000'000;
+
+            waiting_decode = hot;
+            waiting_cutoff = false;
+            hot_sample = 0;
+            conversions_at_switch = host::ds18b20_conversions();
+        }
+
+        // Преобразование с новой температурой началось: его разбор — следующее измерение драйвера
+        if (waiting_decode && !hot_sample && host::ds18b20_conversions() != conversions_at_switch) {
+            hot_sample = app.sensor->getSampleCount() + 1;
+        }
+
+        app_loop(app);
+
+        if (waiting_decode && hot_sample && app.sensor->getSampleCount() >= hot_sample) {
+            waiting_decode = false;
+            waiting_cutoff = true;
+            decoded_us = host::now_us();
+        }
+
+        if (waiting_cutoff && heater_off()) {
+            const uint64_t latency = host::now_us() - decoded_us;
+            waiting_cutoff = false;
+            ++trials;
+            total_us += latency;
+            if (latency > worst_us) worst_us = latency;
+        }
+
+        host::advance_us(quantum_us);
+    }
+
+    const auto critical = app.queue->stats(EventLane::Critical);
+    const auto normal_lane = app.queue->stats(EventLane::Normal);
+
+    std::printf("safety bench: %.1f s simulated, quantum %llu us, sample period %u ms, UART flood 100 keys / 10 ms\n",
+                seconds, static_cast<unsigned long long>(quantum_us), static_cast<unsigned>(period_ms));
+    std::printf("critical lane: %u pushed, %u coalesced, %u dropped\n",
+                critical.pushed, critical.coalesced, critical.dropped);
+    std::printf("normal lane:   %u pushed, %u dropped, high watermark %u\n",
+                normal_lane.pushed, normal_lane.dropped, normal_lane.highWatermark);
+    std::printf("decode -> heater off: %u overheat events, avg %.1f us, worst %llu us%s\n",
+                trials, trials ? static_cast<double>(total_us) / trials : 0.0,
+                static_cast<unsigned long long>(worst_us), waiting_cutoff ? " (last one never cut off)" : "");
+
+    std::printf("BENCH cutoff_trials %u\n", trials);
+    std::printf("BENCH cutoff_worst_us %llu\n", static_cast<unsigned long long>(worst_us));
+    std::printf("BENCH normal_dropped %u\n", normal_lane.dropped);
+
+    return host::iwdg_expired() ? 1 : 0;
+}
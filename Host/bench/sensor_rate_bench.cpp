@@ -0,0 +1,226 @@
+/**
+ * @file sensor_rate_bench.cpp
+ * @brief DS18B20: разрешение 9..12 бит, ожидание преобразования по разрешению, частота измерений
+ *
+ * Использование: stm32f0_basic_sensor_rate_bench [циклов]
+ *
+ * Один датчик на шине модели, преобразование в модели длится ConversionPercent % от
+ * наихудшего tCONV разрешения (как у реальных датчиков, которые обычно быстрее паспорта).
+ * Проверяется:
+ * - для каждого разрешения драйвер записывает конфигурацию (Write Scratchpad), значение
+ *   квантуется с шагом разрешения (0.5 °C при 9 битах), цикл без паузы — tCONV разрешения
+ *   + обмен, а не 750 мс; с DS18B20_POLL_CONVERSION — по готовности, короче tCONV;
+ * - период 100 мс при 9 битах: 10 измерений в секунду с опросом готовности; с ожиданием
+ *   наихудшего времени цикл не короче tCONV + обмен (93.75 + ~13 мс, около 9.4 Гц);
+ * - смена разрешения на ходу не даёт ошибок, новое записывается к следующему циклу;
+ * - сброс питания датчика (12 бит и +85 °C): одна SensorError, не 85.0, затем разрешение
+ *   записывается снова;
+ * - PID на 10 Гц накапливает интеграл так же, как на 1 Гц (остаток error * dt не теряется).
+ *
+ * Печатается цикл (мс времени модели) по разрешениям и частота при периоде 100 мс.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+#include "config.h"
+#include "AppContext.hpp"
+#include "hardware_init.hpp"
+#include "ds18b20.hpp"
+#include "Event.hpp"
+#include "PID.hpp"
+
+App app{};
+
+namespace {
+    /// Шаг основного цикла в модели (мкс): задержка реакции poll() на конец операции TIM1
+    constexpr uint64_t PollStepUs = 50;
+    /// Преобразование в модели: доля наихудшего времени разрешения
+    constexpr uint8_t ConversionPercent = 80;
+    /// Температура датчика (десятые °C): 23.7 различается при 9/11/12 битах
+    constexpr int Tenths = 237;
+    /// Начало цикла: reset и Skip ROM + Convert T; чтение: reset, Match ROM + Read Scratchpad, 72 слота
+    constexpr double StartMs = 1.0 + 16 * 0.062 + 1.0;
+    constexpr double ReadMaxMs = 1.0 + (80 + 72) * 0.062 + 2.0;
+
+    using checks::check;
+
+    struct Sample {
+        uint64_t us;
+        Event event;
+    };
+
+    /// Наихудшее время преобразования разрешения (мс)
+    double conversion_ms(uint8_t bits) { return 93.75 * (1 << (bits - 9)); }
+
+    /// Что вернёт датчик с разрешением bits: младшие биты ниже разрешения — нули
+    int16_t decoded(int tenths, uint8_t bits) {
+        auto raw = static_cast<int16_t>(tenths * 16 / 10);
+        raw = static_cast<int16_t>(raw & ~((1 << (12 - bits)) - 1));
+        return static_cast<int16_t>((raw * 10) >> 4);
+    }
+
+    void setup() {
+        host::reset();
+        __disable_irq();
+        hardware_init(app);
+        __enable_irq();
+
+        host::ds18b20_set_count(1);
+        host::ds18b20_set_temperature(0, Tenths);
+        host::ds18b20_set_conversion_percent(ConversionPercent);
+        while (app.queue->pop()) {}
+    }
+
+    /// Основной цикл без app_loop: только драйвер датчика и очередь
+    std::vector<Sample> run(DS18B20 &sensor, double ms) {
+        std::vector<Sample> out;
+        const uint64_t end = host::now_us() + static_cast<uint64_t>(ms * 1000);
+        while (host::now_us() < end) {
+            sensor.poll();
+            while (auto ev = app.queue->pop()) out.push_back({host::now_us(), *ev});
+            host::advance_us(PollStepUs);
+        }
+        return out;
+    }
+
+    struct Summary {
+        std::vector<uint64_t> times;   ///< Моменты TemperatureReady
+        std::vector<int> values;
+        std::vector<int> errors;       ///< Коды SensorError
+    };
+
+    Summary summarize(const std::vector<Sample> &samples) {
+        Summary s;
+        for (const auto &e: samples) {
+            if (e.event.type == EventType::TemperatureReady) {
+                s.times.push_back(e.us);
+                s.values.push_back(e.event.value);
+            } else if (e.event.type == EventType::SensorError) {
+                s.errors.push_back(e.event.value);
+            }
+        }
+        return s;
+    }
+
+    /// Средний интервал между измерениями (мс), без первого (он включает поиск и запись)
+    double mean_cycle_ms(const std::vector<uint64_t> &t) {
+        return t.size() > 2 ? (t.back() - t[1]) / 1000.0 / static_cast<double>(t.size() - 2) : 0.0;
+    }
+
+    bool all_equal(const std::vector<int> &values, int expected) {
+        bool ok = !values.empty();
+        for (int v: values) ok &= v == expected;
+        return ok;
+    }
+
+    void resolution(uint8_t bits, long cycles) {
+        setup();
+        DS18B20 sensor{};
+        sensor.setResolution(bits);
+        sensor.setSamplePeriod(0);
+        sensor.init();
+
+        const double tconv = conversion_ms(bits);
+        const Summary s = summarize(run(sensor, 20.0 + (cycles + 0.5) * (StartMs + tconv + ReadMaxMs)));
+        const double cycle_ms = mean_cycle_ms(s.times);
+        std::printf("%u bit: %zu samples, cycle %.1f ms (tCONV %.1f ms, sensor done after %.1f ms)\n",
+                    bits, s.times.size(), cycle_ms, tconv, tconv * ConversionPercent / 100);
+        std::printf("BENCH ds18b20_%ubit_cycle_ms %.1f\n", bits, cycle_ms);
+
+        char what[128];
+        std::snprintf(what, sizeof(what), "  configuration written: the sensor converts at %u bits", bits);
+        check(host::ds18b20_resolution(0) == bits && sensor.getResolution() == bits, what);
+        std::snprintf(what, sizeof(what), "  %ld+ samples, no errors, value quantized to %u bits (%d)",
+                      cycles, bits, decoded(Tenths, bits));
+        check(static_cast<long>(s.times.size()) >= cycles && s.errors.empty() &&
+              all_equal(s.values, decoded(Tenths, bits)), what);
+
+#if defined DS18B20_POLL_CONVERSION
+        // Готовность по слоту чтения: не позже шага опроса после конца преобразования
+        const double ready_ms = tconv * ConversionPercent / 100;
+        check(cycle_ms > ready_ms && cycle_ms <= ready_ms + DS18B20_POLL_STEP_MS + StartMs + ReadMaxMs,
+              "  cycle: conversion polled to completion, shorter than tCONV");
+#else
+        check(cycle_ms >= tconv && cycle_ms <= tconv + StartMs + ReadMaxMs,
+              "  cycle: tCONV of the resolution + exchange, not 750 ms");
+#endif
+    }
+
+    void rate() {
+        setup();
+        DS18B20 sensor{};
+        sensor.setResolution(9);
+        sensor.setSamplePeriod(100);
+        sensor.init();
+
+        constexpr double PeriodMs = 100.0;
+        const Summary s = summarize(run(sensor, 2000.0));
+        const double cycle_ms = mean_cycle_ms(s.times);
+        const double hz = cycle_ms > 0 ? 1000.0 / cycle_ms : 0.0;
+        std::printf("9 bit, period 100 ms: %.2f Hz, cycle %.1f ms\n", hz, cycle_ms);
+        std::printf("BENCH ds18b20_9bit_rate_hz %.2f\n", hz);
+#if defined DS18B20_POLL_CONVERSION
+        // Датчик готов за 75 мс: цикл укладывается в период
+        const double busy_ms = PeriodMs;
+#else
+        const double busy_ms = StartMs + conversion_ms(9) + ReadMaxMs;
+#endif
+        check(s.errors.empty() && cycle_ms >= PeriodMs - 1.0 && cycle_ms <= (busy_ms > PeriodMs ? busy_ms : PeriodMs) + 1.0,
+              "  sample period 100 ms: one sample per period or per conversion + exchange, no errors");
+
+        // Смена разрешения на ходу: текущее преобразование дочитывается как было
+        sensor.setResolution(12);
+        sensor.setSamplePeriod(0);
+        Summary c = summarize(run(sensor, 2 * (StartMs + conversion_ms(12) + ReadMaxMs) + 100.0));
+        check(c.errors.empty() && host::ds18b20_resolution(0) == 12 && !c.values.empty() &&
+              c.values.back() == decoded(Tenths, 12),
+              "  resolution changed on the fly: no errors, 12 bits from the next cycle");
+        sensor.setResolution(9);
+        sensor.setSamplePeriod(100);
+        run(sensor, conversion_ms(12) + 200.0);
+
+        // Сброс питания: датчик снова 12 бит и +85 °C, в EEPROM конфигурации нет
+        host::ds18b20_power_cycle(0);
+        c = summarize(run(sensor, 1000.0));
+        bool no_85 = true;
+        for (int v: c.values) no_85 &= v == decoded(Tenths, 9);
+        check(c.errors.size() == 1 && c.errors[0] == DS18B20::TEMP_ERROR_GENERIC && no_85,
+              "  power glitch: one SensorError (readback mismatch), never the 85.0 reset value");
+        check(host::ds18b20_resolution(0) == 9 && c.values.size() >= 5,
+              "  ... then the resolution is written again and sampling resumes");
+    }
+
+    void pid_rate() {
+        // Один шаг 1000 мс против десяти шагов 100 мс при ошибке 0.3 °C: интеграл одинаковый
+        PIDInt slow(0, PIDInt::SCALE, 0, -1000, 1000, -5000, 5000, 1000);
+        PIDInt fast(0, PIDInt::SCALE, 0, -1000, 1000, -5000, 5000, 1000);
+        slow.update(253, 250, 1000);
+        for (int i = 0; i < 10; ++i) fast.update(253, 250, 100);
+        std::printf("PID integral: 1 x 1000 ms -> %ld, 10 x 100 ms -> %ld\n",
+                    static_cast<long>(slow.lastTerms().i), static_cast<long>(fast.lastTerms().i));
+        check(slow.lastTerms().i == 3 && fast.lastTerms().i == 3, "PID at 10 Hz integrates small errors like at 1 Hz");
+    }
+}
+
+int main(int argc, char **argv) {
+    const long cycles = argc > 1 ? std::atol(argv[1]) : 8;
+
+#if defined DS18B20_POLL_CONVERSION
+    std::printf("sensor rate bench (conversion polled, step %u ms): %ld cycles per resolution\n",
+                static_cast<unsigned>(DS18B20_POLL_STEP_MS), cycles);
+#else
+    std::printf("sensor rate bench (worst-case conversion wait): %ld cycles per resolution\n", cycles);
+#endif
+    for (uint8_t bits = 9; bits <= 12; ++bits) resolution(bits, cycles);
+    rate();
+    pid_rate();
+
+    return checks::finish();
+}
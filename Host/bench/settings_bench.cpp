@@ -0,0 +1,224 @@
+/**
+ * @file settings_bench.cpp
+ * @brief Settings на модели 24C32 (I2C1): сохранение, загрузка, обрыв записи, износ страниц
+ *
+ * Использование: stm32f0_basic_settings_bench [оборотов по слотам]
+ *
+ * Прошивка целиком (hardware_init/services_init, app_loop), к I2C1 подключена модель
+ * EEPROM со страницами SETTINGS_EEPROM_PAGE и циклом записи 5 мс. «Перезагрузка» —
+ * новый экземпляр Settings над тем же Controller с уже сброшенными значениями.
+ *
+ * Печатается:
+ * - settings_boot_ms — загрузка (двоичный поиск по заголовкам слотов), settings_full_scan_ms —
+ *   чтение всей EEPROM одной транзакцией (столько занял бы перебор всех записей);
+ * - settings_page_writes_max / settings_page_writes_min — наибольшее и наименьшее число
+ *   циклов записи одной страницы после всех сохранений (без ротации все сохранения
+ *   пришлись бы на одну страницу: settings_saves).
+ *
+ * Обрывы записи: испорченная последняя запись, мусор в заголовке слота за ней,
+ * стёртый слот 0 после оборота — восстанавливается последняя целая запись.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+
+App app{};
+
+namespace {
+    constexpr uint32_t WriteCycleUs = 5000;
+
+    using checks::check;
+
+    void run_for_ms(uint32_t ms, uint32_t quantum_us = 100) {
+        const uint64_t end_us = host::now_us() + ms * 1000ULL;
+        while (host::now_us() < end_us) {
+            app_loop(app);
+            host::advance_us(quantum_us);
+        }
+    }
+
+    /// Загрузка нового экземпляра (как после сброса); время загрузки — в boot_us
+    uint64_t reboot(Settings &s) {
+        app.settings = &s;
+        const uint64_t t0 = host::now_us();
+        s.begin();
+        while (s.state() == Settings::State::Loading && host::now_us() - t0 < 1'000'000) run_for_ms(1);
+        return host::now_us() - t0;
+    }
+
+    void reset_controller() {
+        app.ctrl->setPidGains(CONTROLLER_PID::KP, CONTROLLER_PID::KI, CONTROLLER_PID::KD);
+        app.ctrl->setSetpoint(CONTROLLER_SETPOINT_DEFAULT);
+    }
+
+    /// Сумма циклов записи страниц [first, first + count); наибольший и наименьший — в max/min
+    uint32_t page_writes(uint16_t first, uint16_t count, uint32_t *max = nullptr, uint32_t *min = nullptr) {
+        const auto &w = host::i2c_page_writes(SETTINGS_EEPROM_ADDRESS);
+        uint32_t sum = 0, hi = 0, lo = UINT32_MAX;
+        for (uint16_t p = first; p < first + count; ++p) {
+            sum += w[p];
+            hi = std::max(hi, w[p]);
+            lo = std::min(lo, w[p]);
+        }
+        if (max) *max = hi;
+        if (min) *min = lo;
+        return sum;
+    }
+
+    double full_scan_ms() {
+        static uint8_t addr[2] = {0, 0};
+        static uint8_t all[SETTINGS_EEPROM_SIZE];
+        static volatile bool done;
+        done = false;
+        const uint64_t t0 = host::now_us();
+        TwiDriver::submit({SETTINGS_EEPROM_ADDRESS, addr, 2, all, sizeof(all), [](bool) { done = true; }});
+        while (!done) host::advance_us(100);
+        return (host::now_us() - t0) / 1000.0;
+    }
+}
+
+int main(int argc, char **argv) {
+    const long laps = argc > 1 ? std::atol(argv[1]) : 3;
+    constexpr uint16_t Slots = Settings::Slots;
+
+    host::reset();
+    host::i2c_attach(SETTINGS_EEPROM_ADDRESS, SETTINGS_EEPROM_SIZE, 2, SETTINGS_EEPROM_PAGE, WriteCycleUs);
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+    std::printf("Settings bench: 24C32 model, %u slots, %ld laps\n", Slots, laps);
+
+    Settings &first = *app.settings;
+    run_for_ms(100);
+    check(first.state() == Settings::State::Ready && !first.stats().restored && first.stats().saves == 0,
+          "blank EEPROM: defaults kept, nothing written");
+
+    // Серия изменений — одна запись через SETTINGS_SAVE_DELAY_MS после последнего
+    app.ctrl->setSetpoint(300);
+    run_for_ms(500);
+    app.ctrl->setSetpoint(305);
+    run_for_ms(SETTINGS_SAVE_DELAY_MS - 200);
+    check(first.stats().saves == 0, "no write while the value keeps changing");
+    run_for_ms(500);
+    check(first.stats().saves == 1 && first.idle(), "one save after the pause");
+    check(page_writes(0, Slots) == 1, "a save is one page write");
+
+    app.ctrl->setPidGains(200, 10, 5);
+    run_for_ms(SETTINGS_SAVE_DELAY_MS + 500);
+    check(first.stats().saves == 2 && first.stats().seq == 2, "PID gains change is saved too");
+
+    // Перезагрузка: значения из последней записи
+    reset_controller();
+    Settings second(*app.ctrl);
+    const uint64_t boot_us = reboot(second);
+    const PIDInt &pid = app.ctrl->getPid();
+    check(second.stats().restored && second.stats().seq == 2 && app.ctrl->getSetpoint() == 305 && pid.kp() == 200 &&
+          pid.ki() == 10 && pid.kd() == 5, "reboot restores setpoint and PID from the latest record");
+
+    // Обрыв последней записи (сброс во время записи страницы): берётся предыдущая
+    uint8_t *mem = host::i2c_memory(SETTINGS_EEPROM_ADDRESS);
+    mem[second.stats().slot * SETTINGS_EEPROM_PAGE + 10] ^= 0x5A;
+    reset_controller();
+    Settings third(*app.ctrl);
+    reboot(third);
+    check(third.stats().restored && app.ctrl->getSetpoint() == 305 && app.ctrl->getPid().kp() == CONTROLLER_PID::KP,
+          "torn latest record: the previous one is restored");
+
+    app.ctrl->setSetpoint(310);
+    run_for_ms(SETTINGS_SAVE_DELAY_MS + 500);
+    check(third.stats().seq == 2 && third.stats().slot == 1, "next save rewrites the torn slot, numbers stay in a row");
+
+    // Износ: несколько оборотов по всем слотам
+    const long saves = laps * Slots;
+    const uint32_t before = third.stats().saves;
+    for (long i = 0; i < saves; ++i) {
+        app.ctrl->setSetpoint(static_cast<int>(200 + (i % 2) * 5));
+        run_for_ms(SETTINGS_SAVE_DELAY_MS + 50, 1000);
+    }
+    uint32_t page_max = 0, page_min = 0;
+    const uint32_t page_sum = page_writes(0, Slots, &page_max, &page_min);
+    const uint32_t total = third.stats().saves - before;
+    check(total == saves && third.stats().failures == 0, "every change was saved");
+    // Оборванный слот 1 записан лишний раз, остальные — раз за оборот
+    check(page_sum == first.stats().saves + third.stats().saves && page_max - page_min <= 2,
+          "one page write per save, spread evenly: every page written once per lap");
+
+    // Обрыв с мусором в заголовке слота за последней записью (номер больше всех)
+    const uint16_t torn = static_cast<uint16_t>((third.stats().slot + 1) % Slots);
+    const uint32_t newest = third.stats().seq;
+    mem[torn * SETTINGS_EEPROM_PAGE] = 1;
+    mem[torn * SETTINGS_EEPROM_PAGE + 7] = 0x7F;
+
+    reset_controller();
+    Settings fourth(*app.ctrl);
+    const uint64_t wrap_boot_us = reboot(fourth);
+    check(fourth.stats().restored && fourth.stats().seq == newest &&
+          app.ctrl->getSetpoint() == 200 + ((saves - 1) % 2) * 5,
+          "after wrap-around the newest record wins, a garbage header after it is skipped");
+    check(wrap_boot_us < boot_us + 5000, "boot reads a few slot headers, not all of them");
+
+    // Обрыв записи, перешедшей с последнего слота на слот 0: заголовок слота 0 стёрт (0xFF)
+    int last = 0;
+    for (long i = 0; fourth.stats().slot != Slots - 1; ++i) {
+        last = static_cast<int>(210 + (i % 2) * 5);
+        app.ctrl->setSetpoint(last);
+        run_for_ms(SETTINGS_SAVE_DELAY_MS + 50, 1000);
+    }
+    const uint32_t before_wrap = fourth.stats().seq;
+    std::fill(mem, mem + SETTINGS_EEPROM_PAGE, 0xFF);
+
+    reset_controller();
+    Settings fifth(*app.ctrl);
+    reboot(fifth);
+    check(fifth.stats().restored && fifth.stats().seq == before_wrap && fifth.stats().slot == Slots - 1 &&
+          app.ctrl->getSetpoint() == last,
+          "erased slot 0 after a wrap: the record in the last slot is restored, not the defaults");
+
+    app.ctrl->setSetpoint(last + 1);
+    run_for_ms(SETTINGS_SAVE_DELAY_MS + 500);
+    reset_controller();
+    Settings sixth(*app.ctrl);
+    reboot(sixth);
+    check(sixth.stats().restored && sixth.stats().seq == before_wrap + 1 && sixth.stats().slot == 0 &&
+          app.ctrl->getSetpoint() == last + 1, "... and the next save goes to slot 0 and wins on the next boot");
+
+    // Без EEPROM: умолчания, без попыток записи
+    host::i2c_detach(SETTINGS_EEPROM_ADDRESS);
+    reset_controller();
+    Settings absent(*app.ctrl);
+    reboot(absent);
+    app.ctrl->setSetpoint(250);
+    run_for_ms(SETTINGS_SAVE_DELAY_MS + 500);
+    check(absent.state() == Settings::State::Absent && absent.stats().saves == 0 && absent.stats().failures == 0,
+          "no EEPROM: defaults, no writes");
+    host::i2c_attach(SETTINGS_EEPROM_ADDRESS, SETTINGS_EEPROM_SIZE, 2, SETTINGS_EEPROM_PAGE, WriteCycleUs);
+    const double scan_ms = full_scan_ms();
+
+    check(!host::iwdg_expired(), "watchdog never expired");
+
+    std::printf("  boot by slot header search: %.1f ms, whole EEPROM: %.1f ms\n", boot_us / 1000.0, scan_ms);
+    std::printf("  %u saves: a page written %u..%u times\n", total, page_min, page_max);
+    std::printf("BENCH settings_boot_ms %.1f\n", boot_us / 1000.0);
+    std::printf("BENCH settings_full_scan_ms %.1f\n", scan_ms);
+    std::printf("BENCH settings_saves %u\n", total);
+    std::printf("BENCH settings_page_writes_max %u\n", page_max);
+    std::printf("BENCH settings_page_writes_min %u\n", page_min);
+
+    return checks::finish();
+}
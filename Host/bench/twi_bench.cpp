@@ -0,0 +1,196 @@
+/**
+ * @file twi_bench.cpp
+ * @brief TwiDriver на модели I2C1 с ведомым-памятью: корректность и загрузка шины
+ *
+ * Использование: stm32f0_basic_twi_bench [транзакций]
+ *
+ * Сначала проверяется последовательность: запись длиннее 255 байт (RELOAD), запись
+ * указателя и чтение через повторный START, NACK адреса без остановки очереди,
+ * таймаут при удержании SCL ведомым и восстановление шины после него.
+ *
+ * Затем на 100 и 400 кГц основной цикл держит очередь полной транзакциями как у 24Cxx
+ * (указатель + 32 байта записи или чтения) и печатает:
+ * - bus_utilisation — доля времени, когда SCL тактирует START/адрес/данные/STOP;
+ * - gap_us — средняя пауза шины между STOP и следующим START;
+ * - irqs_per_byte — вызовы обработчиков на байт данных.
+ * Модель шины берёт за каждый ответ прошивки на TC/TCR/STOPF (и TXIS при пустом
+ * сдвиговом регистре) вход и выход из прерывания, а между STOP и START — tBUF:
+ * это и есть потери загрузки и пауза между транзакциями.
+ *
+ * Код возврата 0 — все проверки прошли.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+#include "bench_check.hpp"
+#include "config.h"
+#include "AppContext.hpp"
+#include "TwiDriver.hpp"
+
+App app{};   // Обработчики прерываний прошивки ссылаются на app; здесь он пуст
+
+namespace {
+    constexpr uint8_t EepromAddress = 0x50;
+    constexpr uint8_t AbsentAddress = 0x51;
+    constexpr size_t EepromSize = 4096;
+    constexpr size_t BurstPayload = 32;
+
+    std::vector<bool> results;
+
+    using checks::check;
+
+    void on_done(bool ok) { results.push_back(ok); }
+
+    /// Основной цикл спит, пока очередь не опустеет (не дольше limit_ms времени модели)
+    bool wait_idle(uint32_t limit_ms = 1000) {
+        const uint64_t deadline = host::now_us() + limit_ms * 1000ULL;
+        while (TwiDriver::busy()) {
+            if (host::now_us() > deadline) return false;
+            __WFI();
+        }
+        return true;
+    }
+
+    bool run(const TwiDriver::Request &r) {
+        results.clear();
+        return TwiDriver::submit(r) && wait_idle() && results.size() == 1 && results[0];
+    }
+
+    void fill(uint8_t *p, size_t n, uint8_t seed) {
+        for (size_t i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+
+    void check_sequences() {
+        uint8_t *mem = host::i2c_memory(EepromAddress);
+
+        // Указатель 0x0100 и 600 байт: куски 255 + 255 + 92 по RELOAD
+        static uint8_t tx[2 + 600];
+        tx[0] = 0x01;
+        tx[1] = 0x00;
+        fill(tx + 2, 600, 0x11);
+        check(run({EepromAddress, tx, sizeof(tx), nullptr, 0, on_done}) &&
+              std::memcmp(mem + 0x100, tx + 2, 600) == 0, "600-byte write (NBYTES reload)");
+
+        // Запись указателя, повторный START, чтение 600 байт — один STOP на всю транзакцию
+        static uint8_t rx[600];
+        const auto before = host::i2c_stats();
+        const bool ok = run({EepromAddress, tx, 2, rx, sizeof(rx), on_done});
+        const auto &after = host::i2c_stats();
+        check(ok && std::memcmp(rx, tx + 2, sizeof(rx)) == 0, "write-then-read 600 bytes");
+        check(after.starts - before.starts == 2 && after.stops - before.stops == 1,
+              "read follows the write by a repeated START, one STOP");
+
+        check(run({EepromAddress, nullptr, 0, nullptr, 0, on_done}), "zero-length probe is acknowledged");
+
+        // NACK адреса завершает только свою транзакцию
+        results.clear();
+        const uint32_t nacks = host::i2c_stats().nacks;
+        static const uint8_t one[] = {0x00, 0x10, 0xA5};
+        const bool queued = TwiDriver::submit({AbsentAddress, one, sizeof(one), nullptr, 0, on_done}) &&
+                            TwiDriver::submit({EepromAddress, one, sizeof(one), nullptr, 0, on_done});
+        check(queued && wait_idle() && results == std::vector<bool>{false, true} &&
+              host::i2c_stats().nacks - nacks == 1 && mem[0x10] == 0xA5,
+              "absent address is NACKed, the next queued transaction still runs");
+
+        // Ведомый держит SCL: отмена по таймауту, затем шина снова работает
+        host::i2c_hold_scl(EepromAddress, true);
+        results.clear();
+        const uint64_t t0 = host::now_us();
+        const bool held = TwiDriver::submit({EepromAddress, tx, 2, rx, 4, on_done}) &&
+                          wait_idle(3 * I2C_TIMEOUT_MS);
+        // Таймаут в целых тиках SysTick: первый тик наступает раньше, чем через 1 мс
+        const uint64_t waited_us = host::now_us() - t0;
+        check(held && results == std::vector<bool>{false} && waited_us >= (I2C_TIMEOUT_MS - 1) * 1000ULL &&
+              waited_us <= (I2C_TIMEOUT_MS + 1) * 1000ULL, "held SCL is aborted after I2C_TIMEOUT_MS");
+
+        host::i2c_hold_scl(EepromAddress, false);
+        check(run({EepromAddress, tx, 2, rx, 4, on_done}) && std::memcmp(rx, tx + 2, 4) == 0,
+              "bus recovers after the abort");
+    }
+
+    /// Транзакции 24Cxx: чётные — запись страницы, нечётные — чтение её же
+    void burst(uint32_t speed_hz, long count) {
+        TwiDriver::init(PCLK1_HZ, speed_hz);
+
+        struct Slot {
+            uint8_t tx[2 + BurstPayload];
+            uint8_t rx[BurstPayload];
+        };
+        std::vector<Slot> slots(static_cast<size_t>(count));
+        std::vector<TwiDriver::Request> requests;
+        for (long i = 0; i < count; ++i) {
+            Slot &s = slots[i];
+            const uint16_t page = static_cast<uint16_t>((i / 2 * BurstPayload) % EepromSize);
+            s.tx[0] = static_cast<uint8_t>(page >> 8);
+            s.tx[1] = static_cast<uint8_t>(page);
+            if (i % 2 == 0) {
+                fill(s.tx + 2, BurstPayload, static_cast<uint8_t>(i));
+                requests.push_back({EepromAddress, s.tx, sizeof(s.tx), nullptr, 0, on_done});
+            } else {
+                requests.push_back({EepromAddress, s.tx, 2, s.rx, BurstPayload, on_done});
+            }
+        }
+
+        results.clear();
+        const auto stats0 = host::i2c_stats();
+        const uint64_t irqs0 = host::irq_count();
+        const uint64_t t0 = host::now_cycles();
+
+        size_t submitted = 0;
+        while (results.size() < requests.size()) {
+            while (submitted < requests.size() && TwiDriver::submit(requests[submitted])) ++submitted;
+            __WFI();
+        }
+
+        const uint64_t elapsed = host::now_cycles() - t0;
+        const auto &stats = host::i2c_stats();
+        const uint64_t shift = stats.shift_cycles - stats0.shift_cycles;
+        const uint64_t busy = stats.busy_cycles - stats0.busy_cycles;
+        const uint32_t bytes = stats.bytes - stats0.bytes;
+        // SysTick тоже прерывание: его вклад вычитаем по числу миллисекунд
+        const uint64_t irqs = host::irq_count() - irqs0 - elapsed / (host::CoreClockHz / 1000);
+
+        bool data_ok = true;
+        for (size_t i = 1; i < slots.size(); i += 2) {
+            data_ok = data_ok && std::memcmp(slots[i].rx, slots[i - 1].tx + 2, BurstPayload) == 0;
+        }
+        bool all_ok = true;
+        for (bool r: results) all_ok = all_ok && r;
+
+        const unsigned khz = speed_hz / 1000;
+        char what[128];
+        std::snprintf(what, sizeof(what), "%u kHz burst: %ld transactions complete, data intact", khz, count);
+        check(all_ok && data_ok && stats.stops - stats0.stops == count, what);
+
+        const double us = static_cast<double>(elapsed) / (host::CoreClockHz / 1'000'000);
+        std::printf("  %u kHz: %u bytes in %.0f us, bus clocked %.1f%% of the time, busy %.1f%%\n", khz,
+                    bytes, us, 100.0 * shift / elapsed, 100.0 * busy / elapsed);
+        std::printf("BENCH twi_%ukhz_bus_utilisation %.1f\n", khz, 100.0 * shift / elapsed);
+        std::printf("BENCH twi_%ukhz_gap_us %.2f\n", khz,
+                    static_cast<double>(elapsed - busy) / count / (host::CoreClockHz / 1'000'000));
+        std::printf("BENCH twi_%ukhz_irqs_per_byte %.2f\n", khz, static_cast<double>(irqs) / bytes);
+        std::printf("BENCH twi_%ukhz_kib_per_s %.2f\n", khz, bytes / 1024.0 / (us / 1e6));
+    }
+}
+
+int main(int argc, char **argv) {
+    const long count = argc > 1 ? std::atol(argv[1]) : 200;
+
+    host::reset();
+    SysTick_Config(host::CoreClockHz / 1000);
+    host::i2c_attach(EepromAddress, EepromSize, 2);
+    TwiDriver::init(PCLK1_HZ, 400'000);
+
+    std::printf("TwiDriver bench: %ld transactions per burst, %u-byte payloads\n", count,
+                static_cast<unsigned>(BurstPayload));
+    check_sequences();
+    burst(100'000, count);
+    burst(400'000, count);
+
+    return checks::finish();
+}
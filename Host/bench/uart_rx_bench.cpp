@@ -0,0 +1,129 @@
+/**
+ * @file uart_rx_bench.cpp
+ * @brief Прием UsartDriver на модели: целостность потока и число прерываний
+ *
+ * Использование: stm32f0_basic_uart_rx_bench[_irq] [байт]
+ *   байт — сколько байт принять (по умолчанию 50000)
+ *
+ * На линию приходят посылки случайной длины (1..48 байт) со случайными паузами,
+ * а основной цикл забирает принятое только раз в 1..5 мс — как будто всё остальное
+ * время занят (например, Flush HT1621). Проверяется, что прочитано ровно то,
+ * что было отправлено, в том же порядке и без переполнений.
+ *
+ * Основной вариант — кольцевой DMA1 Channel 5 с IDLE, вариант _irq собран
+ * с USART_RX_IRQ (прерывание RXNE на каждый байт). Строки "BENCH <метрика> <значение>" —
+ * для сравнения.
+ *
+ * Код возврата 0 — прочитанный поток совпал с отправленным.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "UsartDriver.hpp"
+
+namespace {
+    UsartDriver<> uart;
+
+    /// Линейный конгруэнтный генератор: прогон воспроизводим
+    uint32_t g_seed = 54321;
+
+    uint32_t next_random() {
+        g_seed = g_seed * 1664525u + 1013904223u;
+        return g_seed >> 8;
+    }
+
+    /// Время одного байта на линии (10 бит), мкс
+    constexpr uint64_t ByteUs = 10'000'000 / 115200 + 1;
+}
+
+extern "C" {
+    void USART1_IRQHandler(void) {
+        uart.handleIRQ();
+    }
+
+#if !defined USART_TX_IRQ
+    void DMA1_Channel2_3_IRQHandler(void) {
+        uart.handleTxDmaIRQ();
+    }
+#endif
+
+#if !defined USART_RX_IRQ
+    void DMA1_Channel4_5_IRQHandler(void) {
+        uart.handleRxDmaIRQ();
+    }
+#endif
+}
+
+int main(int argc, char **argv) {
+    const size_t bytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50'000;
+
+    host::reset();
+    uart.Init(host::CoreClockHz);
+
+    const uint64_t irqs_before = host::irq_count();
+    const uint64_t start = host::now_cycles();
+
+    std::string sent;
+    std::string received;
+    uint32_t frames = 0;
+    uint32_t reads = 0;
+    uint64_t next_frame_us = host::now_us();
+    uint64_t next_read_us = host::now_us();
+
+    // Отправка посылок и редкое чтение, пока всё отправленное не прочитано
+    const uint64_t deadline = host::now_us() + 60'000'000;
+    while ((sent.size() < bytes || received.size() < sent.size()) && host::now_us() < deadline) {
+        if (sent.size() < bytes && host::now_us() >= next_frame_us) {
+            const size_t len = std::min<size_t>(1 + next_random() % 48, bytes - sent.size());
+            std::string frame;
+            for (size_t i = 0; i < len; ++i) frame.push_back(static_cast<char>(next_random()));
+            host::uart_rx(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+            sent += frame;
+            ++frames;
+            next_frame_us = host::now_us() + len * ByteUs + next_random() % 3000;
+        }
+
+        if (host::now_us() >= next_read_us) {
+            for (int c = uart.read_byte(); c >= 0; c = uart.read_byte()) received.push_back(static_cast<char>(c));
+            ++reads;
+            next_read_us = host::now_us() + 1000 + next_random() % 4000;
+        }
+
+        host::advance_us(50);
+    }
+
+    const uint64_t irqs = host::irq_count() - irqs_before;
+    const double seconds = static_cast<double>(host::now_cycles() - start) / host::CoreClockHz;
+    const uint32_t overruns = uart.get_rx_overrun_count();
+
+    size_t mismatch = 0;
+    while (mismatch < received.size() && mismatch < sent.size() && received[mismatch] == sent[mismatch]) ++mismatch;
+    const bool ok = received == sent && overruns == 0;
+
+#if defined USART_RX_IRQ
+    const char *variant = "RXNE interrupt per byte";
+#else
+    const char *variant = "DMA1 Channel 5 circular + IDLE";
+#endif
+    std::printf("uart rx bench (%s): %zu bytes in %u frames, %.2f s simulated, %u reads\n",
+                variant, sent.size(), frames, seconds, reads);
+    std::printf("interrupts: %llu total, %.1f /s, %.2f per KiB, %u overruns\n",
+                static_cast<unsigned long long>(irqs), irqs / seconds, irqs * 1024.0 / sent.size(), overruns);
+    if (ok) {
+        std::printf("OK: read stream matches the sent stream\n");
+    } else {
+        std::printf("FAIL: %zu of %zu bytes read, first difference at byte %zu\n",
+                    received.size(), sent.size(), mismatch);
+    }
+
+    std::printf("BENCH rx_irqs_per_s %.1f\n", irqs / seconds);
+    std::printf("BENCH rx_irqs_per_kib %.2f\n", irqs * 1024.0 / sent.size());
+    std::printf("BENCH rx_overruns %u\n", overruns);
+
+    return ok ? 0 : 1;
+}
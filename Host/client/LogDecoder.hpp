@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+ * @file LogDecoder.hpp
+ * @brief Текст записей журнала прошивки (ProtoCommand::Log) по строкам формата из секции logfmt
+ *
+ * Номер записи — смещение строки формата в секции logfmt. В прошивке секция есть
+ * только в ELF (fromElf), в хост-сборке её содержимое лежит в памяти процесса
+ * (конструктор от указателя и размера). Текст собирает тот же Log::render(),
+ * что и прошивка в режиме LOG_TEXT.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+
+#include "LogFormat.hpp"
+#include "ProtoClient.hpp"
+
+class LogDecoder {
+public:
+    LogDecoder(const char *section, size_t size) : m_formats(section, size) {}
+
+    /**
+     * @brief Строки формата из ELF прошивки (32 бита, little-endian)
+     * @return nullopt, если файла нет или в нём нет секции logfmt
+     */
+    static std::optional<LogDecoder> fromElf(const char *path) {
+        std::FILE *f = std::fopen(path, "rb");
+        if (!f) return std::nullopt;
+        std::vector<uint8_t> elf;
+        uint8_t buf[4096];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) elf.insert(elf.end(), buf, buf + n);
+        std::fclose(f);
+
+        Elf32_Ehdr eh;
+        if (elf.size() < sizeof(eh)) return std::nullopt;
+        std::memcpy(&eh, elf.data(), sizeof(eh));
+        if (std::memcmp(eh.e_ident, ELFMAG, SELFMAG) != 0 || eh.e_ident[EI_CLASS] != ELFCLASS32 ||
+            eh.e_ident[EI_DATA] != ELFDATA2LSB || eh.e_shstrndx >= eh.e_shnum) {
+            return std::nullopt;
+        }
+
+        auto section = [&](size_t i, Elf32_Shdr &sh) {
+            const size_t at = eh.e_shoff + i * eh.e_shentsize;
+            if (at + sizeof(sh) > elf.size()) return false;
+            std::memcpy(&sh, elf.data() + at, sizeof(sh));
+            return sh.sh_type == SHT_NOBITS || sh.sh_offset + sh.sh_size <= elf.size();
+        };
+
+        Elf32_Shdr names;
+        if (!section(eh.e_shstrndx, names)) return std::nullopt;
+        for (size_t i = 0; i < eh.e_shnum; ++i) {
+            Elf32_Shdr sh;
+            if (!section(i, sh) || sh.sh_type == SHT_NOBITS || sh.sh_name >= names.sh_size) continue;
+            const char *name = reinterpret_cast<const char *>(elf.data() + names.sh_offset + sh.sh_name);
+            if (std::strncmp(name, "logfmt", names.sh_size - sh.sh_name) != 0) continue;
+            return LogDecoder(reinterpret_cast<const char *>(elf.data() + sh.sh_offset), sh.sh_size);
+        }
+        return std::nullopt;
+    }
+
+    std::string decode(const ProtoClient::LogRecord &r) const {
+        if (r.id >= m_formats.size()) return "<log #" + std::to_string(r.id) + ">";
+
+        StringSink out;
+        Log::render(m_formats.c_str() + r.id, r.args.data(), r.args.size(), out);
+        return out.s;
+    }
+
+private:
+    struct StringSink {
+        std::string s;
+
+        void text(const char *p, size_t n) { s.append(p, n); }
+
+        void i32(int32_t v) { s += std::to_string(v); }
+
+        void u32(uint32_t v) { s += std::to_string(v); }
+    };
+
+    std::string m_formats;   ///< Содержимое секции; строки разделены нулями
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+/**
+ * @file ProtoClient.hpp
+ * @brief Клиент протокола USART1 на стороне хоста (без привязки к транспорту)
+ *
+ * request() собирает кадр запроса, feed() принимает байты из линии: текст
+ * вне кадров (LOG_TEXT, LoopProfiler) копится в text(), ответы, кадры телеметрии
+ * и записи журнала разбираются теми же FrameCodec и ProtocolDefs, что и в прошивке
+ * (текст записей журнала восстанавливает LogDecoder). Транспорт (последовательный порт или модель на хосте) —
+ * забота вызывающего.
+ */
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ProtocolDefs.hpp"
+
+class ProtoClient {
+public:
+    struct Response {
+        uint8_t cmd = 0;              ///< Команда запроса (без ProtoResponseFlag)
+        uint8_t seq = 0;
+        ProtoStatus status = ProtoStatus::Ok;
+        std::vector<uint8_t> data;    ///< Данные после статуса
+    };
+
+    struct Telemetry {
+        uint16_t seq = 0;
+        uint32_t ms = 0;
+        int16_t current = 0;          ///< Десятые °C
+        int16_t setpoint = 0;         ///< Десятые °C
+        int16_t error = 0;            ///< Ошибка PID, десятые °C
+        int32_t p = 0;                ///< Слагаемые PID, единицы мощности
+        int32_t i = 0;
+        int32_t d = 0;
+        int16_t power = 0;            ///< 0..1000
+        uint8_t state = 0;            ///< Controller::State
+    };
+
+    /// Запись журнала как пришла: номер формата и сырые аргументы
+    struct LogRecord {
+        uint16_t id = 0;
+        std::vector<uint8_t> args;
+    };
+
+    struct Stats {
+        uint32_t frames = 0;          ///< Принято кадров
+        uint32_t errors = 0;          ///< Испорченных кадров
+        uint32_t telemetryLost = 0;   ///< Пропусков в номерах телеметрии
+    };
+
+    /**
+     * @brief Кадр запроса для отправки в линию
+     * @param[out] seq Номер запроса, с ним придёт ответ
+     */
+    std::vector<uint8_t> request(ProtoCommand cmd, const std::vector<uint8_t> &args, uint8_t &seq) {
+        seq = m_seq++;
+        std::vector<uint8_t> payload{static_cast<uint8_t>(cmd), seq};
+        payload.insert(payload.end(), args.begin(), args.end());
+
+        std::vector<uint8_t> frame(FrameCodec::encodedSize(payload.size()));
+        frame.resize(FrameCodec::encode(payload.data(), payload.size(), frame.data(), frame.size()));
+        return frame;
+    }
+
+    /// Принять байты из линии
+    void feed(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len; ++i) feed(data[i]);
+    }
+
+    /// Забрать ответ на запрос seq, если он уже пришёл
+    std::optional<Response> take(uint8_t seq) {
+        for (auto it = m_responses.begin(); it != m_responses.end(); ++it) {
+            if (it->seq != seq) continue;
+            Response r = *it;
+            m_responses.erase(it);
+            return r;
+        }
+        return std::nullopt;
+    }
+
+    std::deque<Telemetry> &telemetry() { return m_telemetry; }
+
+    std::deque<LogRecord> &logs() { return m_logs; }
+
+    /// Текст, пришедший вне кадров
+    const std::string &text() const { return m_text; }
+
+    const Stats &stats() const { return m_stats; }
+
+    //=========================================================================
+    // Аргументы команд
+    //=========================================================================
+
+    static std::vector<uint8_t> argsI16(int16_t v) {
+        return {static_cast<uint8_t>(v), static_cast<uint8_t>(static_cast<uint16_t>(v) >> 8)};
+    }
+
+    static std::vector<uint8_t> argsU16(uint16_t v) {
+        return argsI16(static_cast<int16_t>(v));
+    }
+
+    static std::vector<uint8_t> argsPid(int32_t kp, int32_t ki, int32_t kd) {
+        std::vector<uint8_t> args(12);
+        ProtoWriter w(args.data(), args.size());
+        w.i32(kp);
+        w.i32(ki);
+        w.i32(kd);
+        return args;
+    }
+
+private:
+    /// На хосте памяти не жалко: кадр любой длины, которую способен прислать протокол
+    using Decoder = FrameCodec::Decoder<256>;
+
+    void feed(uint8_t byte) {
+        if (!m_inFrame) {
+            if (byte == FrameCodec::Delimiter) {
+                m_decoder.reset();
+                m_inFrame = true;
+            } else {
+                m_text.push_back(static_cast<char>(byte));
+            }
+            return;
+        }
+
+        const Decoder::Result result = m_decoder.feed(byte);
+        if (result == Decoder::Result::Error) {
+            ++m_stats.errors;
+        } else if (result == Decoder::Result::Frame) {
+            ++m_stats.frames;
+            m_inFrame = false;
+            handleFrame(m_decoder.data(), m_decoder.size());
+        }
+    }
+
+    void handleFrame(const uint8_t *data, size_t len) {
+        if (len >= 2 && data[0] == static_cast<uint8_t>(ProtoCommand::Telemetry)) {
+            ProtoReader r(data + 1, len - 1);
+            Telemetry t;
+            t.seq = r.u16();
+            t.ms = r.u32();
+            t.current = r.i16();
+            t.setpoint = r.i16();
+            t.error = r.i16();
+            t.p = r.i32();
+            t.i = r.i32();
+            t.d = r.i32();
+            t.power = r.i16();
+            t.state = r.u8();
+            if (!r.ok()) {
+                ++m_stats.errors;
+                return;
+            }
+            if (m_haveTelemetry) m_stats.telemetryLost += static_cast<uint16_t>(t.seq - m_lastTelemetry - 1);
+            m_haveTelemetry = true;
+            m_lastTelemetry = t.seq;
+            m_telemetry.push_back(t);
+            return;
+        }
+
+        if (len >= 3 && data[0] == static_cast<uint8_t>(ProtoCommand::Log)) {
+            LogRecord l;
+            l.id = static_cast<uint16_t>(data[1] | (data[2] << 8));
+            l.args.assign(data + 3, data + len);
+            m_logs.push_back(l);
+            return;
+        }
+
+        if (len < ProtoResponseHeader || !(data[0] & ProtoResponseFlag)) {
+            ++m_stats.errors;
+            return;
+        }
+        Response r;
+        r.cmd = data[0] & ~ProtoResponseFlag;
+        r.seq = data[1];
+        r.status = static_cast<ProtoStatus>(data[2]);
+        r.data.assign(data + ProtoResponseHeader, data + len);
+        m_responses.push_back(r);
+    }
+
+    Decoder m_decoder;
+    bool m_inFrame = false;
+    uint8_t m_seq = 0;
+    bool m_haveTelemetry = false;
+    uint16_t m_lastTelemetry = 0;
+
+    std::deque<Response> m_responses;
+    std::deque<Telemetry> m_telemetry;
+    std::deque<LogRecord> m_logs;
+    std::string m_text;
+    Stats m_stats;
+};
@@ -0,0 +1,192 @@
+/**
+ * @file proto_cli.cpp
+ * @brief Клиент протокола для платы на последовательном порту (Linux, termios)
+ *
+ * Использование: stm32f0_basic_proto_cli <порт> <команда> [аргументы]
+ *   info                    — тег и коммит прошивки
+ *   get-setpoint            — уставка, °C
+ *   set-setpoint <°C>       — задать уставку (например, 45.5)
+ *   get-pid                 — коэффициенты PID (×1000)
+ *   set-pid <kp> <ki> <kd>  — задать коэффициенты PID (×1000)
+ *   subscribe <мс> [кадров] — печатать телеметрию с периодом мс (по умолчанию без конца)
+ *   unsubscribe             — остановить телеметрию
+ *   log <elf> [записей]     — печатать журнал прошивки, строки формата берутся из её ELF
+ *
+ * Порт открывается в режиме 115200 8N1 без управления потоком.
+ * Код возврата 0 — ответ получен со статусом Ok.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ProtoClient.hpp"
+#include "LogDecoder.hpp"
+
+namespace {
+    int open_port(const char *path) {
+        const int fd = ::open(path, O_RDWR | O_NOCTTY);
+        if (fd < 0) return -1;
+
+        termios tio{};
+        if (tcgetattr(fd, &tio) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B115200);
+        cfsetospeed(&tio, B115200);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+        return fd;
+    }
+
+    /// Прочитать из порта всё, что придёт за timeout_ms, и отдать клиенту
+    bool pump(int fd, ProtoClient &client, int timeout_ms) {
+        pollfd p{fd, POLLIN, 0};
+        if (::poll(&p, 1, timeout_ms) <= 0) return false;
+
+        uint8_t buf[256];
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) return false;
+        client.feed(buf, static_cast<size_t>(n));
+        return true;
+    }
+
+    std::optional<ProtoClient::Response> call(int fd, ProtoClient &client, ProtoCommand cmd,
+                                              const std::vector<uint8_t> &args = {}) {
+        uint8_t seq;
+        const auto frame = client.request(cmd, args, seq);
+        if (::write(fd, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size())) return std::nullopt;
+
+        for (int attempt = 0; attempt < 10; ++attempt) {
+            if (auto r = client.take(seq)) return r;
+            pump(fd, client, 100);
+        }
+        return client.take(seq);
+    }
+
+    const char *status_name(ProtoStatus s) {
+        switch (s) {
+            case ProtoStatus::Ok: return "ok";
+            case ProtoStatus::UnknownCommand: return "unknown command";
+            case ProtoStatus::BadLength: return "bad length";
+            case ProtoStatus::BadValue: return "bad value";
+        }
+        return "?";
+    }
+
+    const char *state_name(uint8_t s) {
+        static const char *names[] = {"idle", "heating", "error"};
+        return s < 3 ? names[s] : "?";
+    }
+
+    int usage() {
+        std::fprintf(stderr, "usage: stm32f0_basic_proto_cli <port> info|get-setpoint|set-setpoint <C>|"
+                             "get-pid|set-pid <kp> <ki> <kd>|subscribe <ms> [frames]|unsubscribe|"
+                             "log <elf> [records]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) return usage();
+
+    const int fd = open_port(argv[1]);
+    if (fd < 0) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    ProtoClient client;
+    const std::string cmd = argv[2];
+    std::optional<ProtoClient::Response> r;
+
+    if (cmd == "info") {
+        r = call(fd, client, ProtoCommand::GetInfo);
+        if (r && r->status == ProtoStatus::Ok && !r->data.empty()) {
+            const size_t tag_len = r->data[0];
+            const std::string tag(r->data.begin() + 1, r->data.begin() + 1 + static_cast<long>(tag_len));
+            const std::string commit(r->data.begin() + 2 + static_cast<long>(tag_len), r->data.end());
+            std::printf("tag %s, commit %s\n", tag.c_str(), commit.c_str());
+        }
+    } else if (cmd == "get-setpoint" || (cmd == "set-setpoint" && argc > 3)) {
+        r = cmd == "get-setpoint"
+            ? call(fd, client, ProtoCommand::GetSetpoint)
+            : call(fd, client, ProtoCommand::SetSetpoint,
+                   ProtoClient::argsI16(static_cast<int16_t>(std::lround(std::atof(argv[3]) * 10.0))));
+        if (r && r->data.size() == 2) {
+            ProtoReader reader(r->data.data(), r->data.size());
+            std::printf("setpoint %.1f C\n", reader.i16() / 10.0);
+        }
+    } else if (cmd == "get-pid") {
+        r = call(fd, client, ProtoCommand::GetPid);
+        if (r && r->data.size() == 12) {
+            ProtoReader reader(r->data.data(), r->data.size());
+            const int32_t kp = reader.i32();
+            const int32_t ki = reader.i32();
+            const int32_t kd = reader.i32();
+            std::printf("kp %d, ki %d, kd %d (x1000)\n", kp, ki, kd);
+        }
+    } else if (cmd == "set-pid" && argc > 5) {
+        r = call(fd, client, ProtoCommand::SetPid,
+                 ProtoClient::argsPid(std::atoi(argv[3]), std::atoi(argv[4]), std::atoi(argv[5])));
+    } else if (cmd == "subscribe" && argc > 3) {
+        const long frames = argc > 4 ? std::atol(argv[4]) : -1;
+        r = call(fd, client, ProtoCommand::Subscribe, ProtoClient::argsU16(static_cast<uint16_t>(std::atoi(argv[3]))));
+        for (long printed = 0; r && r->status == ProtoStatus::Ok && (frames < 0 || printed < frames);) {
+            pump(fd, client, 1000);
+            for (; !client.telemetry().empty() && (frames < 0 || printed < frames); ++printed) {
+                const auto t = client.telemetry().front();
+                client.telemetry().pop_front();
+                std::printf("#%u %u ms: %.1f C, setpoint %.1f C, error %.1f, P %d I %d D %d, "
+                            "heater %.1f%%, %s, lost %u\n",
+                            t.seq, t.ms, t.current / 10.0, t.setpoint / 10.0, t.error / 10.0, t.p, t.i, t.d,
+                            t.power / 10.0, state_name(t.state), client.stats().telemetryLost);
+            }
+        }
+    } else if (cmd == "unsubscribe") {
+        r = call(fd, client, ProtoCommand::Subscribe, ProtoClient::argsU16(0));
+    } else if (cmd == "log" && argc > 3) {
+        // Журнал идёт без запроса: ответа нет, печатаем записи, пока не наберётся нужное число
+        const auto decoder = LogDecoder::fromElf(argv[3]);
+        if (!decoder) {
+            std::fprintf(stderr, "%s: no logfmt section\n", argv[3]);
+            ::close(fd);
+            return 1;
+        }
+        const long records = argc > 4 ? std::atol(argv[4]) : -1;
+        for (long printed = 0; records < 0 || printed < records;) {
+            pump(fd, client, 1000);
+            for (; !client.logs().empty() && (records < 0 || printed < records); ++printed) {
+                std::printf("%s\n", decoder->decode(client.logs().front()).c_str());
+                client.logs().pop_front();
+            }
+        }
+        ::close(fd);
+        return 0;
+    } else {
+        ::close(fd);
+        return usage();
+    }
+
+    ::close(fd);
+    if (!r) {
+        std::fprintf(stderr, "no response\n");
+        return 1;
+    }
+    if (r->status != ProtoStatus::Ok) {
+        std::fprintf(stderr, "error: %s\n", status_name(r->status));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file core_cm0.h
+ * @brief Хост-замена CMSIS Cortex-M0 Core Peripheral Access Layer
+ *
+ * Подменяет Libraries/CMSIS/Core/Include/core_cm0.h в хост-сборке (HOST_BUILD).
+ * Вместо inline-ассемблера и регистров по абсолютным адресам даёт:
+ * - квалификаторы __IO/__I/__O (нужны stm32f030x6.h для описания регистров);
+ * - SysTick и SCB (регистры host::Reg, см. host_reg.h) в памяти хоста;
+ * - NVIC-функции и intrinsics (__NOP, __DSB, __WFI, __disable_irq ...),
+ *   реализованные моделью периферии (Host/sim).
+ *
+ * Подключается из stm32f030x6.h внутри extern "C", поэтому всё объявленное
+ * здесь имеет C-компоновку.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C++" {
+#include "host_reg.h"
+}
+#endif
+
+#define __CM0_CMSIS_VERSION_MAIN  (5U)
+#define __CM0_CMSIS_VERSION_SUB   (0U)
+#define __CORTEX_M                (0U)
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline
+
+//=============================================================================
+// SysTick / SCB
+//=============================================================================
+
+#ifdef __cplusplus
+/** SysTick моделируется: VAL считает вниз по времени модели, чтение CTRL сбрасывает COUNTFLAG */
+typedef struct {
+    host::Reg CTRL;
+    host::Reg LOAD;
+    host::Reg VAL;
+    host::Reg CALIB;
+} SysTick_Type;
+#else
+typedef struct {
+    __IOM uint32_t CTRL;
+    __IOM uint32_t LOAD;
+    __IOM uint32_t VAL;
+    __IM  uint32_t CALIB;
+} SysTick_Type;
+#endif
+
+#ifdef __cplusplus
+/** ICSR моделируется: PENDSTSET отражает ожидающее прерывание SysTick */
+typedef struct {
+    host::Reg CPUID;
+    host::Reg ICSR;
+    host::Reg RESERVED0;
+    host::Reg AIRCR;
+    host::Reg SCR;
+    host::Reg CCR;
+} SCB_Type;
+#else
+typedef struct {
+    __IOM uint32_t CPUID;   // На хосте доступен на запись для модели
+    __IOM uint32_t ICSR;
+          uint32_t RESERVED0;
+    __IOM uint32_t AIRCR;
+    __IOM uint32_t SCR;
+    __IOM uint32_t CCR;
+} SCB_Type;
+#endif
+
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16U)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2U)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1U)
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0U)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Msk     (0xFFFFFFUL)
+
+#define SCB_SCR_SEVONPEND_Msk       (1UL << 4U)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2U)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1UL << 1U)
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26U)
+#define SCB_ICSR_PENDSTCLR_Msk      (1UL << 25U)
+
+extern SysTick_Type host_SysTick;
+extern SCB_Type host_SCB;
+
+#define SysTick     (&host_SysTick)
+#define SCB         (&host_SCB)
+
+//=============================================================================
+// NVIC
+//=============================================================================
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+
+uint32_t SysTick_Config(uint32_t ticks);
+
+//=============================================================================
+// Intrinsics
+//=============================================================================
+
+/** Барьеры — точки, в которых модель обслуживает отложенные прерывания. */
+void host_barrier(void);
+/** Сон до ближайшего прерывания: модель продвигает время до следующего события. */
+void host_wfi(void);
+void host_set_primask(uint32_t primask);
+uint32_t host_get_primask(void);
+/** Метка для замеров длительности (замена DWT->CYCCNT): инструкции (perf) или TSC. */
+uint32_t host_cycle_stamp(void);
+/** Модельное время в тактах ядра (младшие 32 бита), для замеров задержек между проходами цикла. */
+uint32_t host_core_cycles(void);
+
+__STATIC_INLINE void __NOP(void) { __asm__ volatile ("" ::: "memory"); }
+__STATIC_INLINE void __DSB(void) { host_barrier(); }
+__STATIC_INLINE void __ISB(void) { host_barrier(); }
+__STATIC_INLINE void __DMB(void) { host_barrier(); }
+__STATIC_INLINE void __WFI(void) { host_wfi(); }
+__STATIC_INLINE void __WFE(void) { host_wfi(); }
+__STATIC_INLINE void __SEV(void) {}
+__STATIC_INLINE void __disable_irq(void) { host_set_primask(1U); }
+__STATIC_INLINE void __enable_irq(void) { host_set_primask(0U); }
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return host_get_primask(); }
+__STATIC_INLINE void __set_PRIMASK(uint32_t primask) { host_set_primask(primask); }
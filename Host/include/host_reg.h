@@ -0,0 +1,61 @@
+/**
+ * @file host_reg.h
+ * @brief Регистр периферии хост-сборки (только C++)
+ *
+ * Подключается из core_cm0.h и stm32f0xx.h.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace host {
+    struct Reg;
+
+    uint32_t reg_read(const Reg &reg);
+    void reg_write(Reg &reg, uint32_t value);
+
+    /**
+     * @brief Регистр периферии в памяти хоста
+     *
+     * Регистры без побочных эффектов (id == 0) ведут себя как обычная память.
+     * Для остальных чтение и запись уходят в модель (Host/sim/peripherals.cpp).
+     */
+    struct Reg {
+        uint32_t value = 0;
+        uint8_t id = 0;   ///< Идентификатор побочного эффекта (host::RegId), 0 — обычная память
+
+        operator uint32_t() const { return id ? reg_read(*this) : value; }
+
+        Reg &operator=(uint32_t v) {
+            if (id) reg_write(*this, v);
+            else value = v;
+            return *this;
+        }
+
+        Reg &operator=(const Reg &other) { return *this = static_cast<uint32_t>(other); }
+
+        // Маски CMSIS имеют тип unsigned long (64 бита на хосте): обрезаем явно, как 32-битная шина
+        template<typename T>
+        Reg &operator=(T v) { return *this = static_cast<uint32_t>(v); }
+
+        template<typename T>
+        Reg &operator|=(T v) { return *this = static_cast<uint32_t>(static_cast<uint32_t>(*this) | v); }
+
+        template<typename T>
+        Reg &operator&=(T v) { return *this = static_cast<uint32_t>(static_cast<uint32_t>(*this) & v); }
+
+        template<typename T>
+        Reg &operator^=(T v) { return *this = static_cast<uint32_t>(static_cast<uint32_t>(*this) ^ v); }
+    };
+
+    /**
+     * @brief Адресный регистр DMA (CPAR/CMAR) шириной в указатель хоста
+     */
+    struct AddrReg {
+        uintptr_t value = 0;
+
+        operator uintptr_t() const { return value; }
+        AddrReg &operator=(uintptr_t v) { value = v; return *this; }
+    };
+}
@@ -0,0 +1,263 @@
+/**
+ * @file stm32f0xx.h
+ * @brief Хост-замена CMSIS Device header для STM32F030x6
+ *
+ * Битовые маски, номера прерываний и SystemCoreClock берутся из настоящего
+ * stm32f030x6.h, а структуры регистров используемой периферии
+ * (RCC, FLASH, GPIOx, TIM1/3/14/16/17, USART1, I2C1, SPI1, DMA1, IWDG, EXTI, SYSCFG) подменяются
+ * программными моделями из Host/sim. Каждый регистр — host::Reg (host_reg.h):
+ * чтение/запись выглядят как обычный доступ к volatile uint32_t,
+ * но модель может реагировать на них (TDR, BSRR, KR, CR1.CEN ...).
+ *
+ * Адресные регистры DMA (CPAR/CMAR) и FLASH_AR хранят uintptr_t, поэтому прошивка
+ * должна записывать в них указатели через (uintptr_t), а не (uint32_t).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef STM32F030x6
+#define STM32F030x6
+#endif
+
+// Настоящие описания регистров переименовываются, чтобы освободить имена
+#define GPIO_TypeDef          hw_GPIO_TypeDef
+#define RCC_TypeDef           hw_RCC_TypeDef
+#define FLASH_TypeDef         hw_FLASH_TypeDef
+#define TIM_TypeDef           hw_TIM_TypeDef
+#define USART_TypeDef         hw_USART_TypeDef
+#define I2C_TypeDef           hw_I2C_TypeDef
+#define SPI_TypeDef           hw_SPI_TypeDef
+#define DMA_Channel_TypeDef   hw_DMA_Channel_TypeDef
+#define DMA_TypeDef           hw_DMA_TypeDef
+#define IWDG_TypeDef          hw_IWDG_TypeDef
+#define EXTI_TypeDef          hw_EXTI_TypeDef
+#define SYSCFG_TypeDef        hw_SYSCFG_TypeDef
+
+#include "stm32f030x6.h"
+
+#undef GPIO_TypeDef
+#undef RCC_TypeDef
+#undef FLASH_TypeDef
+#undef TIM_TypeDef
+#undef USART_TypeDef
+#undef I2C_TypeDef
+#undef SPI_TypeDef
+#undef DMA_Channel_TypeDef
+#undef DMA_TypeDef
+#undef IWDG_TypeDef
+#undef EXTI_TypeDef
+#undef SYSCFG_TypeDef
+
+#undef RCC
+#undef FLASH
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOF
+#undef TIM1
+#undef TIM3
+#undef TIM14
+#undef TIM16
+#undef TIM17
+#undef USART1
+#undef I2C1
+#undef SPI1
+#undef DMA1
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef IWDG
+#undef EXTI
+#undef SYSCFG
+
+#ifdef __cplusplus
+
+#include "host_reg.h"
+
+typedef struct {
+    host::Reg MODER;
+    host::Reg OTYPER;
+    host::Reg OSPEEDR;
+    host::Reg PUPDR;
+    host::Reg IDR;
+    host::Reg ODR;
+    host::Reg BSRR;
+    host::Reg LCKR;
+    host::Reg AFR[2];
+    host::Reg BRR;
+} GPIO_TypeDef;
+
+typedef struct {
+    host::Reg CR;
+    host::Reg CFGR;
+    host::Reg CIR;
+    host::Reg APB2RSTR;
+    host::Reg APB1RSTR;
+    host::Reg AHBENR;
+    host::Reg APB2ENR;
+    host::Reg APB1ENR;
+    host::Reg BDCR;
+    host::Reg CSR;
+    host::Reg AHBRSTR;
+    host::Reg CFGR2;
+    host::Reg CFGR3;
+    host::Reg CR2;
+} RCC_TypeDef;
+
+typedef struct {
+    host::Reg ACR;
+    host::Reg KEYR;
+    host::Reg OPTKEYR;
+    host::Reg SR;
+    host::Reg CR;
+    host::AddrReg AR;
+    host::Reg RESERVED;
+    host::Reg OBR;
+    host::Reg WRPR;
+} FLASH_TypeDef;
+
+typedef struct {
+    host::Reg CR1;
+    host::Reg CR2;
+    host::Reg SMCR;
+    host::Reg DIER;
+    host::Reg SR;
+    host::Reg EGR;
+    host::Reg CCMR1;
+    host::Reg CCMR2;
+    host::Reg CCER;
+    host::Reg CNT;
+    host::Reg PSC;
+    host::Reg ARR;
+    host::Reg RCR;
+    host::Reg CCR1;
+    host::Reg CCR2;
+    host::Reg CCR3;
+    host::Reg CCR4;
+    host::Reg BDTR;
+    host::Reg DCR;
+    host::Reg DMAR;
+    host::Reg OR;
+} TIM_TypeDef;
+
+typedef struct {
+    host::Reg CR1;
+    host::Reg CR2;
+    host::Reg CR3;
+    host::Reg BRR;
+    host::Reg GTPR;
+    host::Reg RTOR;
+    host::Reg RQR;
+    host::Reg ISR;
+    host::Reg ICR;
+    host::Reg RDR;
+    host::Reg TDR;
+} USART_TypeDef;
+
+typedef struct {
+    host::Reg CR1;
+    host::Reg CR2;
+    host::Reg OAR1;
+    host::Reg OAR2;
+    host::Reg TIMINGR;
+    host::Reg TIMEOUTR;
+    host::Reg ISR;
+    host::Reg ICR;
+    host::Reg PECR;
+    host::Reg RXDR;
+    host::Reg TXDR;
+} I2C_TypeDef;
+
+typedef struct {
+    host::Reg CR1;
+    host::Reg CR2;
+    host::Reg SR;
+    host::Reg DR;
+    host::Reg CRCPR;
+    host::Reg RXCRCR;
+    host::Reg TXCRCR;
+    host::Reg I2SCFGR;
+} SPI_TypeDef;
+
+typedef struct {
+    host::Reg CCR;
+    host::Reg CNDTR;
+    host::AddrReg CPAR;
+    host::AddrReg CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    host::Reg ISR;
+    host::Reg IFCR;
+} DMA_TypeDef;
+
+typedef struct {
+    host::Reg KR;
+    host::Reg PR;
+    host::Reg RLR;
+    host::Reg SR;
+    host::Reg WINR;
+} IWDG_TypeDef;
+
+typedef struct {
+    host::Reg IMR;
+    host::Reg EMR;
+    host::Reg RTSR;
+    host::Reg FTSR;
+    host::Reg SWIER;
+    host::Reg PR;
+} EXTI_TypeDef;
+
+typedef struct {
+    host::Reg CFGR1;
+    host::Reg RESERVED;
+    host::Reg EXTICR[4];
+    host::Reg CFGR2;
+} SYSCFG_TypeDef;
+
+namespace host {
+    extern RCC_TypeDef rcc;
+    extern FLASH_TypeDef flash;
+    extern GPIO_TypeDef gpioa, gpiob, gpioc, gpiod, gpiof;
+    extern TIM_TypeDef tim1, tim3, tim14, tim16, tim17;
+    extern USART_TypeDef usart1;
+    extern I2C_TypeDef i2c1;
+    extern SPI_TypeDef spi1;
+    extern DMA_TypeDef dma1;
+    extern DMA_Channel_TypeDef dma1_ch[5];
+    extern IWDG_TypeDef iwdg;
+    extern EXTI_TypeDef exti;
+    extern SYSCFG_TypeDef syscfg;
+}
+
+#define RCC             (&host::rcc)
+#define FLASH           (&host::flash)
+#define GPIOA           (&host::gpioa)
+#define GPIOB           (&host::gpiob)
+#define GPIOC           (&host::gpioc)
+#define GPIOD           (&host::gpiod)
+#define GPIOF           (&host::gpiof)
+#define TIM1            (&host::tim1)
+#define TIM3            (&host::tim3)
+#define TIM14           (&host::tim14)
+#define TIM16           (&host::tim16)
+#define TIM17           (&host::tim17)
+#define USART1          (&host::usart1)
+#define I2C1            (&host::i2c1)
+#define SPI1            (&host::spi1)
+#define DMA1            (&host::dma1)
+#define DMA1_Channel1   (&host::dma1_ch[0])
+#define DMA1_Channel2   (&host::dma1_ch[1])
+#define DMA1_Channel3   (&host::dma1_ch[2])
+#define DMA1_Channel4   (&host::dma1_ch[3])
+#define DMA1_Channel5   (&host::dma1_ch[4])
+#define IWDG            (&host::iwdg)
+#define EXTI            (&host::exti)
+#define SYSCFG          (&host::syscfg)
+
+#endif /* __cplusplus */
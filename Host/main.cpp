@@ -0,0 +1,134 @@
+/**
+ * @file main.cpp
+ * @brief Запуск прошивки на хосте поверх моделей периферии
+ *
+ * Использование: stm32f0_basic_host [секунды] [ввод UART] [квант мкс]
+ *   секунды   — сколько модельного времени прогнать app_loop (по умолчанию 10)
+ *   ввод UART — строка, которая придёт по USART1 через 1 с после старта ('1'..'4' = кнопки)
+ *   квант мкс — модельное время одной итерации app_loop (по умолчанию 20)
+ *
+ * Нагреватель (TIM3 CH1) греет простую тепловую модель, температура которой
+ * отдаётся датчиком DS18B20, так что PID-контур Controller работает замкнуто.
+ *
+ * Вариант stm32f0_basic_host_tickless собран с APP_TICKLESS: после каждой
+ * итерации app_idle() усыпляет ядро (WFI), и в сводке видно, сколько раз
+ * в секунду оно просыпается и какую долю времени спит.
+ *
+ * Вывод USART1 печатается как текст: записи журнала (кадры ProtoCommand::Log)
+ * восстанавливаются по секции logfmt этого же процесса, текст вне кадров — как есть.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "stm32f0xx.h"
+#include "host_sim.hpp"
+
+#include "AppContext.hpp"
+#include "app_loop.hpp"
+#include "hardware_init.hpp"
+#include "services_init.hpp"
+
+#if !defined LOG_TEXT
+#include "ProtoClient.hpp"
+#include "LogDecoder.hpp"
+
+extern "C" const char __start_logfmt[];
+extern "C" const char __stop_logfmt[];
+#endif
+
+App app{};
+
+namespace {
+    /// Тепловая модель: T' = (P * Gain - (T - Ambient)) / Tau
+    struct ThermalPlant {
+        double temperature = 22.0;
+        static constexpr double Ambient = 22.0;
+        static constexpr double Gain = 60.0;   ///< Перегрев при 100% мощности (°C)
+        static constexpr double Tau = 30.0;    ///< Постоянная времени (с)
+
+        void step(double power, double dt) {
+            temperature += (power * Gain - (temperature - Ambient)) * dt / Tau;
+        }
+    };
+
+    double heater_power() {
+        const uint32_t arr = TIM3->ARR;
+        return arr ? static_cast<double>(TIM3->CCR1) / arr : 0.0;
+    }
+
+    void print_lcd() {
+        const uint8_t *ram = host::lcd_ram();
+        std::printf("LCD RAM:");
+        for (uint8_t i = 0; i < 32; ++i) std::printf(" %X", ram[i]);
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const char *uart_input = argc > 2 ? argv[2] : nullptr;
+    const uint64_t quantum_us = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20;
+
+    host::reset();
+
+    __disable_irq();
+    hardware_init(app);
+    __enable_irq();
+    services_init(app);
+
+    ThermalPlant plant;
+    const auto end_us = static_cast<uint64_t>(seconds * 1e6);
+    uint64_t next_plant_us = 0;
+    bool uart_sent = false;
+    uint64_t iterations = 0;
+
+    while (host::now_us() < end_us) {
+        if (uart_input && !uart_sent && host::now_us() >= 1'000'000) {
+            host::uart_rx(uart_input);
+            uart_sent = true;
+        }
+
+        // Во сне модельное время уходит вперёд скачком — догоняем тепловую модель
+        while (host::now_us() >= next_plant_us) {
+            plant.step(heater_power(), 0.01);
+            host::ds18b20_set_temperature(static_cast<int>(plant.temperature * 10.0));
+            next_plant_us += 10'000;
+        }
+
+        app_loop(app);
+        app_idle(app);
+        ++iterations;
+        host::advance_us(quantum_us);
+    }
+
+#if defined LOG_TEXT
+    std::fwrite(host::uart_tx().data(), 1, host::uart_tx().size(), stdout);
+#else
+    ProtoClient client;
+    client.feed(reinterpret_cast<const uint8_t *>(host::uart_tx().data()), host::uart_tx().size());
+    const LogDecoder decoder(__start_logfmt, static_cast<size_t>(__stop_logfmt - __start_logfmt));
+    for (const auto &l: client.logs()) std::printf("%s\r\n", decoder.decode(l).c_str());
+    std::fwrite(client.text().data(), 1, client.text().size(), stdout);
+#endif
+    std::printf("\n--- host run: %.1f s ---\n", seconds);
+    const double total_s = static_cast<double>(host::now_cycles()) / host::CoreClockHz;
+    std::printf("app_loop iterations: %llu\n", static_cast<unsigned long long>(iterations));
+    std::printf("Wakeups (WFI):       %.1f /s, asleep %.2f%%\n",
+                static_cast<double>(host::wfi_count()) / total_s,
+                100.0 * static_cast<double>(host::sleep_cycles()) / static_cast<double>(host::now_cycles()));
+    std::printf("Interrupts:          %.1f /s\n", static_cast<double>(host::irq_count()) / total_s);
+    std::printf("DS18B20 conversions: %u\n", host::ds18b20_conversions());
+    std::printf("Plant temperature:   %.1f C, heater %.0f%%\n", plant.temperature, heater_power() * 100.0);
+    std::printf("IWDG reloads:        %u%s\n", host::iwdg_reloads(), host::iwdg_expired() ? " (EXPIRED)" : "");
+    std::printf("UART RX overruns:    %u\n", host::uart_rx_overruns());
+    const auto queue_stats = app.queue->stats();
+    std::printf("Event queue:         %u pushed, %u dropped, high watermark %u/%u\n",
+                queue_stats.pushed, queue_stats.dropped,
+                queue_stats.highWatermark, static_cast<unsigned>(EventQueue::MaxEvents));
+    std::printf("LCD frames/bits:     %u / %llu\n", host::lcd_frames(),
+                static_cast<unsigned long long>(host::lcd_bits()));
+    print_lcd();
+
+    return host::iwdg_expired() ? 1 : 0;
+}
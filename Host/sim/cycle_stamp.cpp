@@ -0,0 +1,64 @@
+#include "host_sim.hpp"
+
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <ctime>
+
+/**
+ * Метки для CycleCounter::now() в хост-сборке.
+ *
+ * Предпочтительно — число выполненных инструкций пользовательского режима
+ * (perf_event_open, PERF_COUNT_HW_INSTRUCTIONS): оно не зависит от частоты
+ * и загрузки хоста, поэтому пригодно для отслеживания регрессий.
+ * Если счётчик недоступен (контейнер, perf_event_paranoid), берётся TSC.
+ */
+namespace {
+    int g_perf_fd = -2;   ///< -2 — ещё не открывали, -1 — недоступен
+
+    int perf_fd() {
+        if (g_perf_fd != -2) return g_perf_fd;
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        g_perf_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (g_perf_fd < 0) g_perf_fd = -1;
+        return g_perf_fd;
+    }
+
+    uint64_t fallback_stamp() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + ts.tv_nsec;
+#endif
+    }
+}
+
+extern "C" uint32_t host_cycle_stamp(void) {
+    const int fd = perf_fd();
+    if (fd >= 0) {
+        uint64_t count = 0;
+        if (read(fd, &count, sizeof(count)) == sizeof(count)) return static_cast<uint32_t>(count);
+    }
+    return static_cast<uint32_t>(fallback_stamp());
+}
+
+const char *host::cycle_stamp_unit() {
+#if defined(__x86_64__) || defined(__i386__)
+    return perf_fd() >= 0 ? "instructions" : "tsc";
+#else
+    return perf_fd() >= 0 ? "instructions" : "ns";
+#endif
+}
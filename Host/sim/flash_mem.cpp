@@ -0,0 +1,213 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <cstring>
+
+using namespace host::detail;
+
+/**
+ * Модель контроллера flash (FLASH_KEYR/SR/CR/AR) над страницами хранилища _skvstore.
+ *
+ * Прошивка пишет полуслово в память обычной записью при CR.PG, как на железе, поэтому
+ * модель узнаёт о записи по разнице памяти с теневой копией — при следующем доступе
+ * к FLASH_SR или FLASH_CR. Запись в ячейку, уже не равную 0xFFFF, не выполняется
+ * (PGERR), кроме записи 0x0000; стирание — только страницы хранилища по FLASH_AR.
+ *
+ * Пока идёт запись или стирание, ядро стоит (код выполняется из той же flash):
+ * время модели идёт, прерывания ждут конца операции. Одновременно запущенная
+ * последовательность 1-Wire (TIM1 со слотами короче 10 мс) считается конфликтом:
+ * DMA1 Ch4 берёт длительности слотов из flash и тоже ждал бы.
+ *
+ * Обрыв питания: операция с заданным номером выполняется частично (у полуслова
+ * запрограммирована часть нулевых битов, у страницы стёрта часть байтов), а все
+ * следующие не выполняются до host::reset(). Содержимое flash reset() не трогает.
+ */
+namespace {
+    constexpr uint64_t ProgramCycles = 60ULL * host::CoreClockHz / 1'000'000;   ///< tPROG, худшее
+    constexpr uint64_t EraseCycles = 40ULL * host::CoreClockHz / 1'000;         ///< tERASE, худшее
+    constexpr size_t Size = host::FlashKvPages * host::FlashPageSize;
+    constexpr uint32_t NoCut = UINT32_MAX;
+}
+
+extern "C" {
+    alignas(host::FlashPageSize) uint8_t _skvstore[Size];
+}
+
+namespace host {
+    FLASH_TypeDef flash;
+}
+
+namespace {
+    struct FlashModel {
+        uint8_t shadow[Size];          ///< Содержимое после последней учтённой операции
+        uint8_t key_step = 0;          ///< Принятых ключей FLASH_KEYR
+        uint32_t ops = 0;              ///< Операций с последнего flash_cut_after()
+        uint32_t cut_at = NoCut;
+        bool cut_erase = false;        ///< Обрыв на ближайшем стирании
+        bool cut = false;
+        uint32_t rng = 1;
+        host::FlashStats stats;
+    };
+
+    FlashModel g_flash;
+
+    uint32_t random_bits() {
+        // xorshift32: воспроизводимые обрывы по seed
+        uint32_t x = g_flash.rng;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return g_flash.rng = x;
+    }
+
+    /// Идёт последовательность слотов 1-Wire (сброс, команда, чтение), а не пауза или ожидание
+    bool onewire_active() {
+        return (host::tim1.CR1.value & TIM_CR1_CEN) && host::tim1.ARR.value < 10'000;
+    }
+
+    /// Начало операции: true — выполнить полностью, false — обрыв на ней
+    bool start_op(uint64_t cycles, bool erase = false) {
+        if (onewire_active()) ++g_flash.stats.onewire_conflicts;
+        if (g_flash.ops++ == g_flash.cut_at || (erase && g_flash.cut_erase)) {
+            g_flash.cut = true;
+            return false;
+        }
+        g_flash.stats.stall_cycles += cycles;
+        if (cycles > g_flash.stats.max_stall_cycles) g_flash.stats.max_stall_cycles = cycles;
+        return true;
+    }
+
+    bool locked() {
+        return host::flash.CR.value & FLASH_CR_LOCK;
+    }
+
+    uint16_t load16(const uint8_t *p, size_t i) {
+        return static_cast<uint16_t>(p[i] | (p[i + 1] << 8));
+    }
+
+    void store16(uint8_t *p, size_t i, uint16_t v) {
+        p[i] = static_cast<uint8_t>(v);
+        p[i + 1] = static_cast<uint8_t>(v >> 8);
+    }
+
+    void error(uint32_t flag) {
+        host::flash.SR.value |= flag;
+        ++g_flash.stats.errors;
+    }
+
+    void program(size_t i, uint16_t value) {
+        const uint16_t old = load16(g_flash.shadow, i);
+        if (g_flash.cut) {
+            store16(_skvstore, i, old);
+            return;
+        }
+        if (locked() || !(host::flash.CR.value & FLASH_CR_PG) || (old != 0xFFFF && value != 0x0000)) {
+            store16(_skvstore, i, old);
+            error(FLASH_SR_PGERR);
+            return;
+        }
+
+        if (start_op(ProgramCycles)) {
+            store16(g_flash.shadow, i, value);
+            ++g_flash.stats.programs;
+            host::flash.SR.value |= FLASH_SR_EOP;
+            cpu_stall(ProgramCycles);
+        } else {
+            // Запрограммирована только часть нулевых битов
+            const auto torn = static_cast<uint16_t>(old & (value | (random_bits() & ~value)));
+            store16(_skvstore, i, torn);
+            store16(g_flash.shadow, i, torn);
+        }
+    }
+
+    void erase(uintptr_t address) {
+        const auto base = reinterpret_cast<uintptr_t>(_skvstore);
+        if (g_flash.cut) return;
+        if (locked() || address < base || address >= base + Size) {
+            error(FLASH_SR_WRPRTERR);
+            return;
+        }
+
+        uint8_t *page = _skvstore + (address - base) / host::FlashPageSize * host::FlashPageSize;
+        if (start_op(EraseCycles, true)) {
+            std::memset(page, 0xFF, host::FlashPageSize);
+            ++g_flash.stats.erases;
+            host::flash.SR.value |= FLASH_SR_EOP;
+            cpu_stall(EraseCycles);
+        } else {
+            for (size_t i = 0; i < host::FlashPageSize; ++i) {
+                if (random_bits() & 1) page[i] = 0xFF;
+            }
+        }
+        std::memcpy(g_flash.shadow + (page - _skvstore), page, host::FlashPageSize);
+    }
+}
+
+void host::detail::flash_reset() {
+    flash.KEYR.id = FlashKeyr;
+    flash.SR.id = FlashSr;
+    flash.CR.id = FlashCr;
+    flash.CR.value = FLASH_CR_LOCK;
+    g_flash.key_step = 0;
+    g_flash.cut = false;
+    g_flash.cut_at = NoCut;
+    g_flash.cut_erase = false;
+    g_flash.stats = {};
+    std::memcpy(g_flash.shadow, _skvstore, Size);
+}
+
+void host::detail::flash_sync() {
+    for (size_t i = 0; i < Size; i += 2) {
+        const uint16_t now = load16(_skvstore, i);
+        if (now != load16(g_flash.shadow, i)) program(i, now);
+    }
+}
+
+void host::detail::flash_on_keyr(uint32_t value) {
+    if (!locked()) return;
+    if (g_flash.key_step == 0 && value == FLASH_KEY1) {
+        g_flash.key_step = 1;
+    } else if (g_flash.key_step == 1 && value == FLASH_KEY2) {
+        flash.CR.value &= ~FLASH_CR_LOCK;
+        g_flash.key_step = 0;
+    } else {
+        g_flash.key_step = 0;
+    }
+}
+
+void host::detail::flash_on_cr(uint32_t value) {
+    flash_sync();
+    if (locked()) return;   // До разблокировки CR не пишется
+
+    flash.CR.value = value & ~FLASH_CR_STRT;
+    if ((value & FLASH_CR_STRT) && (value & FLASH_CR_PER)) erase(flash.AR.value);
+}
+
+void host::flash_erase_all() {
+    std::memset(_skvstore, 0xFF, Size);
+    std::memcpy(g_flash.shadow, _skvstore, Size);
+}
+
+void host::flash_cut_after(uint32_t ops, uint32_t seed) {
+    g_flash.ops = 0;
+    g_flash.cut_at = ops;
+    g_flash.rng = seed ? seed : 1;
+}
+
+void host::flash_cut_at_erase(uint32_t seed) {
+    g_flash.cut_erase = true;
+    g_flash.rng = seed ? seed : 1;
+}
+
+bool host::flash_cut() {
+    return g_flash.cut;
+}
+
+const host::FlashStats &host::flash_stats() {
+    return g_flash.stats;
+}
+
+namespace {
+    /// Чистая flash при запуске программы
+    [[maybe_unused]] const bool g_erased = (host::flash_erase_all(), true);
+}
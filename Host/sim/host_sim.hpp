@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "stm32f0xx.h"
+
+/**
+ * @brief Модель микроконтроллера для хост-сборки (HOST_BUILD)
+ *
+ * Время модели считается в тактах ядра (48 МГц) и продвигается только явно:
+ * advance_us()/advance_cycles() из управляющей программы или __WFI() из прошивки.
+ * За это время срабатывают SysTick, события обновления таймеров, приём по USART1,
+ * а прерывания вызываются теми же обработчиками, что и на железе
+ * (SysTick_Handler, USART1_IRQHandler, TIM17_IRQHandler, EXTIx_IRQHandler ...).
+ *
+ * Внешние устройства:
+ * - передача USART1 через DMA1 Ch2 (CR3.DMAT): канал отдаёт байты в TDR и поднимает TCIF2;
+ * - прием USART1 через DMA1 Ch3 или Ch5 (ремап в SYSCFG_CFGR1, CR3.DMAR), в т.ч. по кругу,
+ *   и флаг IDLE через кадр тишины после последнего байта;
+ * - датчики DS18B20 на PA8 (TIM1 + DMA1 Ch3/Ch4) отвечают на Skip ROM / Match ROM / Search ROM,
+ *   Convert T и Read Scratchpad;
+ * - контроллер HT1621B на PB5/PB4/PB3 (CS/WR/DATA) декодирует посылки в свою RAM;
+ *   если PB3 в режиме альтернативной функции — он на SPI1 (SCK PB3, MOSI PB5, CS PB4);
+ * - ведомые-памяти на I2C1 (по умолчанию шина пуста) с темпом SCL из TIMINGR;
+ * - страницы flash хранилища (_skvstore): запись полуслов и стирание с остановкой ядра;
+ * - кнопки — входы GPIO с подтяжкой к питанию (по умолчанию отпущены).
+ */
+namespace host {
+    /// Частота ядра модели (Гц), совпадает с SYSTEM_CLOCK_HZ
+    constexpr uint32_t CoreClockHz = 48'000'000;
+
+    /**
+     * @brief Сброс по питанию: регистры в исходное состояние, время = 0, внешние устройства по умолчанию
+     */
+    void reset();
+
+    /**
+     * @brief Продвинуть время модели, обработав все события и прерывания на пути
+     */
+    void advance_cycles(uint64_t cycles);
+
+    inline void advance_us(uint64_t us) { advance_cycles(us * (CoreClockHz / 1'000'000)); }
+
+    /** Текущее время модели в тактах ядра */
+    uint64_t now_cycles();
+
+    inline uint64_t now_us() { return now_cycles() / (CoreClockHz / 1'000'000); }
+
+    /**
+     * @brief Вызвать обработчики всех активных и разрешённых прерываний (если не замаскированы PRIMASK)
+     */
+    void service_irqs();
+
+    /**
+     * @brief Такт ближайшего запланированного события (SysTick, таймер, байт USART)
+     * @return UINT64_MAX, если событий нет
+     */
+    uint64_t next_event_cycles();
+
+    /**
+     * @brief Единица измерения host_cycle_stamp(): "instructions" (perf_event), иначе "tsc" или "ns"
+     */
+    const char *cycle_stamp_unit();
+
+    /** Количество выполненных __WFI()/__WFE() (пробуждений) */
+    uint64_t wfi_count();
+
+    /** Сколько тактов ядро провело во сне внутри __WFI()/__WFE() */
+    uint64_t sleep_cycles();
+
+    /** Количество вызванных обработчиков прерываний (включая SysTick) */
+    uint64_t irq_count();
+
+    /** То же для одной линии IRQn */
+    uint64_t irq_count(IRQn_Type irq);
+
+    //=========================================================================
+    // USART1
+    //=========================================================================
+
+    /** Поставить байты в линию RX; они приходят с темпом, заданным BRR (10 бит на байт) */
+    void uart_rx(const char *s);
+    void uart_rx(const uint8_t *data, size_t len);
+
+    /** Всё, что прошивка записала в TDR с последней очистки */
+    const std::string &uart_tx();
+    void uart_tx_clear();
+
+    /** Количество байт, потерянных моделью из-за ORE (RDR не прочитан вовремя) */
+    uint32_t uart_rx_overruns();
+
+    /**
+     * @brief Темп передачи: false (по умолчанию) — байт уходит в линию сразу при записи TDR
+     *        или по запросу DMA, true — один байт за 10 бит BRR, как на проводе
+     * @note С темпом flush() прошивки на хосте не вернётся: время модели само не идёт
+     */
+    void uart_tx_paced(bool paced);
+
+    //=========================================================================
+    // GPIO
+    //=========================================================================
+
+    /** Уровень на входе (для пинов в режиме Input); фронты доходят до EXTI по SYSCFG_EXTICRx */
+    void gpio_input(GPIO_TypeDef *port, uint8_t pin, bool level);
+
+    /** Количество переключений выходов порта (сумма по всем пинам) */
+    uint64_t gpio_toggles(GPIO_TypeDef *port);
+
+    //=========================================================================
+    // IWDG
+    //=========================================================================
+
+    uint32_t iwdg_reloads();
+
+    /** Истёк ли сторожевой таймер хотя бы раз (на железе это был бы сброс) */
+    bool iwdg_expired();
+
+    //=========================================================================
+    // DS18B20 (PA8)
+    //=========================================================================
+
+    /** Датчиков на шине (1..16, по умолчанию 1); коды ROM у каждого свои и постоянные */
+    void ds18b20_set_count(uint8_t count);
+
+    /** Подключить или отключить все датчики / датчик index */
+    void ds18b20_attach(bool present);
+    void ds18b20_attach(uint8_t index, bool present);
+
+    /** Температура, которую вернёт следующее преобразование (десятые доли °C): всем / датчику index */
+    void ds18b20_set_temperature(int tenths);
+    void ds18b20_set_temperature(uint8_t index, int tenths);
+
+    /** 64-битный код ROM датчика index (8 байт, младший первым) */
+    const uint8_t *ds18b20_rom(uint8_t index);
+
+    /** Время преобразования в процентах от наихудшего tCONV разрешения (по умолчанию 100) */
+    void ds18b20_set_conversion_percent(uint8_t percent);
+
+    /** Разрешение датчика index по регистру конфигурации (9..12) */
+    uint8_t ds18b20_resolution(uint8_t index);
+
+    /** Сброс питания датчика index: +85 °C и 12 бит из EEPROM, записанное Write Scratchpad теряется */
+    void ds18b20_power_cycle(uint8_t index);
+
+    /** Не ответить присутствием на reset номер reset, считая от вызова (1 — ближайший, 0 — отмена) */
+    void ds18b20_drop_presence(uint32_t reset);
+
+    /** Принято команд Convert T */
+    uint32_t ds18b20_conversions();
+
+    //=========================================================================
+    // HT1621B (PB5/PB4/PB3)
+    //=========================================================================
+
+    /** RAM контроллера HT1621B (32 ниббла), как её видит стекло */
+    const uint8_t *lcd_ram();
+
+    /** Количество посылок (CS low..high), принятых контроллером */
+    uint32_t lcd_frames();
+
+    /** Количество бит, защёлкнутых по фронту WR */
+    uint64_t lcd_bits();
+
+    /** Переключений выводов CS/WR/DATA */
+    uint64_t lcd_toggles();
+
+    //=========================================================================
+    // SPI1 (PB3/PB5), только передача
+    //=========================================================================
+
+    struct SpiStats {
+        uint32_t words = 0;          ///< Слов выдвинуто
+        uint64_t bits = 0;           ///< Бит выдвинуто
+        uint64_t busy_cycles = 0;    ///< Тактов ядра, пока сдвиговый регистр работал
+    };
+
+    /** Счётчики с последнего host::reset() */
+    const SpiStats &spi_stats();
+
+    //=========================================================================
+    // I2C1 (PB6/PB7)
+    //=========================================================================
+
+    /**
+     * @brief Подключить ведомое-память (как 24Cxx): после адреса с записью первые
+     *        addr_bytes байт — указатель (старший первым), дальше данные; указатель
+     *        растёт с каждым байтом и в чтении, по кругу в пределах size
+     * @param page Размер страницы записи (степень двойки): запись заворачивает указатель
+     *        внутри страницы; 0 — без страниц
+     * @param write_cycle_us Цикл записи страницы после STOP, всё это время адрес — NACK
+     */
+    void i2c_attach(uint8_t address, size_t size, uint8_t addr_bytes, uint16_t page = 0,
+                    uint32_t write_cycle_us = 0);
+
+    void i2c_detach(uint8_t address);
+
+    /** Память ведомого (изначально 0xFF); nullptr, если устройства нет */
+    uint8_t *i2c_memory(uint8_t address);
+
+    /** Число циклов записи каждой страницы (при page > 0 и write_cycle_us > 0) */
+    const std::vector<uint32_t> &i2c_page_writes(uint8_t address);
+
+    /** Ведомый держит SCL после своего адреса (бесконечное растяжение такта) */
+    void i2c_hold_scl(uint8_t address, bool hold);
+
+    struct I2cStats {
+        uint64_t busy_cycles = 0;    ///< Шина занята: от START до STOP (или сброса PE)
+        uint64_t shift_cycles = 0;   ///< Из них SCL тактировал START/адрес/байты/STOP
+        uint32_t bytes = 0;          ///< Байт данных (без адресов)
+        uint32_t starts = 0;         ///< START, включая повторные
+        uint32_t stops = 0;
+        uint32_t nacks = 0;          ///< Адрес без ответа
+    };
+
+    const I2cStats &i2c_stats();
+
+    //=========================================================================
+    // Flash: страницы хранилища (_skvstore)
+    //=========================================================================
+
+    /// Страница flash STM32F030x6 и число страниц хранилища в модели (FLASH_KV_PAGE_SIZE × 2)
+    constexpr size_t FlashPageSize = 1024;
+    constexpr size_t FlashKvPages = 2;
+
+    /** Стереть страницы хранилища (0xFF); host::reset() содержимое не трогает */
+    void flash_erase_all();
+
+    /**
+     * @brief Обрыв питания на операции номер ops (0 — ближайшая запись полуслова или стирание)
+     * @note Операция выполняется частично (seed задаёт, какие биты/байты успели), следующие —
+     *       не выполняются, пока host::reset() не «включит питание»
+     */
+    void flash_cut_after(uint32_t ops, uint32_t seed);
+
+    /**
+     * @brief Обрыв питания на ближайшем стирании страницы (стёрта часть байтов, seed — какая)
+     */
+    void flash_cut_at_erase(uint32_t seed);
+
+    /** Обрыв, заданный flash_cut_after() или flash_cut_at_erase(), произошёл */
+    bool flash_cut();
+
+    struct FlashStats {
+        uint32_t programs = 0;            ///< Записано полуслов
+        uint32_t erases = 0;              ///< Стёрто страниц
+        uint32_t errors = 0;              ///< PGERR/WRPRTERR
+        uint32_t onewire_conflicts = 0;   ///< Операций во время слотов 1-Wire
+        uint64_t stall_cycles = 0;        ///< Ядро стояло из-за записи и стирания
+        uint64_t max_stall_cycles = 0;    ///< Самая долгая остановка
+    };
+
+    /** Счётчики с последнего host::reset() */
+    const FlashStats &flash_stats();
+}
+
+/// Страницы хранилища (на железе — символ скрипта компоновки)
+extern "C" uint8_t _skvstore[];
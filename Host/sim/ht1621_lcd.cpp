@@ -0,0 +1,116 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <vector>
+
+using namespace host::detail;
+
+/**
+ * Модель HT1621B: CS = PB5, WR = PB4, DATA = PB3.
+ *
+ * Если PB3 переведён в альтернативную функцию, контроллер считается подключённым
+ * к SPI1 (плата HT1621_SPI): WR = SCK (PB3), DATA = MOSI (PB5), CS = PB4.
+ * Тогда биты приходят словами от модели SPI1, старший первым.
+ *
+ * Спад CS открывает посылку, каждый фронт WR защёлкивает DATA,
+ * подъём CS разбирает посылку:
+ * - 100 + 9 бит — команда (состояние модели не меняет);
+ * - 101 + адрес A5..A0 + ниббл(ы) D0..D3 — запись в RAM, каждый
+ *   следующий ниббл уходит по следующему адресу (successive address write).
+ */
+namespace {
+    constexpr uint32_t CsPin = 1U << 5;
+    constexpr uint32_t WrPin = 1U << 4;
+    constexpr uint32_t DataPin = 1U << 3;
+    constexpr uint32_t SpiCsPin = 1U << 4;
+    constexpr uint8_t RamSize = 32;
+
+    struct LcdModel {
+        bool selected = false;
+        std::vector<uint8_t> bits;
+        uint8_t ram[RamSize] = {};
+        uint32_t frames = 0;
+        uint64_t bit_count = 0;
+        uint64_t toggles = 0;
+    };
+
+    LcdModel g_lcd;
+
+    bool on_spi() {
+        return ((host::gpiob.MODER.value >> (3 * 2)) & 0b11) == 0b10;
+    }
+
+    uint32_t take(size_t &pos, uint8_t n) {
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < n; ++i) v = (v << 1) | g_lcd.bits[pos++];
+        return v;
+    }
+
+    void decode_frame() {
+        const auto &bits = g_lcd.bits;
+        if (bits.size() < 3) return;
+
+        size_t pos = 0;
+        const uint32_t id = take(pos, 3);
+        ++g_lcd.frames;
+
+        if (id != 0b101 || bits.size() < 3 + 6) return;
+
+        uint8_t address = static_cast<uint8_t>(take(pos, 6));
+        while (bits.size() - pos >= 4) {
+            uint8_t nibble = 0;
+            for (uint8_t i = 0; i < 4; ++i) nibble |= static_cast<uint8_t>(bits[pos++] << i);
+            g_lcd.ram[address % RamSize] = nibble;
+            address = static_cast<uint8_t>((address + 1) % RamSize);
+        }
+    }
+}
+
+void host::detail::lcd_reset() {
+    g_lcd = {};
+}
+
+void host::detail::lcd_on_gpiob(uint32_t before, uint32_t after) {
+    const uint32_t changed = before ^ after;
+    const bool spi = on_spi();
+    const uint32_t cs = spi ? SpiCsPin : CsPin;
+    // На SPI выводами WR/DATA управляет периферия, программа переключает только CS
+    g_lcd.toggles += static_cast<uint64_t>(__builtin_popcount(changed & (spi ? cs : CsPin | WrPin | DataPin)));
+
+    if ((changed & cs) && !(after & cs)) {
+        g_lcd.selected = true;
+        g_lcd.bits.clear();
+    }
+
+    if (!spi && g_lcd.selected && (changed & WrPin) && (after & WrPin)) {
+        g_lcd.bits.push_back((after & DataPin) ? 1 : 0);
+        ++g_lcd.bit_count;
+    }
+
+    if ((changed & cs) && (after & cs) && g_lcd.selected) {
+        g_lcd.selected = false;
+        decode_frame();
+    }
+}
+
+void host::detail::lcd_on_spi(uint32_t word, uint8_t bits) {
+    if (!on_spi() || !g_lcd.selected) return;
+    for (uint8_t i = bits; i-- > 0;) g_lcd.bits.push_back((word >> i) & 1);
+    g_lcd.bit_count += bits;
+}
+
+const uint8_t *host::lcd_ram() {
+    return g_lcd.ram;
+}
+
+uint32_t host::lcd_frames() {
+    return g_lcd.frames;
+}
+
+uint64_t host::lcd_bits() {
+    return g_lcd.bit_count;
+}
+
+uint64_t host::lcd_toggles() {
+    return g_lcd.toggles;
+}
@@ -0,0 +1,370 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace host::detail;
+
+/**
+ * Модель I2C1 в режиме ведущего и ведомых-памятей на шине.
+ *
+ * Сроки считаются по TIMINGR и источнику I2CCLK (RCC_CFGR3.I2C1SW): бит — период
+ * SCL, START с адресом — 10 бит, байт с ACK — 9 бит, STOP — 1 бит. TXDR и RXDR
+ * двойные, как у железа: следующий байт можно записать (прочитать), пока текущий
+ * идёт по линии. Если прошивка не успевает, ведущий растягивает SCL — это время
+ * видно в i2c_stats() как разница между busy_cycles и shift_cycles.
+ *
+ * Обработчик прошивки в модели выполняется мгновенно, поэтому на флаг, которого
+ * ждёт прошивка (TXIS при пустом сдвиговом регистре, TC, TCR, STOPF), линия
+ * отвечает не раньше чем через IsrCostCycles — вход в прерывание и выход из него.
+ * Новый START после STOP идёт не раньше tBUF (4,7 мкс до 100 кГц, 1,3 мкс выше).
+ *
+ * Последовательность как у ведущего STM32F0: NBYTES кусками, TCR при RELOAD,
+ * TC без AUTOEND (дальше повторный START или STOP), STOP сам при AUTOEND и после
+ * NACK. Ведомые не NACK-ают данные; ошибки шины (BERR/ARLO) не моделируются.
+ *
+ * Ведомый с заданной страницей ведёт себя как 24Cxx: запись заворачивает указатель
+ * внутри страницы, после STOP идёт внутренний цикл записи, в течение которого
+ * ведомый не отвечает на свой адрес (ACK polling), а счётчик записей страницы растёт.
+ */
+namespace {
+    constexpr uint32_t HsiHz = 8'000'000;
+    /// Вход в обработчик и выход из него на Cortex-M0 (16 + 16 тактов без ожидания флеш)
+    constexpr uint64_t IsrCostCycles = 32;
+    /// Минимальная пауза шины между STOP и START (I2C-bus spec, Sm / Fm)
+    constexpr uint64_t BufStandardNs = 4'700;
+    constexpr uint64_t BufFastNs = 1'300;
+
+    enum class Step : uint8_t {
+        Idle,      ///< Шина свободна
+        Address,   ///< START и адрес на линии
+        Data,      ///< Байты текущего куска NBYTES
+        Wait,      ///< Ждём прошивку после TCR или TC
+        Stop,      ///< STOP на линии
+        Held,      ///< Ведомый держит SCL
+    };
+
+    struct Slave {
+        uint8_t address;
+        uint8_t addr_bytes;
+        uint16_t page;                   ///< Запись заворачивает указатель внутри страницы (0 — нет)
+        uint64_t write_cycle;            ///< Внутренний цикл записи после STOP (такты), адрес — NACK
+        bool hold_scl = false;
+        std::vector<uint8_t> mem;
+        uint32_t pointer = 0;
+        uint8_t pointer_got = 0;         ///< Байт указателя, принятых после последнего START
+        int32_t written_page = -1;       ///< Страница, в которую писали данные после START
+        uint64_t busy_until = 0;
+        std::vector<uint32_t> page_writes;
+    };
+
+    struct BusModel {
+        Step step = Step::Idle;
+        uint64_t next = Never;        ///< Конец текущего действия на линии
+        Slave *slave = nullptr;
+        bool read = false;
+        uint32_t chunk_left = 0;      ///< Байт куска, ещё не прошедших по линии
+        bool shifting = false;        ///< Байт в сдвиговом регистре
+        uint8_t shift_byte = 0;
+        bool txdr_full = false;
+        bool rx_held = false;         ///< Принятый байт ждёт, пока прочитают RXDR
+        uint64_t busy_since = 0;
+        uint64_t ready = 0;           ///< Раньше этого момента линия не тактирует (ответ прошивки, tBUF)
+        host::I2cStats stats;
+    };
+
+    std::vector<Slave> g_slaves;
+    BusModel g_bus;
+
+    uint64_t now() { return host::now_cycles(); }
+
+    uint64_t bit_cycles() {
+        const uint32_t t = host::i2c1.TIMINGR.value;
+        const uint64_t presc = ((t >> I2C_TIMINGR_PRESC_Pos) & 0xF) + 1;
+        const uint64_t scll = ((t >> I2C_TIMINGR_SCLL_Pos) & 0xFF) + 1;
+        const uint64_t sclh = ((t >> I2C_TIMINGR_SCLH_Pos) & 0xFF) + 1;
+        const uint64_t kernel = (host::rcc.CFGR3.value & RCC_CFGR3_I2C1SW) ? host::CoreClockHz : HsiHz;
+        return (scll + sclh) * presc * host::CoreClockHz / kernel;
+    }
+
+    /** Занять линию на bits периодов SCL, начиная не раньше g_bus.ready */
+    void clock_bits(uint32_t bits) {
+        const uint64_t cycles = bits * bit_cycles();
+        g_bus.next = std::max(now(), g_bus.ready) + cycles;
+        g_bus.stats.shift_cycles += cycles;
+    }
+
+    /** Выставлен флаг, на который линия ждёт ответа прошивки из обработчика */
+    void await_firmware() {
+        g_bus.ready = now() + IsrCostCycles;
+    }
+
+    /** tBUF по скорости шины: TIMINGR без времён фронтов даёт период короче номинального,
+     *  поэтому граница — посередине между Standard (10 мкс) и Fast (2,5 мкс) */
+    uint64_t buf_cycles() {
+        const uint64_t period_ns = bit_cycles() * 1'000'000'000ULL / host::CoreClockHz;
+        return (period_ns > 5'000 ? BufStandardNs : BufFastNs) * host::CoreClockHz / 1'000'000'000ULL;
+    }
+
+    Slave *find_slave(uint8_t address) {
+        for (auto &s: g_slaves) {
+            if (s.address == address) return &s;
+        }
+        return nullptr;
+    }
+
+    uint32_t nbytes() {
+        return (host::i2c1.CR2.value & I2C_CR2_NBYTES) >> I2C_CR2_NBYTES_Pos;
+    }
+
+    void slave_write(Slave &s, uint8_t byte) {
+        if (s.pointer_got < s.addr_bytes) {
+            s.pointer = (s.pointer_got ? s.pointer << 8 : 0) | byte;
+            if (++s.pointer_got == s.addr_bytes) s.pointer %= s.mem.size();
+            return;
+        }
+        s.mem[s.pointer] = byte;
+        if (s.page) {
+            s.written_page = static_cast<int32_t>(s.pointer / s.page);
+            s.pointer = (s.pointer & ~(s.page - 1U)) | ((s.pointer + 1) & (s.page - 1U));
+        } else {
+            s.pointer = (s.pointer + 1) % s.mem.size();
+        }
+    }
+
+    uint8_t slave_read(Slave &s) {
+        const uint8_t byte = s.mem[s.pointer];
+        s.pointer = (s.pointer + 1) % s.mem.size();
+        return byte;
+    }
+
+    /** TXIS: TXDR пуст, а в куске ещё есть байты, которые прошивка не записала */
+    void update_txis() {
+        const uint32_t queued = (g_bus.shifting ? 1 : 0) + (g_bus.txdr_full ? 1 : 0);
+        auto &isr = host::i2c1.ISR.value;
+        if (!g_bus.txdr_full && g_bus.chunk_left > queued) isr |= I2C_ISR_TXIS;
+        else isr &= ~I2C_ISR_TXIS;
+        if (g_bus.txdr_full) isr &= ~I2C_ISR_TXE;
+        else isr |= I2C_ISR_TXE;
+    }
+
+    void stop() {
+        g_bus.step = Step::Stop;
+        clock_bits(1);
+    }
+
+    void end_chunk() {
+        const uint32_t cr2 = host::i2c1.CR2.value;
+        if (cr2 & I2C_CR2_AUTOEND && !(cr2 & I2C_CR2_RELOAD)) {
+            stop();
+            return;
+        }
+        host::i2c1.ISR.value |= (cr2 & I2C_CR2_RELOAD) ? I2C_ISR_TCR : I2C_ISR_TC;
+        g_bus.step = Step::Wait;
+        g_bus.next = Never;
+        await_firmware();
+    }
+
+    void load_shifter() {
+        g_bus.txdr_full = false;
+        g_bus.shifting = true;
+        g_bus.shift_byte = static_cast<uint8_t>(host::i2c1.TXDR.value);
+        clock_bits(9);
+        update_txis();
+    }
+
+    /** Начать кусок из NBYTES байт в текущем направлении */
+    void start_chunk() {
+        g_bus.step = Step::Data;
+        g_bus.chunk_left = nbytes();
+        g_bus.next = Never;
+        if (g_bus.chunk_left == 0) {
+            end_chunk();
+        } else if (g_bus.read) {
+            clock_bits(9);
+        } else {
+            update_txis();
+            await_firmware();
+        }
+    }
+
+    void deliver_rx(uint8_t byte) {
+        host::i2c1.RXDR.value = byte;
+        host::i2c1.ISR.value |= I2C_ISR_RXNE;
+        ++g_bus.stats.bytes;
+        if (--g_bus.chunk_left) clock_bits(9);
+        else end_chunk();
+    }
+
+    void start_condition() {
+        auto &bus = g_bus;
+        if (bus.step == Step::Idle) {
+            bus.busy_since = std::max(now(), bus.ready);
+            host::i2c1.ISR.value |= I2C_ISR_BUSY;
+        }
+        host::i2c1.ISR.value &= ~I2C_ISR_TC;
+        bus.step = Step::Address;
+        bus.read = host::i2c1.CR2.value & I2C_CR2_RD_WRN;
+        bus.slave = find_slave(static_cast<uint8_t>((host::i2c1.CR2.value >> 1) & 0x7F));
+        bus.shifting = bus.txdr_full = bus.rx_held = false;
+        ++bus.stats.starts;
+        clock_bits(10);
+    }
+
+    void address_done() {
+        auto &bus = g_bus;
+        host::i2c1.CR2.value &= ~I2C_CR2_START;
+        if (!bus.slave || now() < bus.slave->busy_until) {
+            host::i2c1.ISR.value |= I2C_ISR_NACKF;
+            ++bus.stats.nacks;
+            stop();
+            return;
+        }
+        if (bus.slave->hold_scl) {
+            bus.step = Step::Held;
+            bus.next = Never;
+            return;
+        }
+        if (!bus.read) {
+            bus.slave->pointer_got = 0;
+            bus.slave->written_page = -1;
+        }
+        start_chunk();
+    }
+
+    void byte_done() {
+        auto &bus = g_bus;
+        if (bus.read) {
+            const uint8_t byte = slave_read(*bus.slave);
+            bus.next = Never;
+            if (host::i2c1.ISR.value & I2C_ISR_RXNE) {
+                bus.shift_byte = byte;   // RXDR не прочитан: SCL держится низким
+                bus.rx_held = true;
+            } else {
+                deliver_rx(byte);
+            }
+            return;
+        }
+
+        bus.shifting = false;
+        bus.next = Never;
+        slave_write(*bus.slave, bus.shift_byte);
+        ++bus.stats.bytes;
+        --bus.chunk_left;
+        if (bus.txdr_full) load_shifter();
+        else if (bus.chunk_left == 0) end_chunk();
+        else update_txis();
+    }
+
+    void stop_done() {
+        auto &bus = g_bus;
+        host::i2c1.ISR.value = (host::i2c1.ISR.value & ~(I2C_ISR_BUSY | I2C_ISR_TXIS)) | I2C_ISR_STOPF | I2C_ISR_TXE;
+        host::i2c1.CR2.value &= ~I2C_CR2_STOP;
+        bus.step = Step::Idle;
+        bus.next = Never;
+        bus.stats.busy_cycles += now() - bus.busy_since;
+        ++bus.stats.stops;
+        // Следующий START — после tBUF; прошивка за это время успевает ответить на STOPF
+        bus.ready = now() + std::max(buf_cycles(), IsrCostCycles);
+
+        // Данные страницы записываются в массив только после STOP
+        Slave *s = bus.slave;
+        if (s && s->written_page >= 0 && s->write_cycle) {
+            s->busy_until = now() + s->write_cycle;
+            ++s->page_writes[s->written_page];
+            s->written_page = -1;
+        }
+    }
+}
+
+void host::detail::i2c_reset() {
+    g_slaves.clear();
+    g_bus = BusModel{};
+}
+
+void host::detail::i2c_on_cr1(uint32_t before) {
+    if (!(before & I2C_CR1_PE) || (i2c1.CR1.value & I2C_CR1_PE)) return;
+
+    // PE = 0: программный сброс, линия отпускается без STOP
+    if (g_bus.step != Step::Idle) g_bus.stats.busy_cycles += now() - g_bus.busy_since;
+    const I2cStats stats = g_bus.stats;
+    g_bus = BusModel{};
+    g_bus.stats = stats;
+    i2c1.ISR.value = I2C_ISR_TXE;
+}
+
+void host::detail::i2c_on_cr2() {
+    const uint32_t cr2 = i2c1.CR2.value;
+    const uint32_t isr = i2c1.ISR.value;
+    if (!(i2c1.CR1.value & I2C_CR1_PE)) return;
+
+    if ((cr2 & I2C_CR2_START) && (g_bus.step == Step::Idle || (isr & I2C_ISR_TC))) {
+        start_condition();
+    } else if ((isr & I2C_ISR_TCR) && nbytes()) {
+        i2c1.ISR.value &= ~I2C_ISR_TCR;
+        start_chunk();
+    } else if ((cr2 & I2C_CR2_STOP) && (isr & I2C_ISR_TC)) {
+        i2c1.ISR.value &= ~I2C_ISR_TC;
+        stop();
+    }
+}
+
+void host::detail::i2c_on_txdr() {
+    if (g_bus.step != Step::Data || g_bus.read) return;
+    g_bus.txdr_full = true;
+    if (!g_bus.shifting) load_shifter();
+    else update_txis();
+}
+
+void host::detail::i2c_on_rxdr_read() {
+    if (!g_bus.rx_held) return;
+    g_bus.rx_held = false;
+    deliver_rx(g_bus.shift_byte);
+}
+
+uint64_t host::detail::i2c_next_event() {
+    return g_bus.next;
+}
+
+void host::detail::i2c_process_events() {
+    if (g_bus.next != now()) return;
+
+    switch (g_bus.step) {
+        case Step::Address: address_done(); break;
+        case Step::Data: byte_done(); break;
+        case Step::Stop: stop_done(); break;
+        default: g_bus.next = Never; break;
+    }
+}
+
+void host::i2c_attach(uint8_t address, size_t size, uint8_t addr_bytes, uint16_t page, uint32_t write_cycle_us) {
+    Slave dev{address, addr_bytes, page, write_cycle_us * (CoreClockHz / 1'000'000), false,
+              std::vector<uint8_t>(size, 0xFF), 0, 0, -1, 0, std::vector<uint32_t>(page ? size / page : 1, 0)};
+
+    if (auto *s = find_slave(address)) *s = std::move(dev);
+    else g_slaves.push_back(std::move(dev));
+}
+
+void host::i2c_detach(uint8_t address) {
+    std::erase_if(g_slaves, [address](const Slave &s) { return s.address == address; });
+}
+
+uint8_t *host::i2c_memory(uint8_t address) {
+    auto *s = find_slave(address);
+    return s ? s->mem.data() : nullptr;
+}
+
+const std::vector<uint32_t> &host::i2c_page_writes(uint8_t address) {
+    static const std::vector<uint32_t> none;
+    auto *s = find_slave(address);
+    return s ? s->page_writes : none;
+}
+
+void host::i2c_hold_scl(uint8_t address, bool hold) {
+    if (auto *s = find_slave(address)) s->hold_scl = hold;
+}
+
+const host::I2cStats &host::i2c_stats() {
+    return g_bus.stats;
+}
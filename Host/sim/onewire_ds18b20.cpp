@@ -0,0 +1,368 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <cstring>
+#include <deque>
+
+using namespace host::detail;
+
+/**
+ * Модель шины 1-Wire на PA8 с несколькими DS18B20 (по умолчанию один).
+ *
+ * Драйвер описывает каждую операцию целиком через TIM1 + DMA1 и запускает
+ * таймер в режиме OPM, поэтому модель выполняет всю операцию в момент
+ * установки CEN: по настройкам DIER и включённым каналам DMA понимает,
+ * что это — reset (ARR > 200), запись бит (CC4DE, Ch4) или чтение бит
+ * (CC2DE, Ch3), и сразу заполняет буферы DMA. Прошивка увидит результат
+ * только по UIF, т.е. через то же время, что и на железе.
+ *
+ * ROM-команды: Skip ROM (0xCC) выбирает все датчики, Match ROM (0x55) — датчик
+ * с принятым 64-битным кодом, Search ROM (0xF0) — по биту: датчики в поиске выдают
+ * бит кода и его дополнение, затем отсеиваются по записанному ведущим направлению.
+ * Слот чтения — монтажное И выбранных датчиков (ноль любого из них тянет линию).
+ *
+ * Write Scratchpad (0x4E) принимает TH, TL и регистр конфигурации; преобразование длится
+ * tCONV разрешения (93.75 мс при 9 битах, вдвое дольше на бит) с поправкой
+ * ds18b20_set_conversion_percent(), младшие биты результата ниже разрешения — нули.
+ * Пока датчик преобразует, слоты чтения возвращают 0.
+ */
+namespace {
+    /// Фронты захвата CCR2 в слоте reset (мкс от начала): конец reset и конец presence
+    constexpr uint16_t ResetEdgeUs = 482;
+    constexpr uint16_t PresenceEdgeUs = 632;
+    /// Длительность низкого уровня в слоте чтения для «1» и «0» (мкс)
+    constexpr uint8_t ReadOneUs = 2;
+    constexpr uint8_t ReadZeroUs = 32;
+    /// Импульс записи короче этого значения — «1»
+    constexpr uint32_t WriteOneMaxUs = 15;
+    constexpr uint64_t Conversion9BitUs = 93'750;
+    /// Температура и конфигурация после включения питания (+85 °C, 12 бит)
+    constexpr int PowerOnTenths = 850;
+    constexpr uint8_t PowerOnConfig = 0x7F;
+    constexpr uint8_t MaxDevices = 16;
+
+    enum class BusPhase : uint8_t {
+        Idle,       ///< Ждём reset
+        Rom,        ///< Ждём ROM-команду
+        Search,     ///< Search ROM: бит кода, дополнение, направление от ведущего
+        Match,      ///< Match ROM: принимаем 64 бита кода
+        Function,   ///< Ждём функциональную команду
+        Write,      ///< Write Scratchpad: TH, TL, конфигурация
+    };
+
+    struct Ds18b20Model {
+        uint8_t rom[8] = {};
+        bool present = true;
+        int tenths = 250;
+        bool selected = false;        ///< Выбран ROM-командой (в поиске — ещё не отсеян)
+        std::deque<bool> tx_bits;
+        uint8_t scratchpad[9] = {};
+        uint64_t conversion_end = 0;
+    };
+
+    struct BusModel {
+        Ds18b20Model dev[MaxDevices];
+        uint8_t count = 1;
+        BusPhase phase = BusPhase::Idle;
+        uint8_t rx_byte = 0;
+        uint8_t rx_bits = 0;
+        uint8_t bit = 0;              ///< Бит кода (Search, Match)
+        uint8_t step = 0;             ///< Search: 0 — бит, 1 — дополнение, 2 — направление
+        uint8_t match[8] = {};
+        uint8_t written = 0;          ///< Write: принято байт
+        uint8_t conversion_percent = 100;
+        uint32_t conversions = 0;
+        uint32_t drop_presence = 0;   ///< Reset, на который не будет присутствия (0 — нет)
+    };
+
+    BusModel g_bus;
+
+    uint8_t crc8(const uint8_t *data, size_t len) {
+        uint8_t crc = 0;
+        for (size_t i = 0; i < len; ++i) {
+            uint8_t in = data[i];
+            for (uint8_t b = 0; b < 8; ++b) {
+                const uint8_t mix = (crc ^ in) & 0x01;
+                crc >>= 1;
+                if (mix) crc ^= 0x8C;
+                in >>= 1;
+            }
+        }
+        return crc;
+    }
+
+    void crc_scratchpad(Ds18b20Model &d) {
+        d.scratchpad[8] = crc8(d.scratchpad, 8);
+    }
+
+    void power_on(Ds18b20Model &d) {
+        const auto raw = static_cast<int16_t>(PowerOnTenths * 16 / 10);
+        d.scratchpad[0] = static_cast<uint8_t>(raw & 0xFF);
+        d.scratchpad[1] = static_cast<uint8_t>((raw >> 8) & 0xFF);
+        d.scratchpad[2] = 0x4B;   // TH
+        d.scratchpad[3] = 0x46;   // TL
+        d.scratchpad[4] = PowerOnConfig;
+        d.scratchpad[5] = 0xFF;
+        d.scratchpad[6] = 0x0C;
+        d.scratchpad[7] = 0x10;
+        crc_scratchpad(d);
+        d.conversion_end = 0;
+    }
+
+    bool rom_bit(const Ds18b20Model &d, uint8_t bit) {
+        return (d.rom[bit >> 3] >> (bit & 7)) & 1U;
+    }
+
+    uint8_t resolution(const Ds18b20Model &d) {
+        return static_cast<uint8_t>(9 + ((d.scratchpad[4] >> 5) & 3));
+    }
+
+    void latch_temperature(Ds18b20Model &d) {
+        auto raw = static_cast<int16_t>(d.tenths * 16 / 10);
+        raw = static_cast<int16_t>(raw & ~((1 << (12 - resolution(d))) - 1));
+        d.scratchpad[0] = static_cast<uint8_t>(raw & 0xFF);
+        d.scratchpad[1] = static_cast<uint8_t>((raw >> 8) & 0xFF);
+        crc_scratchpad(d);
+    }
+
+    void load_defaults(Ds18b20Model &d, uint8_t index) {
+        // Семейство 0x28, серийный номер — перемешанный номер датчика (разные ветви поиска)
+        uint32_t x = 0x9E3779B9U * (index + 1U);
+        d.rom[0] = 0x28;
+        for (uint8_t i = 1; i < 7; ++i) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            d.rom[i] = static_cast<uint8_t>(x);
+        }
+        d.rom[6] = index;   // Коды гарантированно различаются
+        d.rom[7] = crc8(d.rom, 7);
+
+        power_on(d);
+    }
+
+    bool any_present() {
+        for (uint8_t i = 0; i < g_bus.count; ++i) {
+            if (g_bus.dev[i].present) return true;
+        }
+        return false;
+    }
+
+    void select_present() {
+        for (uint8_t i = 0; i < g_bus.count; ++i) g_bus.dev[i].selected = g_bus.dev[i].present;
+    }
+
+    void on_byte(uint8_t byte) {
+        switch (g_bus.phase) {
+            case BusPhase::Rom:
+                g_bus.bit = 0;
+                g_bus.step = 0;
+                if (byte == 0xCC) {
+                    select_present();
+                    g_bus.phase = BusPhase::Function;
+                } else if (byte == 0xF0) {
+                    select_present();
+                    g_bus.phase = BusPhase::Search;
+                } else if (byte == 0x55) {
+                    std::memset(g_bus.match, 0, sizeof(g_bus.match));
+                    g_bus.phase = BusPhase::Match;
+                } else {
+                    g_bus.phase = BusPhase::Idle;
+                }
+                break;
+            case BusPhase::Write:
+                // TH, TL, конфигурация (в регистре конфигурации пишутся только R1 R0)
+                for (uint8_t i = 0; i < g_bus.count; ++i) {
+                    auto &d = g_bus.dev[i];
+                    if (!d.selected) continue;
+                    d.scratchpad[2 + g_bus.written] = g_bus.written == 2 ? static_cast<uint8_t>((byte | 0x1F) & 0x7F) : byte;
+                    crc_scratchpad(d);
+                }
+                if (++g_bus.written == 3) g_bus.phase = BusPhase::Idle;
+                break;
+            case BusPhase::Function:
+                if (byte == 0x44) {
+                    for (uint8_t i = 0; i < g_bus.count; ++i) {
+                        auto &d = g_bus.dev[i];
+                        if (!d.selected) continue;
+                        latch_temperature(d);
+                        const uint64_t max_us = Conversion9BitUs << (resolution(d) - 9);
+                        d.conversion_end = host::now_us() + max_us * g_bus.conversion_percent / 100;
+                    }
+                    ++g_bus.conversions;
+                } else if (byte == 0x4E) {
+                    g_bus.written = 0;
+                    g_bus.phase = BusPhase::Write;
+                    return;
+                } else if (byte == 0xBE) {
+                    for (uint8_t i = 0; i < g_bus.count; ++i) {
+                        auto &d = g_bus.dev[i];
+                        if (!d.selected) continue;
+                        d.tx_bits.clear();
+                        for (uint8_t b: d.scratchpad) {
+                            for (uint8_t k = 0; k < 8; ++k) d.tx_bits.push_back((b >> k) & 1U);
+                        }
+                    }
+                }
+                g_bus.phase = BusPhase::Idle;
+                break;
+            default:
+                break;
+        }
+    }
+
+    bool next_read_bit() {
+        bool line = true;
+        for (uint8_t i = 0; i < g_bus.count; ++i) {
+            auto &d = g_bus.dev[i];
+            if (!d.selected) continue;
+
+            bool bit;
+            if (g_bus.phase == BusPhase::Search) {
+                bit = g_bus.step == 0 ? rom_bit(d, g_bus.bit) : g_bus.step == 1 ? !rom_bit(d, g_bus.bit) : true;
+            } else if (!d.tx_bits.empty()) {
+                bit = d.tx_bits.front();
+                d.tx_bits.pop_front();
+            } else {
+                // Во время преобразования датчик отвечает нулями, затем единицами
+                bit = host::now_us() >= d.conversion_end;
+            }
+            line = line && bit;
+        }
+        if (g_bus.phase == BusPhase::Search && g_bus.step < 2) ++g_bus.step;
+        return line;
+    }
+
+    void on_write_bit(uint32_t width_us) {
+        const bool bit = width_us <= WriteOneMaxUs;
+
+        switch (g_bus.phase) {
+            case BusPhase::Idle:
+                return;
+            case BusPhase::Search:
+                // Направление: остаются датчики с таким битом кода
+                for (uint8_t i = 0; i < g_bus.count; ++i) {
+                    auto &d = g_bus.dev[i];
+                    if (d.selected && rom_bit(d, g_bus.bit) != bit) d.selected = false;
+                }
+                g_bus.step = 0;
+                if (++g_bus.bit == 64) g_bus.phase = BusPhase::Function;
+                return;
+            case BusPhase::Match:
+                if (bit) g_bus.match[g_bus.bit >> 3] |= static_cast<uint8_t>(1U << (g_bus.bit & 7));
+                if (++g_bus.bit == 64) {
+                    for (uint8_t i = 0; i < g_bus.count; ++i) {
+                        auto &d = g_bus.dev[i];
+                        d.selected = d.present && std::memcmp(d.rom, g_bus.match, sizeof(d.rom)) == 0;
+                    }
+                    g_bus.phase = BusPhase::Function;
+                }
+                return;
+            default:
+                break;
+        }
+
+        g_bus.rx_byte |= static_cast<uint8_t>((bit ? 1U : 0U) << g_bus.rx_bits);
+        if (++g_bus.rx_bits == 8) {
+            on_byte(g_bus.rx_byte);
+            g_bus.rx_byte = 0;
+            g_bus.rx_bits = 0;
+        }
+    }
+
+    void capture(DMA_Channel_TypeDef *ch) {
+        uint32_t n = ch->CNDTR;
+
+        if (TIM1->ARR > 200) {
+            // Слот reset: сброс приёмника команд и импульс присутствия
+            bool present = any_present();
+            if (g_bus.drop_presence && --g_bus.drop_presence == 0) present = false;
+            g_bus.rx_byte = 0;
+            g_bus.rx_bits = 0;
+            g_bus.phase = present ? BusPhase::Rom : BusPhase::Idle;
+            for (auto &d: g_bus.dev) {
+                d.selected = false;
+                d.tx_bits.clear();
+            }
+
+            uint32_t index = 0;
+            if (n > 0) { dma_store(ch, index++, ResetEdgeUs); --n; }
+            if (n > 0 && present) { dma_store(ch, index++, PresenceEdgeUs); --n; }
+            ch->CNDTR = n;
+            return;
+        }
+
+        // Слоты чтения: захват момента возврата линии в «1»
+        for (uint32_t i = 0; i < n; ++i) {
+            dma_store(ch, i, next_read_bit() ? ReadOneUs : ReadZeroUs);
+        }
+        ch->CNDTR = 0;
+    }
+
+    void transmit(DMA_Channel_TypeDef *ch) {
+        // Первый бит берётся из CCR1, остальные DMA подкладывает по CC4
+        const uint32_t n = ch->CNDTR;
+        on_write_bit(TIM1->CCR1);
+        for (uint32_t i = 0; i + 1 < n; ++i) on_write_bit(dma_load(ch, i));
+        ch->CNDTR = 0;
+    }
+}
+
+void host::detail::onewire_reset() {
+    g_bus = {};
+    for (uint8_t i = 0; i < MaxDevices; ++i) load_defaults(g_bus.dev[i], i);
+}
+
+void host::detail::onewire_on_tim1_start() {
+    const uint32_t dier = TIM1->DIER;
+
+    if ((dier & TIM_DIER_CC2DE) && (DMA1_Channel3->CCR & DMA_CCR_EN)) {
+        capture(DMA1_Channel3);
+    } else if ((dier & TIM_DIER_CC4DE) && (DMA1_Channel4->CCR & DMA_CCR_EN)) {
+        transmit(DMA1_Channel4);
+    }
+}
+
+void host::ds18b20_set_count(uint8_t count) {
+    g_bus.count = count < 1 ? 1 : count > MaxDevices ? MaxDevices : count;
+}
+
+void host::ds18b20_attach(bool present) {
+    for (auto &d: g_bus.dev) d.present = present;
+}
+
+void host::ds18b20_attach(uint8_t index, bool present) {
+    if (index < MaxDevices) g_bus.dev[index].present = present;
+}
+
+void host::ds18b20_set_temperature(int tenths) {
+    for (auto &d: g_bus.dev) d.tenths = tenths;
+}
+
+void host::ds18b20_set_temperature(uint8_t index, int tenths) {
+    if (index < MaxDevices) g_bus.dev[index].tenths = tenths;
+}
+
+const uint8_t *host::ds18b20_rom(uint8_t index) {
+    return index < MaxDevices ? g_bus.dev[index].rom : nullptr;
+}
+
+void host::ds18b20_set_conversion_percent(uint8_t percent) {
+    g_bus.conversion_percent = percent;
+}
+
+uint8_t host::ds18b20_resolution(uint8_t index) {
+    return index < MaxDevices ? resolution(g_bus.dev[index]) : 0;
+}
+
+void host::ds18b20_power_cycle(uint8_t index) {
+    if (index < MaxDevices) power_on(g_bus.dev[index]);
+}
+
+void host::ds18b20_drop_presence(uint32_t reset) {
+    g_bus.drop_presence = reset;
+}
+
+uint32_t host::ds18b20_conversions() {
+    return g_bus.conversions;
+}
@@ -0,0 +1,941 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <new>
+
+using namespace host::detail;
+
+extern "C" {
+    uint32_t SystemCoreClock = host::CoreClockHz;
+    const uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+    const uint8_t APBPrescTable[8] = {0, 0, 0, 0, 1, 2, 3, 4};
+
+    SysTick_Type host_SysTick;
+    SCB_Type host_SCB;
+
+    void SystemInit(void) {}
+    void SystemCoreClockUpdate(void) { SystemCoreClock = host::CoreClockHz; }
+
+    // Обработчики прерываний прошивки (Src/core/stm32f0xx_it.cpp, TwiDriver.cpp ...)
+    void SysTick_Handler(void) __attribute__((weak));
+    void TIM1_BRK_UP_TRG_COM_IRQHandler(void) __attribute__((weak));
+    void TIM3_IRQHandler(void) __attribute__((weak));
+    void TIM14_IRQHandler(void) __attribute__((weak));
+    void TIM16_IRQHandler(void) __attribute__((weak));
+    void TIM17_IRQHandler(void) __attribute__((weak));
+    void I2C1_IRQHandler(void) __attribute__((weak));
+    void SPI1_IRQHandler(void) __attribute__((weak));
+    void USART1_IRQHandler(void) __attribute__((weak));
+    void EXTI0_1_IRQHandler(void) __attribute__((weak));
+    void EXTI2_3_IRQHandler(void) __attribute__((weak));
+    void EXTI4_15_IRQHandler(void) __attribute__((weak));
+    void DMA1_Channel1_IRQHandler(void) __attribute__((weak));
+    void DMA1_Channel2_3_IRQHandler(void) __attribute__((weak));
+    void DMA1_Channel4_5_IRQHandler(void) __attribute__((weak));
+}
+
+namespace host {
+    RCC_TypeDef rcc;
+    GPIO_TypeDef gpioa, gpiob, gpioc, gpiod, gpiof;
+    TIM_TypeDef tim1, tim3, tim14, tim16, tim17;
+    USART_TypeDef usart1;
+    I2C_TypeDef i2c1;
+    SPI_TypeDef spi1;
+    DMA_TypeDef dma1;
+    DMA_Channel_TypeDef dma1_ch[5];
+    IWDG_TypeDef iwdg;
+    EXTI_TypeDef exti;
+    SYSCFG_TypeDef syscfg;
+}
+
+namespace {
+    constexpr uint32_t LsiHz = 40'000;
+    constexpr uint32_t MaxIrqDispatch = 10'000;
+
+    struct GpioModel {
+        GPIO_TypeDef *port;
+        uint8_t exti_port;   ///< Код порта в SYSCFG_EXTICRx
+        uint32_t input_level;
+        uint64_t toggles;
+    };
+
+    struct TimerModel {
+        TIM_TypeDef *tim;
+        IRQn_Type irq;
+        void (*handler)();
+        bool has_rcr;
+        uint64_t next_update;
+        uint32_t rep_left;
+    };
+
+    GpioModel g_gpio[] = {
+            {&host::gpioa, 0, 0, 0},
+            {&host::gpiob, 1, 0, 0},
+            {&host::gpioc, 2, 0, 0},
+            {&host::gpiod, 3, 0, 0},
+            {&host::gpiof, 5, 0, 0},
+    };
+
+    TimerModel g_timers[] = {
+            {&host::tim1,  TIM1_BRK_UP_TRG_COM_IRQn, TIM1_BRK_UP_TRG_COM_IRQHandler, true,  Never, 0},
+            {&host::tim3,  TIM3_IRQn,                TIM3_IRQHandler,                false, Never, 0},
+            {&host::tim14, TIM14_IRQn,               TIM14_IRQHandler,               false, Never, 0},
+            {&host::tim16, TIM16_IRQn,               TIM16_IRQHandler,               true,  Never, 0},
+            {&host::tim17, TIM17_IRQn,               TIM17_IRQHandler,               true,  Never, 0},
+    };
+
+    uint64_t g_now = 0;
+    uint32_t g_primask = 0;
+    bool g_in_handler = false;
+    uint32_t g_nvic_enabled = 0;
+    uint32_t g_nvic_pending = 0;
+
+    uint64_t g_systick_next = Never;   ///< Такт, в который счётчик SysTick дойдёт до 0
+    bool g_systick_pending = false;
+
+    uint64_t g_dispatched = 0;
+    uint64_t g_dispatched_irq[32] = {};   ///< По линиям IRQn
+    uint64_t g_wfi_count = 0;
+    uint64_t g_sleep_cycles = 0;
+
+    std::deque<uint8_t> g_uart_rx_line;
+    uint64_t g_uart_rx_next = Never;
+    std::string g_uart_tx;
+    uint32_t g_uart_overruns = 0;
+    bool g_uart_tx_paced = false;
+    uint64_t g_uart_tx_next = Never;   ///< Такт, в который линия освободится (TXE/TC), при темпе
+    uint32_t g_uart_tx_dma_index = 0;  ///< Сколько байт канал DMA1 Ch2 отдал с момента включения
+    uint64_t g_uart_idle_at = Never;   ///< Такт, в который линия приема простоит кадр (флаг IDLE)
+    uint32_t g_dma_reload[5] = {};     ///< CNDTR на момент включения канала (для кольцевого режима)
+
+    bool g_iwdg_running = false;
+    uint64_t g_iwdg_last_reload = 0;
+    uint32_t g_iwdg_reloads = 0;
+    bool g_iwdg_expired = false;
+
+    bool g_irq_storm_reported = false;
+
+    /** Значения регистров после сброса: нули и никаких побочных эффектов (id = 0) */
+    template<typename T>
+    void power_on(T &regs) {
+        regs.~T();
+        new(&regs) T{};
+    }
+
+    template<typename T, size_t N>
+    T *owner_of(const host::Reg &reg, T (&models)[N], auto member) {
+        for (auto &m: models) {
+            auto *base = reinterpret_cast<const uint8_t *>(m.*member);
+            auto *p = reinterpret_cast<const uint8_t *>(&reg);
+            if (p >= base && p < base + sizeof(*(m.*member))) return &m;
+        }
+        return nullptr;
+    }
+
+    GpioModel *gpio_of(const host::Reg &reg) { return owner_of(reg, g_gpio, &GpioModel::port); }
+
+    TimerModel *timer_of(const host::Reg &reg) { return owner_of(reg, g_timers, &TimerModel::tim); }
+
+    uint32_t gpio_output_mask(const GPIO_TypeDef *port) {
+        uint32_t mask = 0;
+        for (uint8_t pin = 0; pin < 16; ++pin) {
+            if (((port->MODER.value >> (pin * 2)) & 0b11) == 0b01) mask |= 1U << pin;
+        }
+        return mask;
+    }
+
+    void gpio_set_odr(GpioModel &m, uint32_t odr) {
+        const uint32_t before = m.port->ODR.value;
+        odr &= 0xFFFF;
+        m.port->ODR.value = odr;
+        m.toggles += __builtin_popcount(before ^ odr);
+        if (m.port == &host::gpiob) lcd_on_gpiob(before, odr);
+    }
+
+    uint64_t timer_period(const TIM_TypeDef *tim) {
+        return static_cast<uint64_t>(tim->ARR.value + 1) * (tim->PSC.value + 1);
+    }
+
+    void timer_start(TimerModel &t) {
+        t.rep_left = t.has_rcr ? (t.tim->RCR.value & 0xFF) : 0;
+        t.next_update = g_now + timer_period(t.tim);
+    }
+
+    void timer_update_event(TimerModel &t) {
+        if (t.rep_left > 0) {
+            --t.rep_left;
+            t.next_update += timer_period(t.tim);
+            return;
+        }
+
+        t.tim->SR.value |= TIM_SR_UIF;
+        t.tim->CNT.value = 0;
+
+        if (t.tim->CR1.value & TIM_CR1_OPM) {
+            t.tim->CR1.value &= ~TIM_CR1_CEN;
+            t.next_update = Never;
+        } else {
+            t.rep_left = t.has_rcr ? (t.tim->RCR.value & 0xFF) : 0;
+            t.next_update += timer_period(t.tim);
+        }
+    }
+
+    uint64_t uart_byte_cycles() {
+        const uint32_t brr = host::usart1.BRR.value ? host::usart1.BRR.value : 1;
+        return 10ULL * brr;
+    }
+
+    /** Запрос периферии к каналу DMA на запись в память; false — канал не принял байт */
+    bool dma_write_request(uint8_t n, uint32_t value) {
+        DMA_Channel_TypeDef &ch = host::dma1_ch[n];
+        if (!(ch.CCR.value & DMA_CCR_EN) || ch.CNDTR.value == 0) return false;
+
+        const uint32_t reload = g_dma_reload[n];
+        dma_store(&ch, (ch.CCR.value & DMA_CCR_MINC) ? reload - ch.CNDTR.value : 0, value);
+
+        const uint32_t left = --ch.CNDTR.value;
+        const uint32_t shift = 4 * n;
+        if (left == reload / 2) host::dma1.ISR.value |= (DMA_ISR_GIF1 | DMA_ISR_HTIF1) << shift;
+        if (left == 0) {
+            host::dma1.ISR.value |= (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << shift;
+            if (ch.CCR.value & DMA_CCR_CIRC) ch.CNDTR.value = reload;
+        }
+        return true;
+    }
+
+    void uart_rx_arrive() {
+        const uint8_t byte = g_uart_rx_line.front();
+        g_uart_rx_line.pop_front();
+
+        // Пауза после последнего байта длиной в кадр поднимет IDLE
+        g_uart_idle_at = g_uart_rx_line.empty() ? g_now + uart_byte_cycles() : Never;
+
+        // USART1_RX: Channel 3, с SYSCFG_CFGR1.USART1RX_DMA_RMP — Channel 5
+        const uint8_t rx_channel = (host::syscfg.CFGR1.value & SYSCFG_CFGR1_USART1RX_DMA_RMP) ? 4 : 2;
+        auto &isr = host::usart1.ISR.value;
+        if ((host::usart1.CR3.value & USART_CR3_DMAR) && !(isr & USART_ISR_RXNE) &&
+            dma_write_request(rx_channel, byte)) {
+            // Байт сразу забран каналом DMA
+        } else if (isr & USART_ISR_RXNE) {
+            isr |= USART_ISR_ORE;   // Предыдущий байт не прочитан — новый теряется
+            ++g_uart_overruns;
+        } else {
+            host::usart1.RDR.value = byte;
+            isr |= USART_ISR_RXNE;
+        }
+
+        g_uart_rx_next = g_uart_rx_line.empty() ? Never : g_now + uart_byte_cycles();
+    }
+
+    /** Байт ушёл в линию: при темпе TDR занят до конца кадра */
+    void uart_tx_byte(uint8_t byte) {
+        g_uart_tx.push_back(static_cast<char>(byte));
+        if (g_uart_tx_paced) {
+            host::usart1.ISR.value &= ~(USART_ISR_TXE | USART_ISR_TC);
+            g_uart_tx_next = g_now + uart_byte_cycles();
+        }
+    }
+
+    /** Запрос USART1_TX к DMA1 Ch2: пока TDR свободен и канал включён, он отдаёт следующий байт */
+    void uart_tx_dma_request() {
+        DMA_Channel_TypeDef &ch = host::dma1_ch[1];
+        while ((host::usart1.CR3.value & USART_CR3_DMAT) && (ch.CCR.value & DMA_CCR_EN) &&
+               ch.CNDTR.value != 0 && (host::usart1.ISR.value & USART_ISR_TXE)) {
+            uart_tx_byte(static_cast<uint8_t>(dma_load(&ch, g_uart_tx_dma_index++)));
+            if (--ch.CNDTR.value == 0) host::dma1.ISR.value |= DMA_ISR_GIF2 | DMA_ISR_TCIF2;
+        }
+    }
+
+    void uart_tx_complete() {
+        host::usart1.ISR.value |= USART_ISR_TXE | USART_ISR_TC;
+        g_uart_tx_next = Never;
+        uart_tx_dma_request();
+    }
+
+    /** Линия прерывания канала DMA: флаги TC/HT/TE лежат на тех же битах, что и TCIE/HTIE/TEIE в CCR */
+    bool dma_channel_irq(uint8_t n) {
+        const uint32_t flags = (host::dma1.ISR.value >> (4 * n)) & 0xF;
+        return flags & host::dma1_ch[n].CCR.value & (DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+    }
+
+    uint64_t iwdg_timeout_cycles() {
+        const uint64_t div = 4ULL << (host::iwdg.PR.value & 0x7);
+        const uint64_t rlr = (host::iwdg.RLR.value & 0xFFF) + 1;
+        return rlr * div * host::CoreClockHz / LsiHz;
+    }
+
+    bool irq_line(IRQn_Type irq) {
+        if (g_nvic_pending & (1U << irq)) return true;
+
+        for (auto &t: g_timers) {
+            if (t.irq == irq) {
+                return (t.tim->DIER.value & TIM_DIER_UIE) && (t.tim->SR.value & TIM_SR_UIF);
+            }
+        }
+
+        if (irq == USART1_IRQn) {
+            const uint32_t cr1 = host::usart1.CR1.value;
+            const uint32_t isr = host::usart1.ISR.value;
+            return ((cr1 & USART_CR1_TXEIE) && (isr & USART_ISR_TXE)) ||
+                   ((cr1 & USART_CR1_TCIE) && (isr & USART_ISR_TC)) ||
+                   ((cr1 & USART_CR1_RXNEIE) && (isr & (USART_ISR_RXNE | USART_ISR_ORE))) ||
+                   ((host::usart1.CR3.value & USART_CR3_EIE) && (host::usart1.CR3.value & USART_CR3_DMAR) &&
+                    (isr & USART_ISR_ORE)) ||
+                   ((cr1 & USART_CR1_IDLEIE) && (isr & USART_ISR_IDLE));
+        }
+
+        if (irq == DMA1_Channel1_IRQn) return dma_channel_irq(0);
+        if (irq == DMA1_Channel2_3_IRQn) return dma_channel_irq(1) || dma_channel_irq(2);
+        if (irq == DMA1_Channel4_5_IRQn) return dma_channel_irq(3) || dma_channel_irq(4);
+
+        const uint32_t exti_active = host::exti.PR.value & host::exti.IMR.value;
+        if (irq == EXTI0_1_IRQn) return exti_active & 0x0003;
+        if (irq == EXTI2_3_IRQn) return exti_active & 0x000C;
+        if (irq == EXTI4_15_IRQn) return exti_active & 0xFFF0;
+
+        if (irq == I2C1_IRQn) {
+            const uint32_t cr1 = host::i2c1.CR1.value;
+            const uint32_t isr = host::i2c1.ISR.value;
+            return ((cr1 & I2C_CR1_TXIE) && (isr & I2C_ISR_TXIS)) ||
+                   ((cr1 & I2C_CR1_RXIE) && (isr & I2C_ISR_RXNE)) ||
+                   ((cr1 & I2C_CR1_TCIE) && (isr & (I2C_ISR_TC | I2C_ISR_TCR))) ||
+                   ((cr1 & I2C_CR1_NACKIE) && (isr & I2C_ISR_NACKF)) ||
+                   ((cr1 & I2C_CR1_STOPIE) && (isr & I2C_ISR_STOPF)) ||
+                   ((cr1 & I2C_CR1_ERRIE) && (isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)));
+        }
+
+        if (irq == SPI1_IRQn) {
+            const uint32_t cr2 = host::spi1.CR2.value;
+            const uint32_t sr = host::spi1.SR.value;
+            return ((cr2 & SPI_CR2_TXEIE) && (sr & SPI_SR_TXE)) || ((cr2 & SPI_CR2_RXNEIE) && (sr & SPI_SR_RXNE)) ||
+                   ((cr2 & SPI_CR2_ERRIE) && (sr & SPI_SR_OVR));
+        }
+
+        return false;
+    }
+
+    void (*irq_handler(IRQn_Type irq))() {
+        for (auto &t: g_timers) {
+            if (t.irq == irq) return t.handler;
+        }
+        if (irq == USART1_IRQn) return USART1_IRQHandler;
+        if (irq == I2C1_IRQn) return I2C1_IRQHandler;
+        if (irq == SPI1_IRQn) return SPI1_IRQHandler;
+        if (irq == EXTI0_1_IRQn) return EXTI0_1_IRQHandler;
+        if (irq == EXTI2_3_IRQn) return EXTI2_3_IRQHandler;
+        if (irq == EXTI4_15_IRQn) return EXTI4_15_IRQHandler;
+        if (irq == DMA1_Channel1_IRQn) return DMA1_Channel1_IRQHandler;
+        if (irq == DMA1_Channel2_3_IRQn) return DMA1_Channel2_3_IRQHandler;
+        if (irq == DMA1_Channel4_5_IRQn) return DMA1_Channel4_5_IRQHandler;
+        return nullptr;
+    }
+
+    /** Найти самое приоритетное активное прерывание: SysTick, затем IRQn по возрастанию. */
+    bool dispatch_one() {
+        if (g_systick_pending) {
+            g_systick_pending = false;
+            ++g_dispatched;
+            if (SysTick_Handler) SysTick_Handler();
+            return true;
+        }
+
+        for (int n = 0; n < 32; ++n) {
+            const auto irq = static_cast<IRQn_Type>(n);
+            if (!(g_nvic_enabled & (1U << n)) || !irq_line(irq)) continue;
+
+            g_nvic_pending &= ~(1U << n);
+            ++g_dispatched;
+            ++g_dispatched_irq[n];
+            if (auto handler = irq_handler(irq)) handler();
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t systick_period() {
+        return (host_SysTick.LOAD.value & SysTick_LOAD_RELOAD_Msk) + 1;
+    }
+
+    /** Есть ли прерывание, которое ядро приняло бы сейчас (без учёта PRIMASK) */
+    bool irq_pending() {
+        if (g_systick_pending) return true;
+        for (int n = 0; n < 32; ++n) {
+            if ((g_nvic_enabled & (1U << n)) && irq_line(static_cast<IRQn_Type>(n))) return true;
+        }
+        return false;
+    }
+
+    void gpio_exti_edges(const GpioModel &m, uint32_t before, uint32_t after) {
+        const uint32_t changed = (before ^ after) & 0xFFFF;
+        for (uint8_t pin = 0; pin < 16; ++pin) {
+            const uint32_t bit = 1U << pin;
+            if (!(changed & bit)) continue;
+
+            const uint32_t sel = (host::syscfg.EXTICR[pin / 4].value >> ((pin % 4) * 4)) & 0xF;
+            if (sel != m.exti_port) continue;
+
+            const bool rising = after & bit;
+            if ((rising && (host::exti.RTSR.value & bit)) || (!rising && (host::exti.FTSR.value & bit))) {
+                host::exti.PR.value |= bit;
+            }
+        }
+    }
+
+    /** Обработать все события, запланированные ровно на g_now. */
+    void process_events() {
+        if (g_systick_next == g_now) {
+            host_SysTick.CTRL.value |= SysTick_CTRL_COUNTFLAG_Msk;
+            if (host_SysTick.CTRL.value & SysTick_CTRL_TICKINT_Msk) g_systick_pending = true;
+            // Новое значение LOAD вступает в силу только на перезагрузке
+            g_systick_next = g_now + systick_period();
+        }
+
+        for (auto &t: g_timers) {
+            if (t.next_update == g_now) timer_update_event(t);
+        }
+
+        if (g_uart_rx_next == g_now) uart_rx_arrive();
+        if (g_uart_tx_next == g_now) uart_tx_complete();
+        if (g_uart_idle_at == g_now) {
+            host::usart1.ISR.value |= USART_ISR_IDLE;
+            g_uart_idle_at = Never;
+        }
+        i2c_process_events();
+        spi_process_events();
+
+        if (g_iwdg_running && g_now - g_iwdg_last_reload > iwdg_timeout_cycles()) {
+            g_iwdg_expired = true;
+            g_iwdg_last_reload = g_now;
+        }
+    }
+}
+
+//=============================================================================
+// Доступ к регистрам
+//=============================================================================
+
+uint32_t host::reg_read(const Reg &reg) {
+    switch (reg.id) {
+        case GpioIdr: {
+            auto *m = gpio_of(reg);
+            const uint32_t out = gpio_output_mask(m->port);
+            return ((m->input_level & ~out) | (m->port->ODR.value & out)) & 0xFFFF;
+        }
+        case GpioBsrr:
+        case GpioBrr:
+        case TimEgr:
+        case UsartIcr:
+        case DmaIfcr:
+        case IwdgKr:
+            return 0;   // Регистры только для записи
+        case UsartRdr:
+            usart1.ISR.value &= ~USART_ISR_RXNE;
+            return reg.value;
+        case I2cRxdr: {
+            const uint32_t v = reg.value;
+            i2c1.ISR.value &= ~I2C_ISR_RXNE;
+            i2c_on_rxdr_read();   // Следующий байт мог ждать в сдвиговом регистре
+            return v;
+        }
+        case I2cIcr:
+            return 0;
+        case SpiSr:
+            spi_on_sr_read();   // Ожидание флагов в цикле: время идёт до конца слова
+            return reg.value;
+        case SpiDr:
+            return spi_on_dr_read();
+        case FlashKeyr:
+            return 0;
+        case FlashSr:
+            flash_sync();   // Записанное полуслово учитывается здесь: прошивка ждёт BSY/EOP
+            return reg.value;
+        case SysTickCtrl: {
+            const uint32_t v = reg.value;
+            const_cast<Reg &>(reg).value &= ~SysTick_CTRL_COUNTFLAG_Msk;   // Сброс чтением
+            return v;
+        }
+        case ScbIcsr:
+            return g_systick_pending ? SCB_ICSR_PENDSTSET_Msk : 0;
+        case SysTickVal:
+            if (g_systick_next == Never) return reg.value;
+            return static_cast<uint32_t>((g_systick_next - g_now) % systick_period()) & SysTick_VAL_CURRENT_Msk;
+        default:
+            return reg.value;
+    }
+}
+
+void host::reg_write(Reg &reg, uint32_t value) {
+    switch (reg.id) {
+        case GpioOdr: {
+            gpio_set_odr(*gpio_of(reg), value);
+            break;
+        }
+        case GpioBsrr: {
+            auto *m = gpio_of(reg);
+            gpio_set_odr(*m, (m->port->ODR.value & ~(value >> 16)) | (value & 0xFFFF));
+            break;
+        }
+        case GpioBrr: {
+            auto *m = gpio_of(reg);
+            gpio_set_odr(*m, m->port->ODR.value & ~value);
+            break;
+        }
+        case TimCr1: {
+            auto *t = timer_of(reg);
+            const bool was_running = reg.value & TIM_CR1_CEN;
+            reg.value = value;
+            if (!was_running && (value & TIM_CR1_CEN)) {
+                timer_start(*t);
+                if (t->tim == &tim1) onewire_on_tim1_start();
+            } else if (!(value & TIM_CR1_CEN)) {
+                t->next_update = Never;
+            }
+            break;
+        }
+        case TimEgr: {
+            auto *t = timer_of(reg);
+            if (value & TIM_EGR_UG) {
+                t->tim->CNT.value = 0;
+                t->tim->SR.value |= TIM_SR_UIF;
+                if (t->tim->CR1.value & TIM_CR1_CEN) timer_start(*t);
+                else t->rep_left = t->has_rcr ? (t->tim->RCR.value & 0xFF) : 0;
+            }
+            break;
+        }
+        case UsartTdr:
+            reg.value = value & 0x1FF;
+            uart_tx_byte(static_cast<uint8_t>(value & 0xFF));
+            break;
+        case UsartIcr:
+            usart1.ISR.value &= ~(value & (USART_ICR_ORECF | USART_ICR_IDLECF | USART_ICR_TCCF |
+                                           USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF));
+            break;
+        case DmaCcr: {
+            const bool was_enabled = reg.value & DMA_CCR_EN;
+            reg.value = value;
+            if (!was_enabled && (value & DMA_CCR_EN)) {
+                for (uint8_t n = 0; n < 5; ++n) {
+                    if (&reg == &dma1_ch[n].CCR) g_dma_reload[n] = dma1_ch[n].CNDTR.value;
+                }
+                if (&reg == &dma1_ch[1].CCR) {
+                    g_uart_tx_dma_index = 0;
+                    uart_tx_dma_request();
+                }
+            }
+            break;
+        }
+        case DmaIfcr:
+            // CGIFx сбрасывает все флаги канала
+            for (uint8_t n = 0; n < 5; ++n) {
+                if (value & (DMA_IFCR_CGIF1 << (4 * n))) value |= 0xFU << (4 * n);
+            }
+            dma1.ISR.value &= ~value;
+            break;
+        case SysTickCtrl: {
+            const bool was_enabled = reg.value & SysTick_CTRL_ENABLE_Msk;
+            const bool enable = value & SysTick_CTRL_ENABLE_Msk;
+            reg.value = (value & ~SysTick_CTRL_COUNTFLAG_Msk) | (reg.value & SysTick_CTRL_COUNTFLAG_Msk);
+            if (!was_enabled && enable) {
+                const uint32_t val = host_SysTick.VAL.value;
+                g_systick_next = g_now + (val ? val : systick_period());
+            } else if (was_enabled && !enable) {
+                host_SysTick.VAL.value = static_cast<uint32_t>(host_SysTick.VAL);
+                g_systick_next = Never;
+            }
+            break;
+        }
+        case SysTickVal:
+            // Любая запись обнуляет счётчик и COUNTFLAG, следующий такт перезагружает LOAD
+            reg.value = 0;
+            host_SysTick.CTRL.value &= ~SysTick_CTRL_COUNTFLAG_Msk;
+            if (host_SysTick.CTRL.value & SysTick_CTRL_ENABLE_Msk) g_systick_next = g_now + systick_period();
+            break;
+        case ScbIcsr:
+            if (value & SCB_ICSR_PENDSTCLR_Msk) g_systick_pending = false;
+            if (value & SCB_ICSR_PENDSTSET_Msk) g_systick_pending = true;
+            break;
+        case ExtiPr:
+            reg.value &= ~value;   // Сброс записью 1
+            break;
+        case I2cCr1: {
+            const uint32_t before = reg.value;
+            reg.value = value;
+            i2c_on_cr1(before);
+            break;
+        }
+        case I2cCr2:
+            reg.value = value;
+            i2c_on_cr2();
+            break;
+        case I2cTxdr:
+            reg.value = value & 0xFF;
+            i2c_on_txdr();
+            break;
+        case I2cIcr:
+            // Биты ICR на тех же местах, что и флаги ISR
+            i2c1.ISR.value &= ~(value & (I2C_ICR_ADDRCF | I2C_ICR_NACKCF | I2C_ICR_STOPCF | I2C_ICR_BERRCF |
+                                         I2C_ICR_ARLOCF | I2C_ICR_OVRCF));
+            break;
+        case SpiDr:
+            spi_on_dr_write(value);
+            break;
+        case FlashKeyr:
+            flash_on_keyr(value);
+            break;
+        case FlashSr:
+            flash_sync();
+            reg.value &= ~(value & (FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR));   // Сброс записью 1
+            break;
+        case FlashCr:
+            flash_on_cr(value);
+            break;
+        case IwdgKr:
+            if (value == 0xCCCC) {
+                g_iwdg_running = true;
+                g_iwdg_last_reload = g_now;
+            } else if (value == 0xAAAA) {
+                g_iwdg_last_reload = g_now;
+                ++g_iwdg_reloads;
+            }
+            break;
+        default:
+            reg.value = value;
+            break;
+    }
+
+    service_irqs();
+}
+
+//=============================================================================
+// Ядро: NVIC, SysTick, intrinsics
+//=============================================================================
+
+extern "C" {
+
+void NVIC_EnableIRQ(IRQn_Type IRQn) {
+    if (IRQn >= 0) g_nvic_enabled |= 1U << IRQn;
+    host::service_irqs();
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn) {
+    if (IRQn >= 0) g_nvic_enabled &= ~(1U << IRQn);
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn) {
+    return IRQn >= 0 ? ((g_nvic_enabled >> IRQn) & 1U) : 0U;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn) {
+    if (IRQn >= 0) g_nvic_pending |= 1U << IRQn;
+    host::service_irqs();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+    if (IRQn >= 0) g_nvic_pending &= ~(1U << IRQn);
+}
+
+void NVIC_SetPriority(IRQn_Type, uint32_t) {}
+
+uint32_t SysTick_Config(uint32_t ticks) {
+    if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk) return 1UL;
+
+    SysTick->LOAD = ticks - 1UL;
+    SysTick->VAL = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0UL;
+}
+
+void host_barrier(void) {
+    host::service_irqs();
+}
+
+void host_wfi(void) {
+    // Ядро спит, пока не появится прерывание, которое оно приняло бы
+    // (при PRIMASK = 1 — только просыпается, обработчик вызовется после __enable_irq)
+    ++g_wfi_count;
+    const uint64_t dispatched = g_dispatched;
+
+    while (!irq_pending() && g_dispatched == dispatched) {
+        const uint64_t next = host::next_event_cycles();
+        if (next == Never) {
+            std::fprintf(stderr, "host: WFI with no wakeup source at %llu cycles\n",
+                         static_cast<unsigned long long>(g_now));
+            return;
+        }
+        g_sleep_cycles += next - g_now;
+        host::advance_cycles(next - g_now);
+    }
+}
+
+void host_set_primask(uint32_t primask) {
+    g_primask = primask & 1U;
+    host::service_irqs();
+}
+
+uint32_t host_get_primask(void) {
+    return g_primask;
+}
+
+uint32_t host_core_cycles(void) {
+    return static_cast<uint32_t>(g_now);
+}
+
+} // extern "C"
+
+//=============================================================================
+// Управление моделью
+//=============================================================================
+
+void host::reset() {
+    power_on(rcc);
+    power_on(flash);
+    for (auto &m: g_gpio) power_on(*m.port);
+    for (auto &t: g_timers) power_on(*t.tim);
+    power_on(usart1);
+    power_on(i2c1);
+    power_on(spi1);
+    power_on(dma1);
+    for (auto &ch: dma1_ch) power_on(ch);
+    power_on(iwdg);
+    power_on(exti);
+    power_on(syscfg);
+    power_on(host_SysTick);
+    host_SysTick.CTRL.id = SysTickCtrl;
+    host_SysTick.VAL.id = SysTickVal;
+    host_SysTick.CALIB.value = CoreClockHz / 1000 / 8 - 1;   // Не точные 10 мс от HCLK/8
+    exti.PR.id = ExtiPr;
+    exti.IMR.id = Notify;
+    power_on(host_SCB);
+    host_SCB.CPUID.value = 0x410CC200;   // Cortex-M0 r0p0
+    host_SCB.ICSR.id = ScbIcsr;
+
+    // Генераторы и PLL готовы сразу, иначе InitMax48MHz()/IWDG_Init() будут ждать вечно
+    rcc.CR.value = RCC_CR_HSION | RCC_CR_HSIRDY | RCC_CR_PLLRDY;
+    rcc.CFGR.value = RCC_CFGR_SWS_PLL;
+    rcc.CSR.value = RCC_CSR_LSIRDY;
+
+    for (auto &m: g_gpio) {
+        m.input_level = 0xFFFF;   // Входы с подтяжкой: кнопки отпущены
+        m.toggles = 0;
+        m.port->IDR.id = GpioIdr;
+        m.port->ODR.id = GpioOdr;
+        m.port->BSRR.id = GpioBsrr;
+        m.port->BRR.id = GpioBrr;
+    }
+
+    for (auto &t: g_timers) {
+        t.next_update = Never;
+        t.rep_left = 0;
+        t.tim->CR1.id = TimCr1;
+        t.tim->EGR.id = TimEgr;
+        t.tim->DIER.id = Notify;
+        t.tim->SR.id = Notify;
+    }
+
+    usart1.ISR.value = USART_ISR_TXE | USART_ISR_TC;
+    usart1.CR1.id = Notify;
+    usart1.RDR.id = UsartRdr;
+    usart1.TDR.id = UsartTdr;
+    usart1.ICR.id = UsartIcr;
+
+    dma1.IFCR.id = DmaIfcr;
+    for (auto &ch: dma1_ch) ch.CCR.id = DmaCcr;
+
+    i2c1.ISR.value = I2C_ISR_TXE;
+    i2c1.CR1.id = I2cCr1;
+    i2c1.CR2.id = I2cCr2;
+    i2c1.TXDR.id = I2cTxdr;
+    i2c1.RXDR.id = I2cRxdr;
+    i2c1.ICR.id = I2cIcr;
+
+    iwdg.KR.id = IwdgKr;
+
+    g_now = 0;
+    g_primask = 0;
+    g_in_handler = false;
+    g_nvic_enabled = 0;
+    g_nvic_pending = 0;
+    g_systick_next = Never;
+    g_systick_pending = false;
+    g_dispatched = 0;
+    for (auto &n: g_dispatched_irq) n = 0;
+    g_wfi_count = 0;
+    g_sleep_cycles = 0;
+    g_uart_rx_line.clear();
+    g_uart_rx_next = Never;
+    g_uart_tx.clear();
+    g_uart_overruns = 0;
+    g_uart_tx_paced = false;
+    g_uart_tx_next = Never;
+    g_uart_tx_dma_index = 0;
+    g_uart_idle_at = Never;
+    for (auto &reload: g_dma_reload) reload = 0;
+    g_iwdg_running = false;
+    g_iwdg_last_reload = 0;
+    g_iwdg_reloads = 0;
+    g_iwdg_expired = false;
+    g_irq_storm_reported = false;
+
+    SystemCoreClock = CoreClockHz;
+
+    onewire_reset();
+    lcd_reset();
+    i2c_reset();
+    spi_reset();
+    flash_reset();
+}
+
+uint64_t host::now_cycles() {
+    return g_now;
+}
+
+uint64_t host::next_event_cycles() {
+    uint64_t next = g_systick_next;
+    for (auto &t: g_timers) {
+        if (t.next_update < next) next = t.next_update;
+    }
+    if (g_uart_rx_next < next) next = g_uart_rx_next;
+    if (g_uart_tx_next < next) next = g_uart_tx_next;
+    if (g_uart_idle_at < next) next = g_uart_idle_at;
+    if (i2c_next_event() < next) next = i2c_next_event();
+    if (spi_next_event() < next) next = spi_next_event();
+    return next;
+}
+
+void host::advance_cycles(uint64_t cycles) {
+    const uint64_t target = g_now + cycles;
+
+    while (true) {
+        const uint64_t next = next_event_cycles();
+        if (next > target) break;
+
+        g_now = next;
+        process_events();
+        service_irqs();
+    }
+
+    g_now = target;
+}
+
+void host::service_irqs() {
+    if (g_primask || g_in_handler) return;
+
+    g_in_handler = true;
+    uint32_t dispatched = 0;
+    while (dispatch_one()) {
+        if (++dispatched >= MaxIrqDispatch) {
+            // Линия прерывания не сбрасывается обработчиком — на железе это зависание
+            if (!g_irq_storm_reported) {
+                std::fprintf(stderr, "host: interrupt storm at %llu cycles\n",
+                             static_cast<unsigned long long>(g_now));
+                g_irq_storm_reported = true;
+            }
+            break;
+        }
+    }
+    g_in_handler = false;
+}
+
+void host::uart_rx(const char *s) {
+    uart_rx(reinterpret_cast<const uint8_t *>(s), std::strlen(s));
+}
+
+void host::uart_rx(const uint8_t *data, size_t len) {
+    const bool idle = g_uart_rx_line.empty();
+    g_uart_rx_line.insert(g_uart_rx_line.end(), data, data + len);
+    if (idle && len) {
+        g_uart_rx_next = g_now + uart_byte_cycles();
+        g_uart_idle_at = Never;   // Линия снова занята: паузы в кадр не будет
+    }
+}
+
+const std::string &host::uart_tx() {
+    return g_uart_tx;
+}
+
+void host::uart_tx_clear() {
+    g_uart_tx.clear();
+}
+
+uint32_t host::uart_rx_overruns() {
+    return g_uart_overruns;
+}
+
+void host::uart_tx_paced(bool paced) {
+    g_uart_tx_paced = paced;
+}
+
+void host::gpio_input(GPIO_TypeDef *port, uint8_t pin, bool level) {
+    for (auto &m: g_gpio) {
+        if (m.port != port) continue;
+        const uint32_t before = m.input_level;
+        if (level) m.input_level |= 1U << pin;
+        else m.input_level &= ~(1U << pin);
+        gpio_exti_edges(m, before, m.input_level);
+    }
+    service_irqs();
+}
+
+uint64_t host::gpio_toggles(GPIO_TypeDef *port) {
+    for (auto &m: g_gpio) {
+        if (m.port == port) return m.toggles;
+    }
+    return 0;
+}
+
+uint64_t host::wfi_count() {
+    return g_wfi_count;
+}
+
+uint64_t host::sleep_cycles() {
+    return g_sleep_cycles;
+}
+
+uint64_t host::irq_count() {
+    return g_dispatched;
+}
+
+uint64_t host::irq_count(IRQn_Type irq) {
+    return irq >= 0 ? g_dispatched_irq[irq] : 0;
+}
+
+uint32_t host::iwdg_reloads() {
+    return g_iwdg_reloads;
+}
+
+bool host::iwdg_expired() {
+    return g_iwdg_expired;
+}
+
+//=============================================================================
+// DMA
+//=============================================================================
+
+void host::detail::cpu_stall(uint64_t cycles) {
+    const uint32_t primask = g_primask;
+    g_primask = 1;
+    host::advance_cycles(cycles);
+    g_primask = primask;
+    host::service_irqs();
+}
+
+void host::detail::dma_store(const DMA_Channel_TypeDef *ch, uint32_t index, uint32_t value) {
+    const uintptr_t addr = ch->CMAR.value;
+    switch ((ch->CCR.value & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos) {
+        case 0: reinterpret_cast<volatile uint8_t *>(addr)[index] = static_cast<uint8_t>(value); break;
+        case 1: reinterpret_cast<volatile uint16_t *>(addr)[index] = static_cast<uint16_t>(value); break;
+        default: reinterpret_cast<volatile uint32_t *>(addr)[index] = value; break;
+    }
+}
+
+uint32_t host::detail::dma_load(const DMA_Channel_TypeDef *ch, uint32_t index) {
+    const uintptr_t addr = ch->CMAR.value;
+    switch ((ch->CCR.value & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos) {
+        case 0: return reinterpret_cast<const volatile uint8_t *>(addr)[index];
+        case 1: return reinterpret_cast<const volatile uint16_t *>(addr)[index];
+        default: return reinterpret_cast<const volatile uint32_t *>(addr)[index];
+    }
+}
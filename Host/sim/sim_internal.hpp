@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stm32f0xx.h"
+
+/**
+ * @brief Внутренние связи между моделями периферии (не для управляющих программ)
+ */
+namespace host::detail {
+    /**
+     * @brief Побочные эффекты доступа к регистрам (поле host::Reg::id)
+     */
+    enum RegId : uint8_t {
+        Plain = 0,   ///< Обычная память
+        Notify,      ///< Запись может поднять линию прерывания
+        GpioIdr,
+        GpioOdr,
+        GpioBsrr,
+        GpioBrr,
+        TimCr1,
+        TimEgr,
+        UsartRdr,
+        UsartTdr,
+        UsartIcr,
+        DmaCcr,
+        DmaIfcr,
+        IwdgKr,
+        SysTickCtrl,
+        SysTickVal,
+        ScbIcsr,
+        ExtiPr,
+        I2cCr1,
+        I2cCr2,
+        I2cTxdr,
+        I2cRxdr,
+        I2cIcr,
+        FlashKeyr,
+        FlashSr,
+        FlashCr,
+        SpiSr,
+        SpiDr,
+    };
+
+    constexpr uint64_t Never = UINT64_MAX;
+
+    /** Модель DS18B20: TIM1 запущен — выполнить слоты 1-Wire, описанные TIM1/DMA1 */
+    void onewire_reset();
+    void onewire_on_tim1_start();
+
+    /** Модель HT1621B: изменились выходы GPIOB */
+    void lcd_reset();
+    void lcd_on_gpiob(uint32_t before, uint32_t after);
+
+    /** Модель HT1621B: SPI1 выдвинул слово (bits бит, старший вперёд) на SCK/MOSI */
+    void lcd_on_spi(uint32_t word, uint8_t bits);
+
+    /** Модель SPI1: записан/прочитан DR, прочитан SR; сдвиг слов по времени */
+    void spi_reset();
+    void spi_on_dr_write(uint32_t value);
+    uint32_t spi_on_dr_read();
+    void spi_on_sr_read();
+    uint64_t spi_next_event();
+    void spi_process_events();
+
+    /** Модель I2C1: записаны CR1/CR2/TXDR, прочитан RXDR; события линии по времени */
+    void i2c_reset();
+    void i2c_on_cr1(uint32_t before);
+    void i2c_on_cr2();
+    void i2c_on_txdr();
+    void i2c_on_rxdr_read();
+    uint64_t i2c_next_event();
+    void i2c_process_events();
+
+    /** Модель flash: записаны KEYR/CR; sync — учесть записи полуслов в память (перед чтением SR) */
+    void flash_reset();
+    void flash_on_keyr(uint32_t value);
+    void flash_on_cr(uint32_t value);
+    void flash_sync();
+
+    /**
+     * @brief Ядро стоит cycles тактов (запись/стирание flash): события идут, прерывания ждут
+     */
+    void cpu_stall(uint64_t cycles);
+
+    /**
+     * @brief Записать значение в память по адресу из CMAR с шириной MSIZE канала DMA
+     */
+    void dma_store(const DMA_Channel_TypeDef *ch, uint32_t index, uint32_t value);
+
+    /**
+     * @brief Прочитать значение из памяти по адресу из CMAR с шириной MSIZE канала DMA
+     */
+    uint32_t dma_load(const DMA_Channel_TypeDef *ch, uint32_t index);
+}
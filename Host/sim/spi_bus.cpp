@@ -0,0 +1,129 @@
+#include "host_sim.hpp"
+#include "sim_internal.hpp"
+
+#include <deque>
+
+using namespace host::detail;
+
+/**
+ * Модель SPI1 в режиме ведущего на передачу (MISO не подключён, принимаются нули).
+ *
+ * Запись в DR кладёт слово в FIFO передачи (32 бита: два слова при DS > 8 бит,
+ * иначе четыре байта), свободный сдвиговый регистр сразу забирает его оттуда.
+ * Слово сдвигается DS периодов SCK, SCK = PCLK / 2^(BR+1); выдвинутые биты
+ * получает модель HT1621B, а в FIFO приёма появляется слово — RXNE значит,
+ * что соответствующее переданное слово ушло целиком.
+ *
+ * SR: TXE — FIFO передачи заполнен не больше чем наполовину, RXNE — есть принятое
+ * слово, OVR — FIFO приёма переполнен, BSY — идёт сдвиг. Прерывание SPI1_IRQn —
+ * TXEIE и TXE или RXNEIE и RXNE.
+ *
+ * Повторное чтение SR в тот же такт без обращений к DR между ними — ожидание флага
+ * в цикле: если слово сдвигается, а принятого нет, время модели идёт до конца слова.
+ */
+namespace {
+    constexpr uint8_t FifoBytes = 4;
+
+    struct SpiModel {
+        std::deque<uint16_t> tx;
+        bool shifting = false;
+        uint16_t shift_word = 0;
+        uint64_t next = Never;        ///< Конец сдвига текущего слова
+        uint8_t rx = 0;               ///< Слов в FIFO приёма
+        uint64_t sr_read = Never;     ///< Такт последнего чтения SR (Never — после него был DR)
+        host::SpiStats stats;
+    };
+
+    SpiModel g_spi;
+
+    uint64_t now() { return host::now_cycles(); }
+
+    uint8_t data_bits() {
+        const uint32_t ds = (host::spi1.CR2.value & SPI_CR2_DS_Msk) >> SPI_CR2_DS_Pos;
+        return static_cast<uint8_t>(ds < 3 ? 8 : ds + 1);   // 0..2 — запрещённые значения, как 8 бит
+    }
+
+    uint8_t fifo_words() {
+        return data_bits() > 8 ? FifoBytes / 2 : FifoBytes;
+    }
+
+    uint64_t word_cycles() {
+        const uint32_t br = (host::spi1.CR1.value & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+        return static_cast<uint64_t>(data_bits()) * (2U << br);
+    }
+
+    void update_sr() {
+        uint32_t sr = host::spi1.SR.value & SPI_SR_OVR;
+        if (g_spi.tx.size() <= fifo_words() / 2u) sr |= SPI_SR_TXE;
+        if (g_spi.rx) sr |= SPI_SR_RXNE;
+        if (g_spi.shifting || !g_spi.tx.empty()) sr |= SPI_SR_BSY;
+        host::spi1.SR.value = sr;
+    }
+
+    /** Свободный сдвиговый регистр забирает слово из FIFO */
+    void load_shift() {
+        if (g_spi.shifting || g_spi.tx.empty()) return;
+        g_spi.shift_word = g_spi.tx.front();
+        g_spi.tx.pop_front();
+        g_spi.shifting = true;
+        g_spi.next = now() + word_cycles();
+        g_spi.stats.busy_cycles += word_cycles();
+    }
+
+    void word_done() {
+        const uint8_t bits = data_bits();
+        lcd_on_spi(g_spi.shift_word & ((1U << bits) - 1), bits);
+        ++g_spi.stats.words;
+        g_spi.stats.bits += bits;
+
+        if (g_spi.rx < fifo_words()) ++g_spi.rx;
+        else host::spi1.SR.value |= SPI_SR_OVR;
+
+        g_spi.shifting = false;
+        g_spi.next = Never;
+        load_shift();
+        update_sr();
+    }
+}
+
+void host::detail::spi_reset() {
+    g_spi = {};
+    spi1.SR.value = SPI_SR_TXE;
+    spi1.SR.id = SpiSr;
+    spi1.DR.id = SpiDr;
+    spi1.CR1.id = Notify;
+    spi1.CR2.id = Notify;
+}
+
+void host::detail::spi_on_dr_write(uint32_t value) {
+    g_spi.sr_read = Never;
+    if (!(spi1.CR1.value & SPI_CR1_SPE)) return;
+    if (g_spi.tx.size() < fifo_words()) g_spi.tx.push_back(static_cast<uint16_t>(value));
+    load_shift();
+    update_sr();
+}
+
+uint32_t host::detail::spi_on_dr_read() {
+    g_spi.sr_read = Never;
+    if (g_spi.rx) --g_spi.rx;
+    update_sr();
+    return 0;
+}
+
+void host::detail::spi_on_sr_read() {
+    const bool polling = g_spi.sr_read == now();
+    if (polling && g_spi.shifting && !g_spi.rx && g_spi.next > now()) cpu_stall(g_spi.next - now());
+    g_spi.sr_read = now();
+}
+
+uint64_t host::detail::spi_next_event() {
+    return g_spi.next;
+}
+
+void host::detail::spi_process_events() {
+    if (g_spi.next == now()) word_done();
+}
+
+const host::SpiStats &host::spi_stats() {
+    return g_spi.stats;
+}
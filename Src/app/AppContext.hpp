@@ -7,7 +7,13 @@
 #include "ht1621.hpp"
 #include "ds18b20.hpp"
 #include "ButtonsManager.hpp"
+#include "DisplayAnimator.hpp"
 #include "Controller.hpp"
+#include "Protocol.hpp"
+#include "Telemetry.hpp"
+#include "KvStore.hpp"
+#include "Settings.hpp"
+#include "TimerWheel.hpp"
 #include "Event.hpp"
 
 /**
@@ -31,6 +37,12 @@ struct App {
 
     // Application-level services
     EventQueue      *queue = nullptr;
+    TimerWheel      *timers = nullptr;
     BeepManager     *beep = nullptr;
+    DisplayAnimator *animator = nullptr;
     Controller      *ctrl = nullptr;
+    Telemetry       *telemetry = nullptr;
+    KvStore         *kv = nullptr;
+    Settings        *settings = nullptr;
+    Protocol        *proto = nullptr;
 };
\ No newline at end of file
@@ -1,10 +1,16 @@
 #pragma once
 
 #include "config.h"
-#include <etl/circular_buffer.h>
+#include "SpscRing.hpp"
 #include <etl/optional.h>
 #include <cstdint>
 
+// #define EVENT_QUEUE_LATENCY
+
+#if defined EVENT_QUEUE_LATENCY
+#include "CycleCounter.hpp"
+#endif
+
 /**
  * @brief All high-level events that can be handled by the controller.
  */
@@ -17,36 +23,283 @@ enum class EventType : uint8_t {
     TemperatureReady, ///< Fresh temperature sample is available (value holds Celsius degrees).
     Tick100ms,        ///< Legacy periodic event (unused).
     DisplayTimeout,   ///< Request to finish displaying the setpoint and revert to current temperature.
+    BeepDone,         ///< Beep duration elapsed, BeepManager turns the piezo off.
+    SensorError,      ///< Temperature sensor failed (value holds DS18B20::ErrorStatus), heater must be cut off.
+    DisplayFrame,     ///< Next blink phase or marquee step is due, DisplayAnimator redraws.
 
     Any               ///< Для перехода по любому событию (wildcard)
 };
 
 struct Event {
     EventType type;
+    uint8_t sensor;   ///< Номер датчика DS18B20 (TemperatureReady, SensorError), иначе 0
     int value; // Универсальное поле (температура в десятых долях градуса, например)
+
+    /// {type, value} как прежде; sensor — в бывшем выравнивании, размер события не меняется
+    constexpr Event(EventType type = EventType::None, int value = 0, uint8_t sensor = 0)
+            : type(type), sensor(sensor), value(value) {}
+};
+
+/**
+ * @brief Полоса приоритета очереди
+ *
+ * Critical (TemperatureReady, SensorError) всегда разбирается раньше Normal
+ * и не теряется: на каждый тип — одна ячейка с самым свежим значением.
+ * Это только датчик 0, по которому регулирует Controller (первый найденный после старта,
+ * см. DS18B20::keep_control_first()); остальные датчики шины — Normal.
+ */
+enum class EventLane : uint8_t {
+    Critical,   ///< События безопасности: от них зависит отключение нагревателя
+    Normal,     ///< Кнопки, таймеры, Tick100ms
+};
+
+/**
+ * @brief Кто кладёт событие в очередь: основной цикл или конкретное прерывание
+ *
+ * У каждого источника своё кольцо SpscRing с единственным писателем,
+ * поэтому писать из обработчиков прерываний можно без __disable_irq().
+ */
+enum class EventSource : uint8_t {
+    Main,   ///< Основной цикл (app_loop, сервисы, TimerWheel)
+    Usart,  ///< USART1_IRQHandler
+    Timer,  ///< TIM17_IRQHandler
+    Twi,    ///< Завершение обмена I2C (callback из I2C1_IRQHandler)
+
+    Count
 };
 
+/**
+ * @brief Очередь событий: полоса Critical и по кольцу на источник, объединение при pop()
+ *
+ * push() — из основного цикла, pushFromIsr() — из прерывания своего источника;
+ * pop() и всё остальное — только из основного цикла. Порядок событий внутри
+ * одного источника сохраняется, между источниками pop() обходит кольца по кругу,
+ * чтобы поток из одного источника не задерживал остальные.
+ *
+ * События полосы Critical (только из основного цикла) pop() отдаёт первыми.
+ * Для каждого их типа хранится одно, самое свежее значение: новое измерение
+ * заменяет ещё не разобранное (счётчик coalesced), но никогда не отбрасывается
+ * из-за заполненных колец кнопок и таймеров. Так задержка от разбора ответа
+ * датчика до отключения нагревателя не больше одного прохода app_loop.
+ * EVENT_QUEUE_SINGLE_LANE отключает полосу (все события в общих кольцах).
+ */
 class EventQueue {
 public:
-    static constexpr size_t MaxEvents = EVENT_QUEUE_MAX_SIZE;
+    static constexpr size_t MaxEvents = EVENT_QUEUE_MAX_SIZE;       ///< Кольцо основного цикла
+    static constexpr size_t IsrEvents = EVENT_QUEUE_ISR_SIZE;       ///< Кольцо каждого прерывания
+    static constexpr uint8_t Sources = static_cast<uint8_t>(EventSource::Count);
+
+    /**
+     * @brief Счётчики заполнения очереди
+     */
+    struct Stats {
+        uint32_t pushed = 0;        ///< Принято событий
+        uint32_t dropped = 0;       ///< Потеряно: push() в полное кольцо
+        uint8_t highWatermark = 0;  ///< Наибольшее число событий в кольце
+        uint32_t coalesced = 0;     ///< Заменено более свежим значением (полоса Critical)
+    };
+
+#if defined EVENT_QUEUE_LATENCY
+    /**
+     * @brief Задержка от push() до pop() в тактах ядра (включается EVENT_QUEUE_LATENCY)
+     */
+    struct Latency {
+        uint32_t min = 0;
+        uint32_t max = 0;
+        uint64_t sum = 0;
+        uint32_t count = 0;
 
+        uint32_t avg() const { return count ? static_cast<uint32_t>(sum / count) : 0; }
+    };
+#endif
+
+    /// Положить событие из основного цикла
     bool push(const Event &ev) {
-        if (m_queue.full()) {
-            return false;
+        const int8_t slot = ev.sensor == 0 ? criticalSlot(ev.type) : -1;
+        if (slot >= 0) {
+            putCritical(m_critical[slot], ev);
+            return true;
         }
-        m_queue.push(ev);
-        return true;
+        return put(m_main, m_stats[0], ev);
+    }
+
+    /**
+     * @brief Положить событие из обработчика прерывания
+     * @note Один источник — одно прерывание: два обработчика не должны писать в одно кольцо
+     */
+    bool pushFromIsr(EventSource src, const Event &ev) {
+        const auto i = static_cast<uint8_t>(src);
+        if (i == 0 || i >= Sources) return false;
+        return put(m_isr[i - 1], m_stats[i], ev);
     }
 
     etl::optional<Event> pop() {
-        if (m_queue.empty()) {
-            return etl::nullopt;
+        for (auto &mailbox: m_critical) {
+            if (!mailbox.pending) continue;
+            mailbox.pending = false;
+#if defined EVENT_QUEUE_LATENCY
+            record(stamp() - mailbox.entry.stamp);
+#endif
+            return mailbox.entry.event;
+        }
+
+        Entry entry;
+        for (uint8_t n = 0; n < Sources; ++n) {
+            const uint8_t i = m_next;
+            m_next = static_cast<uint8_t>((m_next + 1) % Sources);
+
+            if (i == 0 ? m_main.pop(entry) : m_isr[i - 1].pop(entry)) {
+#if defined EVENT_QUEUE_LATENCY
+                record(stamp() - entry.stamp);
+#endif
+                return entry.event;
+            }
         }
-        Event ev = m_queue.front();
-        m_queue.pop();
-        return ev;
+        return etl::nullopt;
+    }
+
+    bool empty() const {
+        for (const auto &mailbox: m_critical) {
+            if (mailbox.pending) return false;
+        }
+        if (!m_main.empty()) return false;
+        for (const auto &ring: m_isr) {
+            if (!ring.empty()) return false;
+        }
+        return true;
+    }
+
+    /// Счётчики одного источника
+    const Stats &stats(EventSource src) const {
+        return m_stats[static_cast<uint8_t>(src)];
     }
 
+    /// Счётчики полосы (Normal — сумма по источникам)
+    Stats stats(EventLane lane) const {
+        if (lane == EventLane::Critical) return m_criticalStats;
+
+        Stats total;
+        for (const auto &s: m_stats) accumulate(total, s);
+        return total;
+    }
+
+    /// Сумма по всей очереди; highWatermark — наибольший из колец
+    Stats stats() const {
+        Stats total = stats(EventLane::Normal);
+        accumulate(total, m_criticalStats);
+        return total;
+    }
+
+    /// @note Счётчики пишут источники: сбрасывать, когда прерывания-источники молчат
+    void resetStats() {
+        for (auto &s: m_stats) s = {};
+        m_criticalStats = {};
+#if defined EVENT_QUEUE_LATENCY
+        m_latency = {};
+#endif
+    }
+
+#if defined EVENT_QUEUE_LATENCY
+    const Latency &latency() const { return m_latency; }
+#endif
+
 private:
-    etl::circular_buffer<Event, MaxEvents> m_queue;
+    struct Entry {
+        Event event{};
+#if defined EVENT_QUEUE_LATENCY
+        uint32_t stamp = 0;   ///< Момент push()
+#endif
+    };
+
+    /**
+     * @brief Ячейка полосы Critical: последнее не разобранное событие своего типа
+     */
+    struct Mailbox {
+        Entry entry{};
+        bool pending = false;
+    };
+
+    /// Типы полосы Critical в порядке разбора (ошибка датчика раньше измерения)
+    static constexpr EventType CriticalTypes[] = {EventType::SensorError, EventType::TemperatureReady};
+    static constexpr uint8_t CriticalCount = sizeof(CriticalTypes) / sizeof(CriticalTypes[0]);
+
+    /// Номер ячейки Critical для типа или -1, если тип идёт в общие кольца
+    static int8_t criticalSlot(EventType type) {
+#if defined EVENT_QUEUE_SINGLE_LANE
+        (void) type;
+#else
+        for (uint8_t i = 0; i < CriticalCount; ++i) {
+            if (CriticalTypes[i] == type) return static_cast<int8_t>(i);
+        }
+#endif
+        return -1;
+    }
+
+    void putCritical(Mailbox &mailbox, const Event &ev) {
+        if (mailbox.pending) ++m_criticalStats.coalesced;
+        else ++m_criticalStats.pushed;
+
+        mailbox.entry.event = ev;
+#if defined EVENT_QUEUE_LATENCY
+        // Задержка считается от первого не разобранного события: замена её не обнуляет
+        if (!mailbox.pending) mailbox.entry.stamp = stamp();
+#endif
+        mailbox.pending = true;
+
+        uint8_t pending = 0;
+        for (const auto &m: m_critical) pending += m.pending;
+        if (pending > m_criticalStats.highWatermark) m_criticalStats.highWatermark = pending;
+    }
+
+    static void accumulate(Stats &total, const Stats &s) {
+        total.pushed += s.pushed;
+        total.dropped += s.dropped;
+        total.coalesced += s.coalesced;
+        if (s.highWatermark > total.highWatermark) total.highWatermark = s.highWatermark;
+    }
+
+    /// Запись в кольцо; счётчики кольца пишет только его источник
+    template<typename Ring>
+    static bool put(Ring &ring, Stats &stats, const Event &ev) {
+        Entry entry;
+        entry.event = ev;
+#if defined EVENT_QUEUE_LATENCY
+        entry.stamp = stamp();
+#endif
+        if (!ring.push(entry)) {
+            ++stats.dropped;
+            return false;
+        }
+        ++stats.pushed;
+        const size_t size = ring.size();
+        if (size > stats.highWatermark) stats.highWatermark = static_cast<uint8_t>(size);
+        return true;
+    }
+
+    SpscRing<Entry, MaxEvents> m_main;
+    SpscRing<Entry, IsrEvents> m_isr[Sources - 1];
+    Stats m_stats[Sources];
+    Mailbox m_critical[CriticalCount];
+    Stats m_criticalStats;
+    uint8_t m_next = 0;   ///< С какого кольца pop() начнёт поиск
+
+#if defined EVENT_QUEUE_LATENCY
+    Latency m_latency;
+
+    /// На хосте задержка считается в модельном времени, а не во времени процессора хоста
+    static uint32_t stamp() {
+#if defined HOST_BUILD
+        return host_core_cycles();
+#else
+        return CycleCounter::now();
+#endif
+    }
+
+    void record(uint32_t cycles) {
+        if (m_latency.count == 0 || cycles < m_latency.min) m_latency.min = cycles;
+        if (cycles > m_latency.max) m_latency.max = cycles;
+        m_latency.sum += cycles;
+        ++m_latency.count;
+    }
+#endif
 };
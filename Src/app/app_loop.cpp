@@ -4,84 +4,105 @@
 #include "config.h"
 
 #include "AppContext.hpp"
+#include "loop_profiler.hpp"
+#include "CycleCounter.hpp"
+#include "PowerDriver.hpp"
+#include "WakeDeadline.hpp"
 
-#include <optional>
+/// Часы бюджета разбора событий; на хосте — модельное время, чтобы прогоны были воспроизводимы
+static uint32_t dispatch_clock() {
+#if defined HOST_BUILD
+    return host_core_cycles();
+#else
+    return CycleCounter::now();
+#endif
+}
 
-void app_loop(App &app) {
+/**
+ * Одна итерация цикла: каждый этап — отдельный блок, замеряемый LoopProfiler
+ */
+static void run_stages(App &app) {
     // Low-level polling
-    app.sensor->poll();
-    app.buttons->poll(*app.queue);
-    app.ctrl->poll();
-    app.beep->poll();
-
-    // Дублирование действий кнопок через UART (клавиши '1'..'4')
-    // Добавляем небольшую «длительность» нажатия, чтобы звук был слышен:
-    // отправляем press сразу, release — через ~50 мс.
     {
-        static std::optional<Event> pending_uart_release;
-        static uint32_t pending_uart_release_deadline = 0;
+        LoopProfiler::Scope s(LoopStage::Sensor);
+        app.sensor->poll();
+    }
+    {
+        LoopProfiler::Scope s(LoopStage::Buttons);
+        app.buttons->poll(*app.queue);
+    }
+    {
+        // Все дедлайны (Tick100ms, звук, показ уставки, удержание кнопок, запись настроек) — здесь.
+        // Операция flash KvStore (ядро стоит до 40 мс) — только между слотами 1-Wire
+        LoopProfiler::Scope s(LoopStage::Timers);
+        app.timers->poll();
+        if (app.settings) app.settings->poll();
+        if (app.kv) app.kv->poll(app.sensor->busQuiet());
+    }
 
-        // Завершаем отложенный release, если подошло время
-        if (pending_uart_release && RccDriver::GetMsTicks() >= pending_uart_release_deadline) {
-            app.queue->push(*pending_uart_release);
-            pending_uart_release.reset();
+    // Протокол по UART: кадры команд, телеметрия по подписке и клавиши '1'..'4' вне кадров
+    {
+        LoopProfiler::Scope s(LoopStage::Uart);
+        if (app.proto) {
+            app.proto->poll();
         }
+    }
 
-        if (app.uart && app.queue && app.uart->has_data()) {
-            while (app.uart->has_data()) {
-                int byte = app.uart->read_byte();
-                if (byte < 0) break;
-
-                Event evt_press{EventType::None, 0};
-                Event evt_release{EventType::None, 2};
-
-                switch (byte) {
-                    case '1':
-                        evt_press.type = EventType::ButtonS1;
-                        evt_release.type = EventType::ButtonS1;
-                        break;
-                    case '2':
-                        evt_press.type = EventType::ButtonS2;
-                        evt_release.type = EventType::ButtonS2;
-                        break;
-                    case '3':
-                        evt_press.type = EventType::ButtonS3;
-                        evt_release.type = EventType::ButtonS3;
-                        break;
-                    case '4':
-                        evt_press.type = EventType::ButtonS4;
-                        evt_release.type = EventType::ButtonS4;
-                        break;
-                    default:
-                        continue;
-                }
-
-                // Отправляем press сразу
-                app.queue->push(evt_press);
-
-                // Планируем release (или заменяем предыдущий отложенный)
-                pending_uart_release = evt_release;
-                pending_uart_release_deadline = RccDriver::GetMsTicks() + UART_BUTTON_PRESS_DURATION_MS;
-            }
+    // Event processing: пачка до APP_LOOP_DISPATCH_MAX_EVENTS событий в пределах бюджета тактов
+    {
+        LoopProfiler::Scope s(LoopStage::Dispatch);
+        const uint32_t start = dispatch_clock();
+        for (uint8_t n = 0; n < APP_LOOP_DISPATCH_MAX_EVENTS; ++n) {
+            auto e = app.queue->pop();
+            if (!e) break;
+            dispatch_event(app, *e);
+            if (dispatch_clock() - start >= APP_LOOP_DISPATCH_BUDGET_CYCLES) break;
         }
     }
 
-    // Timer 100 ms
-    if (app.tim17->getIrqCount()) {
-        app.tim17->decIrqCount();
+    // Watchdog
+    {
+        LoopProfiler::Scope s(LoopStage::Watchdog);
+        RccDriver::IWDG_Reload();
+    }
+}
 
-        static uint8_t tick100 = 0;
-        if (++tick100 >= APP_LOOP_TICKS_PER_100MS) {
-            tick100 = 0;
-            app.queue->push({EventType::Tick100ms, 0});
-        }
+void app_loop(App &app) {
+    {
+        LoopProfiler::Scope total(LoopStage::Total);
+        run_stages(app);
     }
 
-    // Event processing
-    if (auto e = app.queue->pop()) {
-        dispatch_event(app, *e);
+#if defined APP_LOOP_PROFILE && !defined HOST_BUILD
+    // Периодический отчёт (вне замеряемой части итерации)
+    static uint32_t report_deadline = LOOP_PROFILE_REPORT_PERIOD_MS;
+    if (app.uart && RccDriver::GetMsTicks() >= report_deadline) {
+        LoopProfiler::report(*app.uart);
+        LoopProfiler::reset();
+        report_deadline = RccDriver::GetMsTicks() + LOOP_PROFILE_REPORT_PERIOD_MS;
     }
+#endif
+}
 
-    // Watchdog
-    RccDriver::IWDG_Reload();
+void app_idle(App &app) {
+#if defined APP_TICKLESS
+    // Необработанные события, принятые байты и активный I2C — спать нельзя
+    if (!app.queue->empty() || app.uart->has_data() || TwiDriver::busy()) return;
+
+    const uint32_t now = RccDriver::GetMsTicks();
+    WakeDeadline wake(now + TICKLESS_MAX_SLEEP_MS);
+
+    app.timers->nextDeadline(wake);
+    app.sensor->nextDeadline(wake);
+    app.buttons->nextDeadline(wake);
+    if (app.proto) app.proto->nextDeadline(wake);
+    if (app.settings) app.settings->nextDeadline(wake);
+    if (app.kv) app.kv->nextDeadline(wake);
+
+    if (wake.reached(now)) return;
+
+    PowerDriver::SleepUntil(wake.value());
+#else
+    (void) app;
+#endif
 }
@@ -6,4 +6,11 @@ struct App;
  * Главный цикл приложения.
  * Вызывается в while(true) из main.cpp.
  */
-void app_loop(App &app);
\ No newline at end of file
+void app_loop(App &app);
+
+/**
+ * Сон до ближайшего дедлайна сервисов (режим APP_TICKLESS).
+ * Вызывается в while(true) из main.cpp после app_loop; если работа
+ * уже есть (событие в очереди, I2C, наступивший дедлайн) — сразу возвращается.
+ */
+void app_idle(App &app);
\ No newline at end of file
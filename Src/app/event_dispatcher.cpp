@@ -25,6 +25,14 @@ void dispatch_event(App &app, const Event &e) {
         {}
         break;
 
+    case EventType::BeepDone:
+        app.beep->stop();
+        break;
+
+    case EventType::DisplayFrame:
+        app.animator->onFrame();
+        break;
+
     default:
         break;
     }
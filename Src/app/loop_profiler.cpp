@@ -0,0 +1,58 @@
+#include "loop_profiler.hpp"
+
+const char *LoopProfiler::stage_name(LoopStage stage) {
+    switch (stage) {
+        case LoopStage::Sensor:   return "sensor";
+        case LoopStage::Buttons:  return "buttons";
+        case LoopStage::Timers:   return "timers";
+        case LoopStage::Uart:     return "uart";
+        case LoopStage::Dispatch: return "dispatch";
+        case LoopStage::Watchdog: return "watchdog";
+        case LoopStage::Total:    return "total";
+        default:                  return "?";
+    }
+}
+
+#if defined APP_LOOP_PROFILE
+
+namespace {
+    constexpr auto StageCount = static_cast<uint8_t>(LoopStage::Count);
+
+    LoopProfiler::StageStats g_stats[StageCount];
+}
+
+void LoopProfiler::record(LoopStage stage, uint32_t cycles) {
+    auto &s = g_stats[static_cast<uint8_t>(stage)];
+    if (s.count == 0 || cycles < s.min) s.min = cycles;
+    if (cycles > s.max) s.max = cycles;
+    s.sum += cycles;
+    ++s.count;
+}
+
+const LoopProfiler::StageStats &LoopProfiler::stats(LoopStage stage) {
+    return g_stats[static_cast<uint8_t>(stage)];
+}
+
+void LoopProfiler::reset() {
+    for (auto &s: g_stats) s = {};
+}
+
+void LoopProfiler::report(UsartDriver<> &uart) {
+    uart.write_str("stage min/avg/max [cycles]\r\n");
+    uart.flush();
+
+    for (uint8_t i = 0; i < StageCount; ++i) {
+        const auto &s = g_stats[i];
+        uart.write_str(stage_name(static_cast<LoopStage>(i)));
+        uart.write_str(": ");
+        uart.write_int(static_cast<int>(s.min));
+        uart.write_str("/");
+        uart.write_int(static_cast<int>(s.avg()));
+        uart.write_str("/");
+        uart.write_int(static_cast<int>(s.max));
+        uart.write_str("\r\n");
+        uart.flush();
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CycleCounter.hpp"
+#include "UsartDriver.hpp"
+
+// #define APP_LOOP_PROFILE
+
+/**
+ * @brief Этапы одной итерации app_loop, для которых собирается статистика
+ */
+enum class LoopStage : uint8_t {
+    Sensor,     ///< sensor->poll()
+    Buttons,    ///< buttons->poll()
+    Timers,     ///< timers->poll() (TimerWheel), settings->poll(), kv->poll() (запись flash)
+    Uart,       ///< Разбор команд UART
+    Dispatch,   ///< queue->pop() + dispatch_event() (пачка событий)
+    Watchdog,   ///< IWDG_Reload()
+    Total,      ///< Итерация целиком
+
+    Count
+};
+
+/**
+ * @brief Статистика длительности этапов app_loop (min/avg/max в тактах)
+ *
+ * Включается определением APP_LOOP_PROFILE. Без него Scope — пустой объект,
+ * и профилирование не добавляет в цикл ни одной инструкции.
+ */
+namespace LoopProfiler {
+    struct StageStats {
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+        uint32_t count;
+
+        uint32_t avg() const { return count ? static_cast<uint32_t>(sum / count) : 0; }
+    };
+
+    const char *stage_name(LoopStage stage);
+
+#if defined APP_LOOP_PROFILE
+    void record(LoopStage stage, uint32_t cycles);
+
+    const StageStats &stats(LoopStage stage);
+
+    void reset();
+
+    /**
+     * @brief Вывести таблицу min/avg/max по всем этапам в UART
+     * @note Ждёт опустошения буфера передачи после каждой строки — только для профилирующих сборок
+     */
+    void report(UsartDriver<> &uart);
+
+    /**
+     * @brief Замер длительности блока: от конструктора до деструктора
+     */
+    class Scope {
+    public:
+        explicit Scope(LoopStage stage) : m_stage(stage), m_start(CycleCounter::now()) {}
+
+        ~Scope() { record(m_stage, CycleCounter::now() - m_start); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        LoopStage m_stage;
+        uint32_t m_start;
+    };
+#else
+    class Scope {
+    public:
+        explicit Scope(LoopStage) {}
+    };
+#endif
+}
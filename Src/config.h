@@ -78,22 +78,130 @@ static constexpr uint16_t BEEP_DURATION_MS = 50;
 //=============================================================================
 
 /// Длительность нажатия кнопки через UART (мс)
-/// Когда пользователь отправляет символ '1'..'4' через UART,
+/// Когда пользователь отправляет символ '1'..'4' через UART (вне кадров протокола),
 /// генерируется нажатие (press) + отпускание (release) через это время
 static constexpr uint32_t UART_BUTTON_PRESS_DURATION_MS = 50;
 
-/// Размер очереди событий
+/// Наибольший кадр протокола после декодирования COBS (команда, seq, данные, CRC-16);
+/// закодированный кадр должен помещаться в кольцо передачи UsartDriver (64 байта)
+static constexpr size_t PROTOCOL_MAX_FRAME = 48;
+
+/// Наименьший период телеметрии по подписке (мс)
+static constexpr uint16_t PROTOCOL_TELEMETRY_MIN_PERIOD_MS = 50;
+
+/// Записей телеметрии в очереди на отправку (степень двойки), пока линия занята
+static constexpr size_t TELEMETRY_RING_SIZE = 4;
+
+/// Передача USART1 побайтово по прерыванию TXE вместо DMA1 Channel 2
+/// (прежнее поведение: одно прерывание на байт, для сравнения в хост-бенчмарке)
+// #define USART_TX_IRQ
+
+/// Прием USART1 по прерыванию RXNE на каждый байт вместо кольцевого DMA1 Channel 5 с IDLE
+/// (прежнее поведение, для сравнения в хост-бенчмарке)
+// #define USART_RX_IRQ
+
+/// Размер очереди событий основного цикла (степень двойки)
 static constexpr size_t EVENT_QUEUE_MAX_SIZE = 16;
 
+/// Размер кольца событий каждого прерывания-источника (степень двойки)
+static constexpr size_t EVENT_QUEUE_ISR_SIZE = 8;
+
+/// Одна полоса вместо двух: TemperatureReady/SensorError идут в общие кольца
+/// наравне с кнопками (прежнее поведение, для сравнения в хост-бенчмарке)
+// #define EVENT_QUEUE_SINGLE_LANE
+
+/// Сколько событий максимум разбирается за один проход app_loop.
+/// APP_LOOP_SINGLE_DISPATCH возвращает прежнее поведение (одно событие за проход).
+// #define APP_LOOP_SINGLE_DISPATCH
+#if defined APP_LOOP_SINGLE_DISPATCH
+static constexpr uint8_t APP_LOOP_DISPATCH_MAX_EVENTS = 1;
+#else
+static constexpr uint8_t APP_LOOP_DISPATCH_MAX_EVENTS = 8;
+#endif
+
+/// Бюджет разбора событий за проход (такты ядра, 500 мкс на 48 МГц);
+/// проверяется после каждого события, так что хотя бы одно разбирается всегда
+static constexpr uint32_t APP_LOOP_DISPATCH_BUDGET_CYCLES = 24'000;
+
 /// Таймаут I2C операции (мс)
 static constexpr uint8_t I2C_TIMEOUT_MS = 100;
 
+/// Очередь транзакций TwiDriver (степень двойки)
+static constexpr size_t I2C_QUEUE_SIZE = 4;
+
+//=============================================================================
+// LOG CONFIGURATION
+//=============================================================================
+
+/// LOG() печатает строку в UART сразу (прежнее поведение: write_str/write_int
+/// из места вызова, строки формата во flash) вместо записи в кольцо Log
+// #define LOG_TEXT
+
+/// Записей журнала, ждущих отправки кадрами протокола (степень двойки)
+static constexpr size_t LOG_RING_SIZE = 8;
+
+/// Байт аргументов в записи журнала: целое — 4 байта, строка — байт длины и символы
+/// (длинная строка обрезается)
+static constexpr size_t LOG_ARGS_MAX = 21;
+
+/// Символов, гарантированных каждой строке записи: длинная строка не вытесняет
+/// следующие аргументы (короткий хеш коммита после тега), LOG сверяет это при компиляции
+static constexpr size_t LOG_STR_MIN = 7;
+
+//=============================================================================
+// SETTINGS (EEPROM 24Cxx) CONFIGURATION
+//=============================================================================
+
+/// Адрес EEPROM на I2C1 (7 бит, A2..A0 = 0)
+static constexpr uint8_t SETTINGS_EEPROM_ADDRESS = 0x50;
+
+/// Объём и страница EEPROM (24C32: 4 КиБ, страницы по 32 байта, адрес ячейки — 2 байта)
+static constexpr uint16_t SETTINGS_EEPROM_SIZE = 4096;
+static constexpr uint8_t SETTINGS_EEPROM_PAGE = 32;
+
+/// Попыток на транзакцию с шагом 1 мс: пока идёт внутренний цикл записи (до 5 мс),
+/// EEPROM не отвечает на свой адрес (ACK polling)
+static constexpr uint8_t SETTINGS_EEPROM_RETRIES = 20;
+
+/// Запись в EEPROM — после того как уставка и PID не менялись столько мс
+/// (серия нажатий кнопок даёт одну запись)
+static constexpr uint32_t SETTINGS_SAVE_DELAY_MS = 2000;
+
+//=============================================================================
+// FLASH KV CONFIGURATION
+//=============================================================================
+
+/// Страница flash STM32F030x6; хранилище — две страницы перед страницей fw_info
+/// (0x08007400..0x08007BFF, область KVSTORE в stm32f030k6tx_flash.ld)
+static constexpr uint16_t FLASH_KV_PAGE_SIZE = 1024;
+
+/// Различных ключей и наибольшее значение (байт) в хранилище
+static constexpr uint8_t FLASH_KV_MAX_KEYS = 8;
+static constexpr uint8_t FLASH_KV_VALUE_MAX = 16;
+
 //=============================================================================
 // APP LOOP TIMING
 //=============================================================================
 
-/// Период тика 100ms (вызывается каждый 100-й вызов app_loop)
-static constexpr uint8_t APP_LOOP_TICKS_PER_100MS = 100;
+/// Период события Tick100ms (мс), периодический таймер TimerWheel
+static constexpr uint32_t APP_TICK_PERIOD_MS = 100;
+
+/// Ёмкость пула таймеров TimerWheel (Tick100ms, звук, уставка, UART, 4 кнопки, анимация индикатора + запас)
+static constexpr uint8_t TIMER_WHEEL_CAPACITY = 12;
+
+/// Период вывода статистики LoopProfiler в UART (мс), при APP_LOOP_PROFILE
+static constexpr uint32_t LOOP_PROFILE_REPORT_PERIOD_MS = 5000;
+
+//=============================================================================
+// LOW POWER (TICKLESS) CONFIGURATION
+//=============================================================================
+
+/// Режим tickless: между итерациями app_loop ядро спит (WFI) до ближайшего
+/// дедлайна сервисов или прерывания (UART, кнопки через EXTI).
+// #define APP_TICKLESS
+
+/// Максимальная длительность одного сна (мс), с запасом меньше таймаута IWDG
+static constexpr uint32_t TICKLESS_MAX_SLEEP_MS = 250;
 
 //=============================================================================
 // TEMPERATURE CONTROLLER CONFIGURATION
@@ -133,6 +241,10 @@ namespace CONTROLLER_PID {
     static constexpr int32_t SCALE = 1000; ///< Масштаб fixed-point (KP=40000 соответствует 40.0)
 }
 
+/// Перебор всей таблицы переходов на каждое событие вместо таблицы обработчиков Fsm::Table по [состояние][EventType]
+/// (прежнее поведение, для сравнения в хост-бенчмарке и отчёте controller_size)
+// #define CONTROLLER_LINEAR_DISPATCH
+
 /// Ограничения температуры для отображения на дисплее
 static constexpr int TEMPERATURE_DISPLAY_MIN = -99;  ///< Минимум -9.9°C
 static constexpr int TEMPERATURE_DISPLAY_MAX = 999;  ///< Максимум 99.9°C
@@ -165,6 +277,27 @@ static constexpr size_t DISPLAY_TEXT_BUFFER_SIZE = 5;
 static constexpr int DISPLAY_TWO_DIGIT_MIN = 10;
 static constexpr int DISPLAY_TWO_DIGIT_MAX = 99;
 
+/// HT1621B::Present() передаёт все 32 ниббла RAM, каждый отдельной посылкой
+/// (прежнее поведение, для сравнения в хост-бенчмарке)
+// #define HT1621_FULL_FLUSH
+
+/// HT1621B на SPI1: Present() только раскладывает посылки в слова, их передаёт SPI1_IRQHandler.
+/// Нужна плата с WR на PB3 (SCK), DATA на PB5 (MOSI), CS на PB4; без define — программный
+/// вывод на PB5/PB4/PB3 (CS/WR/DATA)
+// #define HT1621_SPI
+
+/// Делитель SCK для HT1621_SPI: PCLK / 2^(BR+1), 7 — 187.5 кГц (самый медленный;
+/// HT1621B принимает WR до 300 кГц при 5 В)
+static constexpr uint8_t HT1621_SPI_BR = 7;
+
+/// Мигание сегментов (DisplayAnimator): сколько мс они видны и сколько погашены
+static constexpr uint32_t DISPLAY_BLINK_ON_MS = 400;
+static constexpr uint32_t DISPLAY_BLINK_OFF_MS = 200;
+
+/// Бегущая строка: шаг на один разряд (мс) и пробелов между концом текста и его повтором
+static constexpr uint32_t DISPLAY_MARQUEE_STEP_MS = 300;
+static constexpr uint8_t DISPLAY_MARQUEE_GAP = 2;
+
 //=============================================================================
 // SENSOR CONFIGURATION
 //=============================================================================
@@ -172,6 +305,32 @@ static constexpr int DISPLAY_TWO_DIGIT_MAX = 99;
 /// Максимальное количество попыток читать датчик
 static constexpr uint8_t SENSOR_MAX_RETRIES = 3;
 
+/// Один датчик на шине: Skip ROM без поиска (прежний обмен). По умолчанию DS18B20
+/// находит датчики Search ROM, запускает преобразование у всех сразу и читает каждый по Match ROM
+// #define DS18B20_SKIP_ROM
+
+/// Сколько датчиков DS18B20 запоминает поиск; регулирование — по датчику 0 (первому найденному)
+static constexpr uint8_t DS18B20_MAX_SENSORS = 8;
+
+/// Разрешение DS18B20 при старте (9..12 бит, пишется Write Scratchpad): 0.5 / 0.25 / 0.125 / 0.0625 °C,
+/// преобразование не дольше 94 / 188 / 375 / 750 мс
+static constexpr uint8_t DS18B20_RESOLUTION_BITS = 12;
+
+/// Период измерений (мс): пауза дополняет цикл до него; 0 — следующий цикл сразу.
+/// PID Controller считает на каждом TemperatureReady: 9 бит и 100 мс — 10 Гц с DS18B20_POLL_CONVERSION,
+/// без него цикл не короче 94 мс + обмен (~9.4 Гц)
+static constexpr uint32_t DS18B20_SAMPLE_PERIOD_MS = 1000;
+
+/// Пауза перед повтором после ошибки (нет ответа на reset, пустая шина)
+static constexpr uint32_t DS18B20_ERROR_PAUSE_MS = 250;
+
+/// Конец преобразования по слотам чтения (датчик отвечает 0, пока преобразует) вместо
+/// ожидания наихудшего времени для разрешения. Только при внешнем питании датчиков
+// #define DS18B20_POLL_CONVERSION
+
+/// Шаг опроса конца преобразования (мс) при DS18B20_POLL_CONVERSION
+static constexpr uint32_t DS18B20_POLL_STEP_MS = 4;
+
 //=============================================================================
 // WATCHDOG CONFIGURATION
 //=============================================================================
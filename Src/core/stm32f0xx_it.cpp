@@ -1,4 +1,5 @@
 #include "AppContext.hpp"
+#include "PowerDriver.hpp"
 
 extern App app;
 
@@ -11,15 +12,28 @@ extern "C" {
 void HardFault_Handler(void) { while (1) {}}
 
 void SysTick_Handler(void) {
-    ++RccDriver::g_msTicks;
+#if defined APP_TICKLESS
+    // Во сне период SysTick растягивается на несколько миллисекунд
+    RccDriver::g_msTicks = RccDriver::g_msTicks + PowerDriver::SysTickElapsedMs();
+#else
+    RccDriver::g_msTicks = RccDriver::g_msTicks + 1;
+#endif
     TwiDriver::tick_1ms();
 }
 
-void EXTI0_1_IRQHandler(void) {}
+// EXTI только будят ядро (кнопки в режиме APP_TICKLESS), состояние читает app_loop
 
-void EXTI2_3_IRQHandler(void) {}
+void EXTI0_1_IRQHandler(void) {
+    EXTI->PR = EXTI->PR & 0x0003;
+}
+
+void EXTI2_3_IRQHandler(void) {
+    EXTI->PR = EXTI->PR & 0x000C;
+}
 
-void EXTI4_15_IRQHandler(void) {}
+void EXTI4_15_IRQHandler(void) {
+    EXTI->PR = EXTI->PR & 0xFFF0;
+}
 
 void USART1_IRQHandler(void) {
     if (app.uart) {
@@ -27,6 +41,22 @@ void USART1_IRQHandler(void) {
     }
 }
 
+#if !defined USART_TX_IRQ
+void DMA1_Channel2_3_IRQHandler(void) {
+    if (app.uart) {
+        app.uart->handleTxDmaIRQ();
+    }
+}
+#endif
+
+#if !defined USART_RX_IRQ
+void DMA1_Channel4_5_IRQHandler(void) {
+    if (app.uart) {
+        app.uart->handleRxDmaIRQ();
+    }
+}
+#endif
+
 void TIM17_IRQHandler(void) {
     if (app.tim17) {
         app.tim17->handleIRQ();
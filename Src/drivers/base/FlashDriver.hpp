@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stm32f0xx.h"
+#include "config.h"
+
+/// Начало страниц хранилища: область KVSTORE скрипта компоновки (на хосте — модель flash)
+extern "C" uint8_t _skvstore[];
+
+/**
+ * @brief Запись полуслов и стирание страниц встроенной flash
+ *
+ * Код выполняется из той же flash, поэтому на время операции ядро стоит
+ * (запись полуслова — до 60 мкс, стирание страницы — до 40 мс), прерывания
+ * ждут её конца, а DMA, читающий константы из flash, тоже. Функции возвращаются
+ * уже после операции; разбивать работу на операции и выбирать для них момент —
+ * дело вызывающего (см. KvStore).
+ */
+namespace FlashDriver {
+    static constexpr uint16_t PageSize = FLASH_KV_PAGE_SIZE;
+
+    inline void Unlock() {
+        if (FLASH->CR & FLASH_CR_LOCK) {
+            FLASH->KEYR = FLASH_KEY1;
+            FLASH->KEYR = FLASH_KEY2;
+        }
+    }
+
+    inline void Lock() {
+        FLASH->CR |= FLASH_CR_LOCK;
+    }
+
+    /// Флаги прошлой операции: true — без ошибок; флаги сбрасываются
+    inline bool Finish() {
+        while (FLASH->SR & FLASH_SR_BSY) {}
+        const uint32_t sr = FLASH->SR;
+        FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+        return !(sr & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR));
+    }
+
+    /**
+     * @brief Записать полуслово в стёртую (0xFFFF) ячейку и проверить чтением
+     */
+    inline bool Program(volatile uint16_t *address, uint16_t value) {
+        Unlock();
+        FLASH->CR |= FLASH_CR_PG;
+        *address = value;
+        const bool ok = Finish();
+        FLASH->CR &= ~FLASH_CR_PG;
+        Lock();
+        return ok && *address == value;
+    }
+
+    /**
+     * @brief Стереть страницу, в которой лежит page
+     */
+    inline bool ErasePage(const volatile void *page) {
+        Unlock();
+        FLASH->CR |= FLASH_CR_PER;
+        FLASH->AR = (uintptr_t) page;
+        FLASH->CR |= FLASH_CR_STRT;
+        const bool ok = Finish();
+        FLASH->CR &= ~FLASH_CR_PER;
+        Lock();
+        return ok;
+    }
+}
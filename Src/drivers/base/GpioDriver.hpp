@@ -21,6 +21,9 @@ public:
     enum class Speed {
         Low = 0b00, Medium = 0b01, High = 0b10
     };
+    enum class Edge {
+        Rising = 0b01, Falling = 0b10, Both = 0b11
+    };
 
     constexpr GpioDriver(GPIO_TypeDef *port, uint8_t pin)
             : m_port(port), m_pin(pin),
@@ -66,7 +69,35 @@ public:
         }
     }
 
+    /**
+     * @brief Подключить пин к линии EXTI и разрешить прерывание по фронтам
+     */
+    void EnableExti(Edge edge) const {
+        RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+
+        const uint8_t shift = (m_pin % 4) * 4;
+        SYSCFG->EXTICR[m_pin / 4] = (SYSCFG->EXTICR[m_pin / 4] & ~(0xFU << shift)) |
+                                    (PortCode() << shift);
+
+        const auto e = static_cast<uint32_t>(edge);
+        EXTI->RTSR = (EXTI->RTSR & ~m_pin_mask) | ((e & 0b01) ? m_pin_mask : 0);
+        EXTI->FTSR = (EXTI->FTSR & ~m_pin_mask) | ((e & 0b10) ? m_pin_mask : 0);
+        EXTI->PR = m_pin_mask;
+        EXTI->IMR |= m_pin_mask;
+
+        NVIC_EnableIRQ(m_pin < 2 ? EXTI0_1_IRQn : (m_pin < 4 ? EXTI2_3_IRQn : EXTI4_15_IRQn));
+    }
+
 private:
+    /// Код порта для SYSCFG_EXTICRx
+    uint32_t PortCode() const {
+        if (m_port == GPIOB) return 1;
+        if (m_port == GPIOC) return 2;
+        if (m_port == GPIOD) return 3;
+        if (m_port == GPIOF) return 5;
+        return 0;
+    }
+
     void EnableClock() const {
         if (m_port == GPIOA) RCC->AHBENR |= RCC_AHBENR_GPIOAEN;
         else if (m_port == GPIOB) RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
@@ -0,0 +1,100 @@
+#include "PowerDriver.hpp"
+#include "RccDriver.hpp"
+
+namespace {
+    /// Сколько миллисекунд покрывает текущий период SysTick (1 вне сна)
+    volatile uint32_t s_periodMs = 1;
+
+    uint32_t s_sleepCount = 0;
+    uint32_t s_sleptMs = 0;
+
+    constexpr uint32_t SysTickRun = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    constexpr uint32_t SysTickStop = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+
+    bool SysTickPending() {
+        return SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    }
+
+    /// Запустить SysTick с периодом cycles тактов, покрывающим ms миллисекунд
+    void SysTickRestart(uint32_t cycles, uint32_t ms) {
+        SysTick->LOAD = cycles - 1;
+        SysTick->VAL = 0;
+        s_periodMs = ms;
+        SysTick->CTRL = SysTickRun;
+    }
+}
+
+uint32_t PowerDriver::SysTickElapsedMs() {
+    const uint32_t ms = s_periodMs;
+
+    // Период был растянут или укорочен — возвращаемся к сетке 1 мс
+    if (ms != 1 || SysTick->LOAD != CyclesPerMs - 1) {
+        SysTick->CTRL = SysTickStop;
+        SysTickRestart(CyclesPerMs, 1);
+    }
+    return ms;
+}
+
+void PowerDriver::SleepUntil(uint32_t deadline) {
+    __disable_irq();
+
+    const auto ahead = static_cast<int32_t>(deadline - RccDriver::g_msTicks);
+    if (ahead <= 0) {
+        __enable_irq();
+        return;
+    }
+
+    ++s_sleepCount;
+
+    // До ближайшего тика — обычный сон, SysTick не трогаем
+    if (ahead == 1) {
+        __DSB();
+        __WFI();
+        __enable_irq();
+        ++s_sleptMs;
+        return;
+    }
+
+    const uint32_t ms = static_cast<uint32_t>(ahead) < MaxSleepMs ? static_cast<uint32_t>(ahead) : MaxSleepMs;
+
+    SysTick->CTRL = SysTickStop;
+    if (SysTickPending()) {
+        // Тик уже случился — пусть обработчик отработает, уснём на следующем проходе
+        SysTick->CTRL = SysTickRun;
+        __enable_irq();
+        return;
+    }
+
+    // Остаток текущей миллисекунды + (ms - 1) полных
+    uint32_t left = SysTick->VAL;
+    if (left == 0) left = CyclesPerMs;
+    const uint32_t period = left + (ms - 1) * CyclesPerMs;
+    SysTickRestart(period, ms);
+
+    __DSB();
+    __WFI();
+
+    SysTick->CTRL = SysTickStop;
+    if (SysTickPending()) {
+        // Проспали весь период: обработчик SysTick добавит ms и вернёт период 1 мс
+        SysTick->CTRL = SysTickRun;
+        s_sleptMs += ms;
+    } else {
+        // Ранний выход: досчитываем прошедшие миллисекунды, до конца текущей — короткий период
+        const uint32_t elapsed = (CyclesPerMs - left) + (period - SysTick->VAL);
+        const uint32_t whole = elapsed / CyclesPerMs;
+        RccDriver::g_msTicks = RccDriver::g_msTicks + whole;
+        SysTickRestart(CyclesPerMs - elapsed % CyclesPerMs, 1);
+        s_sleptMs += whole;
+    }
+
+    __enable_irq();
+}
+
+uint32_t PowerDriver::GetSleepCount() {
+    return s_sleepCount;
+}
+
+uint32_t PowerDriver::GetSleptMs() {
+    return s_sleptMs;
+}
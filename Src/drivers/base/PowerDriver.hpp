@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stm32f0xx.h"
+#include "config.h"
+
+/**
+ * @brief Сон ядра (WFI) с растягиванием периода SysTick
+ *
+ * В обычном режиме SysTick тикает каждую миллисекунду и будит ядро 1000 раз
+ * в секунду. SleepUntil() на время сна перепрограммирует SysTick так, чтобы
+ * следующее прерывание пришло ровно в нужную миллисекунду, а обработчик
+ * SysTick добавляет к g_msTicks столько миллисекунд, сколько покрыл период
+ * (SysTickElapsedMs()). При раннем пробуждении (UART, EXTI ...) g_msTicks
+ * досчитывается по остатку счётчика, и SysTick возвращается к сетке 1 мс.
+ */
+namespace PowerDriver {
+    /// Тактов SysTick в одной миллисекунде
+    static constexpr uint32_t CyclesPerMs = SYSTEM_CLOCK_HZ / 1000;
+
+    /// Самый длинный сон, который помещается в 24-битный SysTick->LOAD (мс)
+    static constexpr uint32_t MaxSleepMs = (SysTick_LOAD_RELOAD_Msk + 1) / CyclesPerMs - 1;
+
+    /**
+     * @brief Сколько миллисекунд покрыл закончившийся период SysTick
+     * @note Вызывается только из SysTick_Handler; восстанавливает период 1 мс
+     */
+    uint32_t SysTickElapsedMs();
+
+    /**
+     * @brief Уснуть до момента deadline (шкала g_msTicks) или до любого прерывания
+     * @note Сон ограничен MaxSleepMs; при deadline <= now + 1 — обычный WFI до ближайшего тика
+     */
+    void SleepUntil(uint32_t deadline);
+
+    /// Количество вызовов WFI и миллисекунд, проведённых во сне (для диагностики)
+    uint32_t GetSleepCount();
+    uint32_t GetSleptMs();
+}
@@ -1,8 +1,13 @@
 #include "TwiDriver.hpp"
 #include "GpioDriver.hpp"
+#include "RccDriver.hpp"
 
 TwiDriver::Context TwiDriver::m_ctx{};
-etl::circular_buffer<TwiDriver::Request, TwiDriver::QueueSize> TwiDriver::m_queue{};
+volatile TwiDriver::Phase TwiDriver::m_phase = TwiDriver::Phase::Idle;
+SpscRing<TwiDriver::Request, I2C_QUEUE_SIZE> TwiDriver::m_queue{};
+
+/// Наибольшее значение поля NBYTES
+static constexpr uint16_t MaxChunk = 255;
 
 void TwiDriver::init(uint32_t pclk1, uint32_t speedHz) {
     GpioDriver scl(GPIOB, 6);
@@ -17,6 +22,10 @@ void TwiDriver::init(uint32_t pclk1, uint32_t speedHz) {
     RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
     I2C1->CR1 &= ~I2C_CR1_PE; // Disable I2C before config
 
+    // Наборы TIMINGR для 48 МГц рассчитаны на I2CCLK = SYSCLK, по умолчанию I2C1 тактируется от HSI
+    if (pclk1 == 48'000'000) RCC->CFGR3 |= RCC_CFGR3_I2C1SW;
+    else RCC->CFGR3 &= ~RCC_CFGR3_I2C1SW;
+
     // Configure timing
     uint32_t timing = 0;
 
@@ -68,18 +77,19 @@ void TwiDriver::init(uint32_t pclk1, uint32_t speedHz) {
     }
 
     I2C1->TIMINGR = timing;
-    I2C1->CR1 = I2C_CR1_TXIE | I2C_CR1_RXIE | I2C_CR1_TCIE | I2C_CR1_ERRIE | I2C_CR1_PE;
+    I2C1->CR1 = I2C_CR1_TXIE | I2C_CR1_RXIE | I2C_CR1_TCIE | I2C_CR1_NACKIE | I2C_CR1_STOPIE |
+                I2C_CR1_ERRIE | I2C_CR1_PE;
     NVIC_EnableIRQ(I2C1_IRQn);
 }
 
 bool TwiDriver::submit(const Request &r) {
-    if (m_queue.full())
+    if (!m_queue.push(r))
         return false;
 
-    m_queue.push(r);
-
-    if (m_ctx.state == State::Idle)
-        start_next();
+    // Автомат стоит — запустить его из обработчика. Если он как раз завершает
+    // транзакцию, запрос уже в очереди и start_next() его заберёт
+    if (m_phase == Phase::Idle)
+        NVIC_SetPendingIRQ(I2C1_IRQn);
 
     return true;
 }
@@ -87,106 +97,107 @@ bool TwiDriver::submit(const Request &r) {
 // Start next transaction
 
 void TwiDriver::start_next() {
-    if (m_queue.empty())
+    if (!m_queue.pop(m_ctx.req))
         return;
 
-    m_ctx.req = m_queue.front();
-    m_queue.pop();
+    m_ctx.ok = true;
+    m_ctx.started = RccDriver::g_msTicks;
+    start_phase(m_ctx.req.tx_len || !m_ctx.req.rx_len ? Phase::Write : Phase::Read);
+}
 
-    m_ctx.tx_pos = 0;
-    m_ctx.rx_pos = 0;
-    m_ctx.timeout = TimeoutMs;
-    m_ctx.state = State::Start;
+// START (или повторный START) фазы: адрес, направление и первый кусок NBYTES
 
-    uint8_t nbytes = m_ctx.req.tx_len ? m_ctx.req.tx_len : m_ctx.req.rx_len;
+void TwiDriver::start_phase(Phase phase) {
+    const bool read = phase == Phase::Read;
+
+    m_phase = phase;
+    m_ctx.pos = 0;
+    m_ctx.left = read ? m_ctx.req.rx_len : m_ctx.req.tx_len;
 
     I2C1->CR2 =
         (m_ctx.req.address << 1) |
-        (nbytes << I2C_CR2_NBYTES_Pos) |
-        (m_ctx.req.rx_len ? I2C_CR2_RD_WRN : 0) |
+        (read ? I2C_CR2_RD_WRN : 0) |
+        next_chunk() |
         I2C_CR2_START;
 }
 
+// NBYTES следующего куска фазы; RELOAD, пока фаза не кончилась, AUTOEND — в конце последней
+
+uint32_t TwiDriver::next_chunk() {
+    const uint16_t n = m_ctx.left > MaxChunk ? MaxChunk : m_ctx.left;
+    m_ctx.left -= n;
+
+    const bool last = m_phase == Phase::Read || !m_ctx.req.rx_len;
+    return (static_cast<uint32_t>(n) << I2C_CR2_NBYTES_Pos) |
+           (m_ctx.left ? I2C_CR2_RELOAD : (last ? I2C_CR2_AUTOEND : 0));
+}
+
 // IRQ FSM
 
 void TwiDriver::irq() {
-    uint32_t isr = I2C1->ISR;
+    if (m_phase == Phase::Idle) {
+        start_next();   // Запуск из submit()
+        return;
+    }
+
+    const uint32_t isr = I2C1->ISR;
 
-    if (isr & (I2C_ISR_NACKF | I2C_ISR_BERR)) {
-        m_ctx.state = State::Error;
+    if (isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR) ||
+        RccDriver::g_msTicks - m_ctx.started >= I2C_TIMEOUT_MS) {
+        abort();
+        return;
     }
 
-    switch (m_ctx.state) {
-    case State::Tx:
-        if (isr & I2C_ISR_TXIS) {
-            I2C1->TXDR = m_ctx.req.tx[m_ctx.tx_pos++];
-
-            if (m_ctx.tx_pos >= m_ctx.req.tx_len) {
-                if (m_ctx.req.rx_len) {
-                    m_ctx.state = State::Start;
-                    m_ctx.timeout = TimeoutMs;
-
-                    I2C1->CR2 =
-                        (m_ctx.req.address << 1) |
-                        (m_ctx.req.rx_len << I2C_CR2_NBYTES_Pos) |
-                        I2C_CR2_RD_WRN |
-                        I2C_CR2_START;
-                }
-                else {
-                    m_ctx.state = State::Stop;
-                }
-            }
-        }
-        break;
+    // STOP после NACK аппаратура ставит сама, транзакция завершится по STOPF
+    if (isr & I2C_ISR_NACKF) {
+        I2C1->ICR = I2C_ICR_NACKCF;
+        m_ctx.ok = false;
+    }
 
-    case State::Rx:
-        if (isr & I2C_ISR_RXNE) {
-            m_ctx.req.rx[m_ctx.rx_pos++] = I2C1->RXDR;
+    if (isr & I2C_ISR_TXIS)
+        I2C1->TXDR = m_ctx.req.tx[m_ctx.pos++];
 
-            if (m_ctx.rx_pos >= m_ctx.req.rx_len)
-                m_ctx.state = State::Stop;
-        }
-        break;
-
-    case State::Stop:
-        I2C1->CR2 |= I2C_CR2_STOP;
-        finish(true);
-        break;
-
-    case State::Error:
-        I2C1->CR2 |= I2C_CR2_STOP;
-        finish(false);
-        break;
-
-    default:
-        if (isr & I2C_ISR_TXIS)
-            m_ctx.state = State::Tx;
-        else if (isr & I2C_ISR_RXNE)
-            m_ctx.state = State::Rx;
-        break;
+    if (isr & I2C_ISR_RXNE)
+        m_ctx.req.rx[m_ctx.pos++] = I2C1->RXDR;
+
+    if (isr & I2C_ISR_TCR) {
+        I2C1->CR2 = (I2C1->CR2 & ~(I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_AUTOEND)) | next_chunk();
+    }
+    else if (isr & I2C_ISR_TC) {
+        start_phase(Phase::Read);   // Запись окончена, чтение — повторным START
+    }
+
+    if (isr & I2C_ISR_STOPF) {
+        I2C1->ICR = I2C_ICR_STOPCF;
+        finish(m_ctx.ok);
     }
 }
 
 // Timeout
 
 void TwiDriver::tick_1ms() {
-    if (m_ctx.state == State::Idle)
-        return;
+    if (m_phase != Phase::Idle && RccDriver::g_msTicks - m_ctx.started >= I2C_TIMEOUT_MS)
+        NVIC_SetPendingIRQ(I2C1_IRQn);
+}
 
-    if (m_ctx.timeout > 0) {
-        m_ctx.timeout--;
-        if (m_ctx.timeout == 0)
-            m_ctx.state = State::Error;
-    }
+// Программный сброс: шина и флаги ISR в исходное состояние. PE = 0 держится не меньше
+// трёх тактов APB — запись 0, проверка 0, запись 1, как требует RM0360
+
+void TwiDriver::abort() {
+    I2C1->CR1 &= ~I2C_CR1_PE;
+    while (I2C1->CR1 & I2C_CR1_PE) {}
+    I2C1->CR1 |= I2C_CR1_PE;
+    finish(false);
 }
 
 // Finish
 
 void TwiDriver::finish(bool ok) {
+    m_phase = Phase::Idle;
+
     if (m_ctx.req.callback)
         m_ctx.req.callback(ok);
 
-    m_ctx.state = State::Idle;
     start_next();
 }
 
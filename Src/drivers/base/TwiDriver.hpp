@@ -1,58 +1,86 @@
 #pragma once
 
 #include "stm32f0xx.h"
-#include "etl/circular_buffer.h"
+#include "config.h"
+#include "SpscRing.hpp"
 
+/**
+ * @brief Ведущий I2C1 (PB6/PB7): очередь транзакций, вся последовательность — в I2C1_IRQHandler
+ *
+ * Транзакция — запись tx, затем чтение rx через повторный START (любая из фаз может
+ * быть пустой). Обработчик прерывания сам ведёт её до конца и сразу запускает
+ * следующую из очереди:
+ * - байт данных на TXIS/RXNE (TXDR и RXDR двойные, линия не ждёт, пока ISR успевает за байт);
+ * - фаза длиннее 255 байт идёт кусками по NBYTES с RELOAD (TCR);
+ * - после записи перед чтением — TC и повторный START без STOP;
+ * - STOP последней фазы ставит аппаратура (AUTOEND), транзакция завершается по STOPF,
+ *   NACK и ошибки шины — в том же прерывании, а не в следующем.
+ *
+ * submit() только кладёт запрос в SpscRing и, если автомат стоит, взводит I2C1_IRQn
+ * программно: start_next() выполняется лишь в обработчике, гонки с основным циклом нет.
+ * Таймаут считается от g_msTicks, решение об отмене принимает тоже обработчик.
+ *
+ * DMA1 не используется: у STM32F030x6 запросы I2C1 только на Ch2/Ch3 (без ремапа),
+ * а они заняты передачей USART1 и захватом DS18B20.
+ */
 class TwiDriver {
 public:
     /**
      * @brief Описание транзакций
      */
     struct Request {
-        uint8_t address;
+        uint8_t address;              ///< 7-битный адрес
         const uint8_t *tx;
-        uint8_t tx_len;
+        uint16_t tx_len;
         uint8_t *rx;
-        uint8_t rx_len;
-        void (*callback)(bool ok);
+        uint16_t rx_len;
+        void (*callback)(bool ok);    ///< Вызывается из I2C1_IRQHandler
     };
 
     static void init(uint32_t pclk1 = 48'000'000, uint32_t speedHz = 100'000);
+
+    /**
+     * @brief Поставить транзакцию в очередь (только основной цикл: писатель очереди один)
+     * @return false, если очередь полна
+     */
     static bool submit(const Request &r);
+
     static void irq();
+
+    /// Из SysTick_Handler: по истечении I2C_TIMEOUT_MS взводит I2C1_IRQn
     static void tick_1ms();
 
+    /// Идёт транзакция или в очереди есть запросы
+    static bool busy() { return m_phase != Phase::Idle || !m_queue.empty(); }
+
 private:
     /**
-     * @brief Состояния FSM
+     * @brief Фаза текущей транзакции
      */
-    enum class State : uint8_t {
+    enum class Phase : uint8_t {
         Idle,
-        Start,
-        Tx,
-        Rx,
-        Stop,
-        Error
+        Write,
+        Read
     };
 
     /**
-     * @brief Контекст FSM
+     * @brief Контекст FSM (меняет только обработчик прерывания)
      */
     struct Context {
-        State state = State::Idle;
         Request req{};
-        uint8_t tx_pos = 0;
-        uint8_t rx_pos = 0;
-        uint16_t timeout = 0;
+        uint16_t pos = 0;         ///< Следующий байт фазы
+        uint16_t left = 0;        ///< Байт фазы, ещё не заданных в NBYTES
+        uint32_t started = 0;     ///< g_msTicks запуска
+        bool ok = true;           ///< Не было NACK
     };
 
-    static constexpr uint8_t TimeoutMs = 100;
-
     static Context m_ctx;
-
-    static constexpr size_t QueueSize = 4;
-    static etl::circular_buffer<Request, QueueSize> m_queue;
+    static volatile Phase m_phase;
+    static SpscRing<Request, I2C_QUEUE_SIZE> m_queue;
 
     static void start_next();
+    static void start_phase(Phase phase);
+    static uint32_t next_chunk();
+    static void abort();
     static void finish(bool ok);
 };
@@ -1,22 +1,60 @@
 #pragma once
 
-#include <etl/circular_buffer.h>
+#include <atomic>
+
 #include <etl/string.h>
 
 #include "stm32f0xx.h"
+#include "config.h"
 #include "GpioDriver.hpp"
+#include "IntFormat.hpp"
 
 /**
  * @brief Драйвер USART с неблокирующей передачей и приемом через кольцевые буферы
+ *
+ * Передача: write()/write_str() кладут байты в кольцо, DMA1 Channel 2 забирает их
+ * прямо оттуда — самым длинным непрерывным участком (до конца кольца или до головы),
+ * следующий участок запускается из прерывания Transfer Complete. Так на строку
+ * приходится одно-два прерывания вместо прерывания TXE на каждый байт.
+ * USART_TX_IRQ возвращает побайтовую передачу по TXE.
+ *
+ * Прием: DMA1 Channel 5 (ремап USART1_RX, Channel 3 занят DS18B20) в кольцевом режиме
+ * пишет прямо в кольцо приема, available()/read()/read_str() читают оттуда же.
+ * Голова кольца сдвигается по прерываниям IDLE (пауза в линии — конец посылки)
+ * и половины/конца кольца DMA, так что прерываний на каждый байт нет.
+ * Читатель видит байты с задержкой до половины кольца, поэтому кольцо должно вмещать
+ * всё принятое за самую долгую паузу основного цикла плюс половину кольца
+ * (128 байт на 115200 — около 5 мс занятого цикла без потерь).
+ * USART_RX_IRQ возвращает прием по RXNE на каждый байт.
+ *
+ * В каждом кольце один писатель и один читатель (основной цикл и прерывание),
+ * поэтому индексы — атомарные load/store без запрета прерываний (как в SpscRing).
+ *
  * @tparam Baudrate Скорость передачи (по умолчанию 115200)
- * @tparam TxBuffSize Размер кольцевого буфера для передачи
- * @tparam RxBuffSize Размер кольцевого буфера для приема
+ * @tparam TxBuffSize Размер кольцевого буфера для передачи (степень двойки)
+ * @tparam RxBuffSize Размер кольцевого буфера для приема (степень двойки)
  */
-template<uint32_t Baudrate = 115200, size_t TxBuffSize = 64, size_t RxBuffSize = 32>
+template<uint32_t Baudrate = 115200, size_t TxBuffSize = 64, size_t RxBuffSize = 128>
 class UsartDriver {
-    etl::circular_buffer<uint8_t, TxBuffSize> m_tx_buf; ///< Кольцевой буфер для передачи
-    etl::circular_buffer<uint8_t, RxBuffSize> m_rx_buf; ///< Кольцевой буфер для приема
+    static_assert(TxBuffSize >= 2 && (TxBuffSize & (TxBuffSize - 1)) == 0,
+                  "UsartDriver: TxBuffSize должно быть степенью двойки");
+    static_assert(RxBuffSize >= 2 && (RxBuffSize & (RxBuffSize - 1)) == 0,
+                  "UsartDriver: RxBuffSize должно быть степенью двойки");
+
+    static constexpr uint32_t TxMask = TxBuffSize - 1;
+    static constexpr uint32_t RxMask = RxBuffSize - 1;
+
+    uint8_t m_tx_data[TxBuffSize]{};                    ///< Кольцо передачи (DMA читает прямо отсюда)
+    std::atomic<uint32_t> m_tx_head{0};                 ///< Сколько байт положено (пишет только основной цикл)
+    std::atomic<uint32_t> m_tx_tail{0};                 ///< Сколько байт отправлено (пишет только прерывание)
+#if !defined USART_TX_IRQ
+    std::atomic<uint32_t> m_tx_dma_len{0};              ///< Длина участка в работе у DMA, 0 — канал свободен
+#endif
+    uint8_t m_rx_data[RxBuffSize]{};                    ///< Кольцо приема (DMA пишет прямо сюда)
+    std::atomic<uint32_t> m_rx_head{0};                 ///< Сколько байт принято (пишет только прерывание)
+    std::atomic<uint32_t> m_rx_tail{0};                 ///< Сколько байт прочитано (пишет только основной цикл)
     volatile uint32_t m_rx_overrun_count = 0;            ///< Счетчик переполнений буфера приема
+    volatile uint32_t m_rx_idle_count = 0;               ///< Сколько раз линия замолкала после приема (посылок)
 
     /**
      * @brief Включает тактирование USART1
@@ -42,23 +80,100 @@ class UsartDriver {
      * @brief Неблокирующая запись одного байта в буфер передачи
      * @param byte Байта для записи
      * @return true, если запись успешна, false если буфер полон
-     * @note Включает прерывание TXE при успешной записи
+     * @note Передачу запускает tx_start() после записи всей порции
      */
     bool tx_enqueue_byte(uint8_t byte) {
-        if (m_tx_buf.full()) {
+        const uint32_t head = m_tx_head.load(std::memory_order_relaxed);
+        if (head - m_tx_tail.load(std::memory_order_acquire) >= TxBuffSize) {
             return false;
         }
-        m_tx_buf.push(byte);
+        m_tx_data[head & TxMask] = byte;
+        m_tx_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Запустить передачу записанного (основной цикл)
+     */
+    void tx_start() {
+#if defined USART_TX_IRQ
         USART1->CR1 |= USART_CR1_TXEIE;
+#else
+        // Канал занят — следующий участок запустит прерывание Transfer Complete.
+        // Свободный канал прерывание уже не тронет: TC приходит только после запуска
+        if (m_tx_dma_len.load(std::memory_order_acquire) == 0) {
+            tx_dma_kick();
+        }
+#endif
+    }
+
+#if !defined USART_TX_IRQ
+    /**
+     * @brief Отдать DMA самый длинный непрерывный участок кольца от хвоста
+     * @note Вызывается только при свободном канале
+     */
+    void tx_dma_kick() {
+        const uint32_t tail = m_tx_tail.load(std::memory_order_relaxed);
+        const uint32_t pending = m_tx_head.load(std::memory_order_acquire) - tail;
+        const uint32_t offset = tail & TxMask;
+        const uint32_t span = pending < TxBuffSize - offset ? pending : TxBuffSize - offset;
+        if (span == 0) {
+            return;
+        }
+
+        m_tx_dma_len.store(span, std::memory_order_relaxed);
+        DMA1_Channel2->CMAR = (uintptr_t) &m_tx_data[offset];
+        DMA1_Channel2->CNDTR = span;
+        DMA1_Channel2->CCR |= DMA_CCR_EN;
+    }
+#endif
+
+    /**
+     * @brief Забрать самый старый принятый байт (основной цикл)
+     * @return false, если кольцо пусто
+     */
+    bool rx_pop(uint8_t &byte) {
+        const uint32_t head = m_rx_head.load(std::memory_order_acquire);
+        uint32_t tail = m_rx_tail.load(std::memory_order_relaxed);
+        if (head == tail) {
+            return false;
+        }
+        // DMA обогнал чтение на круг: старые байты уже перезаписаны (учтены в rx_dma_sync)
+        if (head - tail > RxBuffSize) {
+            tail = head - RxBuffSize;
+        }
+        byte = m_rx_data[tail & RxMask];
+        m_rx_tail.store(tail + 1, std::memory_order_release);
         return true;
     }
 
+#if !defined USART_RX_IRQ
+    /**
+     * @brief Сдвинуть голову кольца приема до позиции записи DMA (только из прерываний)
+     * @note Вызывается по IDLE и по половине/концу кольца, поэтому между вызовами
+     *       DMA проходит меньше круга и сдвиг однозначен
+     */
+    void rx_dma_sync() {
+        const uint32_t head = m_rx_head.load(std::memory_order_relaxed);
+        const uint32_t pos = (RxBuffSize - DMA1_Channel5->CNDTR) & RxMask;
+        const uint32_t next = head + ((pos - head) & RxMask);
+
+        // Отставание чтения больше кольца — потерянные байты (считаются один раз)
+        const uint32_t tail = m_rx_tail.load(std::memory_order_acquire);
+        const uint32_t lost_before = head - tail > RxBuffSize ? head - tail - RxBuffSize : 0;
+        const uint32_t lost_after = next - tail > RxBuffSize ? next - tail - RxBuffSize : 0;
+        m_rx_overrun_count = m_rx_overrun_count + (lost_after - lost_before);
+
+        m_rx_head.store(next, std::memory_order_release);
+    }
+#endif
+
 public:
     /**
      * @brief Инициализация USART1 и GPIO
      * @param apb_clk_hz Частота шины APB (Гц)
      */
-    static void Init(uint32_t apb_clk_hz) {
+    void Init(uint32_t apb_clk_hz) {
         GpioDriver rx(GPIOA, 10);
         GpioDriver tx(GPIOA, 9);
 
@@ -78,12 +193,69 @@ public:
         USART1->CR2 = 0;
         USART1->CR1 |= USART_CR1_UE; // Включение USART
         
-        // Включение прерываний на прием (RXNE) и передачу (TXE)
+#if defined USART_RX_IRQ
+        // Прерывание на каждый принятый байт (RXNE)
         USART1->CR1 |= USART_CR1_RXNEIE;
+#else
+        // DMA1 Channel 5 — USART1_RX после ремапа: RDR -> кольцо приема, по кругу.
+        // Прерывания: IDLE (конец посылки), половина/конец кольца, ORE через EIE
+        RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+        RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+        SYSCFG->CFGR1 |= SYSCFG_CFGR1_USART1RX_DMA_RMP;
+
+        DMA1_Channel5->CCR = 0;
+        DMA1_Channel5->CPAR = (uintptr_t) &USART1->RDR;
+        DMA1_Channel5->CMAR = (uintptr_t) m_rx_data;
+        DMA1_Channel5->CNDTR = RxBuffSize;
+        DMA1_Channel5->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+
+        USART1->CR3 |= USART_CR3_DMAR | USART_CR3_EIE;
+        USART1->CR1 |= USART_CR1_IDLEIE;
+
+        NVIC_EnableIRQ(DMA1_Channel4_5_IRQn);
+#endif
+
+#if !defined USART_TX_IRQ
+        // DMA1 Channel 2 — запрос USART1_TX (без ремапа): память -> TDR, байтами
+        RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+        DMA1_Channel2->CCR = 0;
+        DMA1_Channel2->CPAR = (uintptr_t) &USART1->TDR;
+        DMA1_Channel2->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE | DMA_CCR_TEIE;
+        USART1->CR3 |= USART_CR3_DMAT;
+
+        NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+#endif
 
         NVIC_EnableIRQ(USART1_IRQn);
     }
 
+    /**
+     * @brief Неблокирующая запись массива байт в буфер передачи
+     * @param data Данные
+     * @param len Длина
+     * @return Количество успешно записанных байт (меньше len, если буфер заполнился)
+     */
+    int write(const uint8_t *data, size_t len) {
+        size_t count = 0;
+        while (count < len && tx_enqueue_byte(data[count])) {
+            count++;
+        }
+        if (count) tx_start();
+        return static_cast<int>(count);
+    }
+
+    /// Ёмкость буфера передачи
+    static constexpr size_t TxCapacity = TxBuffSize;
+
+    /**
+     * @brief Свободное место в буфере передачи
+     * @note Писатель один (основной цикл), поэтому после проверки место только прибавляется:
+     *       порция не длиннее tx_free() запишется целиком
+     */
+    size_t tx_free() const {
+        return TxBuffSize - (m_tx_head.load(std::memory_order_relaxed) - m_tx_tail.load(std::memory_order_acquire));
+    }
+
     /**
      * @brief Неблокирующая запись C-style строки в буфер передачи
      * @param s Указатель на нуль-терминированную строку
@@ -95,6 +267,7 @@ public:
             s++;
             count++;
         }
+        if (count) tx_start();
         return count;
     }
 
@@ -111,6 +284,7 @@ public:
             if (!tx_enqueue_byte(static_cast<uint8_t>(c))) break;
             count++;
         }
+        if (count) tx_start();
         return count;
     }
 
@@ -119,91 +293,115 @@ public:
      * @param value Целое число для передачи
      */
     void write_int(int value) {
-        etl::string<7> buf;
-        buf.clear();
-
-        if (value == 0) {
-            buf.push_back('0');
-        } else {
-            int is_negative = 0;
-            unsigned int uvalue = value;
-            if (value < 0) {
-                is_negative = 1;
-                uvalue = -value;
-            }
-
-            etl::string<7> tmp;
-            while (uvalue) {
-                tmp.push_back('0' + (uvalue % 10));
-                uvalue /= 10;
-            }
-
-            if (is_negative) tmp.push_back('-');
-
-            for (int i = tmp.size() - 1; i >= 0; --i) {
-                buf.push_back(tmp[i]);
-            }
-        }
-
-        write_str(buf);
+        char buf[IntFormat::IntBufSize];
+        write(reinterpret_cast<const uint8_t *>(buf), IntFormat::formatInt(value, buf));
     }
 
     /**
      * @brief Обработчик прерывания USART1
      * @note Должен вызываться из ISR (например, USART1_IRQHandler)
-     * @note Обрабатывает передачу (TXE) и прием (RXNE) данных
+     * @note Обрабатывает передачу (TXE, при USART_TX_IRQ) и прием (RXNE) данных
      */
     void handleIRQ() {
+#if defined USART_TX_IRQ
         // Обработка передачи (TXE - Transmit Data Register Empty)
         if (USART1->ISR & USART_ISR_TXE) {
-            if (!m_tx_buf.empty()) {
-                USART1->TDR = m_tx_buf.front();
-                m_tx_buf.pop();
+            const uint32_t tail = m_tx_tail.load(std::memory_order_relaxed);
+            if (m_tx_head.load(std::memory_order_acquire) != tail) {
+                USART1->TDR = m_tx_data[tail & TxMask];
+                m_tx_tail.store(tail + 1, std::memory_order_release);
             } else {
                 // Буфер пуст - отключаем прерывание TXE
                 USART1->CR1 &= ~USART_CR1_TXEIE;
             }
         }
+#endif
+
+        const uint32_t isr = USART1->ISR;
 
-        // Обработка приема и ошибок
-        // Важно: проверяем ORE перед RXNE, так как чтение RDR очищает оба флага
-        uint32_t isr = USART1->ISR;
-        
         // Обработка ошибки переполнения (ORE - Overrun Error)
-        // ORE возникает когда новые данные приходят до чтения предыдущих из RDR
+        // ORE возникает когда новые данные приходят до чтения предыдущих из RDR.
+        // На STM32F0 флаг сбрасывается только записью ORECF (чтение RDR его не трогает,
+        // и прерывание повторялось бы без конца); байт в RDR при этом не потерян
         if (isr & USART_ISR_ORE) {
-            // Читаем RDR для очистки флагов ORE и RXNE
-            // Данные теряются на уровне железа (не успели прочитать вовремя)
-            volatile uint8_t dummy = static_cast<uint8_t>(USART1->RDR);
-            (void)dummy;
-            ++m_rx_overrun_count;
+            USART1->ICR = USART_ICR_ORECF;
+            m_rx_overrun_count = m_rx_overrun_count + 1;
         }
+
+#if defined USART_RX_IRQ
         // Обработка приема (RXNE - Read Data Register Not Empty)
-        // Проверяем только если ORE не был установлен (чтение RDR выше очистило бы RXNE)
-        else if (isr & USART_ISR_RXNE) {
+        if (isr & USART_ISR_RXNE) {
             // Читаем данные из регистра (это также очищает флаг RXNE)
             uint8_t byte = static_cast<uint8_t>(USART1->RDR);
-            
-            if (!m_rx_buf.full()) {
-                m_rx_buf.push(byte);
+
+            const uint32_t head = m_rx_head.load(std::memory_order_relaxed);
+            if (head - m_rx_tail.load(std::memory_order_acquire) < RxBuffSize) {
+                m_rx_data[head & RxMask] = byte;
+                m_rx_head.store(head + 1, std::memory_order_release);
             } else {
                 // Буфер переполнен - инкрементируем счетчик переполнений
                 // Данные теряются (FIFO поведение - старые данные сохраняются)
-                ++m_rx_overrun_count;
+                m_rx_overrun_count = m_rx_overrun_count + 1;
             }
         }
-        
+#else
+        // Пауза в линии после приема: посылка закончилась, отдаем ее читателю
+        if (isr & USART_ISR_IDLE) {
+            USART1->ICR = USART_ICR_IDLECF;
+            rx_dma_sync();
+            m_rx_idle_count = m_rx_idle_count + 1;
+        }
+#endif
+
         // Примечание: флаги FE (Frame Error), PE (Parity Error), NE (Noise Error)
         // очищаются автоматически при чтении RDR вместе с RXNE
         // Если нужна детальная диагностика ошибок, можно добавить отдельные счетчики
     }
 
+#if !defined USART_TX_IRQ
+    /**
+     * @brief Обработчик прерывания DMA1 Channel 2 (передача участка завершена)
+     * @note Должен вызываться из DMA1_Channel2_3_IRQHandler
+     */
+    void handleTxDmaIRQ() {
+        const uint32_t isr = DMA1->ISR;
+        if (!(isr & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2))) {
+            return;
+        }
+        DMA1->IFCR = DMA_IFCR_CGIF2;
+        DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+
+        // При ошибке шины участок тоже списывается, иначе передача остановится навсегда
+        const uint32_t tail = m_tx_tail.load(std::memory_order_relaxed);
+        m_tx_tail.store(tail + m_tx_dma_len.load(std::memory_order_relaxed), std::memory_order_release);
+        m_tx_dma_len.store(0, std::memory_order_release);
+
+        tx_dma_kick();
+    }
+#endif
+
+#if !defined USART_RX_IRQ
+    /**
+     * @brief Обработчик прерывания DMA1 Channel 5 (половина/конец кольца приема)
+     * @note Должен вызываться из DMA1_Channel4_5_IRQHandler
+     */
+    void handleRxDmaIRQ() {
+        if (DMA1->ISR & (DMA_ISR_HTIF5 | DMA_ISR_TCIF5)) {
+            DMA1->IFCR = DMA_IFCR_CHTIF5 | DMA_IFCR_CTCIF5;
+            rx_dma_sync();
+        }
+    }
+#endif
+
     /**
      * @brief Получить количество доступных байт в буфере приема
      * @return Количество байт, доступных для чтения
+     * @note С DMA байты становятся доступны после паузы в линии (IDLE)
+     *       или заполнения половины кольца
      */
     size_t available() const {
-        return m_rx_buf.size();
+        const uint32_t pending = m_rx_head.load(std::memory_order_acquire) - m_rx_tail.load(std::memory_order_relaxed);
+        return pending < RxBuffSize ? pending : RxBuffSize;
     }
 
     /**
@@ -211,7 +409,14 @@ public:
      * @return true, если есть данные для чтения
      */
     bool has_data() const {
-        return !m_rx_buf.empty();
+        return m_rx_head.load(std::memory_order_acquire) != m_rx_tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Сколько раз линия замолкала после приема (число посылок, только с DMA)
+     */
+    uint32_t get_rx_idle_count() const {
+        return m_rx_idle_count;
     }
 
     /**
@@ -220,12 +425,7 @@ public:
      * @return true, если байт успешно прочитан, false если буфер пуст
      */
     bool read(uint8_t *byte) {
-        if (m_rx_buf.empty()) {
-            return false;
-        }
-        *byte = m_rx_buf.front();
-        m_rx_buf.pop();
-        return true;
+        return rx_pop(*byte);
     }
 
     /**
@@ -233,11 +433,10 @@ public:
      * @return Прочитанный байт или -1 если буфер пуст
      */
     int read_byte() {
-        if (m_rx_buf.empty()) {
+        uint8_t byte;
+        if (!rx_pop(byte)) {
             return -1;
         }
-        uint8_t byte = m_rx_buf.front();
-        m_rx_buf.pop();
         return static_cast<int>(byte);
     }
 
@@ -253,9 +452,8 @@ public:
         str.clear();
         size_t count = 0;
         
-        while (!m_rx_buf.empty() && str.size() < str.max_size() - 1) {
-            uint8_t byte = m_rx_buf.front();
-            m_rx_buf.pop();
+        uint8_t byte;
+        while (str.size() < str.max_size() - 1 && rx_pop(byte)) {
             ++count;
             
             str.push_back(static_cast<char>(byte));
@@ -283,10 +481,8 @@ public:
         size_t count = 0;
         size_t max_read = buffer_size - 1; // Оставляем место для '\0'
         
-        while (!m_rx_buf.empty() && count < max_read) {
-            uint8_t byte = m_rx_buf.front();
-            m_rx_buf.pop();
-            
+        uint8_t byte;
+        while (count < max_read && rx_pop(byte)) {
             buffer[count] = static_cast<char>(byte);
             ++count;
             
@@ -303,7 +499,7 @@ public:
      * @brief Очистить буфер приема
      */
     void clear_rx() {
-        m_rx_buf.clear();
+        m_rx_tail.store(m_rx_head.load(std::memory_order_acquire), std::memory_order_release);
     }
 
     /**
@@ -312,7 +508,7 @@ public:
      */
     void flush() {
         // Wait for TX buffer to be empty (all data sent)
-        while (!m_tx_buf.empty()) {
+        while (m_tx_head.load(std::memory_order_acquire) != m_tx_tail.load(std::memory_order_acquire)) {
             // Spin-wait: буфер заполняется в main(), опустошается в IRQ
         }
     }
@@ -320,7 +516,8 @@ public:
     /**
      * @brief Получить счетчик переполнений буфера приема
      * @return Количество переполнений с момента инициализации
-     * @note Счетчик инкрементируется при попытке записи в полный буфер
+     * @note Счетчик инкрементируется при попытке записи в полный буфер, при ORE
+     *       и (с DMA) на каждый байт, перезаписанный до чтения
      */
     uint32_t get_rx_overrun_count() const {
         return m_rx_overrun_count;
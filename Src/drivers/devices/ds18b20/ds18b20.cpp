@@ -2,9 +2,12 @@
 
 #include <cstdint>
 #include <array>
+#include <algorithm>
 
 #include "Event.hpp"
 #include "AppContext.hpp"
+#include "CycleCounter.hpp"
+#include "Log.hpp"
 
 // #define PRINT_TEMP
 
@@ -55,7 +58,7 @@ static uint32_t elapsed_time;
 #define DS18B20_SCRATCHPAD_BITS (DS18B20_SCRATCHPAD_LEN * DS18B20_BITS_PER_BYTE)
 /** @brief Threshold to distinguish short/long pulses (10µs) */
 #define SHORT_PULSE_MAX       0x0A
-/** @brief Number of DMA transfers for command transmission */
+/** @brief Number of DMA transfers for a two-byte command (Skip ROM + function) */
 #define DS18B20_DMA_TRANSFERS   16
 
 // Константы для длительностей импульсов
@@ -86,9 +89,35 @@ constexpr auto makeCommand(const std::array<uint8_t, N> &bytes) noexcept {
     return cmd;
 }
 
+// Преобразование n байтов во время выполнения (команда с кодом ROM)
+static void encodeCommand(const uint8_t *bytes, uint8_t n, uint8_t *pulses) noexcept {
+    for (uint8_t i = 0; i < n; ++i)
+        for (uint8_t bit = 0; bit < 8; ++bit)
+            pulses[i * 8 + bit] = bitToPulse(bytes[i], bit);
+    pulses[n * 8] = 0;
+}
+
+/** @brief Skip ROM + Write Scratchpad: TH, TL (значения по включению) и регистр конфигурации */
+constexpr uint8_t WRITE_SCRATCHPAD = 0x4E;
+constexpr uint8_t ALARM_TH_DEFAULT = 0x4B;
+constexpr uint8_t ALARM_TL_DEFAULT = 0x46;
+constexpr uint8_t CONFIG_WRITE_BYTES = 5;
+/** @brief Наихудшее время преобразования при 9 битах (мкс), каждый следующий бит — вдвое дольше */
+constexpr uint32_t CONVERSION_9BIT_US = 93750;
+constexpr uint32_t CONVERSION_MAX_US = CONVERSION_9BIT_US << 3;
+
 // Использование
 constexpr auto conv_cmd = makeCommand(std::array<uint8_t, 2>{0xCC, 0x44});
+#if defined DS18B20_SKIP_ROM
 constexpr auto read_cmd = makeCommand(std::array<uint8_t, 2>{0xCC, 0xBE});
+#else
+constexpr auto search_cmd = makeCommand(std::array<uint8_t, 1>{0xF0});
+
+/** @brief Match ROM: 0x55, 8 байт ROM, затем функциональная команда */
+constexpr uint8_t MATCH_ROM = 0x55;
+constexpr uint8_t READ_SCRATCHPAD = 0xBE;
+constexpr uint8_t MATCH_READ_BYTES = 10;
+#endif
 
 void DS18B20::detect_sensor_type() {
     // DS18S20 не имеет конфигурационного регистра - scratchpad[4] = 0xFF
@@ -136,51 +165,52 @@ void ds18b20_led_control(unsigned action) {
  * @param[in] temp Temperature value in tenths of degrees Celsius, or error code
  */
 #if defined ELAPSED_TIME
-void ds18b20_temp_ready(int16_t temp, uint32_t t) {
+void ds18b20_temp_ready(uint8_t sensor, int16_t temp, uint32_t t) {
 #else
 
-void ds18b20_temp_ready(int16_t temp) {
+void ds18b20_temp_ready(uint8_t sensor, int16_t temp) {
 #endif
-    if (temp == DS18B20::ErrorStatus::TEMP_ERROR_NO_SENSOR) { // No sensor detected error - enqueue error message
-        app.uart->write_str("DS18B20 error: no sensor detected.\r\n");
-    } else if (temp == DS18B20::ErrorStatus::TEMP_ERROR_CRC_FAIL) { // CRC check failed error - enqueue error message
-        app.uart->write_str("DS18B20 error: CRC check failed.\r\n");
-    } else if (temp == DS18B20::ErrorStatus::TEMP_ERROR_GENERIC) { // Generic error - enqueue error message
-        app.uart->write_str("DS18B20 error: generic failure.\r\n");
-    } else {                                 // Valid temperature reading - format and display
+    const auto n = static_cast<unsigned>(sensor);
+    if (temp == DS18B20::ErrorStatus::TEMP_ERROR_NO_SENSOR) { // No sensor detected error
+        LOG("DS18B20 %u error: no sensor detected.", n);
+    } else if (temp == DS18B20::ErrorStatus::TEMP_ERROR_CRC_FAIL) { // CRC check failed error
+        LOG("DS18B20 %u error: CRC check failed.", n);
+    } else if (temp == DS18B20::ErrorStatus::TEMP_ERROR_GENERIC) { // Generic error
+        LOG("DS18B20 %u error: generic failure.", n);
+    }
+
+    if (temp <= DS18B20::ErrorStatus::TEMP_ERROR_CRC_FAIL) { // Any error - controller must cut off the heater
+        if (app.queue) {
+            app.queue->push({EventType::SensorError, temp, sensor});
+        }
+    } else {                                 // Valid temperature reading - log and pass on
+#if defined PRINT_TEMP
         int whole = temp / 10;               // Get whole degrees (temp is in tenths)
         int frac = temp % 10;                // Get fractional part (tenths)
         if (frac < 0) frac = -frac;          // Ensure fractional part is positive
-#if defined PRINT_TEMP
-        app.uart->write_str("Temperature: ");
-        app.uart->write_int(whole);          // Display whole part
-        app.uart->write_str(".");               // Decimal point
-        app.uart->write_int(frac);           // Display fractional part
-        app.uart->write_str(" C");              // Units
 #if defined ELAPSED_TIME
-        app.uart->write_str(" (");   // Parenthesis
-        app.uart->write_int(t / 48); // Display time elapsed
-        app.uart->write_str(" us)"); // Parenthesis
+        LOG("Temperature %u: %d.%d C (%u us)", n, whole, frac, t / 48);
+#else
+        LOG("Temperature %u: %d.%d C", n, whole, frac);
 #endif
-        app.uart->write_str("\r\n");     // And newline
 #endif
 
         if (app.queue) {
             // temp уже в десятых долях градуса, передаём как есть
-            app.queue->push({EventType::TemperatureReady, temp});
+            app.queue->push({EventType::TemperatureReady, temp, sensor});
         }
     }
 }
 
 /**
- * @brief Calculate CRC8 checksum for DS18B20 scratchpad data validation
+ * @brief Dallas/Maxim CRC8 of len bytes (scratchpad, ROM code)
  * @return CRC8 checksum value
  */
-uint8_t DS18B20::check_scratchpad_crc() {
+uint8_t DS18B20::crc8(const uint8_t *data, uint8_t len) {
     uint8_t crc = 0;
-    // Process each byte in the scratchpad (first 8 bytes) for CRC calculation
-    for (uint8_t i = 0; i < DS18B20_CRC8_BYTES; i++) {
-        uint8_t inByte = m_ctx.scratchpad[i];
+    // Process each byte for CRC calculation
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t inByte = data[i];
         // Process each bit in the byte using Dallas/Maxim CRC8 algorithm
         for (uint8_t b = 0; b < 8; b++) {
             uint8_t mix = (crc ^ inByte) & 0x01;
@@ -192,6 +222,14 @@ uint8_t DS18B20::check_scratchpad_crc() {
     return crc;
 }
 
+/**
+ * @brief Calculate CRC8 checksum for DS18B20 scratchpad data validation
+ * @return CRC8 checksum value
+ */
+uint8_t DS18B20::check_scratchpad_crc() {
+    return crc8(m_ctx.scratchpad, DS18B20_CRC8_BYTES);
+}
+
 /**
  * @brief Decode pulse durations into scratchpad bytes using bit timing analysis
  */
@@ -255,12 +293,50 @@ void DS18B20::start_timer(uint16_t arr, uint8_t rcr) {
     ForceUpdateEvent(TIM1);
     // Start timer in One Pulse Mode (OPM) - runs once then stops
     TIM1->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;
+    arm_deadline();
+}
+
+/**
+ * @brief Run TIM1 for about us microseconds: fewest passes of at most 65536 ticks
+ * @param[in] us Duration in microseconds (10 µs .. 16.7 s)
+ */
+void DS18B20::start_timer_us(uint32_t us) {
+    if (us < 10) us = 10;
+    // RCR is 8 bits: at most 256 passes
+    uint32_t passes = (us + 0xFFFF) / 0x10000;
+    if (passes > 256) passes = 256;
+    uint32_t ticks = us / passes;
+    if (ticks > 0x10000) ticks = 0x10000;
+    start_timer(static_cast<uint16_t>(ticks - 1), static_cast<uint8_t>(passes - 1));
+}
+
+/**
+ * @brief Worst-case conversion time: 93.75 ms at 9 bits, doubling per bit; DS18S20 — always 750 ms
+ */
+uint32_t DS18B20::conversion_us() const {
+    return m_fullWait ? CONVERSION_MAX_US : CONVERSION_9BIT_US << (m_resolution - 9);
+}
+
+void DS18B20::start_cycle_pause() {
+    const uint32_t spent = RccDriver::GetMsTicks() - m_cycleStart;
+    start_timer_us(m_periodMs > spent ? (m_periodMs - spent) * 1000 : 0);
+}
+
+/**
+ * @brief Remember when the just started TIM1 operation ends
+ * @note Timer ticks at 1µs: operation lasts (ARR + 1) * (RCR + 1) µs, rounded up with 1 ms margin
+ */
+void DS18B20::arm_deadline() {
+    const uint32_t us = (TIM1->ARR + 1) * ((TIM1->RCR & 0xFF) + 1);
+    m_deadline = RccDriver::GetMsTicks() + us / 1000 + 2;
 }
 
 /**
  * @brief Initialize 1-Wire bus reset sequence using timer and DMA
  */
 void DS18B20::reset_bus() {
+    // Stale edges of an earlier reset must not pass for a presence pulse
+    m_ctx.fill_union = (uint64_t) -1;
     // Configure timer for reset pulse generation (480µs low)
     TIM1->ARR = RESET_TIMEOUT;              // Total reset slot time (960µs)
     TIM1->CCR1 = RESET_PULSE_DURATION;      // Reset pulse duration (480µs)
@@ -272,8 +348,8 @@ void DS18B20::reset_bus() {
     TIM1->RCR = 0;                                  // No repetition
     // Configure DMA to capture presence pulse edge timestamps
     DMA1_Channel3->CCR = 0;                           // Clear DMA configuration
-    DMA1_Channel3->CPAR = (uint32_t) &TIM1->CCR2;      // DMA destination: timer capture register
-    DMA1_Channel3->CMAR = (uint32_t) m_ctx.edge;        // DMA source: edge timestamp buffer
+    DMA1_Channel3->CPAR = (uintptr_t) &TIM1->CCR2;      // DMA destination: timer capture register
+    DMA1_Channel3->CMAR = (uintptr_t) m_ctx.edge;        // DMA source: edge timestamp buffer
     DMA1_Channel3->CNDTR = CAPTURE_BUF_SIZE;          // Number of transfers (2 edges)
     // Enable DMA with memory increment
     DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 | DMA_CCR_EN;
@@ -282,16 +358,18 @@ void DS18B20::reset_bus() {
     TIM1->CCR1 = 0;                           // Clear output compare value
     TIM1->DIER = TIM_DIER_CC2DE;              // Enable DMA request on capture
     TIM1->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;   // Start timer in one-pulse mode
+    arm_deadline();
 }
 
 /**
  * @brief Transmit command sequence to DS18B20 using DMA
- * @param[in] cmd Pointer to command sequence in pulse duration format
+ * @param[in] cmd Pointer to command sequence in pulse duration format (bits + terminating 0)
+ * @param[in] bits Number of bit slots (1..256)
  * @note Non-blocking - configures hardware to transmit command automatically
  */
-void DS18B20::send_command(const uint8_t *cmd) {
+void DS18B20::send_command(const uint8_t *cmd, uint8_t bits) {
     // Configure timer for command transmission using DMA
-    TIM1->RCR = DS18B20_DMA_TRANSFERS - 1;   // Number of repetitions (16 transfers)
+    TIM1->RCR = bits - 1;                    // Number of repetitions (one per bit slot)
     TIM1->ARR = ONE_PULSE + ZERO_PULSE + 1;  // Total bit slot time (62µs)
     TIM1->CCR1 = cmd[0];                     // First pulse duration
     TIM1->CCR4 = ONE_PULSE + ZERO_PULSE;     // Update trigger time
@@ -303,21 +381,23 @@ void DS18B20::send_command(const uint8_t *cmd) {
     ForceUpdateEvent(TIM1);
     // Configure DMA to transmit command pulse sequence
     DMA1_Channel4->CCR = 0;                          // Clear DMA configuration
-    DMA1_Channel4->CPAR = (uint32_t) &TIM1->CCR1;    // DMA destination: output compare register
-    DMA1_Channel4->CMAR = (uint32_t) &cmd[1];        // DMA source: command data (skip first byte)
-    DMA1_Channel4->CNDTR = DS18B20_DMA_TRANSFERS;    // Number of transfers
+    DMA1_Channel4->CPAR = (uintptr_t) &TIM1->CCR1;    // DMA destination: output compare register
+    DMA1_Channel4->CMAR = (uintptr_t) &cmd[1];        // DMA source: command data (skip first byte)
+    DMA1_Channel4->CNDTR = bits;                     // Number of transfers
     // Enable DMA with memory increment
     DMA1_Channel4->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_EN;
     TIM1->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;           // Start timer in one-pulse mode
+    arm_deadline();
 }
 
 /**
  * @brief Read scratchpad data from DS18B20 using timer capture and DMA
+ * @param[in] bits Number of read slots (scratchpad — 72, search — 2)
  * @note Non-blocking - configures hardware to capture data automatically
  */
-void DS18B20::read_data() {
+void DS18B20::read_data(uint8_t bits) {
     // Configure timer for data reading with input capture
-    TIM1->RCR = DS18B20_SCRATCHPAD_BITS - 1; // Number of repetitions (72 bits)
+    TIM1->RCR = bits - 1;                    // Number of repetitions (one per read slot)
     TIM1->ARR = ONE_PULSE + ZERO_PULSE + 1;  // Total bit slot time (62µs)
     TIM1->CCR1 = ONE_PULSE;                  // Read pulse duration (1µs)
     // Configure channel 1 for output compare (generate read pulse)
@@ -331,11 +411,12 @@ void DS18B20::read_data() {
     TIM1->CCR1 = 0;                          // Clear output compare value
     // Configure DMA to capture pulse durations into pulse buffer
     DMA1_Channel3->CCR = 0;                                            // Clear DMA configuration
-    DMA1_Channel3->CPAR = (uint32_t) &TIM1->CCR2;                       // DMA destination: capture register
-    DMA1_Channel3->CMAR = (uint32_t) m_ctx.pulse;                        // DMA source: pulse duration buffer
-    DMA1_Channel3->CNDTR = DS18B20_SCRATCHPAD_BITS;                    // Number of transfers (72 bits)
+    DMA1_Channel3->CPAR = (uintptr_t) &TIM1->CCR2;                       // DMA destination: capture register
+    DMA1_Channel3->CMAR = (uintptr_t) m_ctx.pulse;                        // DMA source: pulse duration buffer
+    DMA1_Channel3->CNDTR = bits;                                       // Number of transfers (one per slot)
     DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_EN;  // Enable DMA with memory increment
     TIM1->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;   // Start timer in one-pulse mode
+    arm_deadline();
 }
 
 /**
@@ -347,13 +428,62 @@ void DS18B20::read_data() {
  * @{
  */
 
+/**
+ * @brief Store the result of sensor and pass it on
+ */
+void DS18B20::report(uint8_t sensor, int16_t temp) {
+    m_temps[sensor] = temp;
+#if defined ELAPSED_TIME
+    ds18b20_temp_ready(sensor, temp, CycleCounter::now() - elapsed_time);
+#else
+    ds18b20_temp_ready(sensor, temp);
+#endif
+}
+
+/**
+ * @brief Report the same status for every sensor of the table (sensor 0 if it is empty)
+ */
+void DS18B20::report_all(int16_t status) {
+    const uint8_t count = m_count ? m_count : 1;
+    for (uint8_t i = 0; i < count; ++i) report(i, status);
+}
+
+/**
+ * @brief Decode the scratchpad of sensor m_index and report temperature or CRC error
+ */
+void DS18B20::decode_and_report() {
+    // Decode captured pulse durations into scratchpad bytes
+    decode_scratchpad();
+#if defined DS18B20_SKIP_ROM
+    detect_sensor_type();
+#endif
+    ++m_samples;
+
+    // Validate CRC and report temperature or error
+    if (m_ctx.scratchpad[8] == check_scratchpad_crc()) {
+        const bool matches = config_matches();
+        // A DS18S20 needs 750 ms from now on, whatever the resolution
+        if (m_family == 0x10) m_fullWait = true;
+        if (matches) {
+            // CRC valid - decode and report temperature
+            report(m_index, decode_temperature());
+        } else {
+            // Sensor lost its resolution (power glitch) or needs 750 ms: the wait may have been too short
+            m_configured = false;
+            report(m_index, ErrorStatus::TEMP_ERROR_GENERIC);
+        }
+    } else {
+        // CRC invalid - report error
+        report(m_index, ErrorStatus::TEMP_ERROR_CRC_FAIL);
+    }
+}
+
 // Методы-действия для состояний FSM
 void DS18B20::action_idle() {
 #if defined ELAPSED_TIME
-    elapsed_time = DWT->CYCCNT;
+    elapsed_time = CycleCounter::now();
 #endif
-    // Initialize union memory (fills with 0xFF pattern)
-    m_ctx.fill_union = (uint64_t) -1;
+    m_cycleStart = RccDriver::GetMsTicks();
 }
 
 void DS18B20::action_start() {
@@ -364,24 +494,32 @@ void DS18B20::action_start() {
 }
 
 void DS18B20::action_convert_ok() {
-    // Device present - send temperature conversion command
-    send_command(conv_cmd.data());
+    // Device present - start conversion on every sensor at once (Skip ROM + Convert T)
+    m_index = 0;
+    send_command(conv_cmd.data(), DS18B20_DMA_TRANSFERS);
 }
 
 void DS18B20::action_convert_fail() {
     // No device present - report error and pause
-#if defined ELAPSED_TIME
-    ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_NO_SENSOR, DWT->CYCCNT - elapsed_time);
-#else
-    ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+    report_all(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+#if !defined DS18B20_SKIP_ROM
+    // Search the bus again once sensors answer
+    m_count = 0;
 #endif
-    // Start inter-measurement pause
-    start_cycle_pause();
+    // Sensors that come back start with the resolution from their EEPROM
+    m_configured = false;
+    start_error_pause();
 }
 
 void DS18B20::action_wait() {
-    // Start timer for conversion wait period (750ms typical)
+#if defined DS18B20_POLL_CONVERSION
+    // First read slot after one step; give up polling after the worst-case time
+    m_pollLeft = static_cast<uint16_t>(conversion_us() / (DS18B20_POLL_STEP_MS * 1000) + 1);
+    start_timer_us(DS18B20_POLL_STEP_MS * 1000);
+#else
+    // Start timer for the worst-case conversion time of the resolution
     wait_conversion();
+#endif
 }
 
 void DS18B20::action_continue() {
@@ -391,92 +529,320 @@ void DS18B20::action_continue() {
 
 void DS18B20::action_request_ok() {
     // Device present - send read scratchpad command
-    send_command(read_cmd.data());
+#if defined DS18B20_SKIP_ROM
+    send_command(read_cmd.data(), DS18B20_DMA_TRANSFERS);
+#else
+    // Match ROM: only sensor m_index answers the read slots
+    uint8_t bytes[MATCH_READ_BYTES];
+    bytes[0] = MATCH_ROM;
+    for (uint8_t i = 0; i < 8; ++i) bytes[1 + i] = m_roms[m_index][i];
+    bytes[9] = READ_SCRATCHPAD;
+    encodeCommand(bytes, MATCH_READ_BYTES, m_ctx.command);
+    m_family = m_roms[m_index][0];
+    send_command(m_ctx.command, MATCH_READ_BYTES * DS18B20_BITS_PER_BYTE);
+#endif
 }
 
 void DS18B20::action_request_fail() {
     // No device present - report error and pause
-#if defined ELAPSED_TIME
-    ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_NO_SENSOR, DWT->CYCCNT - elapsed_time);
-#else
-    ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+    report_all(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+#if !defined DS18B20_SKIP_ROM
+    m_count = 0;
 #endif
-    // Start inter-measurement pause
-    start_cycle_pause();
+    m_configured = false;
+    start_error_pause();
 }
 
 void DS18B20::action_read() {
     // Initiate scratchpad data read using timer capture and DMA
-    read_data();
+    read_data(DS18B20_SCRATCHPAD_BITS);
+}
+
+void DS18B20::action_decode_next() {
+    decode_and_report();
+    // Next sensor of the same conversion: reset, then Match ROM
+    ++m_index;
+    reset_bus();
 }
 
 void DS18B20::action_decode() {
-    // Decode captured pulse durations into scratchpad bytes
-    decode_scratchpad();
-    detect_sensor_type();
+    decode_and_report();
     // Turn off LED to indicate measurement complete
     ds18b20_led_control(0);
 
-    // Validate CRC and report temperature or error
+    // Start inter-measurement pause period
+    start_cycle_pause();
+}
+
+void DS18B20::action_configure() {
+    // Every sensor at once: Skip ROM + Write Scratchpad (TH, TL, configuration)
+    m_resolution = m_requested;
+    const uint8_t bytes[CONFIG_WRITE_BYTES] = {0xCC, WRITE_SCRATCHPAD, ALARM_TH_DEFAULT, ALARM_TL_DEFAULT, config_byte()};
+    encodeCommand(bytes, CONFIG_WRITE_BYTES, m_ctx.command);
+    send_command(m_ctx.command, CONFIG_WRITE_BYTES * DS18B20_BITS_PER_BYTE);
+}
+
+void DS18B20::action_configure_done() {
+    m_configured = true;
+    // Write Scratchpad ends with a reset, then the conversion as usual
+    reset_bus();
+}
+
+/**
+ * @brief Resolution read back with the scratchpad is the one the conversion wait assumed
+ */
+bool DS18B20::config_matches() const {
+    // DS18S20: no configuration register, conversion always takes up to 750 ms
+    if (m_family == 0x10) return m_fullWait || m_resolution == 12;
+    return m_ctx.scratchpad[4] == config_byte();
+}
+
+void DS18B20::setResolution(uint8_t bits) {
+    if (bits < 9) bits = 9;
+    if (bits > 12) bits = 12;
+    // The conversion in flight keeps the old resolution (wait and readback), the new one
+    // is written at the start of the next cycle
+    m_requested = bits;
+}
+
+#if defined DS18B20_POLL_CONVERSION
+/**
+ * @brief The read slot came back high: every sensor has finished converting
+ */
+bool DS18B20::conversion_done() const {
+    return m_ctx.pulse[0] <= SHORT_PULSE_MAX;
+}
+
+void DS18B20::action_poll_slot() {
+    --m_pollLeft;
+    read_data(1);
+}
+
+void DS18B20::action_poll_pause() {
+    // Disarm the slot capture: the next one is started by action_poll_slot()
+    TIM1->DIER = 0;
+    start_timer_us(DS18B20_POLL_STEP_MS * 1000);
+}
+#endif
+
+#if !defined DS18B20_SKIP_ROM
+/**
+ * @brief Both read slots returned 1: no sensor drives the bit or its complement
+ */
+bool DS18B20::search_no_device() const {
+    return m_ctx.pulse[0] <= SHORT_PULSE_MAX && m_ctx.pulse[1] <= SHORT_PULSE_MAX;
+}
+
+void DS18B20::action_search_begin() {
 #if defined ELAPSED_TIME
-    if (m_ctx.scratchpad[8] == check_scratchpad_crc()) {
-        // CRC valid - decode and report temperature
-        ds18b20_temp_ready(decode_temperature(), DWT->CYCCNT - elapsed_time);
+    elapsed_time = CycleCounter::now();
+#endif
+    m_cycleStart = RccDriver::GetMsTicks();
+    ds18b20_led_control(!0);
+    m_lastDiscrepancy = 0;
+    m_configured = false;
+    reset_bus();
+}
+
+void DS18B20::action_search_command() {
+    m_searchBit = 0;
+    m_lastZero = 0;
+    send_command(search_cmd.data(), DS18B20_BITS_PER_BYTE);
+}
+
+void DS18B20::action_search_fail() {
+    // Nobody answered (or the search broke off) before a single ROM was stored;
+    // a later pass that breaks off ends in action_search_done() with the codes found so far
+    report_all(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+    m_count = 0;
+    ds18b20_led_control(0);
+    start_error_pause();
+}
+
+void DS18B20::action_search_read() {
+    read_data(2);
+}
+
+/**
+ * @brief Choose the branch for the current ROM bit and write it (Maxim AN187)
+ * @note Bit numbers in m_lastDiscrepancy / m_lastZero are 1-based, 0 means "none"
+ */
+void DS18B20::action_search_write() {
+    const bool bit = m_ctx.pulse[0] <= SHORT_PULSE_MAX;
+    const bool complement = m_ctx.pulse[1] <= SHORT_PULSE_MAX;
+    const uint8_t number = m_searchBit + 1;
+    uint8_t &romByte = m_searchRom[m_searchBit >> 3];
+    const auto mask = static_cast<uint8_t>(1U << (m_searchBit & 7));
+
+    bool direction;
+    if (bit != complement) {
+        // All remaining sensors agree on this bit
+        direction = bit;
     } else {
-        // CRC invalid - report error
-        ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_CRC_FAIL, DWT->CYCCNT - elapsed_time);
+        // Discrepancy: repeat the previous pass before m_lastDiscrepancy, take 1 at it, 0 after it
+        direction = number < m_lastDiscrepancy ? (romByte & mask) != 0 : number == m_lastDiscrepancy;
+        if (!direction) m_lastZero = number;
     }
-#else
-    if (m_ctx.scratchpad[8] == check_scratchpad_crc()) {
-        // CRC valid - decode and report temperature
-        ds18b20_temp_ready(decode_temperature());
-    } else {
-        // CRC invalid - report error
-        ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_CRC_FAIL);
+    if (direction) romByte |= mask;
+    else romByte &= static_cast<uint8_t>(~mask);
+
+    if (++m_searchBit == 64) {
+        m_lastDiscrepancy = m_lastZero;
+        if (crc8(m_searchRom, 7) == m_searchRom[7]) {
+            for (uint8_t i = 0; i < 8; ++i) m_roms[m_count][i] = m_searchRom[i];
+            ++m_count;
+        } else {
+            // Corrupted pass: keep what was found so far
+            m_lastDiscrepancy = 0;
+        }
     }
-#endif
 
-    // Start inter-measurement pause period
-    start_cycle_pause();
+    m_ctx.command[0] = direction ? ONE_PULSE : ZERO_PULSE;
+    m_ctx.command[1] = 0;
+    send_command(m_ctx.command, 1);
+}
+
+void DS18B20::action_search_restart() {
+    reset_bus();
 }
 
-// Таблица переходов FSM
-const DS18B20::Transition DS18B20::m_transitions[] = {
+/**
+ * @brief Put the regulating probe at index 0 whatever order the search found the bus in
+ * @note A probe missing from the search keeps its slot: it is read (and fails) like a
+ *       detached one, regulation does not move to another probe. On a full table it
+ *       takes the place of the last code.
+ */
+void DS18B20::keep_control_first() {
+    if (!m_controlKnown) {
+        for (uint8_t b = 0; b < 8; ++b) m_controlRom[b] = m_roms[0][b];
+        m_controlKnown = true;
+        return;
+    }
+
+    uint8_t i = 0;
+    while (i < m_count && !std::equal(m_controlRom, m_controlRom + 8, m_roms[i])) ++i;
+    if (i == m_count) {
+        if (m_count < DS18B20_MAX_SENSORS) ++m_count;
+        i = m_count - 1;
+        for (uint8_t b = 0; b < 8; ++b) m_roms[i][b] = m_controlRom[b];
+    }
+    // The others keep the search order
+    for (; i > 0; --i) {
+        for (uint8_t b = 0; b < 8; ++b) std::swap(m_roms[i][b], m_roms[i - 1][b]);
+    }
+}
+
+void DS18B20::action_search_done() {
+    keep_control_first();
+    // DS18S20 has a fixed 9-bit conversion of up to 750 ms
+    m_fullWait = false;
+    for (uint8_t i = 0; i < m_count; ++i) m_fullWait |= m_roms[i][0] == 0x10;
+    // Table complete: first conversion right away
+    reset_bus();
+}
+#endif
+
+// Таблица переходов FSM (проверяется и разворачивается по состояниям при компиляции, см. Fsm.hpp)
+constexpr DS18B20::Machine::Row DS18B20::m_transitions[] = {
+#if !defined DS18B20_SKIP_ROM
+        // IDLE -> SEARCH (таблица датчиков пуста: сначала Search ROM)
+        {FsmSignals::TimerDone, FsmStates::IDLE,     &DS18B20::needs_search,        &DS18B20::action_search_begin, FsmStates::SEARCH},
+#endif
+
         // IDLE -> START (безусловный, fallthrough - выполняем action_idle и сразу переходим в START)
-        {FsmStates::IDLE,     nullptr,                       &DS18B20::action_idle,         FsmStates::START},
+        {FsmSignals::TimerDone, FsmStates::IDLE,     nullptr,                       &DS18B20::action_idle,         FsmStates::START, true},
 
         // START -> CONVERT (безусловный)
-        {FsmStates::START,    nullptr,                       &DS18B20::action_start,        FsmStates::CONVERT},
+        {FsmSignals::TimerDone, FsmStates::START,    nullptr,                       &DS18B20::action_start,        FsmStates::CONVERT},
+
+        // CONVERT -> CONFIGURE (если присутствует, а разрешение не записано или изменено)
+        {FsmSignals::TimerDone, FsmStates::CONVERT,  &DS18B20::needs_config,        &DS18B20::action_configure,    FsmStates::CONFIGURE},
 
         // CONVERT -> WAIT (если присутствует)
-        {FsmStates::CONVERT,  &DS18B20::check_presence_ok,   &DS18B20::action_convert_ok,   FsmStates::WAIT},
+        {FsmSignals::TimerDone, FsmStates::CONVERT,  &DS18B20::check_presence_ok,   &DS18B20::action_convert_ok,   FsmStates::WAIT},
 
         // CONVERT -> IDLE (если отсутствует)
-        {FsmStates::CONVERT,  &DS18B20::check_presence_fail, &DS18B20::action_convert_fail, FsmStates::IDLE},
+        {FsmSignals::TimerDone, FsmStates::CONVERT,  &DS18B20::check_presence_fail, &DS18B20::action_convert_fail, FsmStates::IDLE},
 
         // WAIT -> CONTINUE (безусловный)
-        {FsmStates::WAIT,     nullptr,                       &DS18B20::action_wait,         FsmStates::CONTINUE},
+        {FsmSignals::TimerDone, FsmStates::WAIT,     nullptr,                       &DS18B20::action_wait,         FsmStates::CONTINUE},
+
+#if defined DS18B20_POLL_CONVERSION
+        // CONTINUE -> POLL (слот чтения, пока не истекло наихудшее время)
+        {FsmSignals::TimerDone, FsmStates::CONTINUE, &DS18B20::conversion_pending,  &DS18B20::action_poll_slot,    FsmStates::POLL},
+#endif
 
         // CONTINUE -> REQUEST (безусловный)
-        {FsmStates::CONTINUE, nullptr,                       &DS18B20::action_continue,     FsmStates::REQUEST},
+        {FsmSignals::TimerDone, FsmStates::CONTINUE, nullptr,                       &DS18B20::action_continue,     FsmStates::REQUEST},
+
+#if defined DS18B20_POLL_CONVERSION
+        // POLL -> REQUEST (слот вернул 1: преобразование закончено у всех датчиков)
+        {FsmSignals::TimerDone, FsmStates::POLL,     &DS18B20::conversion_done,     &DS18B20::action_continue,     FsmStates::REQUEST},
+
+        // POLL -> CONTINUE (ещё преобразует: следующий слот через шаг)
+        {FsmSignals::TimerDone, FsmStates::POLL,     nullptr,                       &DS18B20::action_poll_pause,   FsmStates::CONTINUE},
+#endif
 
         // REQUEST -> READ (если присутствует)
-        {FsmStates::REQUEST,  &DS18B20::check_presence_ok,   &DS18B20::action_request_ok,   FsmStates::READ},
+        {FsmSignals::TimerDone, FsmStates::REQUEST,  &DS18B20::check_presence_ok,   &DS18B20::action_request_ok,   FsmStates::READ},
 
         // REQUEST -> IDLE (если отсутствует)
-        {FsmStates::REQUEST,  &DS18B20::check_presence_fail, &DS18B20::action_request_fail, FsmStates::IDLE},
+        {FsmSignals::TimerDone, FsmStates::REQUEST,  &DS18B20::check_presence_fail, &DS18B20::action_request_fail, FsmStates::IDLE},
 
         // READ -> DECODE (безусловный)
-        {FsmStates::READ,     nullptr,                       &DS18B20::action_read,         FsmStates::DECODE},
+        {FsmSignals::TimerDone, FsmStates::READ,     nullptr,                       &DS18B20::action_read,         FsmStates::DECODE},
+
+        // DECODE -> REQUEST (есть следующий датчик: то же преобразование, чтение по Match ROM)
+        {FsmSignals::TimerDone, FsmStates::DECODE,   &DS18B20::more_sensors,        &DS18B20::action_decode_next,  FsmStates::REQUEST},
 
         // DECODE -> IDLE (безусловный, CRC проверяется внутри)
-        {FsmStates::DECODE,   nullptr,                       &DS18B20::action_decode,       FsmStates::IDLE},
+        {FsmSignals::TimerDone, FsmStates::DECODE,   nullptr,                       &DS18B20::action_decode,       FsmStates::IDLE},
+
+        // CONFIGURE -> CONVERT (разрешение записано: reset и преобразование)
+        {FsmSignals::TimerDone, FsmStates::CONFIGURE, nullptr,                      &DS18B20::action_configure_done, FsmStates::CONVERT},
+
+#if !defined DS18B20_SKIP_ROM
+        // SEARCH -> SEARCH_READ (если присутствует: Search ROM)
+        {FsmSignals::TimerDone, FsmStates::SEARCH,       &DS18B20::check_presence_ok,  &DS18B20::action_search_command, FsmStates::SEARCH_READ},
+
+        // SEARCH -> CONVERT (нет присутствия на следующем проходе: таблица из найденного)
+        {FsmSignals::TimerDone, FsmStates::SEARCH,       &DS18B20::search_found,       &DS18B20::action_search_done,    FsmStates::CONVERT},
+
+        // SEARCH -> IDLE (если отсутствует)
+        {FsmSignals::TimerDone, FsmStates::SEARCH,       nullptr,                      &DS18B20::action_search_fail,    FsmStates::IDLE},
+
+        // SEARCH_READ -> SEARCH_WRITE (бит ROM и его дополнение)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_READ,  nullptr,                      &DS18B20::action_search_read,    FsmStates::SEARCH_WRITE},
+
+        // SEARCH_WRITE -> CONVERT (проход оборвался, но коды уже есть: таблица из найденного)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_WRITE, &DS18B20::search_lost,        &DS18B20::action_search_done,    FsmStates::CONVERT},
+
+        // SEARCH_WRITE -> IDLE (оба слота 1: ни один датчик не отвечает)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_WRITE, &DS18B20::search_no_device,   &DS18B20::action_search_fail,    FsmStates::IDLE},
+
+        // SEARCH_WRITE -> SEARCH_READ (направление записано, следующий бит)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_WRITE, &DS18B20::search_more_bits,   &DS18B20::action_search_write,   FsmStates::SEARCH_READ},
+
+        // SEARCH_WRITE -> SEARCH_NEXT (записан 64-й бит)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_WRITE, nullptr,                      &DS18B20::action_search_write,   FsmStates::SEARCH_NEXT},
+
+        // SEARCH_NEXT -> SEARCH (есть ещё ветви и место в таблице)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_NEXT,  &DS18B20::search_more_roms,   &DS18B20::action_search_restart, FsmStates::SEARCH},
+
+        // SEARCH_NEXT -> IDLE (ни одного кода с верным CRC)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_NEXT,  &DS18B20::search_empty,       &DS18B20::action_search_fail,    FsmStates::IDLE},
+
+        // SEARCH_NEXT -> CONVERT (таблица готова)
+        {FsmSignals::TimerDone, FsmStates::SEARCH_NEXT,  nullptr,                      &DS18B20::action_search_done,    FsmStates::CONVERT},
+#endif
 };
 
 /**
  * @brief Initialize DS18B20 driver - configure clocks and peripherals
  */
 void DS18B20::init() {
+    for (auto &temp: m_temps) temp = ErrorStatus::TEMP_ERROR_NO_SENSOR;
+
     // Enable clocks for required peripherals: GPIOA, TIM1, DMA1
     RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
     RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_DMA1EN;
@@ -508,6 +874,28 @@ void DS18B20::init() {
     GPIOA->AFR[1] |= (0x2U << ((8 - 8) * 4)); // установить AF2
 }
 
+const uint8_t *DS18B20::getRom(uint8_t i) const {
+#if defined DS18B20_SKIP_ROM
+    (void) i;
+    return nullptr;
+#else
+    return i < m_count ? m_roms[i] : nullptr;
+#endif
+}
+
+int16_t DS18B20::getTemperature(uint8_t i) const {
+    return i < m_count ? m_temps[i] : static_cast<int16_t>(ErrorStatus::TEMP_ERROR_NO_SENSOR);
+}
+
+void DS18B20::nextDeadline(WakeDeadline &d) const {
+    // UIF уже поднят (в т.ч. после init()) — работа есть прямо сейчас
+    if (TIM1->SR & TIM_SR_UIF) {
+        d.at(RccDriver::GetMsTicks());
+    } else {
+        d.at(m_deadline);
+    }
+}
+
 /**
  * @brief Main state machine function - must be called periodically from main loop
  * @note Non-blocking state machine that advances 1-Wire communication state
@@ -520,52 +908,18 @@ void DS18B20::poll() {
     // Clear timer update interrupt flag
     TIM1->SR = 0;
 
-    // Поиск подходящего перехода в таблице
-    bool transition_found = false;
-    bool need_fallthrough = false;
-
-    for (const auto &t: m_transitions) {
-        if (t.state == m_ctx.current_state) {
-            // Проверка условия (если есть)
-            if (!t.guard || (this->*t.guard)()) {
-                // Выполнение действия
-                (this->*t.action)();
-                // Переход в следующее состояние
-                m_ctx.current_state = t.next;
-                transition_found = true;
-
-                // Обработка fallthrough: IDLE -> START выполняется сразу
-                if (t.next == FsmStates::START) {
-                    need_fallthrough = true;
-                    // Продолжаем поиск для START
-                    continue;
-                }
-                break;
-            }
-        }
-    }
-
-    // Если нужен fallthrough (IDLE -> START), выполняем START -> CONVERT сразу
-    if (need_fallthrough && m_ctx.current_state == FsmStates::START) {
-        for (const auto &t: m_transitions) {
-            if (t.state == FsmStates::START) {
-                if (!t.guard || (this->*t.guard)()) {
-                    (this->*t.action)();
-                    m_ctx.current_state = t.next;
-                    break;
-                }
-            }
-        }
+    // O(1) lookup by current state; IDLE -> START runs in the same poll (fallthrough row)
+    FsmStates next;
+    const bool transition_found =
+            Machine::Table<m_transitions, FsmStates::IDLE>::dispatch(*this, m_ctx.current_state, FsmSignals::TimerDone, next);
+    if (transition_found) {
+        m_ctx.current_state = next;
     }
 
     // Если переход не найден - ошибка
     if (!transition_found) {
         // Unexpected state - report generic error
-#if defined ELAPSED_TIME
-        ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_GENERIC, DWT->CYCCNT - elapsed_time);
-#else
-        ds18b20_temp_ready(ErrorStatus::TEMP_ERROR_GENERIC);
-#endif
+        report_all(ErrorStatus::TEMP_ERROR_GENERIC);
         // Return to IDLE state
         m_ctx.current_state = FsmStates::IDLE;
     }
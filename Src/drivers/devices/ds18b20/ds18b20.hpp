@@ -17,11 +17,30 @@
  * 2. Call ds18b20_poll() repeatedly from main loop
  * 3. Implement weak callbacks ds18b20_led_control() and ds18b20_temp_ready()
  *    to handle LED feedback and temperature results
+ *
+ * Multi-drop bus (default): the first cycle enumerates the sensors with Search ROM (0xF0),
+ * bit by bit (two read slots and one write slot per ROM bit), into a table of up to
+ * DS18B20_MAX_SENSORS ROM codes. Every cycle then starts one broadcast conversion
+ * (Skip ROM + Convert T) and reads each sensor with Match ROM + Read Scratchpad, so the
+ * cycle lasts one conversion plus N scratchpad reads. Each result is reported with
+ * the sensor index (table order). The table is searched again once no sensor answers.
+ * Index 0 is the regulating probe: the first one found after init() stays there across
+ * searches, and reads as a missing sensor while it is off the bus.
+ * DS18B20_SKIP_ROM keeps the single-sensor Skip ROM exchange.
+ *
+ * Resolution (9..12 bits) is written to every sensor with Write Scratchpad before the
+ * first conversion and checked in each scratchpad read; the conversion wait follows it
+ * (94/188/375/750 ms, DS18S20 always 750 ms). The pause only fills the cycle up to the
+ * sample period. DS18B20_POLL_CONVERSION replaces the blind wait with a read slot every
+ * DS18B20_POLL_STEP_MS: sensors hold the slot low until all of them have finished.
  */
 
 #pragma once
 
 #include "stm32f0xx.h"
+#include "config.h"
+#include "WakeDeadline.hpp"
+#include "Fsm.hpp"
 
 class DS18B20 {
     enum class FsmStates : uint8_t {
@@ -33,8 +52,27 @@ class DS18B20 {
         REQUEST,
         READ,
         DECODE,
-        ERROR
+        CONFIGURE,      ///< Write Scratchpad (resolution) in progress
+#if defined DS18B20_POLL_CONVERSION
+        POLL,           ///< Read slot: 0 while a sensor is still converting
+#endif
+#if !defined DS18B20_SKIP_ROM
+        SEARCH,         ///< Presence after reset, then Search ROM command
+        SEARCH_READ,    ///< Two read slots: ROM bit and its complement
+        SEARCH_WRITE,   ///< Write slot: the chosen direction
+        SEARCH_NEXT,    ///< One ROM found: next search pass or first conversion
+#endif
+        Any             ///< Wildcard for the transition table / number of states
     };
+
+    /** @brief FSM signal: the TIM1 operation started by the previous action has finished */
+    enum class FsmSignals : uint8_t {
+        TimerDone,
+        Any
+    };
+
+    using Machine = Fsm<DS18B20, FsmStates, FsmSignals>;
+
     /**
      * @brief DS18B20 driver context structure using union for memory efficiency
      * @note Different stages of communication use the same memory for different purposes
@@ -44,24 +82,47 @@ class DS18B20 {
             volatile uint16_t edge[36];   /**< Edge timestamps for presence detection */
             volatile uint8_t pulse[72];   /**< Pulse durations for data decoding */
             uint8_t scratchpad[9];        /**< Sensor scratchpad data */
+            uint8_t command[81];          /**< Runtime command in pulse format (Match ROM: 80 bits + 0) */
             uint64_t fill_union;          /**< Utility field for filling the union */
         };
         FsmStates current_state;            /**< Current state of the state machine */
     } m_ctx;
 
-    struct Transition {
-        FsmStates state;                  ///< Исходное состояние
-        bool (DS18B20::*guard)() const;   ///< Условие перехода (nullptr = безусловный)
-        void (DS18B20::*action)();       ///< Действие при переходе
-        FsmStates next;                   ///< Целевое состояние
-    };
-
     uint8_t m_family = 0x28;
 
+#if defined DS18B20_SKIP_ROM
+    uint8_t m_count = 1;       ///< Single sensor addressed with Skip ROM
+#else
+    uint8_t m_roms[DS18B20_MAX_SENSORS][8] = {};   ///< ROM codes found by the search, family code first
+    uint8_t m_count = 0;       ///< Sensors in m_roms (0 — search on the next cycle)
+    uint8_t m_searchRom[8] = {};   ///< ROM of the current search pass (previous one until overwritten)
+    uint8_t m_searchBit = 0;       ///< ROM bits written in the current pass
+    uint8_t m_lastDiscrepancy = 0; ///< 1-based bit where the next pass takes the 1 branch (0 — done)
+    uint8_t m_lastZero = 0;        ///< 1-based bit of the last 0 branch taken at a discrepancy
+    uint8_t m_controlRom[8] = {};  ///< Regulating probe: the first one found after init(), kept at index 0
+    bool m_controlKnown = false;   ///< m_controlRom is set
+#endif
+    uint8_t m_index = 0;       ///< Sensor being read in this cycle
+    uint8_t m_resolution = DS18B20_RESOLUTION_BITS; ///< Written to the sensors: the running conversion uses it
+    uint8_t m_requested = DS18B20_RESOLUTION_BITS;  ///< setResolution(): written before the next conversion
+    bool m_configured = false; ///< Resolution written since the last search / readback mismatch
+    bool m_fullWait = false;   ///< A DS18S20 is on the bus: 750 ms regardless of resolution
+    uint32_t m_periodMs = DS18B20_SAMPLE_PERIOD_MS;
+    uint32_t m_cycleStart = 0; ///< Start of the current cycle (ms)
+#if defined DS18B20_POLL_CONVERSION
+    uint16_t m_pollLeft = 0;   ///< Read slots left before the worst-case conversion time
+#endif
+    int16_t m_temps[DS18B20_MAX_SENSORS] = {};   ///< Last result per sensor (init(): TEMP_ERROR_NO_SENSOR)
+
+    uint32_t m_deadline = 0;   ///< Момент (мс), к которому TIM1 закончит текущую операцию
+    uint32_t m_samples = 0;    ///< Decoded scratchpads, valid or not (diagnostics)
+
     inline void detect_sensor_type();
 
     void ForceUpdateEvent(TIM_TypeDef *tim);
 
+    static uint8_t crc8(const uint8_t *data, uint8_t len);
+
     uint8_t check_scratchpad_crc();
 
     void decode_scratchpad();
@@ -76,23 +137,52 @@ class DS18B20 {
 
     void start_timer(uint16_t arr, uint8_t rcr);
 
+    /** @brief Run TIM1 for about us microseconds (ARR and RCR chosen for the length) */
+    void start_timer_us(uint32_t us);
+
+    void arm_deadline();
+
+    /** @brief Worst-case conversion time for the configured resolution (µs) */
+    uint32_t conversion_us() const;
+
+    /** @brief Configuration register for the configured resolution (R1 R0 in bits 6..5) */
+    uint8_t config_byte() const { return static_cast<uint8_t>(((m_resolution - 9) << 5) | 0x1F); }
+
     /**
-     * @brief Wait for temperature conversion to complete (750ms typical)
+     * @brief Wait for temperature conversion to complete (conversion_us())
      * @note Non-blocking - starts timer that will generate update event when complete
      */
-    void wait_conversion() { start_timer(62500, 11); }
+    void wait_conversion() { start_timer_us(conversion_us()); }
 
     /**
-     * @brief Start inter-measurement pause period (timer arr_value [us] * rcr_value)
+     * @brief Start inter-measurement pause: the rest of the sample period
      * @note Non-blocking - starts timer for inter-measurement delay
      */
-    void start_cycle_pause() { start_timer(62500, 3); }
+    void start_cycle_pause();
+
+    /** @brief Pause before retrying after an error (DS18B20_ERROR_PAUSE_MS) */
+    void start_error_pause() { start_timer_us(DS18B20_ERROR_PAUSE_MS * 1000); }
 
     void reset_bus();
 
-    void send_command(const uint8_t *cmd);
+    void send_command(const uint8_t *cmd, uint8_t bits);
+
+    void read_data(uint8_t bits);
+
+    /** @brief Store the result of sensor and pass it on */
+    void report(uint8_t sensor, int16_t temp);
+
+    /** @brief Report status for every known sensor (sensor 0 if the table is empty) */
+    void report_all(int16_t status);
+
+    void decode_and_report();
+
+    bool config_matches() const;
 
-    void read_data();
+    bool more_sensors() const { return m_index + 1 < m_count; }
+
+    /** @brief Sensor present, but the resolution is not written yet or was changed */
+    bool needs_config() const { return (!m_configured || m_requested != m_resolution) && check_presence(); }
 
     // Методы-действия для состояний FSM
     void action_idle();
@@ -104,9 +194,39 @@ class DS18B20 {
     void action_request_ok();
     void action_request_fail();
     void action_read();
+    void action_decode_next();
     void action_decode();
+    void action_configure();
+    void action_configure_done();
+
+#if defined DS18B20_POLL_CONVERSION
+    bool conversion_pending() const { return m_pollLeft != 0; }
+    bool conversion_done() const;
+
+    void action_poll_slot();
+    void action_poll_pause();
+#endif
 
-    static const Transition m_transitions[];
+#if !defined DS18B20_SKIP_ROM
+    bool needs_search() const { return m_count == 0; }
+    bool search_no_device() const;
+    bool search_more_bits() const { return m_searchBit + 1 < 64; }
+    bool search_more_roms() const { return m_lastDiscrepancy != 0 && m_count < DS18B20_MAX_SENSORS; }
+    bool search_empty() const { return m_count == 0; }
+    bool search_found() const { return m_count != 0; }
+    bool search_lost() const { return search_no_device() && m_count != 0; }
+
+    void action_search_begin();
+    void action_search_command();
+    void action_search_fail();
+    void action_search_read();
+    void action_search_write();
+    void action_search_restart();
+    void action_search_done();
+    void keep_control_first();
+#endif
+
+    static const Machine::Row m_transitions[];
 
 public:
     /**
@@ -133,4 +253,51 @@ public:
      * timer and DMA to handle timing-critical operations without software delays.
      */
     void poll();
+
+    /**
+     * @brief Report when poll() has work again (end of the running TIM1 operation)
+     */
+    void nextDeadline(WakeDeadline &d) const;
+
+    /**
+     * @brief No 1-Wire slot sequence is running (conversion wait or pause between cycles)
+     * @note Slot durations are DMA'd from flash: a flash write or erase may stall the core only now
+     */
+    bool busQuiet() const {
+        return m_ctx.current_state == FsmStates::CONTINUE || m_ctx.current_state == FsmStates::IDLE;
+    }
+
+    /**
+     * @brief Number of decoded scratchpads, including CRC failures (diagnostics)
+     */
+    uint32_t getSampleCount() const { return m_samples; }
+
+    /**
+     * @brief Sensors on the bus: found by the search (0 before it), 1 with DS18B20_SKIP_ROM
+     */
+    uint8_t getSensorCount() const { return m_count; }
+
+    /**
+     * @brief ROM code of sensor i (8 bytes, family code first) or nullptr (unknown / no such sensor)
+     */
+    const uint8_t *getRom(uint8_t i) const;
+
+    /**
+     * @brief Last result of sensor i: tenths of °C or ErrorStatus
+     */
+    int16_t getTemperature(uint8_t i) const;
+
+    /**
+     * @brief Resolution 9..12 bits (clamped), written to the sensors before the next conversion
+     */
+    void setResolution(uint8_t bits);
+
+    uint8_t getResolution() const { return m_requested; }
+
+    /**
+     * @brief Sample period (ms): the pause fills the cycle up to it; 0 — back-to-back cycles
+     */
+    void setSamplePeriod(uint32_t ms) { m_periodMs = ms; }
+
+    uint32_t getSamplePeriod() const { return m_periodMs; }
 };
\ No newline at end of file
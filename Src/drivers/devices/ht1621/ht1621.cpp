@@ -1,33 +1,16 @@
 #include "ht1621.hpp"
 #include <cstddef>
+#include <cstring>
 
-static inline void itoa_simple(int value, char *buf) {
-    char tmp[12];
-    int i = 0;
-    bool neg = false;
-
-    if (value < 0) {
-        neg = true;
-        value = -value;
-    }
-
-    do {
-        tmp[i++] = '0' + (value % 10);
-        value /= 10;
-    } while (value);
-
-    if (neg)
-        *buf++ = '-';
-
-    while (i--)
-        *buf++ = tmp[i];
-
-    *buf = '\0';
-}
+#include "CycleCounter.hpp"
+#include "IntFormat.hpp"
 
 HT1621B::HT1621B() : m_cs_pin(GPIOB, 5),
                      m_write_pin(GPIOB, 4),
                      m_data_pin(GPIOB, 3) {
+#if defined HT1621_SPI
+    Ht1621Spi::init();
+#else
     m_cs_pin.Init(GpioDriver::Mode::Output,
                   GpioDriver::OutType::PushPull,
                   GpioDriver::Pull::None,
@@ -40,6 +23,7 @@ HT1621B::HT1621B() : m_cs_pin(GPIOB, 5),
                     GpioDriver::OutType::PushPull,
                     GpioDriver::Pull::None,
                     GpioDriver::Speed::High);
+#endif
     Init();
 }
 
@@ -70,6 +54,10 @@ void HT1621B::WriteBit(uint8_t bit) {
 }
 
 void HT1621B::WriteCommand(Commands cmd) {
+#if defined HT1621_SPI
+    Ht1621Spi::command(cmd);
+    return;
+#endif
     uint8_t cmd_v = cmd;
     m_cs_pin.Set();  // Убедимся, что CS в HIGH
     __NOP();
@@ -130,49 +118,239 @@ void HT1621B::WriteData(uint8_t address, uint8_t data) {
     __NOP();
 }
 
+void HT1621B::WriteRun(uint8_t address, uint8_t count) {
+    m_cs_pin.Set();  // Убедимся, что CS в HIGH
+    __NOP();
+    __NOP();
+    m_cs_pin.Reset();
+    __NOP();
+    __NOP();
+
+    WriteBit(1);
+    WriteBit(0);
+    WriteBit(1);
+
+    uint8_t a = address << 2;
+    for (uint8_t i = 0; i < 6; i++) {
+        WriteBit((a & 0x80) ? 1 : 0);
+        a <<= 1;
+    }
+
+    // Адрес в контроллере увеличивается сам после каждого ниббла
+    for (uint8_t n = 0; n < count; ++n) {
+        uint8_t data = Visible(address + n);
+        m_front[address + n] = data;
+        for (uint8_t i = 0; i < 4; i++) {
+            WriteBit((data & 0x01) ? 1 : 0);
+            data >>= 1;
+        }
+    }
+
+    __NOP();
+    __NOP();
+    m_cs_pin.Set();
+    __NOP();
+    __NOP();
+}
+
+#if defined HT1621_SPI
+void HT1621B::QueueRun(uint8_t address, uint8_t count) {
+    // Слово SPI уходит старшим битом вперёд, ниббл — D0 первым
+    static constexpr uint8_t Reversed[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE,
+                                             0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+
+    Ht1621Spi::put(0b101, 3);
+    Ht1621Spi::put(address, 6);
+    for (uint8_t n = 0; n < count; ++n) {
+        const uint8_t data = Visible(address + n);
+        m_front[address + n] = data;
+        Ht1621Spi::put(Reversed[data & 0x0F], 4);
+    }
+    Ht1621Spi::endFrame();
+}
+#endif
+
 /**
  * @defgroup Функции для работы с VRAM
  */
 
+void HT1621B::StoreWord(uint8_t j, uint32_t value, uint32_t mask) {
+    // memcpy по выровненному адресу — одна загрузка и одна запись слова
+    uint32_t before;
+    std::memcpy(&before, m_back + j * 4, sizeof(before));
+    const uint32_t after = (before & ~mask) | (value & mask);
+    uint32_t changed = before ^ after;
+    if (!changed) return;
+    std::memcpy(m_back + j * 4, &after, sizeof(after));
+
+    // Бит 0 каждого байта — «байт изменился», затем четыре бита подряд — адреса 4j..4j+3
+    changed |= changed >> 4;
+    changed |= changed >> 2;
+    changed |= changed >> 1;
+    changed &= 0x01010101U;
+    m_dirty |= ((changed | changed >> 7 | changed >> 14 | changed >> 21) & 0xFU) << (j * 4);
+}
+
+void HT1621B::StoreGlyph(uint8_t position, uint32_t glyph, uint32_t byteMask) {
+    const uint8_t j = 5 - position;
+    StoreWord(j, glyph << 8, byteMask << 8);
+    StoreWord(j + 1, glyph >> 24, byteMask >> 24);
+}
+
 void HT1621B::SetData(uint8_t address, uint8_t data, WriteMode mode) {
-    if (address >= sizeof(m_vram)) return;
+    if (address >= sizeof(m_back)) return;
 
     switch (mode) {
         case WriteMode::Replace:
-            m_vram[address] = data;
+            Store(address, data);
             break;
         case WriteMode::SetBit:
-            m_vram[address] |= data;
+            Store(address, m_back[address] | data);
             break;
         case WriteMode::ClearBit:
-            m_vram[address] &= ~data;
+            Store(address, m_back[address] & ~data);
             break;
     }
 }
 
-void HT1621B::Flush() {
-    for (size_t i = 0; i < sizeof(m_vram); i++) {
-        WriteData(i, m_vram[i]);
+void HT1621B::Present() {
+    const uint32_t started = CycleCounter::now();
+    ++m_stats.presents;
+
+#if defined HT1621_FULL_FLUSH
+    for (uint8_t i = 0; i < sizeof(m_back); i++) {
+        m_front[i] = Visible(i);
+        WriteData(i, m_front[i]);
+    }
+    m_stats.frames += sizeof(m_back);
+    m_stats.bits += sizeof(m_back) * (9 + 4);
+#else
+    // Адреса, вернувшиеся к значению переднего буфера, передавать не нужно
+    for (uint8_t i = 0; i < sizeof(m_back); ++i) {
+        if (Visible(i) == m_front[i]) m_dirty &= ~(1UL << i);
+    }
+    if (!m_dirty) {
+        // Кадр совпал с тем, что уже на стекле: шина не нужна (и передачу SPI не ждём)
+        ++m_stats.idle;
+        return;
+    }
+
+    // До двух чистых адресов между изменёнными дешевле передать внутри посылки
+    // (4 бита на ниббл), чем начинать новую (CS, 101 и 6 бит адреса)
+    constexpr uint8_t RunGapMax = 2;
+
+#if defined HT1621_SPI
+    // 12 + 4 * count бит — целое число слов при count % 4 == 1; длиннее 29 нибблов
+    // такая посылка не помещается в адреса 0..31
+    constexpr uint8_t SpiRunMax = 29;
+
+    Ht1621Spi::begin();
+#endif
+
+    uint8_t address = 0;
+    while (address < sizeof(m_back)) {
+        if (!(m_dirty & (1UL << address))) {
+            ++address;
+            continue;
+        }
+        uint8_t end = address + 1;
+        for (uint8_t next = end; next < sizeof(m_back) && next <= end + RunGapMax; ++next) {
+            if (m_dirty & (1UL << next)) end = next + 1;
+        }
+#if defined HT1621_SPI
+        // Добавленные до целого слова нибблы повторяют RAM; у конца RAM посылка начинается раньше
+        uint8_t count = end - address;
+        if (count > SpiRunMax) count = SpiRunMax;
+        count += (1 - count) & 3;
+        const uint8_t first = address + count <= sizeof(m_back) ? address : sizeof(m_back) - count;
+        QueueRun(first, count);
+        address = first + count;
+        m_stats.bits += 12 + 4 * count;   // С дополнением до целого слова
+#else
+        WriteRun(address, end - address);
+        m_stats.bits += 9 + 4 * (end - address);
+        address = end;
+#endif
+        ++m_stats.frames;
+    }
+    m_dirty = 0;
+#if defined HT1621_SPI
+    Ht1621Spi::start();
+#endif
+#endif
+
+    const uint32_t cycles = CycleCounter::now() - started;
+    m_stats.cycles += cycles;
+    if (cycles > m_stats.maxCycles) m_stats.maxCycles = cycles;
+}
+
+void HT1621B::Invalidate() {
+    // Ни один адрес не совпадает с записанным в контроллер — уйдут все
+    for (uint8_t i = 0; i < sizeof(m_back); ++i) {
+        m_front[i] = ~Visible(i);
+    }
+    m_dirty = 0xFFFFFFFFUL;
+}
+
+void HT1621B::SetBlinkMask(uint8_t address, uint8_t mask) {
+    if (m_blink[address] == mask) return;
+    m_blink[address] = mask;
+    if (mask) m_blinkAddrs |= 1UL << address;
+    else m_blinkAddrs &= ~(1UL << address);
+    if (m_blinkHidden) m_dirty |= 1UL << address;
+}
+
+void HT1621B::BlinkPosition(uint8_t position, bool enable) {
+    if (position >= 6) return;
+
+    const uint8_t base = (5 - position) * 4;
+    for (uint8_t k = 1; k <= 4; ++k) {
+        const uint8_t address = base + k;
+        // У 0x17 сегмент разряда только в бите 0, бит 1 — спецсимвол "k"
+        const uint8_t segments = address == 0x17 ? 0x01 : 0x0F;
+        SetBlinkMask(address, enable ? m_blink[address] | segments : m_blink[address] & ~segments);
     }
 }
 
+void HT1621B::BlinkSpecial(uint8_t type, bool enable) {
+    if (type > 3) return;
+
+    const auto &special = m_specials[type];
+    SetBlinkMask(special.addr, enable ? m_blink[special.addr] | special.val : m_blink[special.addr] & ~special.val);
+}
+
+void HT1621B::BlinkChargeLevel(bool enable) {
+    for (const auto &seg: m_chargeLevels) {
+        SetBlinkMask(seg.addr, enable ? m_blink[seg.addr] | seg.val : m_blink[seg.addr] & ~seg.val);
+    }
+}
+
+void HT1621B::SetBlinkHidden(bool hidden) {
+    if (m_blinkHidden == hidden) return;
+    m_blinkHidden = hidden;
+    m_dirty |= m_blinkAddrs;
+}
+
 void HT1621B::FullClear(bool flushNow) {
-    for (size_t i = 0; i < sizeof(m_vram); ++i) {
-        m_vram[i] = 0;
+    for (uint8_t i = 0; i < sizeof(m_back); ++i) {
+        Store(i, 0);
     }
-    if (flushNow) Flush();
+    if (flushNow) Present();
+}
+
+void HT1621B::ShowImage(const SegImage &image, bool flushNow) {
+    // Адреса 1..24; у 0x17 сегмент разряда только в бите 0, остальное — спецсимвол "k"
+    static constexpr uint32_t Masks[SegWords] = {
+            0xFFFFFF00U, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xFFFFFFFFU, 0x01FFFFFFU, 0x000000FFU
+    };
+    for (uint8_t j = 0; j < SegWords; ++j) StoreWord(j, image.words[j], Masks[j]);
+
+    if (flushNow) Present();
 }
 
 void HT1621B::ClearSegArea(bool flushNow) {
     // Очистим только 6 x 4 байта сегментов
-    for (uint8_t i = 1; i <= 6 * 4; ++i) {
-        if (i == 0x17)
-            m_vram[i] &= ~0b01; // Чтобы не очищать десятичные разделители
-        else
-            m_vram[i] = 0;
-    }
-
-    if (flushNow) Flush();
+    ShowImage(SegImage{}, flushNow);
 }
 
 void HT1621B::Init() {
@@ -192,7 +370,8 @@ void HT1621B::Init() {
     WriteCommand(Commands::LcdOn);
     for (volatile int i = 0; i < 1000; i++) __NOP();
     
-    // Очищаем дисплей
+    // Очищаем дисплей: RAM контроллера после включения не определена, пишем её целиком
+    Invalidate();
     FullClear(true);
     for (volatile int i = 0; i < 1000; i++) __NOP();
 }
@@ -204,7 +383,7 @@ void HT1621B::ShowDot(uint8_t position, bool enable, bool flushNow) {
 
     SetData(dot.addr, dot.val, enable ? WriteMode::SetBit : WriteMode::ClearBit);
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowSpecial(uint8_t type, bool enable, bool flushNow) {
@@ -214,108 +393,59 @@ void HT1621B::ShowSpecial(uint8_t type, bool enable, bool flushNow) {
 
     SetData(special.addr, special.val, enable ? WriteMode::SetBit : WriteMode::ClearBit);
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowDigit(uint8_t position, uint8_t digit, bool withDot, bool flushNow) {
     if (position >= 6 || digit > 9) return;
 
-    const uint8_t base = (5 - position) * 4;
-
-    // Отрисовка цифры - используем Replace режим для корректной перезаписи
-    for (const auto &seg: m_digits[digit]) {
-        if (seg.addr == 0) break;
-        SetData(seg.addr + base, seg.val, WriteMode::Replace);
-    }
+    // Отрисовка цифры: все четыре адреса разряда заменяются
+    StoreGlyph(position, Ht1621Glyphs::of(static_cast<char>('0' + digit)), 0xFFFFFFFFU);
 
     // Добавляем точку, если нужно
     if (withDot && position > 0) {
         ShowDot(position, true);
     }
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowFull(bool flushNow) {
-    for (size_t i = 0; i < sizeof(m_vram); ++i) {
-        m_vram[i] = 0xFF;
+    for (uint8_t i = 0; i < sizeof(m_back); ++i) {
+        Store(i, 0xFF);
     }
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowLetter(uint8_t position, char c, bool flushNow) {
     if (position >= 6) return;
 
-    const uint8_t base = (5 - position) * 4;
-    const Segment *segs = nullptr;
-
-    switch (c) {
-        case 'A': segs = m_letters[0]; break;
-        case 'b': segs = m_letters[1]; break;
-        case 'C': segs = m_letters[2]; break;
-        case 'd': segs = m_letters[3]; break;
-        case 'E': segs = m_letters[4]; break;
-        case 'F': segs = m_letters[5]; break;
-        case 'G': segs = m_letters[6]; break;
-        case 'h': segs = m_letters[7]; break;
-        case 'I': segs = m_letters[8]; break;
-        case 'J': segs = m_letters[9]; break;
-        case 'L': segs = m_letters[10]; break;
-        case 'n': segs = m_letters[11]; break;
-        case 'o': segs = m_letters[12]; break;
-        case 'P': segs = m_letters[13]; break;
-        case 'r': segs = m_letters[14]; break;
-        case 't': segs = m_letters[15]; break;
-        case 'U': segs = m_letters[16]; break;
-        case 'X': segs = m_letters[17]; break;
-        case '-': segs = m_letters[18]; break;
-        case '_': segs = m_letters[19]; break;
-        default: return;
-    }
+    const uint32_t glyph = Ht1621Glyphs::of(c);
+    if (!glyph) return;
 
-    // Отрисовка всех непустых сегментов
-    for (uint8_t i = 0; i < 4; ++i) {
-        if (segs[i].val)
-            SetData(segs[i].addr + base, segs[i].val);
+    // Отрисовка всех непустых сегментов: байты глифа, отличные от нуля
+    uint32_t byteMask = 0;
+    for (uint8_t k = 0; k < 4; ++k) {
+        if (glyph & (0xFFU << (k * 8))) byteMask |= 0xFFU << (k * 8);
     }
+    StoreGlyph(position, glyph, byteMask);
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowString(const char *str, bool flushNow) {
     if (!str) return;
 
-    // Очищаем только сегменты цифр/символов, оставляем иконки нетронутыми
-    ClearSegArea(false);
-
-    // Вычисляем длину строки (не более 6 символов)
-    uint8_t len = 0;
-    while (str[len] && len < 6) len++;
-
-    // Позиции на индикаторе идут справа налево:
-    // pos = 0 (правый символ), pos = len - 1 (левый)
-    for (uint8_t i = 0; i < len; ++i) {
-        char c = str[len - 1 - i];  // Выводим в обратном порядке
-        if (c >= '0' && c <= '9') {
-            ShowDigit(i, c - '0', false, false);
-        } else {
-            ShowLetter(i, c, false);
-        }
-    }
-
-    if (flushNow) Flush();
+    // Сегменты цифр/символов заменяются целиком, иконки остаются нетронутыми
+    ShowImage(Render(str), flushNow);
 }
 
 void HT1621B::ShowInt(int value, bool flushNow) {
-    char buf[8];
-    itoa_simple(value, buf);
+    char buf[IntFormat::IntBufSize];
+    const uint8_t len = IntFormat::formatInt(value, buf);
 
     bool negative = (value < 0);
     uint8_t start = negative ? 1 : 0; // Пропустить '-' при выводе цифр
-
-    // Вычисляем длину (без знака)
-    uint8_t len = 0;
-    while (buf[len]) len++;
     uint8_t l_digits = len - start;
 
     // Проверяем, влезет ли в 6 позиций
@@ -324,7 +454,7 @@ void HT1621B::ShowInt(int value, bool flushNow) {
         // Покажем "------" как индикатор переполнения
         for (uint8_t i = 0; i < 6; ++i)
             SetData(i * 4 + 2, 1); // Короткий сегмент по центру
-        if (flushNow) Flush();
+        if (flushNow) Present();
         return;
     }
 
@@ -341,7 +471,7 @@ void HT1621B::ShowInt(int value, bool flushNow) {
         SetData(base + 2, 1); // Маленький горизонтальный сегмент
     }
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowChargeLevel(uint8_t level, bool flushNow) {
@@ -355,7 +485,7 @@ void HT1621B::ShowChargeLevel(uint8_t level, bool flushNow) {
         SetData(seg.addr, seg.val, (i <= level) ? WriteMode::SetBit : WriteMode::ClearBit);
     }
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
 
 void HT1621B::ShowDate(uint8_t day, uint8_t month, uint8_t year, bool flushNow) {
@@ -389,5 +519,5 @@ void HT1621B::ShowDate(uint8_t day, uint8_t month, uint8_t year, bool flushNow)
         ShowDigit(pos, digits[pos], dot, false);
     }
 
-    if (flushNow) Flush();
+    if (flushNow) Present();
 }
\ No newline at end of file
@@ -1,9 +1,78 @@
 #pragma once
 
 #include "stm32f0xx.h"
+#include "config.h"
 #include "GpioDriver.hpp"
+#include "ht1621_glyphs.hpp"
+#if defined HT1621_SPI
+#include "ht1621_spi.hpp"
+#endif
+
+#if defined HT1621_SPI && defined HT1621_FULL_FLUSH
+#error "HT1621_FULL_FLUSH: прежний вывод только программный, без HT1621_SPI"
+#endif
 
 class HT1621B {
+public:
+    /// Слов RAM, покрывающих сегментную область (адреса 1..24)
+    static constexpr uint8_t SegWords = 7;
+
+    /**
+     * @brief Образ сегментной области RAM словами: слово j — адреса 4j..4j+3
+     *        (младший байт — младший адрес, как в памяти Cortex-M0)
+     *
+     * Собирается целиком до вывода, в том числе при компиляции (Render() постоянных
+     * надписей), и выводится ShowImage() несколькими записями слов.
+     */
+    struct SegImage {
+        uint32_t words[SegWords] = {};
+
+        /**
+         * @brief Символ в позиции [5..0] (0 - правый разряд); гасит разделитель этой позиции
+         */
+        constexpr SegImage &Put(uint8_t position, char c) {
+            if (position >= 6) return *this;
+            const uint32_t glyph = Ht1621Glyphs::of(c);
+            const uint8_t j = 5 - position;   // Разряд — байты 1..3 слова j и байт 0 слова j + 1
+            words[j] = (words[j] & 0x000000FFU) | (glyph << 8);
+            words[j + 1] = (words[j + 1] & 0xFFFFFF00U) | (glyph >> 24);
+            return *this;
+        }
+
+        /**
+         * @brief Десятичный разделитель в позиции [5..1] (после Put() той же позиции)
+         */
+        constexpr SegImage &Dot(uint8_t position) {
+            if (position == 0 || position >= 6) return *this;
+            words[5 - position] |= 0x02U << 24;   // Адрес base+3, как m_dots
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Образ строки (не более 6 символов, выравнивание вправо, как ShowString())
+     */
+    static constexpr SegImage Render(const char *str) {
+        SegImage image;
+        uint8_t len = 0;
+        while (str[len] && len < 6) len++;
+        for (uint8_t i = 0; i < len; ++i) image.Put(i, str[len - 1 - i]);
+        return image;
+    }
+
+    /**
+     * @brief Статистика вывода кадров
+     */
+    struct PresentStats {
+        uint32_t presents = 0;    ///< Вызовов Present()
+        uint32_t idle = 0;        ///< Из них кадр не изменился: на шину ничего не ушло
+        uint32_t frames = 0;      ///< Посылок контроллеру
+        uint32_t bits = 0;        ///< Бит на линии, с заголовками посылок
+        uint32_t cycles = 0;      ///< Тактов ядра в Present() (CycleCounter), сумма
+        uint32_t maxCycles = 0;   ///< Самый долгий Present()
+    };
+
+private:
     struct Segment {
         uint8_t addr;
         uint8_t val;
@@ -15,49 +84,6 @@ class HT1621B {
         ClearBit
     };
 
-    /**
-     * @brief Массив для формирования цифр
-     */
-    static constexpr Segment m_digits[10][4] = {
-            /* 0 */ {{1, 3}, {2, 2}, {3, 1}, {4, 3}},
-            /* 1 */ {{1, 0}, {2, 0}, {3, 1}, {4, 2}},
-            /* 2 */ {{1, 2}, {2, 3}, {3, 0}, {4, 3}},
-            /* 3 */ {{1, 0}, {2, 3}, {3, 1}, {4, 3}},
-            /* 4 */ {{1, 1}, {2, 1}, {3, 1}, {4, 2}},
-            /* 5 */ {{1, 1}, {2, 3}, {3, 1}, {4, 1}},
-            /* 6 */ {{1, 3}, {2, 3}, {3, 1}, {4, 1}},
-            /* 7 */ {{1, 0}, {2, 0}, {3, 1}, {4, 3}},
-            /* 8 */ {{1, 3}, {2, 3}, {3, 1}, {4, 3}},
-            /* 9 */ {{1, 1}, {2, 3}, {3, 1}, {4, 3}}
-    };
-
-    /**
-     * @brief Набор латинских букв для 7-сегментного индикатора
-     */
-    static constexpr Segment m_letters[][4] = {
-            /* A */ {{1,3}, {2,1}, {3,1}, {4,3}},
-            /* b */ {{1,3}, {2,3}, {3,1}, {4,0}},
-            /* C */ {{1,3}, {2,2}, {3,0}, {4,1}},
-            /* d */ {{1,2}, {2,3}, {3,1}, {4,2}},
-            /* E */ {{1,3}, {2,3}, {3,0}, {4,1}},
-            /* F */ {{1,3}, {2,1}, {3,0}, {4,1}},
-            /* G */ {{1,3}, {2,2}, {3,1}, {4,1}},
-            /* h */ {{1,3}, {2,1}, {3,1}, {4,0}},
-            /* I */ {{1,3}, {2,0}, {3,0}, {4,0}},
-            /* J */ {{1,0}, {2,2}, {3,1}, {4,2}},
-            /* L */ {{1,3}, {2,2}, {3,0}, {4,0}},
-            /* n */ {{1,2}, {2,1}, {3,1}, {4,0}},
-            /* o */ {{1,2}, {2,3}, {3,1}, {4,0}},
-            /* P */ {{1,3}, {2,1}, {3,0}, {4,3}},
-            /* r */ {{1,2}, {2,1}, {3,0}, {4,0}},
-            /* t */ {{1,3}, {2,3}, {3,0}, {4,0}},
-            /* U */ {{1,3}, {2,2}, {3,1}, {4,2}},
-            /* X */ {{1,3}, {2,1}, {3,1}, {4,2}},
-            /* - */ {{1,0}, {2,1}, {3,0}, {4,0}},
-            /* _ */ {{1,0}, {2,2}, {3,0}, {4,0}},
-            /* Space {{1,0}, {2,0}, {3,0}, {4,0}}, */
-    };
-
     /**
      * @brief Массив для формирования десятичных разделителей
      */
@@ -102,9 +128,16 @@ class HT1621B {
         Bias13 = 0x29, // 4 commons option
     };
 
-    uint8_t m_vram[32] = {0}; ///< RAM-память для контроллера HT1621B
+    alignas(4) uint8_t m_back[32] = {0}; ///< Задний буфер: кадр, который собирают Show*() (пословно — StoreWord)
+    uint8_t m_front[32] = {0}; ///< Передний буфер: что уже записано в RAM контроллера
+    uint32_t m_dirty = 0;     ///< Бит на адрес m_back, изменённый после Present()
+    PresentStats m_stats;
 
-    GpioDriver m_cs_pin, m_write_pin, m_data_pin;
+    uint8_t m_blink[32] = {0};   ///< Мигающие сегменты: биты ниббла, гаснущие в фазе «скрыто»
+    uint32_t m_blinkAddrs = 0;   ///< Бит на адрес с ненулевой маской m_blink
+    bool m_blinkHidden = false;  ///< Фаза мигания: мигающие сегменты погашены
+
+    GpioDriver m_cs_pin, m_write_pin, m_data_pin; ///< Программный вывод (без HT1621_SPI)
 
     /**
      * @brief Запись бита данных или команды в контроллер HT1621B
@@ -125,6 +158,53 @@ class HT1621B {
      */
     void WriteData(uint8_t address, uint8_t data);
 
+    /**
+     * @brief Отправляет подряд идущие адреса одной посылкой (successive address write)
+     * @param address Первый адрес
+     * @param count Количество нибблов из m_back начиная с address
+     */
+    void WriteRun(uint8_t address, uint8_t count);
+
+#if defined HT1621_SPI
+    /**
+     * @brief Кладёт посылку successive address write в буфер Ht1621Spi
+     * @param address Первый адрес
+     * @param count Количество нибблов, count % 4 == 1: посылка ровно в целое число слов
+     */
+    void QueueRun(uint8_t address, uint8_t count);
+#endif
+
+    /**
+     * @brief Записывает значение в m_back и отмечает адрес, если значение изменилось
+     */
+    void Store(uint8_t address, uint8_t data) {
+        if (m_back[address] == data) return;
+        m_back[address] = data;
+        m_dirty |= 1UL << address;
+    }
+
+    /**
+     * @brief Записывает в слово j RAM биты value под маской и отмечает изменившиеся адреса
+     */
+    void StoreWord(uint8_t j, uint32_t value, uint32_t mask);
+
+    /**
+     * @brief Глиф в разряде position; заменяются только байты под byteMask (слово глифа)
+     */
+    void StoreGlyph(uint8_t position, uint32_t glyph, uint32_t byteMask);
+
+    /**
+     * @brief Значение адреса на стекле: задний буфер с погашенными в фазе «скрыто» сегментами
+     */
+    uint8_t Visible(uint8_t address) const {
+        return m_blinkHidden ? m_back[address] & ~m_blink[address] : m_back[address];
+    }
+
+    /**
+     * @brief Заменяет маску мигания адреса; в фазе «скрыто» адрес уйдёт со следующим Present()
+     */
+    void SetBlinkMask(uint8_t address, uint8_t mask);
+
     /**
      * @brief Функция, записывающая данные от высокоуровневых функций в RAM
      * @param address
@@ -137,9 +217,51 @@ public:
     HT1621B();
 
     /**
-     * Немедленно выводит содержимое RAM на дисплей (используя функцию WriteData)
+     * @brief Выводит кадр: разница заднего буфера с передним, подряд идущие адреса — одной
+     *        посылкой; после вызова передний буфер равен заднему
+     *
+     * Show*() меняют только задний буфер, так что кадр собирается целиком и уходит
+     * одним Present() — на стекле не бывает половины перерисовки. Кадр без изменений
+     * не занимает шину. С HT1621_SPI только запускает передачу и возвращается сразу
+     * (предыдущую — дожидается).
+     */
+    void Present();
+
+    /// Счётчики Present() — единственное место, где HT1621B занимает шину
+    const PresentStats &GetStats() const { return m_stats; }
+
+    /**
+     * @brief Следующий Present() перепишет всю RAM контроллера (например, после его сброса)
      */
-    void Flush();
+    void Invalidate();
+
+    /**
+     * @brief Мигание разряда вместе с его разделителем (сегмент "k" не затрагивается)
+     * @param position Позиция [5..0] (0 - правый разряд, 5 - левый)
+     * @param enable Включить или выключить мигание
+     *
+     * Маски мигания — слой поверх заднего буфера: Show*() рисуют как обычно,
+     * а Present() в фазе «скрыто» (SetBlinkHidden()) гасит отмеченные сегменты.
+     */
+    void BlinkPosition(uint8_t position, bool enable);
+
+    /**
+     * @brief Мигание спецсимвола, индекс как в ShowSpecial()
+     */
+    void BlinkSpecial(uint8_t type, bool enable);
+
+    /**
+     * @brief Мигание всех четырёх сегментов уровня заряда (горящие ShowChargeLevel() мигают)
+     */
+    void BlinkChargeLevel(bool enable);
+
+    /**
+     * @brief Фаза мигания; меняет только адреса с масками, на шину они уйдут с Present()
+     */
+    void SetBlinkHidden(bool hidden);
+
+    /// Есть хотя бы один мигающий сегмент
+    bool Blinking() const { return m_blinkAddrs != 0; }
 
     /**
      * @brief Полностью очищает RAM
@@ -147,6 +269,13 @@ public:
      */
     void FullClear(bool flushNow = false);
 
+    /**
+     * @brief Выводит образ сегментной области: адреса 1..24 заменяются целиком,
+     *        кроме сегмента "k" (адрес 0x17, бит 1)
+     * @param flushNow Немедленно выводит результат операции на дисплей
+     */
+    void ShowImage(const SegImage &image, bool flushNow = false);
+
     /**
      * @brief Очищает область RAM, соответствующую только сегментным индикаторам
      * @param flushNow Немедленно выводит результат операции на дисплей
@@ -187,14 +316,14 @@ public:
     /**
      * @brief Вывод предопределенного символа на заданной позиции дисплея
      * @param position Позиция символа [5..0] (0 - правый разряд, 5 - левый)
-     * @param c Символ из набора m_letters
+     * @param c Символ из Ht1621Glyphs (гасятся только сегменты, которых нет в глифе)
      * @param flushNow Немедленно выводит результат операции на дисплей
      */
     void ShowLetter(uint8_t position, char c, bool flushNow = false);
 
     /**
-     * @brief Выводит строку из m_digits и m_letters (не более 6 символов) на дисплей
-     * @param str Строка, содержащая m_digits, m_letters или пробел
+     * @brief Выводит строку (не более 6 символов) на дисплей: Render() + ShowImage()
+     * @param str Строка из цифр, букв Ht1621Glyphs::LetterChars и пробелов
      * @param flushNow Немедленно выводит результат операции на дисплей
      */
     void ShowString(const char *str, bool flushNow = false);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file ht1621_glyphs.hpp
+ * @brief Знакогенератор HT1621B: ASCII -> сегменты разряда одной таблицей
+ *
+ * Разряд индикатора занимает четыре адреса RAM подряд: base+1..base+4,
+ * base = (5 - позиция) * 4. Глиф — значения этих адресов, упакованные в байты
+ * слова (младший байт — адрес base+1), так что разряд выводится сдвигом и маской,
+ * без перебора сегментов. Таблица на 128 символов строится при компиляции
+ * из Digits и Letters; символ без глифа (в том числе пробел) — 0.
+ */
+namespace Ht1621Glyphs {
+    struct Segment {
+        uint8_t addr;   ///< Смещение 1..4 от base разряда
+        uint8_t val;
+    };
+
+    /**
+     * @brief Сегменты цифр 0..9
+     */
+    inline constexpr Segment Digits[10][4] = {
+            /* 0 */ {{1, 3}, {2, 2}, {3, 1}, {4, 3}},
+            /* 1 */ {{1, 0}, {2, 0}, {3, 1}, {4, 2}},
+            /* 2 */ {{1, 2}, {2, 3}, {3, 0}, {4, 3}},
+            /* 3 */ {{1, 0}, {2, 3}, {3, 1}, {4, 3}},
+            /* 4 */ {{1, 1}, {2, 1}, {3, 1}, {4, 2}},
+            /* 5 */ {{1, 1}, {2, 3}, {3, 1}, {4, 1}},
+            /* 6 */ {{1, 3}, {2, 3}, {3, 1}, {4, 1}},
+            /* 7 */ {{1, 0}, {2, 0}, {3, 1}, {4, 3}},
+            /* 8 */ {{1, 3}, {2, 3}, {3, 1}, {4, 3}},
+            /* 9 */ {{1, 1}, {2, 3}, {3, 1}, {4, 3}}
+    };
+
+    /**
+     * @brief Латинские буквы и знаки для 7-сегментного индикатора, по порядку LetterChars
+     */
+    inline constexpr char LetterChars[] = "AbCdEFGhIJLnoPrtUX-_";
+
+    inline constexpr Segment Letters[][4] = {
+            /* A */ {{1,3}, {2,1}, {3,1}, {4,3}},
+            /* b */ {{1,3}, {2,3}, {3,1}, {4,0}},
+            /* C */ {{1,3}, {2,2}, {3,0}, {4,1}},
+            /* d */ {{1,2}, {2,3}, {3,1}, {4,2}},
+            /* E */ {{1,3}, {2,3}, {3,0}, {4,1}},
+            /* F */ {{1,3}, {2,1}, {3,0}, {4,1}},
+            /* G */ {{1,3}, {2,2}, {3,1}, {4,1}},
+            /* h */ {{1,3}, {2,1}, {3,1}, {4,0}},
+            /* I */ {{1,3}, {2,0}, {3,0}, {4,0}},
+            /* J */ {{1,0}, {2,2}, {3,1}, {4,2}},
+            /* L */ {{1,3}, {2,2}, {3,0}, {4,0}},
+            /* n */ {{1,2}, {2,1}, {3,1}, {4,0}},
+            /* o */ {{1,2}, {2,3}, {3,1}, {4,0}},
+            /* P */ {{1,3}, {2,1}, {3,0}, {4,3}},
+            /* r */ {{1,2}, {2,1}, {3,0}, {4,0}},
+            /* t */ {{1,3}, {2,3}, {3,0}, {4,0}},
+            /* U */ {{1,3}, {2,2}, {3,1}, {4,2}},
+            /* X */ {{1,3}, {2,1}, {3,1}, {4,2}},
+            /* - */ {{1,0}, {2,1}, {3,0}, {4,0}},
+            /* _ */ {{1,0}, {2,2}, {3,0}, {4,0}},
+    };
+
+    static_assert(sizeof(Letters) / sizeof(Letters[0]) == sizeof(LetterChars) - 1,
+                  "Ht1621Glyphs: на каждую букву LetterChars — строка Letters");
+
+    constexpr uint32_t pack(const Segment (&segs)[4]) {
+        uint32_t glyph = 0;
+        for (const auto &seg: segs) glyph |= static_cast<uint32_t>(seg.val) << ((seg.addr - 1) * 8);
+        return glyph;
+    }
+
+    struct Table {
+        uint32_t glyph[128];
+    };
+
+    consteval Table build() {
+        Table t{};
+        for (uint8_t d = 0; d < 10; ++d) t.glyph['0' + d] = pack(Digits[d]);
+        for (size_t i = 0; i + 1 < sizeof(LetterChars); ++i) {
+            t.glyph[static_cast<uint8_t>(LetterChars[i])] = pack(Letters[i]);
+        }
+        return t;
+    }
+
+    inline constexpr Table table = build();
+
+    /**
+     * @brief Глиф символа: байт k — значение адреса base+1+k разряда
+     */
+    constexpr uint32_t of(char c) {
+        const auto code = static_cast<uint8_t>(c);
+        return code < 128 ? table.glyph[code] : 0;
+    }
+}
@@ -0,0 +1,152 @@
+#include "ht1621_spi.hpp"
+
+#if defined HT1621_SPI
+
+#include "GpioDriver.hpp"
+
+uint16_t Ht1621Spi::m_words[WordsMax]{};
+uint8_t Ht1621Spi::m_ends[FramesMax]{};
+uint8_t Ht1621Spi::m_count = 0;
+uint8_t Ht1621Spi::m_frames = 0;
+uint16_t Ht1621Spi::m_acc = 0;
+uint8_t Ht1621Spi::m_accBits = 0;
+uint8_t Ht1621Spi::m_tx = 0;
+uint8_t Ht1621Spi::m_rx = 0;
+uint8_t Ht1621Spi::m_frame = 0;
+volatile bool Ht1621Spi::m_busy = false;
+
+/// CS контроллера (WR и DATA заняты SCK и MOSI)
+static constexpr uint8_t CsPin = 4;
+
+void Ht1621Spi::init() {
+    GpioDriver cs(GPIOB, CsPin);
+    GpioDriver sck(GPIOB, 3);
+    GpioDriver mosi(GPIOB, 5);
+
+    cs.Set();
+    cs.Init(GpioDriver::Mode::Output,
+            GpioDriver::OutType::PushPull,
+            GpioDriver::Pull::None,
+            GpioDriver::Speed::High);
+
+    sck.Init(GpioDriver::Mode::Alternate, GpioDriver::OutType::PushPull,
+             GpioDriver::Pull::None, GpioDriver::Speed::High);
+    sck.SetAlternateFunction(0);
+
+    mosi.Init(GpioDriver::Mode::Alternate, GpioDriver::OutType::PushPull,
+              GpioDriver::Pull::None, GpioDriver::Speed::High);
+    mosi.SetAlternateFunction(0);
+
+    RCC->APB2ENR |= RCC_APB2ENR_SPI1EN;
+    SPI1->CR1 &= ~SPI_CR1_SPE; // Disable SPI before config
+
+    // Ведущий, NSS программный; SCK в покое высокий, данные защёлкиваются по фронту
+    SPI1->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_CPOL | SPI_CR1_CPHA |
+                (static_cast<uint32_t>(HT1621_SPI_BR) << SPI_CR1_BR_Pos);
+    SPI1->CR2 = 15U << SPI_CR2_DS_Pos;   // 16 бит, RXNE на каждое слово
+
+    SPI1->CR1 |= SPI_CR1_SPE;
+
+    NVIC_EnableIRQ(SPI1_IRQn);
+}
+
+void Ht1621Spi::select() {
+    GpioDriver(GPIOB, CsPin).Reset();
+}
+
+void Ht1621Spi::deselect() {
+    GpioDriver(GPIOB, CsPin).Set();
+}
+
+void Ht1621Spi::command(uint8_t cmd) {
+    wait();
+
+    // 100, 8 бит команды, 0; последние 4 бита слова контроллер пропускает
+    select();
+    SPI1->DR = (0b100U << 13) | (static_cast<uint32_t>(cmd) << 5);
+    while (!(SPI1->SR & SPI_SR_RXNE)) {}
+    (void) static_cast<uint32_t>(SPI1->DR);
+    deselect();
+}
+
+void Ht1621Spi::begin() {
+    wait();
+    m_count = 0;
+    m_frames = 0;
+    m_acc = 0;
+    m_accBits = 0;
+}
+
+void Ht1621Spi::put(uint16_t value, uint8_t n) {
+    while (n) {
+        const uint8_t room = 16 - m_accBits;
+        const uint8_t take = n < room ? n : room;
+        n -= take;
+        m_acc = static_cast<uint16_t>((static_cast<uint32_t>(m_acc) << take) | ((value >> n) & ((1U << take) - 1)));
+        m_accBits += take;
+        if (m_accBits == 16) {
+            if (m_count < WordsMax) m_words[m_count++] = m_acc;
+            m_acc = 0;
+            m_accBits = 0;
+        }
+    }
+}
+
+void Ht1621Spi::endFrame() {
+    if (m_accBits) put(0, 16 - m_accBits);
+    if (m_frames < FramesMax && (m_frames == 0 || m_ends[m_frames - 1] < m_count)) {
+        m_ends[m_frames++] = m_count;
+    }
+}
+
+void Ht1621Spi::start() {
+    if (!m_frames) return;
+
+    m_tx = 0;
+    m_rx = 0;
+    m_frame = 0;
+    m_busy = true;
+
+    // Остальное — в обработчике: первое слово пишет он же
+    select();
+    SPI1->CR2 |= SPI_CR2_RXNEIE;
+    NVIC_SetPendingIRQ(SPI1_IRQn);
+}
+
+void Ht1621Spi::wait() {
+    while (m_busy) {
+        // В hardware_init() прерывания запрещены: ведём передачу сами
+        if (__get_PRIMASK()) irq();
+        else __WFI();
+    }
+}
+
+void Ht1621Spi::irq() {
+    while (SPI1->SR & SPI_SR_RXNE) {
+        (void) static_cast<uint32_t>(SPI1->DR);
+        ++m_rx;
+    }
+    if (!m_busy) return;
+
+    if (m_rx == m_ends[m_frame]) {
+        deselect();
+        if (++m_frame == m_frames) {
+            SPI1->CR2 &= ~SPI_CR2_RXNEIE;
+            m_busy = false;
+            return;
+        }
+        select();
+    }
+
+    while (m_tx < m_ends[m_frame] && static_cast<uint8_t>(m_tx - m_rx) < InFlight) {
+        SPI1->DR = m_words[m_tx++];
+    }
+}
+
+// IRQ entry
+
+extern "C" void SPI1_IRQHandler() {
+    Ht1621Spi::irq();
+}
+
+#endif
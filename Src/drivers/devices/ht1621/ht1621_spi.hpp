@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stm32f0xx.h"
+#include "config.h"
+
+/**
+ * @brief Передача посылок HT1621B через SPI1 (режим HT1621_SPI): WR = SCK, DATA = MOSI, CS — GPIO
+ *
+ * Посылка — слова по 16 бит, старший бит первым (CPOL = 1, CPHA = 1: WR в покое высокий,
+ * контроллер защёлкивает DATA по фронту). Длина посылки кратна 16 битам: HT1621B
+ * отбрасывает неполный ниббл в конце записи и лишние биты после 9 бит команды.
+ *
+ * Основной цикл складывает посылки в буфер (begin(), put(), endFrame()) и запускает
+ * передачу start(); дальше всё делает SPI1_IRQHandler по RXNE: принятое слово значит,
+ * что переданное вышло целиком. В FIFO передачи не больше двух слов, CS поднимается
+ * после последнего слова посылки и тут же опускается для следующей.
+ *
+ * DMA1 не используется: запрос SPI1_TX есть только на Ch3, а он занят захватом DS18B20.
+ */
+class Ht1621Spi {
+public:
+    /// Слов на все посылки одного Present() (32 ниббла с адресами — не больше 16)
+    static constexpr uint8_t WordsMax = 20;
+    static constexpr uint8_t FramesMax = 8;
+
+    /**
+     * @brief PB3/PB5 на SPI1 (AF0), PB4 — CS, SPI1 ведущий на передачу
+     */
+    static void init();
+
+    /**
+     * @brief Команда (100 + 8 бит + 0) с ожиданием конца передачи
+     */
+    static void command(uint8_t cmd);
+
+    /**
+     * @brief Дождаться конца предыдущей передачи и очистить буфер
+     */
+    static void begin();
+
+    /**
+     * @brief Добавить к текущей посылке n младших бит value (n <= 16), старший из них первым
+     */
+    static void put(uint16_t value, uint8_t n);
+
+    /**
+     * @brief Закрыть посылку: последнее слово дополняется нулями
+     */
+    static void endFrame();
+
+    /**
+     * @brief Запустить передачу собранных посылок (возврат сразу)
+     */
+    static void start();
+
+    /**
+     * @brief Дождаться конца передачи; при запрещённых прерываниях ведёт её опросом
+     */
+    static void wait();
+
+    static void irq();
+
+    /// Идёт передача
+    static bool busy() { return m_busy; }
+
+private:
+    /// Слов в FIFO передачи и сдвиговом регистре
+    static constexpr uint8_t InFlight = 2;
+
+    static void select();
+    static void deselect();
+
+    static uint16_t m_words[WordsMax];
+    static uint8_t m_ends[FramesMax];   ///< Индекс слова за концом посылки
+    static uint8_t m_count;             ///< Слов в буфере
+    static uint8_t m_frames;            ///< Посылок в буфере
+    static uint16_t m_acc;              ///< Незаконченное слово
+    static uint8_t m_accBits;
+
+    // Меняет только обработчик прерывания (после start())
+    static uint8_t m_tx;                ///< Следующее слово в DR
+    static uint8_t m_rx;                ///< Слов передано целиком
+    static uint8_t m_frame;             ///< Текущая посылка
+    static volatile bool m_busy;
+};
@@ -21,8 +21,7 @@ void hardware_init(App& app) {
 
     // TIM17
     static TimDriver tim17(TIM17);
-    tim17.Init(TIM17_PRESCALER, TIM17_ARR);
-    tim17.Start();
+    tim17.Init(TIM17_PRESCALER, TIM17_ARR);   // Tick100ms теперь даёт TimerWheel, TIM17 свободен
     app.tim17 = &tim17;
 
     // GPIO
@@ -91,14 +90,22 @@ void hardware_init(App& app) {
     piezo.Init(PIEZO_PRESCALER, PIEZO_ARR);
     app.piezo = &piezo;
 
+    // EventQueue (critical for app_loop - must be initialized here)
+    static EventQueue queue;
+    app.queue = &queue;
+
+    // TimerWheel (ведётся от g_msTicks, нужен кнопкам для событий удержания)
+    static TimerWheel timers(queue);
+    app.timers = &timers;
+
     // Buttons
-    static ButtonsManager btns(GPIOA, 1,
+    static ButtonsManager btns(timers,
+                               GPIOA, 1,
                                GPIOA, 2,
                                GPIOA, 3,
                                GPIOA, 4);
     app.buttons = &btns;
-
-    // EventQueue (critical for app_loop - must be initialized here)
-    static EventQueue queue;
-    app.queue = &queue;
+#if defined APP_TICKLESS
+    btns.enableWakeup();
+#endif
 }
@@ -12,5 +12,6 @@ struct App;
  *   - дисплей HT1621B
  *   - DS18B20
  *   - кнопки
+ *   - EventQueue и TimerWheel (нужны кнопкам)
  */
 void hardware_init(App &app);
\ No newline at end of file
@@ -18,5 +18,6 @@ int main() {
 
     while (true) {
         app_loop(app);
+        app_idle(app);   // WFI до ближайшего дедлайна (только при APP_TICKLESS)
     }
 }
\ No newline at end of file
@@ -4,36 +4,35 @@
 #include "config.h"
 #include "TimDriver.hpp"
 #include "RccDriver.hpp"
+#include "TimerWheel.hpp"
 
 using namespace RccDriver;
 
 class BeepManager {
 public:
-    explicit BeepManager(PwmDriver *driver)
-            : m_driver(driver) {}
+    BeepManager(PwmDriver *driver, TimerWheel &timers)
+            : m_driver(driver),
+              m_timers(timers),
+              m_timer(timers.create({EventType::BeepDone, 0})) {}
 
     void requestBeep(uint16_t freq = BEEP_FREQUENCY_HZ, uint16_t duration = BEEP_DURATION_MS) {
         m_freq = freq;
-        m_active = true;
 
         // включаем звук
         m_driver->setPower(BEEP_POWER_PERCENT);   // duty
         m_driver->setFrequency(freq);
 
-        m_endTime = GetMsTicks() + duration;
+        // выключит stop() по событию BeepDone
+        m_timers.arm(m_timer, duration);
     }
 
-    void poll() {
-        if (!m_active) return;
-        if (GetMsTicks() < m_endTime) return;
-
+    void stop() {
         m_driver->setPower(0);   // выключаем
-        m_active = false;
     }
 
 private:
     PwmDriver *m_driver;
-    uint32_t m_endTime = 0;
-    bool m_active = false;
+    TimerWheel &m_timers;
+    TimerWheel::Id m_timer;
     uint16_t m_freq = 0;
-};
\ No newline at end of file
+};
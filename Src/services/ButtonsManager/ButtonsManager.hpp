@@ -3,43 +3,79 @@
 #include "config.h"
 #include "Button.hpp"
 #include "Event.hpp"
+#include "TimerWheel.hpp"
 
 class ButtonsManager {
 public:
-    ButtonsManager(GPIO_TypeDef *portS1, uint8_t pinS1,
+    ButtonsManager(TimerWheel &timers,
+                   GPIO_TypeDef *portS1, uint8_t pinS1,
                    GPIO_TypeDef *portS2, uint8_t pinS2,
                    GPIO_TypeDef *portS3, uint8_t pinS3,
                    GPIO_TypeDef *portS4, uint8_t pinS4)
-            : btnS1(portS1, pinS1),
+            : m_timers(timers),
+              btnS1(portS1, pinS1),
               btnS2(portS2, pinS2),
               btnS3(portS3, pinS3),
-              btnS4(portS4, pinS4) {}
+              btnS4(portS4, pinS4) {
+        // Удержание (value = 1) выдаёт периодический таймер, запущенный на время нажатия
+        holdTimer[0] = timers.create({EventType::ButtonS1, 1});
+        holdTimer[1] = timers.create({EventType::ButtonS2, 1});
+        holdTimer[2] = timers.create({EventType::ButtonS3, 1});
+        holdTimer[3] = timers.create({EventType::ButtonS4, 1});
+    }
 
     void poll(EventQueue &queue) {
-        handle(btnS1, EventType::ButtonS1, lastRelease[0], queue);
-        handle(btnS2, EventType::ButtonS2, lastRelease[1], queue);
-        handle(btnS3, EventType::ButtonS3, lastRelease[2], queue);
-        handle(btnS4, EventType::ButtonS4, lastRelease[3], queue);
+        handle(btnS1, EventType::ButtonS1, lastRelease[0], holdTimer[0], queue);
+        handle(btnS2, EventType::ButtonS2, lastRelease[1], holdTimer[1], queue);
+        handle(btnS3, EventType::ButtonS3, lastRelease[2], holdTimer[2], queue);
+        handle(btnS4, EventType::ButtonS4, lastRelease[3], holdTimer[3], queue);
 
         checkCombination(queue);
     }
 
+    /**
+     * @brief Ближайший момент, когда poll() может выдать событие
+     */
+    void nextDeadline(WakeDeadline &d) const {
+        btnS1.nextDeadline(d);
+        btnS2.nextDeadline(d);
+        btnS3.nextDeadline(d);
+        btnS4.nextDeadline(d);
+
+        if (comboStart != 0) d.at(comboStart + BUTTONS_COMBO_LONG_THRESHOLD_MS + 1);
+    }
+
+    /**
+     * @brief Будить ядро по любому фронту на кнопках (режим APP_TICKLESS)
+     */
+    void enableWakeup() const {
+        btnS1.EnableExti(GpioDriver::Edge::Both);
+        btnS2.EnableExti(GpioDriver::Edge::Both);
+        btnS3.EnableExti(GpioDriver::Edge::Both);
+        btnS4.EnableExti(GpioDriver::Edge::Both);
+    }
+
 private:
     static constexpr uint32_t DoubleClickGap = BUTTONS_DOUBLE_CLICK_GAP_MS; // мс
+    static constexpr uint32_t HoldPeriod = BUTTONS_HOLD_MS;        // мс
     uint32_t lastRelease[4] = {0, 0, 0, 0};
+    uint32_t comboStart = 0;
+
+    TimerWheel &m_timers;
+    TimerWheel::Id holdTimer[4];
 
     Button<> btnS1, btnS2, btnS3, btnS4;
 
-    void handle(Button<> &b, EventType type, uint32_t &lastR, EventQueue &queue) {
+    void handle(Button<> &b, EventType type, uint32_t &lastR, TimerWheel::Id hold, EventQueue &queue) {
         const auto now = RccDriver::GetMsTicks();
         auto e = b.tick();
 
         if (e == Button<>::Event::Pressed) {
             queue.push({type, 0});     // short press start
+            m_timers.arm(hold, HoldPeriod, HoldPeriod);
             lastR = 0;
-        } else if (e == Button<>::Event::Held) {
-            queue.push({type, 1});     // hold
         } else if (e == Button<>::Event::Released) {
+            m_timers.cancel(hold);
             queue.push({type, 2});
             if (now - lastR <= DoubleClickGap) {
                 queue.push({type, 3}); // double click code
@@ -53,8 +89,6 @@ private:
         const bool s2 = !btnS2.Read();
         const uint32_t now = RccDriver::GetMsTicks();
 
-        static uint32_t comboStart = 0;
-
         if (s1 && s2) {
             if (comboStart == 0) comboStart = now;
 
@@ -1,15 +1,9 @@
 #include "Controller.hpp"
 #include "config.h"
+#include "IntFormat.hpp"
 
 using namespace RccDriver;
 
-namespace {
-    /** Возвращает абсолютный срок для таймаута (now + delta). */
-    inline uint32_t make_deadline(uint32_t now, uint32_t delta) {
-        return now + delta;
-    }
-}
-
 /**
  * @note В коде имеются два механизма wildcard (переход из любого состояния (.source) и
  *       переход по любому типу события (.signal) {что есть еще более сильный wildcard}).
@@ -20,15 +14,25 @@ namespace {
  *       никогда не выполнятся.
  *
  *       !!! Это ключевой момент!
+ *
+ *       Таблица constexpr: Fsm::Table проверяет это при компиляции (строка, перекрытая
+ *       вышестоящим wildcard без guard, — ошибка сборки) и разворачивает таблицу
+ *       по [состояние][EventType] с сохранением порядка строк, так что guard/action
+ *       вызываются напрямую. CONTROLLER_LINEAR_DISPATCH возвращает прежний
+ *       перебор всей таблицы.
  */
-const Controller::Transition Controller::transitions[] = {
+constexpr Controller::Machine::Row Controller::transitions[] = {
         /// Реальные, специфичные переходы
         {EventType::Tick100ms,        Controller::State::Idle,    nullptr,                 &Controller::actionPIDTick,           Controller::State::Idle},
         {EventType::Tick100ms,        Controller::State::Heating, nullptr,                 &Controller::actionPIDTick,           Controller::State::Heating},
 
         /// Переходы, содержащие wildcard по состоянию
+        // DisplayTimeout: вернуть отображение `t1` по таймеру TimerWheel
+        {EventType::DisplayTimeout,   Controller::State::Any,     &Controller::guardDisplayTimeout, &Controller::actionDisplayTimeout, Controller::ComputeState},
+        // SensorError: без измерений греть нельзя — нагреватель выключается до следующего TemperatureReady
+        {EventType::SensorError,      Controller::State::Any,     &Controller::guardControlSensor, &Controller::actionSensorError,       Controller::ComputeState},
         // TemperatureReady: состояние вычисляется динамически через evaluateState()
-        {EventType::TemperatureReady, Controller::State::Any,     nullptr,                 &Controller::actionTemperatureSample, Controller::ComputeState},
+        {EventType::TemperatureReady, Controller::State::Any,     &Controller::guardControlSensor, &Controller::actionTemperatureSample, Controller::ComputeState},
         // ButtonS1: уменьшение уставки, состояние вычисляется после изменения
         {EventType::ButtonS1,         Controller::State::Any,     &Controller::guardClickS1, &Controller::actionDecreaseSetpoint,  Controller::ComputeState},
         {EventType::ButtonS1,         Controller::State::Any,     &Controller::guardHeld,    &Controller::actionDecreaseSetpoint,  Controller::ComputeState},
@@ -38,10 +42,10 @@ const Controller::Transition Controller::transitions[] = {
         {EventType::ButtonS2,         Controller::State::Any,     &Controller::guardHeld,    &Controller::actionIncreaseSetpoint,  Controller::ComputeState},
 
         // Звук при нажатии на кнопки
-        {EventType::ButtonS1,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::State::Any},
-        {EventType::ButtonS2,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::State::Any},
-        {EventType::ButtonS3,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::State::Any},
-        {EventType::ButtonS4,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::State::Any},
+        {EventType::ButtonS1,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::ComputeState},
+        {EventType::ButtonS2,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::ComputeState},
+        {EventType::ButtonS3,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::ComputeState},
+        {EventType::ButtonS4,         Controller::State::Any,     nullptr,                   &Controller::actionBeep,              Controller::ComputeState},
         /// Переходы, содержащие wildcard по типу события
 };
 
@@ -49,7 +53,7 @@ const Controller::Transition Controller::transitions[] = {
 void Controller::init() {
     m_current = m_setpoint;
     m_showingSetpoint = false;
-    m_setpointDisplayDeadline = 0;
+    m_timers.cancel(m_displayTimer);
     m_pid.reset();
     m_heaterPower = 0;
     m_lastPidTimestamp = GetMsTicks();
@@ -70,34 +74,19 @@ void Controller::processEvent(const Event &e) {
         else if (e.value == 1) m_s2Held = true;
     }
 
-    for (const auto &transition: transitions) {
-        if (transition.signal != e.type && transition.signal != EventType::Any) continue;
-        if (transition.source != m_state && transition.source != State::Any) continue;
-        if (transition.guard && !(this->*transition.guard)(e)) continue;
-
-        // Определяем целевое состояние
-        State next;
-        if (transition.to == ComputeState) {
-            // Вычисляем через action-функцию (для TemperatureReady и кнопок)
-            next = (this->*transition.action)(e);
-        } else {
-            // Используем явно указанное состояние из таблицы
-            next = transition.to;
-            // Вызываем action для побочных эффектов (если есть)
-            if (transition.action) {
-                (this->*transition.action)(e);
-            }
-        }
-        
+    using Table = Machine::Table<transitions, State::Idle>;
+
+    State next;
+#if defined CONTROLLER_LINEAR_DISPATCH
+    const bool fired = Table::dispatchLinear(*this, m_state, e.type, e, next);
+#else
+    const bool fired = Table::dispatch(*this, m_state, e.type, e, next);
+#endif
+    if (fired) {
         applyState(next);
-        return;
     }
 }
 
-/** Обработка тайм-аутов и фоновых задач. */
-void Controller::poll() {
-    ensureDisplayTimeout();
-}
 
 /** Guard: реагировать только на первое событие «нажата» (value == 0). */
 bool Controller::guardPress(const Event &e) const {
@@ -109,6 +98,15 @@ bool Controller::guardHeld(const Event &e) const {
     return e.value == 1;
 }
 
+/**
+ * Guard: регулирование — по датчику 0, остальные только измеряются.
+ * Датчик 0 — первый найденный после старта; драйвер держит его под номером 0 при повторных
+ * поисках, а пропавший с шины даёт SensorError, а не значение другого датчика.
+ */
+bool Controller::guardControlSensor(const Event &e) const {
+    return e.sensor == 0;
+}
+
 bool Controller::guardClickS1(const Event &e) const {
     return e.value == 2 && !m_s1Held;
 }
@@ -147,29 +145,29 @@ Controller::State Controller::actionTemperatureSample(const Event &e) {
     return next;
 }
 
-/** Action: уменьшить уставку (ButtonS1). */
-Controller::State Controller::actionDecreaseSetpoint(const Event &) {
-    m_setpoint -= SetpointStep;
-    if (m_setpoint < SetpointMin) m_setpoint = SetpointMin;
-
-    m_showingSetpoint = true;
-    m_setpointDisplayDeadline = make_deadline(GetMsTicks(), SetpointDisplayDurationMs);
-    displaySetpointTemperature();
-    m_pid.reset();
+/** Action: отказ датчика — отключить нагрев (состояние Error до следующего измерения). */
+Controller::State Controller::actionSensorError(const Event &) {
     m_heaterPower = 0;
-    m_lastPidTimestamp = GetMsTicks();
+    return State::Error;
+}
 
-    return evaluateState();
+/** Action: уменьшить уставку (ButtonS1). */
+Controller::State Controller::actionDecreaseSetpoint(const Event &) {
+    return changeSetpoint(m_setpoint - SetpointStep);
 }
 
 /** Action: увеличить уставку (ButtonS2). */
 Controller::State Controller::actionIncreaseSetpoint(const Event &) {
-    m_setpoint += SetpointStep;
-    if (m_setpoint > SetpointMax) m_setpoint = SetpointMax;
+    return changeSetpoint(m_setpoint + SetpointStep);
+}
 
-    m_showingSetpoint = true;
-    m_setpointDisplayDeadline = make_deadline(GetMsTicks(), SetpointDisplayDurationMs);
-    displaySetpointTemperature();
+/** Новая уставка: показать `t2`, сбросить PID и вернуть пересчитанное состояние. */
+Controller::State Controller::changeSetpoint(int value) {
+    if (value < SetpointMin) value = SetpointMin;
+    if (value > SetpointMax) value = SetpointMax;
+    m_setpoint = value;
+
+    showSetpoint();
     m_pid.reset();
     m_heaterPower = 0;
     m_lastPidTimestamp = GetMsTicks();
@@ -177,6 +175,17 @@ Controller::State Controller::actionIncreaseSetpoint(const Event &) {
     return evaluateState();
 }
 
+/** Уставка по команде протокола — то же, что нажатие кнопки, но сразу на нужное значение. */
+void Controller::setSetpoint(int value) {
+    applyState(changeSetpoint(value));
+}
+
+/** Новые коэффициенты PID; мощность пересчитается со следующим измерением. */
+void Controller::setPidGains(int32_t kp, int32_t ki, int32_t kd) {
+    m_pid.setGains(kp, ki, kd);
+    m_lastPidTimestamp = GetMsTicks();
+}
+
 Controller::State Controller::actionPIDTick(const Event &) {
     // Периодически переустанавливаем выходы, чтобы учесть PWM/индикацию.
     updateOutputsFor(m_state);
@@ -190,6 +199,17 @@ Controller::State Controller::actionBeep(const Event &e) {
     return m_state; // состояние не меняем
 }
 
+/** Guard: таймаут актуален, только если таймер не перезапущен после его срабатывания. */
+bool Controller::guardDisplayTimeout(const Event &) const {
+    return m_showingSetpoint && !m_timers.armed(m_displayTimer);
+}
+
+/** Action: вернуть отображение текущей температуры после показа уставки. */
+Controller::State Controller::actionDisplayTimeout(const Event &) {
+    displayCurrentTemperature();
+    return evaluateState();
+}
+
 bool Controller::isDouble(const Event &e) {
     return e.value == 3;
 }
@@ -222,6 +242,11 @@ void Controller::applyState(State newState) {
     }
 
     updateOutputsFor(newState);
+
+    // Надпись `Err`/`t1` зависит от состояния
+    if ((previous == State::Error) != (newState == State::Error) && !m_showingSetpoint) {
+        displayCurrentTemperature();
+    }
 }
 
 /**
@@ -250,69 +275,70 @@ void Controller::updateOutputsFor(State state) {
     }
 }
 
-/** Показать на индикаторе текущую температуру (`t1`). */
+/** Показать на индикаторе текущую температуру (`t1`, в State::Error — мигающее `Err`). */
 void Controller::displayCurrentTemperature() {
     m_showingSetpoint = false;
-    displayTemperature('1', m_current);
+    updateBlink();
+    displayTemperature(m_state == State::Error ? LabelError : LabelCurrent, m_current);
 }
 
 /** Показать на индикаторе уставку (`t2`). */
 void Controller::displaySetpointTemperature() {
-    displayTemperature('2', m_setpoint);
+    displayTemperature(LabelSetpoint, m_setpoint);
 }
 
 /** Универсальный вывод значения на индикатор HT1621. */
-void Controller::displayTemperature(char label, int value) {
+void Controller::displayTemperature(const HT1621B::SegImage &label, int value) {
     if (!m_display) return;
 
-    m_display->ClearSegArea(false);
-
     // value уже в десятых долях градуса, ограничиваем диапазон
     int clamped = value;
     if (clamped < -99) clamped = -99;  // -9.9°C
     else if (clamped > 999) clamped = 999;  // 99.9°C
 
     bool negative = clamped < 0;
-    int magnitude = negative ? -clamped : clamped;
-
-    int whole = magnitude / 10;
-    int frac = magnitude % 10;
+    const auto magnitude = static_cast<uint32_t>(negative ? -clamped : clamped);
 
-    char text[7] = {'t', label, ' ', ' ', ' ', '0', '\0'};
+    // Десятки, единицы и десятые — сдвигами, без вызовов деления libgcc
+    uint32_t frac, ones;
+    uint32_t whole = IntFormat::div10(magnitude, frac);
+    if (whole > 99) whole = 99;
+    const uint32_t tens = IntFormat::div10(whole, ones);
 
+    // Надпись готова с компиляции, остаются три разряда справа и разделитель
+    HT1621B::SegImage image = label;
     if (negative) {
-        text[3] = '-';
-        if (whole < 10) {
-            text[4] = static_cast<char>('0' + whole);
-        } else {
-            if (whole > 99) whole = 99;
-            text[4] = static_cast<char>('0' + (whole / 10));
-        }
+        image.Put(2, '-');
+        image.Put(1, static_cast<char>('0' + (whole < 10 ? ones : tens)));
     } else {
-        // Форматируем whole как двузначное число с ведущим нулём (без snprintf)
-        if (whole > 99) whole = 99;
-        text[3] = static_cast<char>('0' + (whole / 10));
-        text[4] = static_cast<char>('0' + (whole % 10));
+        // Двузначное число с ведущим нулём (без snprintf)
+        image.Put(2, static_cast<char>('0' + tens));
+        image.Put(1, static_cast<char>('0' + ones));
     }
-    text[5] = static_cast<char>('0' + frac);
+    image.Put(0, static_cast<char>('0' + frac)).Dot(1);
 
-    m_display->ShowString(text, false);
-    m_display->ShowDot(1, true, true);
+    // Кадр собран в заднем буфере целиком: на индикатор уходит одним Present()
+    m_display->ShowImage(image);
+    m_display->Present();
 }
 
-/** Проверить, не истёк ли таймаут отображения уставки. */
-void Controller::ensureDisplayTimeout() {
-    if (!m_showingSetpoint) return;
-    uint32_t now = GetMsTicks();
-    if (timeReached(now, m_setpointDisplayDeadline)) {
-        displayCurrentTemperature();
-        applyState(evaluateState());
-    }
+/** Показать уставку `t2` и (пере)запустить таймер возврата к `t1`. */
+void Controller::showSetpoint() {
+    m_showingSetpoint = true;
+    m_timers.arm(m_displayTimer, SetpointDisplayDurationMs);
+    updateBlink();
+    // Новое значение сразу видно, гаснет только после полной фазы
+    if (m_animator) m_animator->restartBlink();
+    displaySetpointTemperature();
 }
 
-/** Безопасное сравнение времени с учётом переполнения счётчика. */
-bool Controller::timeReached(uint32_t now, uint32_t deadline) {
-    return static_cast<int32_t>(now - deadline) >= 0;
+/** Мигание: значение `t2` во время правки уставки, надпись `Err` в State::Error. */
+void Controller::updateBlink() {
+    if (!m_animator) return;
+
+    if (m_showingSetpoint) m_animator->blinkPositions(BlinkValue);
+    else if (m_state == State::Error) m_animator->blinkPositions(BlinkLabel);
+    else m_animator->blinkPositions(0);
 }
 
 /**
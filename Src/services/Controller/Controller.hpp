@@ -6,6 +6,9 @@
 #include "Event.hpp"
 #include "PID.hpp"
 #include "BeepManager.hpp"
+#include "DisplayAnimator.hpp"
+#include "TimerWheel.hpp"
+#include "Fsm.hpp"
 
 /**
  * @brief Высокоуровневый термостат с табличным конечным автоматом.
@@ -17,8 +20,11 @@
  */
 class Controller {
 public:
-    Controller(HT1621B *display, BeepManager *beep, PwmDriver *heater) :
+    Controller(HT1621B *display, DisplayAnimator *animator, BeepManager *beep, PwmDriver *heater, TimerWheel &timers) :
+            m_timers(timers),
+            m_displayTimer(timers.create({EventType::DisplayTimeout, 0})),
             m_display(display),
+            m_animator(animator),
             m_beep(beep),
             m_heater(heater) {}
 
@@ -28,18 +34,21 @@ public:
     enum class State : uint8_t {
         Idle,    ///< Цель достигнута, нагрев не требуется.
         Heating, ///< Нужно греть, загорается зелёный светодиод.
-        Error,   ///< Перегрев относительно цели, горит красный светодиод.
+        Error,   ///< Перегрев относительно цели или отказ датчика, горит красный светодиод.
 
         Any      ///< Для перехода из любого состояния (wildcard)
     };
 
+    /// Табличный автомат контроллера: сигнал — тип события, guard/action получают событие целиком.
+    using Machine = Fsm<Controller, State, EventType, Event>;
+
     /**
-     * @brief Специальное значение для поля `to` в таблице переходов.
+     * @brief Специальное значение для поля `target` в таблице переходов.
      *
      * Означает, что целевое состояние нужно вычислить динамически через action-функцию.
      * Используется для переходов, где состояние зависит от текущих значений температуры.
      */
-    static constexpr State ComputeState = static_cast<State>(0xFF);
+    static constexpr State ComputeState = Machine::Compute;
 
     /**
      * @brief Инициализировать внутренние структуры и обновить индикацию.
@@ -54,35 +63,42 @@ public:
     void processEvent(const Event &e);
 
     /**
-     * @brief Периодическая обработка фоновых задач (таймауты и пр.).
+     * @brief Задать уставку (как кнопками: показ `t2`, сброс PID, пересчёт состояния).
+     *
+     * @param value Уставка в десятых долях °C, ограничивается SetpointMin..SetpointMax.
      */
-    void poll();
-
-private:
-    using Guard = bool (Controller::*)(const Event &) const;
-    using Action = State (Controller::*)(const Event &);
+    void setSetpoint(int value);
 
     /**
-     * @brief Строка таблицы переходов.
+     * @brief Заменить коэффициенты PID (×PIDInt::SCALE), накопленное состояние PID сбрасывается.
      */
-    struct Transition {
-        EventType signal;  ///< Какой тип события обрабатываем.
-        State source;      ///< В каком состоянии переход допустим.
-        Guard guard;       ///< Дополнительная проверка (nullptr — без условий).
-        Action action;     ///< Выполняемое действие, возвращает новое состояние.
-        State to;          ///< Целевое состояние (ComputeState означает "вычислить через action").
-    };
+    void setPidGains(int32_t kp, int32_t ki, int32_t kd);
+
+    int getSetpoint() const { return m_setpoint; }
+    int getCurrent() const { return m_current; }
+    int getHeaterPower() const { return m_heaterPower; }
+    State getState() const { return m_state; }
+    const PIDInt &getPid() const { return m_pid; }
+
+    static constexpr int SetpointMin = CONTROLLER_SETPOINT_MIN;                     ///< Минимально допустимая уставка (в десятых долях °C, -95 = -9.5°C).
+    static constexpr int SetpointMax = CONTROLLER_SETPOINT_MAX;                     ///< Максимально допустимая уставка (в десятых долях °C, 995 = 99.5°C).
 
+
+private:
     // Guard-функции и действия
     bool guardPress(const Event &e) const;
     bool guardHeld(const Event &e) const;
     State actionTemperatureSample(const Event &e);
+    State actionSensorError(const Event &e);
     State actionDecreaseSetpoint(const Event &e);
     State actionIncreaseSetpoint(const Event &e);
     State actionPIDTick(const Event &e);
     State actionBeep(const Event &e);
+    bool guardDisplayTimeout(const Event &e) const;
+    State actionDisplayTimeout(const Event &e);
     bool guardClickS1(const Event &e) const;
     bool guardClickS2(const Event &e) const;
+    bool guardControlSensor(const Event &e) const;
     bool isDouble(const Event &e);
     bool isComboShort(const Event &e);
 
@@ -90,35 +106,39 @@ private:
     State evaluateState() const;
     void applyState(State newState);
     void updateOutputsFor(State state);
+    State changeSetpoint(int value);
 
     // Работа с индикацией
     void displayCurrentTemperature();
     void displaySetpointTemperature();
-    void displayTemperature(char label, int value);  // value в десятых долях градуса
-    void ensureDisplayTimeout();
+    void displayTemperature(const HT1621B::SegImage &label, int value);  // value в десятых долях градуса
+    void showSetpoint();
+    void updateBlink();
 
-    // Вспомогательные функции
-    static bool timeReached(uint32_t now, uint32_t deadline);
-
-    /// Таблица переходов конечного автомата (определена в .cpp).
-    static const Transition transitions[];
+    /// Таблица переходов конечного автомата (constexpr, определена в .cpp).
+    static const Machine::Row transitions[];
 
     int m_setpoint = CONTROLLER_SETPOINT_DEFAULT;               ///< Уставка, задаваемая пользователем (в десятых долях °C, 250 = 25.0°C).
     int m_current = 0;                          ///< Текущая измеренная температура (в десятых долях °C).
     State m_state = State::Idle;                ///< Состояние автомата.
     bool m_showingSetpoint = false;             ///< Отображается ли сейчас уставка `t2`.
-    uint32_t m_setpointDisplayDeadline = 0;     ///< Момент возврата к отображению `t1`.
     int m_heaterPower = 0;                      ///< Последнее вычисленное значение мощности (0..1000).
     uint32_t m_lastPidTimestamp = 0;            ///< Время последнего обновления PID (мс).
 
     static constexpr uint32_t SetpointDisplayDurationMs = CONTROLLER_SETPOINT_DISPLAY_DURATION_MS; ///< Время показа `t2` после нажатия (мс).
     static constexpr int SetpointStep = 5;                      ///< Шаг изменения уставки (в десятых долях °C, 5 = 0.5°C).
-    static constexpr int SetpointMin = CONTROLLER_SETPOINT_MIN;                     ///< Минимально допустимая уставка (в десятых долях °C, -95 = -9.5°C).
-    static constexpr int SetpointMax = CONTROLLER_SETPOINT_MAX;                     ///< Максимально допустимая уставка (в десятых долях °C, 995 = 99.5°C).
     static constexpr int ErrorDelta = CONTROLLER_ERROR_DELTA;                       ///< Перегрев относительно цели (в десятых долях °C, 30 = 3.0°C).
     static constexpr uint32_t PidNominalSamplePeriodMs = CONTROLLER_PID_SAMPLE_PERIOD_MS;  ///< Базовый период дискретизации PID.
     static constexpr int PidDeadband = 1;                       ///< Мёртвая зона PID (0.2°C).
 
+    /// Надписи `t1`/`t2` в левых разрядах — образы RAM индикатора, собранные при компиляции.
+    static constexpr HT1621B::SegImage LabelCurrent = HT1621B::Render("t1    ");
+    static constexpr HT1621B::SegImage LabelSetpoint = HT1621B::Render("t2    ");
+    static constexpr HT1621B::SegImage LabelError = HT1621B::Render("Err   ");   ///< Вместо `t1` в State::Error, мигает
+
+    static constexpr uint8_t BlinkLabel = 0b111000;   ///< Разряды надписи (DisplayAnimator::blinkPositions)
+    static constexpr uint8_t BlinkValue = 0b000111;   ///< Разряды значения
+
     bool m_s1Held = false, m_s2Held = false;
 
     /** PID-регулятор мощности нагрева (fixed-point integer) */
@@ -148,10 +168,14 @@ private:
      */
     int computeHeatingPower(uint32_t dtMs);
 
+    TimerWheel &m_timers;
+    TimerWheel::Id m_displayTimer;              ///< Однократный таймер возврата к отображению `t1` (DisplayTimeout).
+
     /**
      * @brief Указатели на исполнительные механизмы для класса Controller
      */
     HT1621B *m_display;
+    DisplayAnimator *m_animator;
     BeepManager *m_beep;
     PwmDriver *m_heater;
 };
\ No newline at end of file
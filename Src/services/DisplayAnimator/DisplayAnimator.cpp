@@ -0,0 +1,126 @@
+#include "DisplayAnimator.hpp"
+#include "RccDriver.hpp"
+
+using namespace RccDriver;
+
+void DisplayAnimator::blinkPositions(uint8_t positions) {
+    if (!m_display || positions == m_positions) return;
+    m_positions = positions;
+    for (uint8_t p = 0; p < 6; ++p) m_display->BlinkPosition(p, positions & (1U << p));
+    blinkChanged();
+}
+
+void DisplayAnimator::blinkSpecial(uint8_t type, bool enable) {
+    if (!m_display) return;
+    m_display->BlinkSpecial(type, enable);
+    blinkChanged();
+}
+
+void DisplayAnimator::blinkChargeLevel(bool enable) {
+    if (!m_display) return;
+    m_display->BlinkChargeLevel(enable);
+    blinkChanged();
+}
+
+void DisplayAnimator::blinkChanged() {
+    const bool blinking = m_display->Blinking();
+    if (blinking == m_blinking) return;
+
+    m_blinking = blinking;
+    if (blinking) {
+        restartBlink();
+        return;
+    }
+    // Мигать нечему: погашенные сегменты возвращаются, таймер — только для строки
+    m_hidden = false;
+    m_display->SetBlinkHidden(false);
+    schedule(GetMsTicks());
+}
+
+void DisplayAnimator::restartBlink() {
+    if (!m_blinking) return;
+
+    const uint32_t now = GetMsTicks();
+    m_hidden = false;
+    m_display->SetBlinkHidden(false);
+    m_blinkDue = now + DISPLAY_BLINK_ON_MS;
+    schedule(now);
+}
+
+void DisplayAnimator::marquee(const char *text) {
+    if (!m_display || !text) return;
+
+    uint8_t length = 0;
+    while (text[length] && length < 0xFF - DISPLAY_MARQUEE_GAP) ++length;
+
+    const uint32_t now = GetMsTicks();
+    if (length <= 6) {
+        m_text = nullptr;
+        m_display->ShowString(text);
+    } else {
+        m_text = text;
+        m_length = length;
+        m_offset = 0;
+        showWindow();
+        m_stepDue = now + DISPLAY_MARQUEE_STEP_MS;
+    }
+    schedule(now);
+}
+
+void DisplayAnimator::stopMarquee() {
+    if (!m_text) return;
+    m_text = nullptr;
+    schedule(GetMsTicks());
+}
+
+void DisplayAnimator::showWindow() {
+    // Текст, затем DISPLAY_MARQUEE_GAP пробелов, и снова с начала
+    const uint8_t cycle = m_length + DISPLAY_MARQUEE_GAP;
+    uint8_t index = m_offset;
+
+    HT1621B::SegImage image;
+    for (uint8_t k = 0; k < 6; ++k) {
+        image.Put(5 - k, index < m_length ? m_text[index] : ' ');
+        if (++index == cycle) index = 0;
+    }
+    m_display->ShowImage(image);
+}
+
+void DisplayAnimator::onFrame() {
+    // Событие от отменённого таймера могло остаться в очереди: сроки проверяются здесь
+    const uint32_t now = GetMsTicks();
+
+    if (m_blinking && static_cast<int32_t>(now - m_blinkDue) >= 0) {
+        m_hidden = !m_hidden;
+        m_display->SetBlinkHidden(m_hidden);
+        m_blinkDue = now + (m_hidden ? DISPLAY_BLINK_OFF_MS : DISPLAY_BLINK_ON_MS);
+    }
+    if (m_text && static_cast<int32_t>(now - m_stepDue) >= 0) {
+        if (++m_offset == m_length + DISPLAY_MARQUEE_GAP) m_offset = 0;
+        showWindow();
+        m_stepDue = now + DISPLAY_MARQUEE_STEP_MS;
+    }
+
+    if (m_display) m_display->Present();
+    schedule(now);
+}
+
+void DisplayAnimator::schedule(uint32_t now) {
+    bool armed = false;
+    uint32_t due = 0;
+    if (m_blinking) {
+        due = m_blinkDue;
+        armed = true;
+    }
+    if (m_text && (!armed || static_cast<int32_t>(m_stepDue - due) < 0)) {
+        due = m_stepDue;
+        armed = true;
+    }
+
+    if (!armed) {
+        m_timers.cancel(m_timer);
+        return;
+    }
+    const int32_t delay = static_cast<int32_t>(due - now);
+    m_timers.arm(m_timer, delay > 0 ? static_cast<uint32_t>(delay) : 0);
+}
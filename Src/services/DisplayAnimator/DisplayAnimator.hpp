@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "ht1621.hpp"
+#include "TimerWheel.hpp"
+
+/**
+ * @brief Анимация индикатора HT1621B по таймеру: мигание сегментов и бегущая строка
+ *
+ * Мигание — маски сегментов в HT1621B (разряды, спецсимволы, уровень заряда),
+ * которые Present() применяет поверх заднего буфера: остальной код рисует как обычно
+ * и о фазе не знает. Бегущая строка выводит окно в 6 символов текста длиннее
+ * индикатора через ShowImage().
+ *
+ * Один таймер TimerWheel (событие DisplayFrame) взводится однократно на ближайший срок:
+ * смену фазы мигания или шаг строки. Кадр — смена фазы и/или окна и Present(),
+ * на шину уходят только изменившиеся нибблы. Без анимаций таймер не взведён, так что
+ * между кадрами индикатор не стоит ядру ничего (в APP_TICKLESS оно спит до срока).
+ *
+ * Как и Show*() у HT1621B, методы меняют только задний буфер и маски: на стекло
+ * изменения попадают с ближайшим Present() вызывающего или со следующим кадром.
+ */
+class DisplayAnimator {
+public:
+    DisplayAnimator(HT1621B *display, TimerWheel &timers)
+            : m_display(display),
+              m_timers(timers),
+              m_timer(timers.create({EventType::DisplayFrame, 0})) {}
+
+    /**
+     * @brief Мигающие разряды вместе с разделителями: бит p — позиция p (0 - правый разряд)
+     */
+    void blinkPositions(uint8_t positions);
+
+    /**
+     * @brief Пульсация спецсимвола (индекс как в HT1621B::ShowSpecial())
+     */
+    void blinkSpecial(uint8_t type, bool enable);
+
+    /**
+     * @brief Пульсация уровня заряда
+     */
+    void blinkChargeLevel(bool enable);
+
+    /**
+     * @brief Начать фазу «видно» заново (после изменения мигающего значения)
+     */
+    void restartBlink();
+
+    /**
+     * @brief Бегущая строка; text должен жить до stopMarquee() (строковый литерал).
+     *        Текст не длиннее 6 символов выводится неподвижно, как ShowString().
+     */
+    void marquee(const char *text);
+
+    void stopMarquee();
+
+    /// Взведён таймер кадров: есть мигание или бегущая строка
+    bool active() const { return m_blinking || m_text; }
+
+    /**
+     * @brief Событие DisplayFrame: сменить фазу и/или сдвинуть строку, если подошёл срок
+     */
+    void onFrame();
+
+private:
+    void blinkChanged();
+    void showWindow();
+    void schedule(uint32_t now);
+
+    HT1621B *m_display;
+    TimerWheel &m_timers;
+    TimerWheel::Id m_timer;
+
+    uint8_t m_positions = 0;        ///< Мигающие разряды (бит на позицию)
+    bool m_blinking = false;        ///< В HT1621B есть маски мигания
+    bool m_hidden = false;          ///< Фаза: мигающие сегменты погашены
+    uint32_t m_blinkDue = 0;        ///< Смена фазы (шкала GetMsTicks())
+
+    const char *m_text = nullptr;   ///< Бегущая строка, nullptr — нет
+    uint8_t m_length = 0;
+    uint8_t m_offset = 0;           ///< Символ в левом разряде окна
+    uint32_t m_stepDue = 0;         ///< Следующий шаг строки
+};
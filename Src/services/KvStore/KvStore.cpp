@@ -0,0 +1,268 @@
+#include "KvStore.hpp"
+#include "RccDriver.hpp"
+#include "Crc16.hpp"
+
+namespace {
+    /// Метка активной страницы (записывается последней)
+    constexpr uint16_t Marker = 0x5AA5;
+    /// Погашенная метка: 0x0000 можно записать поверх любого полуслова
+    constexpr uint16_t Retired = 0x0000;
+    constexpr uint16_t Erased = 0xFFFF;
+
+    /// CRC ключа, длины и значения записи (значение — младшими байтами полуслов вперёд)
+    uint16_t recordCrc(const volatile uint16_t *r) {
+        const uint8_t len = static_cast<uint8_t>(r[0] >> 8);
+        uint16_t crc = Crc16::update(Crc16::update(Crc16::Init, static_cast<uint8_t>(r[0])), len);
+        for (uint8_t i = 0; i < len; ++i) {
+            const uint16_t w = r[1 + i / 2];
+            crc = Crc16::update(crc, static_cast<uint8_t>(i & 1 ? w >> 8 : w));
+        }
+        return crc;
+    }
+}
+
+uint32_t KvStore::generation(const volatile uint16_t *p) {
+    if (p[0] != Marker || p[1] == Erased || p[2] == Erased) return 0;
+    return p[1] | (static_cast<uint32_t>(p[2]) << 16);
+}
+
+uint32_t KvStore::nextGeneration(uint32_t gen) {
+    // Половина 0xFFFF не отличается от недостёртой — такие номера пропускаются
+    do {
+        ++gen;
+    } while (static_cast<uint16_t>(gen) == Erased || static_cast<uint16_t>(gen >> 16) == Erased || gen == 0);
+    return gen;
+}
+
+bool KvStore::recordValid(const volatile uint16_t *r, uint16_t room) {
+    const uint8_t key = static_cast<uint8_t>(r[0]);
+    const uint8_t len = static_cast<uint8_t>(r[0] >> 8);
+    if (key == 0 || key == 0xFF || len > FLASH_KV_VALUE_MAX) return false;
+
+    const uint16_t words = recordWords(len);
+    return words <= room && r[words - 1] == recordCrc(r);
+}
+
+void KvStore::begin() {
+    // Из двух помеченных страниц активна следующая за другой (перенос оборван после метки).
+    // Несмежные поколения — след повреждения: стирание только поднимает биты, поэтому
+    // меньшее из них вероятнее записано целиком
+    const uint32_t g0 = generation(page(0));
+    const uint32_t g1 = generation(page(1));
+    if (g0 == 0 || g1 == 0) {
+        m_active = g1 != 0 ? 1 : 0;
+    } else if (g1 == nextGeneration(g0)) {
+        m_active = 1;
+    } else if (g0 == nextGeneration(g1)) {
+        m_active = 0;
+    } else {
+        m_active = g1 < g0 ? 1 : 0;
+    }
+    m_step = Step::Idle;
+    scan();
+}
+
+// Индекс по журналу активной страницы; первая испорченная запись закрывает журнал
+
+void KvStore::scan() {
+    for (auto &k: m_keys) k = 0;
+
+    const volatile uint16_t *p = page(m_active);
+    uint16_t pos = HeaderWords;
+    m_dirty = generation(p) == 0;   // Страницы ещё нет: первая запись создаст её переносом
+
+    while (!m_dirty && pos < PageWords && p[pos] != Erased) {
+        if (!recordValid(p + pos, PageWords - pos)) {
+            m_dirty = true;
+            break;
+        }
+        const uint8_t key = static_cast<uint8_t>(p[pos]);
+        const uint8_t len = static_cast<uint8_t>(p[pos] >> 8);
+        int8_t i = find(key);
+        if (len == 0) {
+            if (i >= 0) m_keys[i] = 0;
+        } else {
+            if (i < 0) i = find(0);
+            if (i >= 0) {
+                m_keys[i] = key;
+                m_at[i] = pos;
+            }
+        }
+        pos += recordWords(len);
+    }
+
+    // Оборванная запись могла оставить запрограммированные полуслова дальше конца журнала
+    for (uint16_t i = pos; i < PageWords && !m_dirty; ++i) {
+        if (p[i] != Erased) m_dirty = true;
+    }
+
+    m_write = pos;
+    m_stats.generation = generation(p);
+    m_stats.used = static_cast<uint16_t>(m_write * 2);
+}
+
+int8_t KvStore::find(uint8_t key) const {
+    for (uint8_t i = 0; i < FLASH_KV_MAX_KEYS; ++i) {
+        if (m_keys[i] == key) return static_cast<int8_t>(i);
+    }
+    return -1;
+}
+
+bool KvStore::put(uint8_t key, const void *data, uint8_t len) {
+    if (m_step != Step::Idle || key == 0 || key == 0xFF || len > FLASH_KV_VALUE_MAX) return false;
+    if (len == 0 && find(key) < 0) return true;   // Удалять нечего
+    if (len != 0 && find(key) < 0 && find(0) < 0) return false;
+
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    m_recWords = recordWords(len);
+    m_rec[0] = static_cast<uint16_t>(key | (len << 8));
+    for (uint8_t w = 0; w < (len + 1) / 2; ++w) {
+        const uint8_t hi = 2 * w + 1 < len ? bytes[2 * w + 1] : 0xFF;
+        m_rec[1 + w] = static_cast<uint16_t>(bytes[2 * w] | (hi << 8));
+    }
+    m_rec[m_recWords - 1] = recordCrc(m_rec);
+
+    if (m_dirty || m_write + m_recWords > PageWords) {
+        m_step = Step::Retire;   // Перенос на вторую страницу вместе с новой записью
+    } else {
+        m_step = Step::Append;
+        m_src = m_rec;
+        m_left = m_recWords;
+        m_dst = m_write;
+    }
+    return true;
+}
+
+int KvStore::get(uint8_t key, void *data, uint8_t size) const {
+    const int8_t i = find(key);
+    if (key == 0 || i < 0) return -1;
+
+    const volatile uint16_t *r = page(m_active) + m_at[i];
+    const uint8_t len = static_cast<uint8_t>(r[0] >> 8);
+    auto *out = static_cast<uint8_t *>(data);
+    for (uint8_t n = 0; n < len && n < size; ++n) {
+        const uint16_t w = r[1 + n / 2];
+        out[n] = static_cast<uint8_t>(n & 1 ? w >> 8 : w);
+    }
+    return len;
+}
+
+void KvStore::poll(bool mayStall) {
+    if (m_step == Step::Idle || !mayStall) return;
+
+    switch (m_step) {
+        case Step::Append:
+            if (!program(*m_src++)) return fail();
+            if (--m_left == 0) commit();
+            break;
+
+        case Step::Retire:
+            // Метка прошлого поколения не должна пережить оборванное стирание
+            m_step = Step::Erase;
+            if (page(m_active ^ 1)[0] == Marker) {
+                m_dst = 0;
+                if (!program(Retired)) return fail();
+            }
+            break;
+
+        case Step::Erase:
+            if (!FlashDriver::ErasePage(page(m_active ^ 1))) return fail();
+            m_step = Step::Copy;
+            m_copy = 0;
+            m_dst = HeaderWords;
+            nextCopy();
+            break;
+
+        case Step::Copy:
+        case Step::AppendSpare:
+            if (!program(*m_src++)) return fail();
+            if (--m_left != 0) break;
+            if (m_step == Step::Copy) {
+                nextCopy();
+            } else {
+                m_step = Step::Header;
+                m_left = 3;
+            }
+            break;
+
+        case Step::Header: {
+            // Поколение, затем метка: метка без полного поколения не появляется
+            const uint32_t gen = nextGeneration(m_stats.generation);
+            uint16_t value = Marker;
+            if (m_left == 3) {
+                m_dst = 1;
+                value = static_cast<uint16_t>(gen);
+            } else if (m_left == 2) {
+                value = static_cast<uint16_t>(gen >> 16);
+            } else {
+                m_dst = 0;
+            }
+            if (!program(value)) return fail();
+            if (--m_left == 0) commit();
+            break;
+        }
+
+        case Step::Idle:
+            break;
+    }
+}
+
+void KvStore::nextDeadline(WakeDeadline &d) const {
+    if (m_step != Step::Idle) d.at(RccDriver::GetMsTicks());
+}
+
+// Следующая живая запись для переноса; ключ новой записи не переносится
+
+void KvStore::nextCopy() {
+    const uint8_t newKey = static_cast<uint8_t>(m_rec[0]);
+    while (m_copy < FLASH_KV_MAX_KEYS) {
+        const uint8_t i = m_copy++;
+        if (m_keys[i] == 0 || m_keys[i] == newKey) continue;
+        m_src = page(m_active) + m_at[i];
+        m_left = recordWords(static_cast<uint8_t>(*m_src >> 8));
+        return;
+    }
+
+    if (m_rec[0] >> 8) {
+        m_step = Step::AppendSpare;
+        m_src = m_rec;
+        m_left = m_recWords;
+    } else {
+        m_step = Step::Header;   // Удаление: ключ просто не перенесён
+        m_left = 3;
+    }
+}
+
+bool KvStore::program(uint16_t value) {
+    const uint8_t target = m_step == Step::Append ? m_active : m_active ^ 1;
+    return FlashDriver::Program(page(target) + m_dst++, value);
+}
+
+void KvStore::fail() {
+    // Дописывать за испорченным полусловом нельзя: следующая запись — переносом
+    ++m_stats.failures;
+    m_dirty = true;
+    m_step = Step::Idle;
+}
+
+void KvStore::commit() {
+    if (m_step == Step::Append) {
+        const uint8_t key = static_cast<uint8_t>(m_rec[0]);
+        int8_t i = find(key);
+        if ((m_rec[0] >> 8) == 0) {
+            m_keys[i] = 0;
+        } else {
+            if (i < 0) i = find(0);
+            m_keys[i] = key;
+            m_at[i] = static_cast<uint16_t>(m_write);
+        }
+        m_write = m_dst;
+        m_stats.used = static_cast<uint16_t>(m_write * 2);
+    } else {
+        m_active ^= 1;
+        scan();
+        ++m_stats.compactions;
+    }
+    ++m_stats.puts;
+    m_step = Step::Idle;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "FlashDriver.hpp"
+#include "WakeDeadline.hpp"
+
+/**
+ * @brief Ключ-значение во встроенной flash: журнал записей на двух страницах
+ *
+ * Активная страница — заголовок (метка и номер поколения) и записи подряд:
+ * полуслово «ключ | длина << 8», значение, CRC-16 ключа, длины и значения.
+ * put() дописывает запись в конец журнала; действует последняя запись ключа,
+ * запись длины 0 удаляет ключ. Когда место кончается (или хвост журнала испорчен),
+ * живые записи вместе с новой переносятся на вторую страницу: метка прежнего поколения
+ * на ней гасится (0x0000), затем стирание, копирование, номер поколения и последней —
+ * метка, которая делает страницу активной.
+ *
+ * Обрыв питания в любой момент оставляет либо прежнее, либо новое значение ключа:
+ * запись без верной CRC отбрасывается при загрузке, страница без метки не выбирается,
+ * из двух помеченных берётся та, чьё поколение следует за поколением другой. Частично
+ * стёртая страница метки уже не несёт; половина поколения 0xFFFF (след стирания)
+ * недопустима, такие номера при переносе пропускаются.
+ *
+ * put() только готовит запись в RAM; poll() основного цикла выполняет не больше
+ * одной операции flash (полуслово или стирание страницы) и только когда mayStall:
+ * на время операции ядро стоит (см. FlashDriver), а значит её нельзя начинать,
+ * пока DS18B20 ведёт слоты 1-Wire с длительностями из flash.
+ */
+class KvStore {
+public:
+    struct Stats {
+        uint32_t puts = 0;          ///< Записей (и удалений) сохранено
+        uint32_t compactions = 0;   ///< Переносов на другую страницу
+        uint32_t failures = 0;      ///< Операций flash с ошибкой (запись потеряна)
+        uint32_t generation = 0;    ///< Поколение активной страницы (0 — хранилище пусто)
+        uint16_t used = 0;          ///< Занято байт активной страницы
+    };
+
+    static constexpr uint16_t PageSize = FLASH_KV_PAGE_SIZE;
+
+    /**
+     * @brief Найти активную страницу и построить индекс ключей (чтение flash, без записи)
+     */
+    void begin();
+
+    /**
+     * @brief Сохранить значение (key 1..254, len <= FLASH_KV_VALUE_MAX)
+     * @return false — предыдущая запись ещё идёт, значение длинное или ключам нет места
+     */
+    bool put(uint8_t key, const void *data, uint8_t len);
+
+    /// Удалить ключ (запись длины 0)
+    bool remove(uint8_t key) { return put(key, nullptr, 0); }
+
+    /**
+     * @brief Прочитать значение (последнее сохранённое, пока новая запись не завершена)
+     * @return Длина значения или -1, если ключа нет; копируется не больше size байт
+     */
+    int get(uint8_t key, void *data, uint8_t size) const;
+
+    /**
+     * @brief Одна операция flash, если есть работа и mayStall (основной цикл)
+     */
+    void poll(bool mayStall);
+
+    /**
+     * @brief Работа есть — следующий проход без сна (режим APP_TICKLESS)
+     */
+    void nextDeadline(WakeDeadline &d) const;
+
+    /// Нет записи в работе
+    bool idle() const { return m_step == Step::Idle; }
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    enum class Step : uint8_t {
+        Idle,
+        Append,       ///< Новая запись в конец активной страницы
+        Retire,       ///< Погасить метку второй страницы перед стиранием
+        Erase,        ///< Стирание второй страницы
+        Copy,         ///< Живые записи индекса m_copy.. на вторую страницу
+        AppendSpare,  ///< Новая запись за ними
+        Header,       ///< Поколение, затем метка второй страницы
+    };
+
+    /// Полуслов: заголовок страницы и страница целиком
+    static constexpr uint16_t HeaderWords = 4;
+    static constexpr uint16_t PageWords = PageSize / 2;
+    /// Самая длинная запись (полуслов)
+    static constexpr uint16_t RecordWordsMax = 2 + (FLASH_KV_VALUE_MAX + 1) / 2;
+
+    static_assert(HeaderWords + (FLASH_KV_MAX_KEYS + 1) * RecordWordsMax <= PageWords,
+                  "KvStore: все ключи и новая запись должны помещаться на страницу");
+
+    static uint16_t recordWords(uint8_t len) { return 2 + (len + 1) / 2; }
+
+    static volatile uint16_t *page(uint8_t n) {
+        return reinterpret_cast<volatile uint16_t *>(_skvstore) + n * PageWords;
+    }
+
+    static uint32_t generation(const volatile uint16_t *p);
+    static uint32_t nextGeneration(uint32_t gen);
+    static bool recordValid(const volatile uint16_t *r, uint16_t room);
+
+    void scan();
+    int8_t find(uint8_t key) const;
+    void nextCopy();
+    bool program(uint16_t value);
+    void fail();
+    void commit();
+
+    uint8_t m_active = 0;
+    bool m_dirty = false;          ///< Хвост журнала не чистый: дописывать нельзя, только перенос
+    uint16_t m_write = 0;          ///< Конец журнала активной страницы (полуслово)
+
+    uint8_t m_keys[FLASH_KV_MAX_KEYS] = {};   ///< 0 — свободно
+    uint16_t m_at[FLASH_KV_MAX_KEYS] = {};    ///< Последняя запись ключа (полуслово страницы)
+
+    Step m_step = Step::Idle;
+    uint16_t m_rec[RecordWordsMax] = {};      ///< Новая запись
+    uint16_t m_recWords = 0;
+    uint8_t m_copy = 0;            ///< Следующий индекс для переноса
+    const volatile uint16_t *m_src = nullptr;
+    uint16_t m_left = 0;           ///< Полуслов текущего копирования
+    uint16_t m_dst = 0;            ///< Куда писать следующее полуслово (полуслово страницы)
+
+    Stats m_stats;
+};
@@ -0,0 +1,67 @@
+#include "Log.hpp"
+
+#if defined LOG_TEXT
+#include "AppContext.hpp"
+
+extern App app;
+#else
+#include "SpscRing.hpp"
+
+/// Границы секции logfmt: GNU ld задаёт их сам (имя секции — идентификатор C),
+/// в прошивке — скрипт компоновки
+extern "C" const char __start_logfmt[];
+#endif
+
+namespace {
+    Log::Stats g_stats;
+
+#if defined LOG_TEXT
+    /// Вывод render() прямо в кольцо передачи UART
+    struct UartSink {
+        UsartDriver<> &uart;
+
+        void text(const char *s, size_t n) { uart.write(reinterpret_cast<const uint8_t *>(s), n); }
+
+        void i32(int32_t v) { uart.write_int(static_cast<int>(v)); }
+
+        void u32(uint32_t v) {
+            char buf[IntFormat::IntBufSize];
+            text(buf, IntFormat::formatUnsigned(v, buf));
+        }
+    };
+#else
+    SpscRing<Log::Record, LOG_RING_SIZE> g_ring;
+#endif
+}
+
+namespace Log {
+    void commit(const char *fmt, Record &r) {
+        ++g_stats.written;
+#if defined LOG_TEXT
+        if (!app.uart) return;
+        UartSink out{*app.uart};
+        render(fmt, r.args, r.len, out);
+        out.text("\r\n", 2);
+#else
+        r.id = static_cast<uint16_t>(fmt - __start_logfmt);
+        if (!g_ring.push(r)) ++g_stats.dropped;
+#endif
+    }
+
+    const Record *front() {
+#if defined LOG_TEXT
+        return nullptr;
+#else
+        return g_ring.front();
+#endif
+    }
+
+    void pop() {
+#if !defined LOG_TEXT
+        Record r;
+        g_ring.pop(r);
+#endif
+    }
+
+    const Stats &stats() { return g_stats; }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "config.h"
+#include "LogFormat.hpp"
+
+/**
+ * @file Log.hpp
+ * @brief Отложенный журнал: в месте вызова — номер формата и сырые аргументы
+ *
+ * LOG("Temperature: %d.%u C", whole, frac) не форматирует текст: строка формата
+ * лежит в секции logfmt (в прошивке она есть только в ELF и во flash не попадает),
+ * номер записи — её смещение в секции. В кольцо Log кладутся номер и аргументы
+ * (несколько сохранений, без деления и без ожидания UART), Protocol отправляет
+ * записи кадрами ProtoCommand::Log, а текст собирает хост по ELF прошивки.
+ * Формат сверяется с аргументами при компиляции (Log::Format).
+ *
+ * Писатель один — основной цикл (из прерываний LOG() не вызывается).
+ * LOG_TEXT возвращает немедленный вывод строки в UART.
+ */
+namespace Log {
+    /**
+     * @brief Запись журнала в кольце
+     */
+    struct Record {
+        uint16_t id = 0;                  ///< Смещение строки формата в секции logfmt
+        uint8_t len = 0;                  ///< Занято байт в args
+        uint8_t args[LOG_ARGS_MAX];       ///< Аргументы подряд (см. LogFormat.hpp)
+    };
+
+    struct Stats {
+        uint32_t written = 0;   ///< Записей принято
+        uint32_t dropped = 0;   ///< Пропущено: кольцо полно
+    };
+
+    /// Дописать номер и отдать запись в кольцо (или сразу в UART при LOG_TEXT)
+    void commit(const char *fmt, Record &r);
+
+    /// Самая старая не отправленная запись; nullptr — кольцо пусто (только Protocol)
+    const Record *front();
+
+    /// Убрать отправленную запись (только Protocol)
+    void pop();
+
+    const Stats &stats();
+
+    inline void put(Record &r, uint32_t v) {
+        if (r.len + sizeof(uint32_t) > sizeof(r.args)) return;
+        r.args[r.len++] = static_cast<uint8_t>(v);
+        r.args[r.len++] = static_cast<uint8_t>(v >> 8);
+        r.args[r.len++] = static_cast<uint8_t>(v >> 16);
+        r.args[r.len++] = static_cast<uint8_t>(v >> 24);
+    }
+
+    /**
+     * @brief Строка обрезается по месту, оставшемуся в записи
+     * @param reserve Байт, оставляемых аргументам после этой строки
+     */
+    inline void put(Record &r, const char *s, size_t reserve = 0) {
+        if (r.len + reserve >= sizeof(r.args)) return;   // нет места даже под байт длины
+        const size_t room = sizeof(r.args) - reserve - r.len - 1;
+        size_t n = 0;
+        while (n < room && s[n]) ++n;
+        r.args[r.len++] = static_cast<uint8_t>(n);
+        for (size_t i = 0; i < n; ++i) r.args[r.len++] = static_cast<uint8_t>(s[i]);
+    }
+
+    template<typename T>
+    void putArg(Record &r, const T &v, size_t reserve) {
+        if constexpr (argKind<T>() == 's') put(r, static_cast<const char *>(v), reserve);
+        else put(r, static_cast<uint32_t>(v));
+    }
+
+    template<typename... Args>
+    void write(Format<std::type_identity_t<Args>...> fmt, const Args &... args) {
+        Record r;
+        // Каждой строке — не больше, чем оставляет минимум следующим аргументам (argBytes)
+        [[maybe_unused]] size_t reserve = (argBytes<Args>() + ... + 0);
+        ((reserve -= argBytes<Args>(), putArg(r, args, reserve)), ...);
+        commit(fmt.text(), r);
+    }
+}
+
+#if defined LOG_TEXT
+#define LOG_FORMAT_SECTION
+#else
+#define LOG_FORMAT_SECTION __attribute__((section("logfmt"), used))
+#endif
+
+/**
+ * @brief Записать строку журнала (формат — строковый литерал, без перевода строки)
+ */
+#define LOG(fmt, ...)                                                           \
+    do {                                                                        \
+        LOG_FORMAT_SECTION static const char log_format_[] = fmt;               \
+        ::Log::write({fmt, log_format_} __VA_OPT__(,) __VA_ARGS__);             \
+    } while (0)
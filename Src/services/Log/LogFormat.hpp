@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "config.h"
+
+/**
+ * @file LogFormat.hpp
+ * @brief Формат записей журнала: проверка при компиляции и восстановление текста
+ *
+ * Строка формата понимает %d (целое со знаком), %u (без знака), %s (строка) и %%.
+ * Аргументы записи идут подряд: целое — 4 байта little-endian, строка — байт длины
+ * и символы без нуля. По одной строке формата и байтам аргументов текст собирает
+ * render() — и прошивка (LOG_TEXT), и декодер на хосте (Host/client/LogDecoder.hpp).
+ */
+namespace Log {
+    /// Вызов из consteval-конструктора Format — ошибка компиляции с этим текстом
+    inline void formatError(const char *) {}
+
+    template<typename T>
+    consteval char argKind() {
+        using D = std::decay_t<T>;
+        if constexpr (std::is_pointer_v<D> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<D>>, char>) {
+            return 's';
+        } else {
+            static_assert(std::is_integral_v<D> || std::is_enum_v<D>, "LOG: аргумент — целое или строка");
+            static_assert(sizeof(D) <= 4, "LOG: целое шире 32 бит");
+            return 'i';
+        }
+    }
+
+    /// Минимум байт аргумента в записи: целое — 4, строка — байт длины и LOG_STR_MIN символов
+    template<typename T>
+    consteval size_t argBytes() {
+        return argKind<T>() == 's' ? 1 + LOG_STR_MIN : 4;
+    }
+
+    /**
+     * @brief Строка формата, сверенная с типами аргументов при компиляции
+     *
+     * Число полей, их вид (%d/%u — целое, %s — строка) и размер аргументов в записи
+     * (строке — не меньше LOG_STR_MIN символов) проверяются consteval-конструктором;
+     * text — та же строка, но уже размещённая в секции logfmt (см. LOG()).
+     */
+    template<typename... Args>
+    class Format {
+    public:
+        template<size_t N>
+        consteval Format(const char (&fmt)[N], const char *text) : m_text(text) {
+            constexpr char kinds[] = {argKind<Args>()..., 0};
+            size_t arg = 0;
+            size_t bytes = 0;
+            for (size_t i = 0; i + 1 < N; ++i) {
+                if (fmt[i] != '%') continue;
+                const char c = fmt[++i];
+                if (c == '%') continue;
+                if (c != 'd' && c != 'u' && c != 's') formatError("LOG: поддерживаются только %d, %u, %s и %%");
+                if (arg == sizeof...(Args)) formatError("LOG: полей в формате больше, чем аргументов");
+                if ((c == 's') != (kinds[arg] == 's')) formatError("LOG: %s — строка, %d/%u — целое");
+                bytes += c == 's' ? 1 + LOG_STR_MIN : 4;
+                ++arg;
+            }
+            if (arg != sizeof...(Args)) formatError("LOG: аргументов больше, чем полей в формате");
+            if (bytes > LOG_ARGS_MAX) formatError("LOG: аргументы не помещаются в запись (LOG_ARGS_MAX)");
+        }
+
+        const char *text() const { return m_text; }
+
+    private:
+        const char *m_text;
+    };
+
+    /**
+     * @brief Восстановить текст записи
+     * @tparam Sink text(const char *, size_t), i32(int32_t), u32(uint32_t)
+     * @note Недостающие аргументы (обрезанная запись) выводятся как 0 и пустая строка
+     */
+    template<typename Sink>
+    void render(const char *fmt, const uint8_t *args, size_t len, Sink &out) {
+        size_t pos = 0;
+        const char *run = fmt;
+        for (; *fmt; ++fmt) {
+            if (*fmt != '%') continue;
+            out.text(run, static_cast<size_t>(fmt - run));
+            const char c = *++fmt;
+            run = fmt + 1;
+            if (c == 0) {
+                run = fmt;
+                break;
+            }
+            if (c == '%') {
+                out.text("%", 1);
+            } else if (c == 's') {
+                size_t n = pos < len ? args[pos++] : 0;
+                if (n > len - pos) n = len - pos;
+                out.text(reinterpret_cast<const char *>(args + pos), n);
+                pos += n;
+            } else {
+                uint32_t v = 0;
+                if (pos + 4 <= len) {
+                    v = args[pos] | (args[pos + 1] << 8) | (args[pos + 2] << 16) | (static_cast<uint32_t>(args[pos + 3]) << 24);
+                }
+                pos += 4;
+                if (c == 'd') out.i32(static_cast<int32_t>(v));
+                else out.u32(v);
+            }
+        }
+        out.text(run, static_cast<size_t>(fmt - run));
+    }
+}
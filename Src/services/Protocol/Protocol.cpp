@@ -0,0 +1,234 @@
+#include "Protocol.hpp"
+#include "RccDriver.hpp"
+#include "fw_info.hpp"
+
+using namespace RccDriver;
+
+Protocol::Protocol(UsartDriver<> &uart, Controller &ctrl, Telemetry &telemetry, EventQueue &queue,
+                   TimerWheel &timers) :
+        m_uart(uart),
+        m_ctrl(ctrl),
+        m_telemetry(telemetry),
+        m_queue(queue),
+        m_timers(timers),
+        m_releaseTimer(timers.create({EventType::None, 2})) {}
+
+void Protocol::poll() {
+    // Байт читается, только если в кольце передачи хватит места на ответ:
+    // иначе запросы ждут в кольце приема, пока линия не отдаст предыдущие ответы
+    while (m_uart.tx_free() >= MaxEncoded) {
+        const int byte = m_uart.read_byte();
+        if (byte < 0) break;
+        feed(static_cast<uint8_t>(byte));
+    }
+
+    drainLog();
+    m_telemetry.poll();
+    drainTelemetry();
+}
+
+void Protocol::nextDeadline(WakeDeadline &d) const {
+    m_telemetry.nextDeadline(d);
+}
+
+void Protocol::feed(uint8_t byte) {
+    if (!m_inFrame) {
+        // Закрывающий ноль испорченного кадра — начало следующего, если дальше похоже на кадр
+        const bool reopen = m_afterError && looksLikeCode(byte);
+        m_afterError = false;
+        if (byte == FrameCodec::Delimiter || reopen) {
+            m_decoder.reset();
+            m_inFrame = true;
+            if (reopen) m_decoder.feed(byte);
+        } else {
+            handleKey(byte);
+        }
+        return;
+    }
+
+    switch (m_decoder.feed(byte)) {
+        case FrameCodec::Decoder<ProtoMaxFrame>::Result::Frame:
+            ++m_stats.frames;
+            m_inFrame = false;
+            handleFrame(m_decoder.data(), m_decoder.size());
+            break;
+        case FrameCodec::Decoder<ProtoMaxFrame>::Result::Error:
+            // Вне кадра снова консоль; следующий байт решит, не начало ли это кадра
+            ++m_stats.errors;
+            m_inFrame = false;
+            m_afterError = true;
+            break;
+        case FrameCodec::Decoder<ProtoMaxFrame>::Result::None:
+            break;
+    }
+}
+
+/** Клавиши '1'..'4' вне кадров: press сразу, release — через UART_BUTTON_PRESS_DURATION_MS. */
+void Protocol::handleKey(uint8_t key) {
+    if (key < '1' || key > '4') return;
+
+    static constexpr EventType Buttons[] = {
+            EventType::ButtonS1, EventType::ButtonS2, EventType::ButtonS3, EventType::ButtonS4,
+    };
+    const EventType type = Buttons[key - '1'];
+
+    m_queue.push({type, 0});
+
+    // Планируем release (или заменяем предыдущий отложенный)
+    m_timers.setEvent(m_releaseTimer, {type, 2});
+    m_timers.arm(m_releaseTimer, UART_BUTTON_PRESS_DURATION_MS);
+}
+
+void Protocol::handleFrame(const uint8_t *data, size_t len) {
+    if (len < 2) {
+        ++m_stats.errors;
+        return;
+    }
+
+    const auto cmd = static_cast<ProtoCommand>(data[0]);
+    ProtoReader args(data + 2, len - 2);
+
+    uint8_t out[ProtoMaxPayload];
+    ProtoWriter reply(out, sizeof(out));
+    reply.u8(data[0] | ProtoResponseFlag);
+    reply.u8(data[1]);
+    reply.u8(static_cast<uint8_t>(ProtoStatus::Ok));
+
+    ProtoStatus status = ProtoStatus::Ok;
+    switch (cmd) {
+        case ProtoCommand::GetInfo: {
+            if (args.remaining() != 0) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            // Тег укорачивается, чтобы кадр поместился целиком
+            constexpr size_t CommitMax = sizeof(fw_info.commit);
+            constexpr size_t TagMax = ProtoMaxPayload - ProtoResponseHeader - 2 - CommitMax;
+            reply.str(fw_info.tag, TagMax < sizeof(fw_info.tag) ? TagMax : sizeof(fw_info.tag));
+            reply.str(fw_info.commit, CommitMax);
+            break;
+        }
+
+        case ProtoCommand::GetSetpoint:
+            if (args.remaining() != 0) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            reply.i16(static_cast<int16_t>(m_ctrl.getSetpoint()));
+            break;
+
+        case ProtoCommand::SetSetpoint: {
+            if (args.remaining() != 2) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            const int value = args.i16();
+            if (value < Controller::SetpointMin || value > Controller::SetpointMax) {
+                status = ProtoStatus::BadValue;
+            } else {
+                m_ctrl.setSetpoint(value);
+            }
+            reply.i16(static_cast<int16_t>(m_ctrl.getSetpoint()));
+            break;
+        }
+
+        case ProtoCommand::GetPid:
+            if (args.remaining() != 0) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            reply.i32(m_ctrl.getPid().kp());
+            reply.i32(m_ctrl.getPid().ki());
+            reply.i32(m_ctrl.getPid().kd());
+            break;
+
+        case ProtoCommand::SetPid: {
+            if (args.remaining() != 12) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            const int32_t kp = args.i32();
+            const int32_t ki = args.i32();
+            const int32_t kd = args.i32();
+            if (kp < 0 || ki < 0 || kd < 0) {
+                status = ProtoStatus::BadValue;
+            } else {
+                m_ctrl.setPidGains(kp, ki, kd);
+            }
+            break;
+        }
+
+        case ProtoCommand::Subscribe: {
+            if (args.remaining() != 2) {
+                status = ProtoStatus::BadLength;
+                break;
+            }
+            const uint16_t period = args.u16();
+            if (period != 0 && period < PROTOCOL_TELEMETRY_MIN_PERIOD_MS) {
+                status = ProtoStatus::BadValue;
+                break;
+            }
+            m_telemetry.setPeriod(period);
+            break;
+        }
+
+        default:
+            status = ProtoStatus::UnknownCommand;
+            break;
+    }
+
+    // При ошибке ответ — только заголовок со статусом
+    out[2] = static_cast<uint8_t>(status);
+    send(out, status == ProtoStatus::Ok ? reply.size() : ProtoResponseHeader);
+}
+
+/** Отправить записи журнала, пока в кольце передачи есть место на кадр. */
+void Protocol::drainLog() {
+    while (const Log::Record *r = Log::front()) {
+        if (m_uart.tx_free() < MaxEncoded) return;
+
+        uint8_t out[ProtoMaxPayload];
+        ProtoWriter frame(out, sizeof(out));
+        frame.u8(static_cast<uint8_t>(ProtoCommand::Log));
+        frame.u16(r->id);
+        for (uint8_t i = 0; i < r->len; ++i) frame.u8(r->args[i]);
+        send(out, frame.size());
+        Log::pop();
+    }
+}
+
+/** Отправить записи телеметрии, пока в кольце передачи есть место на кадр. */
+void Protocol::drainTelemetry() {
+    while (const Telemetry::Record *r = m_telemetry.front()) {
+        if (m_uart.tx_free() < MaxEncoded) return;
+
+        uint8_t out[ProtoMaxPayload];
+        ProtoWriter frame(out, sizeof(out));
+        frame.u8(static_cast<uint8_t>(ProtoCommand::Telemetry));
+        frame.u16(r->seq);
+        frame.u32(r->ms);
+        frame.i16(r->current);
+        frame.i16(r->setpoint);
+        frame.i16(r->error);
+        frame.i32(r->p);
+        frame.i32(r->i);
+        frame.i32(r->d);
+        frame.i16(r->output);
+        frame.u8(r->state);
+        send(out, frame.size());
+        m_telemetry.pop();
+    }
+}
+
+bool Protocol::send(const uint8_t *payload, size_t len) {
+    uint8_t encoded[MaxEncoded];
+    const size_t n = FrameCodec::encode(payload, len, encoded, sizeof(encoded));
+
+    // Половина кадра в линии хуже, чем никакого
+    if (n == 0 || m_uart.tx_free() < n) {
+        ++m_stats.txDropped;
+        return false;
+    }
+    m_uart.write(encoded, n);
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "UsartDriver.hpp"
+#include "Controller.hpp"
+#include "TimerWheel.hpp"
+#include "WakeDeadline.hpp"
+#include "Telemetry.hpp"
+#include "Log.hpp"
+#include "ProtocolDefs.hpp"
+
+/**
+ * @brief Командный протокол по USART1: кадры FrameCodec (COBS + CRC-16) и клавиши '1'..'4'
+ *
+ * Вне кадра линия остаётся консолью: '1'..'4' — нажатия кнопок (press сразу,
+ * release через UART_BUTTON_PRESS_DURATION_MS), прочие байты игнорируются.
+ * 0x00 открывает кадр, следующий 0x00 его закрывает. После испорченного кадра
+ * линия снова консоль; закрывающий ноль открывает следующий кадр, только если
+ * за ним идёт правдоподобный код COBS (не клавиша и не длиннее кадра): так поток
+ * кадров не теряет синхронизацию из-за одного оборванного кадра, а случайный
+ * 0x00 в линии не переводит консоль в режим кадров.
+ *
+ * poll() забирает байты прямо из кольца приема UsartDriver по одному, каждый
+ * декодируется и учитывается в CRC один раз (работа на байт постоянна),
+ * память не выделяется. Ответ кодируется на стеке и уходит в кольцо передачи
+ * целиком: пока в нём нет места на самый длинный кадр, новые байты не читаются
+ * (запросы ждут в кольце приема), так что основной цикл не ждёт линию, а ответы
+ * не теряются. Записи Telemetry и Log уходят из своих колец, когда в кольце передачи
+ * есть место на кадр, и ждут там, пока его нет.
+ */
+class Protocol {
+public:
+    /**
+     * @brief Счётчики протокола
+     */
+    struct Stats {
+        uint32_t frames = 0;      ///< Принято целых кадров
+        uint32_t errors = 0;      ///< Отброшено испорченных кадров (CRC, COBS, длина)
+        uint32_t txDropped = 0;   ///< Ответов, не поместившихся в кольцо передачи
+    };
+
+    Protocol(UsartDriver<> &uart, Controller &ctrl, Telemetry &telemetry, EventQueue &queue, TimerWheel &timers);
+
+    /**
+     * @brief Разобрать принятые байты, отправить журнал и телеметрию по подписке (этап Uart app_loop).
+     */
+    void poll();
+
+    /**
+     * @brief Сообщить срок следующего снимка телеметрии (сон в режиме APP_TICKLESS).
+     */
+    void nextDeadline(WakeDeadline &d) const;
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    /// Самый длинный кадр в линии
+    static constexpr size_t MaxEncoded = FrameCodec::encodedSize(ProtoMaxPayload);
+    static_assert(MaxEncoded <= UsartDriver<>::TxCapacity, "Protocol: кадр не помещается в кольцо передачи");
+    static_assert(3 + LOG_ARGS_MAX <= ProtoMaxPayload, "Protocol: запись журнала не помещается в кадр");
+
+    void handleKey(uint8_t key);
+    void handleFrame(const uint8_t *data, size_t len);
+    void drainTelemetry();
+    void drainLog();
+    bool send(const uint8_t *payload, size_t len);
+
+    /// Принять байт вне кадра или внутри него
+    void feed(uint8_t byte);
+
+    /// Байт после испорченного кадра может быть первым кодом COBS следующего
+    static bool looksLikeCode(uint8_t byte) {
+        return byte != FrameCodec::Delimiter && byte <= ProtoMaxFrame + 1 && (byte < '1' || byte > '4');
+    }
+
+    UsartDriver<> &m_uart;
+    Controller &m_ctrl;
+    Telemetry &m_telemetry;
+    EventQueue &m_queue;
+    TimerWheel &m_timers;
+    TimerWheel::Id m_releaseTimer;          ///< Отложенный release для нажатий с клавиатуры
+
+    FrameCodec::Decoder<ProtoMaxFrame> m_decoder;
+    bool m_inFrame = false;                 ///< Между открывающим и закрывающим 0x00
+    bool m_afterError = false;              ///< Предыдущий байт закрыл испорченный кадр
+
+    Stats m_stats;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "config.h"
+#include "FrameCodec.hpp"
+
+/**
+ * @file ProtocolDefs.hpp
+ * @brief Команды и формат кадров протокола USART1 (общие для прошивки и клиента на хосте)
+ *
+ * Кадр после декодирования FrameCodec (CRC уже проверена и отрезана):
+ *   запрос   — [команда][seq][аргументы...]
+ *   ответ    — [команда | ProtoResponseFlag][seq][ProtoStatus][данные...]
+ *   телеметрия — [ProtoCommand::Telemetry][данные...], без запроса
+ *   журнал   — [ProtoCommand::Log][номер формата u16][аргументы...], без запроса
+ * seq запроса возвращается в ответе, по нему клиент сопоставляет ответы.
+ * Многобайтовые поля — little-endian.
+ */
+
+enum class ProtoCommand : uint8_t {
+    GetInfo = 0x01,       ///< -> [длина тега][тег][длина коммита][коммит]
+    GetSetpoint = 0x02,   ///< -> [уставка i16, десятые °C]
+    SetSetpoint = 0x03,   ///< [уставка i16] -> [уставка i16]
+    GetPid = 0x04,        ///< -> [Kp i32][Ki i32][Kd i32] (×PIDInt::SCALE)
+    SetPid = 0x05,        ///< [Kp i32][Ki i32][Kd i32] -> ничего
+    Subscribe = 0x06,     ///< [период u16, мс; 0 — отписаться] -> ничего
+
+    /// Кадр подписки: [номер u16][мс u32][температура i16][уставка i16][ошибка i16]
+    /// [P i32][I i32][D i32][мощность i16][состояние u8] (Telemetry::Record)
+    Telemetry = 0x40,
+
+    /// Запись журнала: [номер формата u16][аргументы Log::Record] (текст собирает хост)
+    Log = 0x41,
+};
+
+/// Бит ответа в поле команды
+static constexpr uint8_t ProtoResponseFlag = 0x80;
+
+enum class ProtoStatus : uint8_t {
+    Ok,
+    UnknownCommand,   ///< Команда не поддерживается
+    BadLength,        ///< Длина аргументов не совпадает с ожидаемой
+    BadValue,         ///< Аргумент вне допустимого диапазона
+};
+
+/// Наибольший кадр после декодирования, с CRC
+static constexpr size_t ProtoMaxFrame = PROTOCOL_MAX_FRAME;
+
+/// Наибольший кадр без CRC
+static constexpr size_t ProtoMaxPayload = ProtoMaxFrame - FrameCodec::CrcSize;
+
+/// Заголовок ответа: команда, seq, статус
+static constexpr size_t ProtoResponseHeader = 3;
+
+/**
+ * @brief Запись полей кадра little-endian в буфер фиксированного размера
+ * @note При переполнении запись прекращается и ok() возвращает false
+ */
+class ProtoWriter {
+public:
+    ProtoWriter(uint8_t *buf, size_t cap) : m_buf(buf), m_cap(cap) {}
+
+    void u8(uint8_t v) {
+        if (m_len < m_cap) m_buf[m_len++] = v;
+        else m_ok = false;
+    }
+
+    void u16(uint16_t v) {
+        u8(static_cast<uint8_t>(v));
+        u8(static_cast<uint8_t>(v >> 8));
+    }
+
+    void u32(uint32_t v) {
+        u16(static_cast<uint16_t>(v));
+        u16(static_cast<uint16_t>(v >> 16));
+    }
+
+    void i16(int16_t v) { u16(static_cast<uint16_t>(v)); }
+
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+
+    /// Строка с байтом длины впереди, не длиннее max символов
+    void str(const char *s, size_t max) {
+        size_t n = 0;
+        while (n < max && s[n]) ++n;
+        u8(static_cast<uint8_t>(n));
+        for (size_t i = 0; i < n; ++i) u8(static_cast<uint8_t>(s[i]));
+    }
+
+    size_t size() const { return m_len; }
+
+    bool ok() const { return m_ok; }
+
+private:
+    uint8_t *m_buf;
+    size_t m_cap;
+    size_t m_len = 0;
+    bool m_ok = true;
+};
+
+/**
+ * @brief Чтение полей кадра little-endian
+ * @note Чтение за концом кадра даёт 0 и ok() == false
+ */
+class ProtoReader {
+public:
+    ProtoReader(const uint8_t *buf, size_t len) : m_buf(buf), m_len(len) {}
+
+    uint8_t u8() {
+        if (m_pos < m_len) return m_buf[m_pos++];
+        m_ok = false;
+        return 0;
+    }
+
+    uint16_t u16() {
+        const uint16_t lo = u8();
+        return static_cast<uint16_t>(lo | (u8() << 8));
+    }
+
+    uint32_t u32() {
+        const uint32_t lo = u16();
+        return lo | (static_cast<uint32_t>(u16()) << 16);
+    }
+
+    int16_t i16() { return static_cast<int16_t>(u16()); }
+
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+
+    size_t remaining() const { return m_len - m_pos; }
+
+    bool ok() const { return m_ok; }
+
+private:
+    const uint8_t *m_buf;
+    size_t m_len;
+    size_t m_pos = 0;
+    bool m_ok = true;
+};
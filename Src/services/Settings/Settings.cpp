@@ -0,0 +1,315 @@
+#include "Settings.hpp"
+#include "RccDriver.hpp"
+#include "Crc16.hpp"
+#include "Log.hpp"
+
+using namespace RccDriver;
+
+volatile bool Settings::s_done = false;
+volatile bool Settings::s_ok = false;
+
+namespace {
+    /// Версия формата записи (первый байт слота)
+    constexpr uint8_t RecordVersion = 1;
+    /// Номер в заголовке пустого слота: EEPROM с завода и после стирания — 0xFF
+    constexpr uint32_t NoEntry = 0xFFFF'FFFF;
+
+    /// Ключ и размер значений в KvStore: уставка, Kp, Ki, Kd (little-endian)
+    constexpr uint8_t FlashKey = 1;
+    constexpr uint8_t FlashSize = 14;
+
+    void put16(uint8_t *p, uint16_t v) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+    }
+
+    void put32(uint8_t *p, uint32_t v) {
+        put16(p, static_cast<uint16_t>(v));
+        put16(p + 2, static_cast<uint16_t>(v >> 16));
+    }
+
+    uint16_t get16(const uint8_t *p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t get32(const uint8_t *p) {
+        return get16(p) | (static_cast<uint32_t>(get16(p + 2)) << 16);
+    }
+}
+
+void Settings::onDone(bool ok) {
+    s_ok = ok;
+    s_done = true;
+}
+
+Settings::Values Settings::snapshot() const {
+    const PIDInt &pid = m_ctrl.getPid();
+    return {static_cast<int16_t>(m_ctrl.getSetpoint()), pid.kp(), pid.ki(), pid.kd()};
+}
+
+void Settings::apply(const Values &v) {
+    m_ctrl.setPidGains(v.kp, v.ki, v.kd);
+    m_ctrl.setSetpoint(v.setpoint);
+}
+
+void Settings::begin() {
+    m_state = State::Loading;
+    m_step = Step::LoadHeader;
+    m_scan = m_lo = 0;
+    m_hi = Slots;
+    m_candidate = 0;
+    m_best[0] = m_best[1] = Candidate{};
+    m_pending = m_saved = snapshot();
+    submit();
+}
+
+void Settings::poll() {
+    const uint32_t now = GetMsTicks();
+
+    if (m_inFlight) {
+        if (!s_done) return;
+        m_inFlight = false;
+        complete(s_ok, now);
+    }
+
+    if (m_retry) {
+        if (static_cast<int32_t>(now - m_retryAt) < 0) return;
+        m_retry = false;
+        submit();
+        return;
+    }
+
+    if (m_step != Step::Idle || (m_state != State::Ready && m_state != State::Flash)) return;
+
+    // Серия изменений — одна запись после паузы SETTINGS_SAVE_DELAY_MS
+    const Values v = snapshot();
+    if (v != m_pending) {
+        m_pending = v;
+        m_changedAt = now;
+    }
+    if (m_pending == m_saved || now - m_changedAt < SETTINGS_SAVE_DELAY_MS) return;
+
+    if (m_state == State::Flash) saveFlash();
+    else startSave();
+}
+
+void Settings::nextDeadline(WakeDeadline &d) const {
+    // Транзакция могла завершиться после poll() этого прохода — не спать, пока её не разобрали
+    if (m_inFlight) d.at(GetMsTicks());
+    else if (m_retry) d.at(m_retryAt);
+    else if ((m_state == State::Ready || m_state == State::Flash) && m_step == Step::Idle && m_pending != m_saved)
+        d.at(m_changedAt + SETTINGS_SAVE_DELAY_MS);
+}
+
+// Одна транзакция текущего шага: адрес ячейки, затем чтение или данные
+
+void Settings::submit() {
+    uint16_t address = 0;
+    uint16_t txLen = 2;
+    uint16_t rxLen = 0;
+
+    switch (m_step) {
+        case Step::LoadHeader:
+            address = slotAddress(m_scan);
+            rxLen = HeaderSize;
+            break;
+        case Step::LoadRecord:
+            address = slotAddress(m_best[m_candidate].slot);
+            rxLen = Page;
+            break;
+        case Step::WriteRecord:
+            address = slotAddress(m_next);
+            txLen += Page;
+            break;
+        case Step::Idle:
+            return;
+    }
+
+    m_buf[0] = static_cast<uint8_t>(address >> 8);
+    m_buf[1] = static_cast<uint8_t>(address);
+    s_done = false;
+
+    const TwiDriver::Request r{SETTINGS_EEPROM_ADDRESS, m_buf, txLen, rxLen ? m_buf + 2 : nullptr, rxLen, onDone};
+    if (TwiDriver::submit(r)) {
+        m_inFlight = true;
+    } else {
+        // Очередь занята другими транзакциями — попробовать через 1 мс
+        m_retry = true;
+        m_retryAt = GetMsTicks() + 1;
+    }
+}
+
+void Settings::complete(bool ok, uint32_t now) {
+    if (!ok) {
+        // NACK: EEPROM ещё пишет предыдущую страницу (или её нет) — повтор через 1 мс
+        if (++m_attempts < SETTINGS_EEPROM_RETRIES) {
+            m_retry = true;
+            m_retryAt = now + 1;
+            return;
+        }
+        m_attempts = 0;
+        if (m_state == State::Loading) {
+            LOG("Settings: EEPROM not responding");
+            loadFlash();
+        } else {
+            ++m_stats.failures;   // m_saved не изменился — запись повторится после следующей паузы
+            m_changedAt = now;
+        }
+        m_step = Step::Idle;
+        return;
+    }
+    m_attempts = 0;
+
+    switch (m_step) {
+        case Step::LoadHeader:
+            if (searchStep()) m_step = Step::LoadRecord;
+            break;
+
+        case Step::LoadRecord: {
+            Values v;
+            if (parseRecord(v, m_best[m_candidate].seq)) {
+                m_stats.restored = true;
+                apply(v);
+                finishLoad();
+            } else if (m_candidate == 0) {
+                m_candidate = 1;   // Последняя запись оборвана — берём предыдущий слот
+            } else {
+                finishLoad();
+            }
+            break;
+        }
+
+        case Step::WriteRecord:
+            m_saved = m_writing;
+            m_stats.slot = m_next;
+            ++m_stats.saves;
+            ++m_stats.seq;
+            m_step = Step::Idle;
+            break;
+
+        case Step::Idle:
+            break;
+    }
+
+    if (m_step != Step::Idle) submit();
+}
+
+// Двоичный поиск последней записи по заголовкам. Слоты пишутся по кругу, номер
+// растёт на 1 с каждой записью: от слота 0 номера не меньше его номера идут подряд
+// до последней записи, дальше — старые записи прошлого оборота или пустые слоты.
+// Оборванная запись лежит сразу за последней: попадёт она в поиск или нет,
+// её CRC не сойдётся, и будет взят предыдущий слот. Пустой заголовок слота 0
+// значит пустую EEPROM, только если пуст и последний слот: иначе оборвана запись,
+// перешедшая с последнего слота на слот 0, и последняя запись — в слоте Slots - 1.
+
+bool Settings::searchStep() {
+    const uint8_t *h = m_buf + 2;
+    uint32_t seq = get32(h + 4);
+    if (h[0] != RecordVersion || seq == NoEntry) seq = 0;
+
+    if (m_scan == 0) {
+        m_first = seq;
+        if (seq == 0) {   // Слот 0 пуст или стёрт обрывом — смотрим последний слот
+            m_scan = Slots - 1;
+            return false;
+        }
+        m_best[0] = {seq, 0};
+    } else if (m_first == 0) {
+        if (seq == 0) {   // Пустая EEPROM: первая запись идёт в слот 0
+            finishLoad();
+            return false;
+        }
+        m_lo = m_scan;
+        m_best[0] = {seq, m_scan};
+    } else if (seq >= m_first) {
+        m_lo = m_scan;
+        m_best[0] = {seq, m_scan};
+    } else {
+        m_hi = m_scan;
+    }
+    if (m_hi - m_lo > 1) {
+        m_scan = static_cast<uint16_t>((m_lo + m_hi) / 2);
+        return false;
+    }
+
+    m_best[1] = {0, static_cast<uint16_t>((m_lo + Slots - 1) % Slots)};
+    m_candidate = 0;
+    return true;
+}
+
+bool Settings::parseRecord(Values &v, uint32_t &seq) const {
+    const uint8_t *r = m_buf + 2;
+    if (Crc16::compute(r, Page) != 0 || r[0] != RecordVersion) return false;
+    seq = get32(r + 4);
+    if (seq == 0 || seq == NoEntry) return false;
+
+    v.setpoint = static_cast<int16_t>(get16(r + 2));
+    v.kp = static_cast<int32_t>(get32(r + 8));
+    v.ki = static_cast<int32_t>(get32(r + 12));
+    v.kd = static_cast<int32_t>(get32(r + 16));
+    return true;
+}
+
+// Загрузка окончена: следующая запись идёт в слот за восстановленной
+// (оборванную запись она перезаписывает) — номера по кругу остаются подряд
+
+void Settings::finishLoad() {
+    const Candidate &c = m_stats.restored ? m_best[m_candidate] : m_best[0];
+    m_stats.seq = c.seq;
+    m_stats.slot = c.seq ? c.slot : Slots - 1;
+    m_pending = m_saved = snapshot();
+    m_state = State::Ready;
+    m_step = Step::Idle;
+    if (m_stats.restored) LOG("Settings: restored record %u, setpoint %d", m_stats.seq, m_saved.setpoint);
+}
+
+void Settings::startSave() {
+    m_writing = m_pending;
+    m_next = static_cast<uint16_t>((m_stats.slot + 1) % Slots);
+    const uint32_t seq = m_stats.seq + 1;
+
+    uint8_t *r = m_buf + 2;
+    for (uint16_t i = 0; i < Page; ++i) r[i] = 0xFF;
+    r[0] = RecordVersion;
+    r[1] = 0;
+    put16(r + 2, static_cast<uint16_t>(m_writing.setpoint));
+    put32(r + 4, seq);
+    put32(r + 8, static_cast<uint32_t>(m_writing.kp));
+    put32(r + 12, static_cast<uint32_t>(m_writing.ki));
+    put32(r + 16, static_cast<uint32_t>(m_writing.kd));
+    const uint16_t crc = Crc16::compute(r, Page - 2);
+    r[Page - 2] = static_cast<uint8_t>(crc >> 8);
+    r[Page - 1] = static_cast<uint8_t>(crc);
+
+    m_step = Step::WriteRecord;
+    submit();
+}
+
+// Без EEPROM: одна запись KvStore, её перенос и защиту от обрыва ведёт сам KvStore
+
+void Settings::loadFlash() {
+    m_state = m_kv ? State::Flash : State::Absent;
+    if (!m_kv) return;
+
+    uint8_t r[FlashSize];
+    if (m_kv->get(FlashKey, r, sizeof(r)) == FlashSize) {
+        apply({static_cast<int16_t>(get16(r)), static_cast<int32_t>(get32(r + 2)),
+               static_cast<int32_t>(get32(r + 6)), static_cast<int32_t>(get32(r + 10))});
+        m_stats.restored = true;
+        LOG("Settings: restored from flash, setpoint %d", m_ctrl.getSetpoint());
+    }
+    m_pending = m_saved = snapshot();
+}
+
+void Settings::saveFlash() {
+    uint8_t r[FlashSize];
+    put16(r, static_cast<uint16_t>(m_pending.setpoint));
+    put32(r + 2, static_cast<uint32_t>(m_pending.kp));
+    put32(r + 6, static_cast<uint32_t>(m_pending.ki));
+    put32(r + 10, static_cast<uint32_t>(m_pending.kd));
+
+    // KvStore занят прошлой записью — попробовать на следующем проходе
+    if (!m_kv->put(FlashKey, r, sizeof(r))) return;
+    m_saved = m_pending;
+    ++m_stats.saves;
+}
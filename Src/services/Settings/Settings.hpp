@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "Controller.hpp"
+#include "KvStore.hpp"
+#include "TwiDriver.hpp"
+#include "WakeDeadline.hpp"
+
+/**
+ * @brief Уставка и коэффициенты PID в EEPROM 24Cxx: журнал записей по кругу страниц
+ *
+ * Память делится на слоты данных по одной странице. Сохранение пишет запись
+ * в следующий по кругу слот (одна страничная запись через очередь TwiDriver):
+ * за оборот каждая страница проходит ровно один цикл записи, а запись,
+ * оборванная сбросом, не портит предыдущую. Отдельного индекса нет — ячейки
+ * номеров на его страницах перезаписывались бы чаще слотов.
+ *
+ * Запись (страница): версия, уставка, номер, Kp/Ki/Kd, CRC-16 в конце страницы.
+ * При загрузке последняя запись ищется двоичным поиском по заголовкам слотов
+ * (HeaderSize байт за транзакцию, log2(Slots) + 1 чтений) и читается один слот;
+ * если его CRC не сходится (сброс во время записи), берётся предыдущий слот.
+ *
+ * Всё асинхронно: poll() основного цикла ставит по одной транзакции в TwiDriver,
+ * ждёт её завершения (флаг из обработчика I2C1) и переходит к следующему шагу;
+ * пока идёт внутренний цикл записи EEPROM, адрес не подтверждается — шаг
+ * повторяется через 1 мс. Если EEPROM не отвечает при загрузке, значения берутся
+ * из KvStore во встроенной flash и сохраняются туда же (без KvStore — умолчания
+ * Controller, запись не ведётся).
+ */
+class Settings {
+public:
+    /**
+     * @brief Сохраняемые значения Controller
+     */
+    struct Values {
+        int16_t setpoint = 0;   ///< Десятые °C
+        int32_t kp = 0;         ///< ×PIDInt::SCALE
+        int32_t ki = 0;
+        int32_t kd = 0;
+
+        bool operator==(const Values &) const = default;
+    };
+
+    enum class State : uint8_t {
+        Loading,   ///< Чтение заголовков слотов и последней записи
+        Ready,     ///< Значения загружены (или EEPROM пуста), изменения сохраняются
+        Absent,    ///< EEPROM не ответила при загрузке, KvStore нет
+        Flash      ///< EEPROM не ответила при загрузке, значения — в KvStore
+    };
+
+    struct Stats {
+        uint32_t saves = 0;      ///< Записей сохранено
+        uint32_t failures = 0;   ///< Сохранений, брошенных после SETTINGS_EEPROM_RETRIES
+        uint32_t seq = 0;        ///< Номер последней записи (0 — записей нет)
+        uint16_t slot = 0;       ///< Её слот
+        bool restored = false;   ///< При загрузке значения взяты из EEPROM
+    };
+
+    /// Страница EEPROM; слот — каждая страница
+    static constexpr uint16_t Page = SETTINGS_EEPROM_PAGE;
+    static constexpr uint16_t Slots = SETTINGS_EEPROM_SIZE / Page;
+    /// Заголовок записи, читаемый при загрузке: версия, уставка, номер
+    static constexpr uint16_t HeaderSize = 8;
+
+    static_assert(Page >= 24 && (Page & (Page - 1)) == 0, "Settings: страница EEPROM — степень двойки от 24 байт");
+    static_assert(Slots >= 2, "Settings: EEPROM мала");
+
+    explicit Settings(Controller &ctrl, KvStore *kv = nullptr) : m_ctrl(ctrl), m_kv(kv) {}
+
+    /**
+     * @brief Начать загрузку (после init TwiDriver, до первого poll())
+     */
+    void begin();
+
+    /**
+     * @brief Следующий шаг загрузки или сохранения (основной цикл).
+     */
+    void poll();
+
+    /**
+     * @brief Сообщить срок отложенной записи или повтора (сон в режиме APP_TICKLESS).
+     */
+    void nextDeadline(WakeDeadline &d) const;
+
+    State state() const { return m_state; }
+
+    /// Нет несохранённых изменений и транзакций в работе
+    bool idle() const { return m_step == Step::Idle && m_pending == m_saved; }
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    /**
+     * @brief Шаг автомата; каждый — одна транзакция TwiDriver
+     */
+    enum class Step : uint8_t {
+        LoadHeader,    ///< Заголовок слота m_scan (шаг поиска)
+        LoadRecord,    ///< Слот кандидата m_candidate
+        WriteRecord,   ///< Запись в слот m_next
+        Idle,
+    };
+
+    /// Кандидат при загрузке: слот и номер записи (0 — ещё не прочитан)
+    struct Candidate {
+        uint32_t seq = 0;
+        uint16_t slot = 0;
+    };
+
+    Values snapshot() const;
+    void apply(const Values &v);
+    void submit();
+    void complete(bool ok, uint32_t now);
+    bool searchStep();
+    bool parseRecord(Values &v, uint32_t &seq) const;
+    void finishLoad();
+    void startSave();
+    void loadFlash();
+    void saveFlash();
+
+    static uint16_t slotAddress(uint16_t slot) { return slot * Page; }
+
+    static void onDone(bool ok);
+
+    Controller &m_ctrl;
+    KvStore *m_kv;
+    State m_state = State::Loading;
+    Step m_step = Step::Idle;
+    bool m_inFlight = false;
+    uint8_t m_attempts = 0;
+    uint16_t m_scan = 0;          ///< Слот, заголовок которого читается
+    uint16_t m_lo = 0;            ///< Поиск: последняя запись в [m_lo, m_hi)
+    uint16_t m_hi = 0;
+    uint32_t m_first = 0;         ///< Номер записи в слоте 0
+    uint8_t m_candidate = 0;
+    Candidate m_best[2];          ///< Последняя запись и слот перед ней
+    uint16_t m_next = 0;          ///< Слот сохраняемой записи
+    uint32_t m_retryAt = 0;       ///< Не раньше этого момента (мс) ставить транзакцию
+    bool m_retry = false;
+    Values m_saved;               ///< Значения последней записи в EEPROM
+    Values m_pending;             ///< Последний снимок Controller
+    Values m_writing;             ///< Значения записи в работе
+    uint32_t m_changedAt = 0;     ///< Когда снимок последний раз изменился (мс)
+    Stats m_stats;
+
+    /// Адрес ячейки (2 байта, старший первым) и данные транзакции
+    uint8_t m_buf[2 + Page] = {};
+
+    static volatile bool s_done;
+    static volatile bool s_ok;
+};
@@ -0,0 +1,40 @@
+#include "Telemetry.hpp"
+#include "RccDriver.hpp"
+
+using namespace RccDriver;
+
+void Telemetry::setPeriod(uint16_t periodMs) {
+    m_periodMs = periodMs;
+    m_deadline = GetMsTicks() + periodMs;
+}
+
+void Telemetry::poll() {
+    if (!m_periodMs) return;
+
+    const uint32_t now = GetMsTicks();
+    if (static_cast<int32_t>(now - m_deadline) < 0) return;
+
+    sample(now);
+    // Расписание без накопления сдвига; после долгой паузы — не догонять пропущенное
+    m_deadline += m_periodMs;
+    if (static_cast<int32_t>(now - m_deadline) >= 0) m_deadline = now + m_periodMs;
+}
+
+void Telemetry::sample(uint32_t now) {
+    const PIDInt::Terms &terms = m_ctrl.getPid().lastTerms();
+
+    Record r;
+    r.ms = now;
+    r.seq = m_seq++;
+    r.current = static_cast<int16_t>(m_ctrl.getCurrent());
+    r.setpoint = static_cast<int16_t>(m_ctrl.getSetpoint());
+    r.error = static_cast<int16_t>(terms.error);
+    r.p = terms.p;
+    r.i = terms.i;
+    r.d = terms.d;
+    r.output = static_cast<int16_t>(m_ctrl.getHeaterPower());
+    r.state = static_cast<uint8_t>(m_ctrl.getState());
+
+    ++m_stats.sampled;
+    if (!m_ring.push(r)) ++m_stats.dropped;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "Controller.hpp"
+#include "SpscRing.hpp"
+#include "WakeDeadline.hpp"
+
+/**
+ * @brief Телеметрия контура: снимки Controller/PID с заданным периодом в кольцо записей
+ *
+ * poll() по расписанию (период задаёт команда Subscribe протокола) снимает запись
+ * фиксированного размера — время, температура, уставка, слагаемые PID, выход,
+ * состояние — и кладёт её в кольцо. Снимок — это несколько копирований полей,
+ * без форматирования и без ожидания линии: отправкой из кольца занимается Protocol,
+ * когда в кольце передачи UsartDriver есть место. Если линия не успевает и кольцо
+ * полно, запись пропускается, но номер всё равно увеличивается — хост видит пропуск.
+ */
+class Telemetry {
+public:
+    /**
+     * @brief Запись телеметрии (в линию уходит полями little-endian, см. ProtoCommand::Telemetry)
+     */
+    struct Record {
+        uint32_t ms = 0;        ///< GetMsTicks() в момент снимка
+        uint16_t seq = 0;       ///< Номер записи (с пропущенными)
+        int16_t current = 0;    ///< Температура (десятые °C)
+        int16_t setpoint = 0;   ///< Уставка (десятые °C)
+        int16_t error = 0;      ///< Ошибка PID после мёртвой зоны
+        int32_t p = 0;          ///< Слагаемые последнего шага PID (единицы выхода)
+        int32_t i = 0;
+        int32_t d = 0;
+        int16_t output = 0;     ///< Мощность нагревателя 0..1000
+        uint8_t state = 0;      ///< Controller::State
+    };
+
+    struct Stats {
+        uint32_t sampled = 0;   ///< Снято записей
+        uint32_t dropped = 0;   ///< Пропущено: кольцо полно
+    };
+
+    explicit Telemetry(const Controller &ctrl) : m_ctrl(ctrl) {}
+
+    /**
+     * @brief Задать период снимков (мс); 0 — выключить. Первый снимок — через период.
+     */
+    void setPeriod(uint16_t periodMs);
+
+    uint16_t period() const { return m_periodMs; }
+
+    /**
+     * @brief Снять запись, если подошёл срок (основной цикл).
+     */
+    void poll();
+
+    /// Самая старая не отправленная запись; nullptr — кольцо пусто
+    const Record *front() const { return m_ring.front(); }
+
+    /// Убрать отправленную запись
+    void pop() {
+        Record r;
+        m_ring.pop(r);
+    }
+
+    /**
+     * @brief Сообщить срок следующего снимка (сон в режиме APP_TICKLESS).
+     */
+    void nextDeadline(WakeDeadline &d) const {
+        if (m_periodMs) d.at(m_deadline);
+    }
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    void sample(uint32_t now);
+
+    const Controller &m_ctrl;
+    SpscRing<Record, TELEMETRY_RING_SIZE> m_ring;
+    uint16_t m_periodMs = 0;
+    uint32_t m_deadline = 0;
+    uint16_t m_seq = 0;
+    Stats m_stats;
+};
@@ -0,0 +1,197 @@
+#include "TimerWheel.hpp"
+#include "RccDriver.hpp"
+
+namespace {
+    /** Номер первого установленного бита, начиная с позиции start (по кругу), или 32. */
+    uint8_t first_set_from(uint32_t bits, uint32_t start) {
+        if (!bits) return 32;
+        const uint32_t rotated = (bits >> start) | (bits << ((32 - start) & 31));
+        return static_cast<uint8_t>(__builtin_ctz(rotated));
+    }
+}
+
+TimerWheel::TimerWheel(EventQueue &queue) : m_queue(queue), m_now(RccDriver::GetMsTicks()) {
+    for (auto &head: m_heads) head = InvalidId;
+}
+
+TimerWheel::Id TimerWheel::create(const Event &evt) {
+    if (m_count >= Capacity) return InvalidId;
+
+    const Id id = m_count++;
+    m_timers[id].event = evt;
+    return id;
+}
+
+void TimerWheel::setEvent(Id id, const Event &evt) {
+    if (id >= m_count) return;
+    m_timers[id].event = evt;
+}
+
+void TimerWheel::arm(Id id, uint32_t delayMs, uint32_t periodMs) {
+    if (id >= m_count) return;
+
+    Timer &t = m_timers[id];
+    if (t.slot != NoSlot) unlink(id);
+    else ++m_armed;
+
+    // Срок считаем от g_msTicks: время колеса может отставать до следующего poll()
+    t.expires = RccDriver::GetMsTicks() + (delayMs ? delayMs : 1);
+    t.period = periodMs;
+    insert(id);
+}
+
+void TimerWheel::cancel(Id id) {
+    if (id >= m_count || m_timers[id].slot == NoSlot) return;
+
+    unlink(id);
+    --m_armed;
+}
+
+bool TimerWheel::armed(Id id) const {
+    return id < m_count && m_timers[id].slot != NoSlot;
+}
+
+void TimerWheel::poll() {
+    const uint32_t target = RccDriver::GetMsTicks();
+
+    if (!m_armed) {
+        m_now = target;
+        return;
+    }
+
+    while (m_now != target) step();
+}
+
+void TimerWheel::nextDeadline(WakeDeadline &d) const {
+    // Нижний уровень: слоты однозначно задают момент срабатывания
+    const uint8_t off = first_set_from(m_occupied[0], (m_now + 1) & SlotMask);
+    if (off < Slots) d.at(m_now + 1 + off);
+
+    // Верхние уровни: ближайший непустой слот после текущего
+    for (uint8_t level = 1; level < Levels; ++level) {
+        const uint8_t shift = level * SlotBits;
+        const uint32_t start = (slotIndex(m_now, level) + 1) & SlotMask;
+        const uint8_t n = first_set_from(m_occupied[level], start);
+        if (n == Slots) continue;
+
+        const uint32_t cascadeAt = ((m_now >> shift) + 1 + n) << shift;
+        d.at(earliestIn(static_cast<uint8_t>(level * Slots + ((start + n) & SlotMask)), cascadeAt, shift));
+    }
+}
+
+/** Положить запущенный таймер в слот по его сроку относительно m_now. */
+void TimerWheel::insert(Id id) {
+    Timer &t = m_timers[id];
+
+    // Срок m_now возможен только при каскаде: слот m_now ещё будет обработан в step()
+    if (static_cast<int32_t>(t.expires - m_now) < 0) t.expires = m_now;
+
+    const uint32_t e = t.expires;
+    uint8_t level;
+    uint32_t index;
+
+    if (e - m_now < Slots) {
+        level = 0;
+        index = slotIndex(e, 0);
+    } else if (blocksAhead(e, 1) < Slots) {
+        level = 1;
+        index = slotIndex(e, 1);
+    } else if (blocksAhead(e, 2) < Slots) {
+        level = 2;
+        index = slotIndex(e, 2);
+    } else {
+        // Дальше диапазона колеса: последний слот, при каскаде переложится снова
+        level = Levels - 1;
+        index = (slotIndex(m_now, level) + SlotMask) & SlotMask;
+    }
+
+    const uint8_t slot = static_cast<uint8_t>(level * Slots + index);
+    t.slot = slot;
+    t.prev = InvalidId;
+    t.next = m_heads[slot];
+    if (t.next != InvalidId) m_timers[t.next].prev = id;
+    m_heads[slot] = id;
+    m_occupied[level] |= 1U << index;
+}
+
+void TimerWheel::unlink(Id id) {
+    Timer &t = m_timers[id];
+    const uint8_t slot = t.slot;
+
+    if (t.prev != InvalidId) m_timers[t.prev].next = t.next;
+    else m_heads[slot] = t.next;
+    if (t.next != InvalidId) m_timers[t.next].prev = t.prev;
+
+    if (m_heads[slot] == InvalidId) m_occupied[slot / Slots] &= ~(1U << (slot % Slots));
+
+    t.slot = NoSlot;
+    t.next = t.prev = InvalidId;
+}
+
+/** Снять весь список слота; таймеры остаются связаны через next. */
+TimerWheel::Id TimerWheel::detach(uint8_t slot) {
+    const Id head = m_heads[slot];
+    m_heads[slot] = InvalidId;
+    m_occupied[slot / Slots] &= ~(1U << (slot % Slots));
+    return head;
+}
+
+void TimerWheel::cascade(uint8_t level) {
+    Id id = detach(static_cast<uint8_t>(level * Slots + slotIndex(m_now, level)));
+    while (id != InvalidId) {
+        const Id next = m_timers[id].next;
+        insert(id);
+        id = next;
+    }
+}
+
+/** Продвинуть время колеса на 1 мс: каскад верхних уровней и срабатывание слота. */
+void TimerWheel::step() {
+    ++m_now;
+
+    if (slotIndex(m_now, 0) == 0) {
+        if (slotIndex(m_now, 1) == 0) cascade(2);
+        cascade(1);
+    }
+
+    Id id = detach(static_cast<uint8_t>(slotIndex(m_now, 0)));
+    while (id != InvalidId) {
+        Timer &t = m_timers[id];
+        const Id next = t.next;
+
+        m_queue.push(t.event);
+
+        if (t.period) {
+            t.expires += t.period;
+            // Колесо отстало больше чем на период — не выдаём пачку пропущенных срабатываний
+            if (static_cast<int32_t>(t.expires - m_now) <= 0) t.expires = m_now + 1;
+            insert(id);
+        } else {
+            t.slot = NoSlot;
+            t.next = t.prev = InvalidId;
+            --m_armed;
+        }
+        id = next;
+    }
+}
+
+/** Сколько блоков уровня level (по модулю переполнения счётчика) от блока m_now до блока time. */
+uint32_t TimerWheel::blocksAhead(uint32_t time, uint8_t level) const {
+    const uint8_t shift = level * SlotBits;
+    return (time - ((m_now >> shift) << shift)) >> shift;
+}
+
+/**
+ * Самый ранний срок в слоте верхнего уровня. Таймер за пределами колеса
+ * (отложенный в последний слот) учитывается моментом каскада слота.
+ */
+uint32_t TimerWheel::earliestIn(uint8_t slot, uint32_t cascadeAt, uint8_t shift) const {
+    uint32_t earliest = cascadeAt + (1U << shift);
+
+    for (Id id = m_heads[slot]; id != InvalidId; id = m_timers[id].next) {
+        uint32_t e = m_timers[id].expires;
+        if (e - cascadeAt >= (1U << shift)) e = cascadeAt;
+        if (static_cast<int32_t>(e - earliest) < 0) earliest = e;
+    }
+    return earliest;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "Event.hpp"
+#include "WakeDeadline.hpp"
+
+/**
+ * @brief Иерархическое колесо программных таймеров с разрешением 1 мс.
+ *
+ * Три уровня по 32 слота: 1 мс, 32 мс и 1024 мс на слот. Таймер кладётся
+ * в слот того уровня, в диапазон которого попадает его срок, и по мере
+ * хода времени перекладывается (каскадируется) на уровень ниже. Дедлайны
+ * дальше ~32 с ставятся в последний слот верхнего уровня и перекладываются повторно.
+ *
+ * Таймеры берутся из статического пула (create() при инициализации модулей),
+ * в слоте они связаны двусвязным списком по индексам, поэтому arm()/cancel() — O(1)
+ * и без выделения памяти. При срабатывании связанное с таймером Event
+ * кладётся в EventQueue.
+ *
+ * Время колеса догоняет RccDriver::g_msTicks (его ведёт SysTick_Handler) в poll():
+ * одно чтение счётчика за проход app_loop. Обработка идёт в основном цикле,
+ * потому что EventQueue не рассчитана на запись из прерывания.
+ */
+class TimerWheel {
+public:
+    using Id = uint8_t;
+
+    static constexpr Id InvalidId = 0xFF;
+
+    explicit TimerWheel(EventQueue &queue);
+
+    /**
+     * @brief Взять таймер из пула.
+     * @param evt Событие, которое таймер положит в очередь при срабатывании.
+     * @return InvalidId, если пул (TIMER_WHEEL_CAPACITY) исчерпан.
+     */
+    Id create(const Event &evt);
+
+    /**
+     * @brief Заменить событие таймера (например, перед повторным arm()).
+     */
+    void setEvent(Id id, const Event &evt);
+
+    /**
+     * @brief Запустить или перезапустить таймер.
+     * @param delayMs  Через сколько мс сработать (0 трактуется как 1).
+     * @param periodMs Период повтора (0 — однократный).
+     */
+    void arm(Id id, uint32_t delayMs, uint32_t periodMs = 0);
+
+    /**
+     * @brief Остановить таймер; событие уже лежащее в очереди не отзывается.
+     */
+    void cancel(Id id);
+
+    bool armed(Id id) const;
+
+    /**
+     * @brief Довести время колеса до GetMsTicks() и выдать события сработавших таймеров.
+     */
+    void poll();
+
+    /**
+     * @brief Сообщить ближайший срок срабатывания (сон в режиме APP_TICKLESS).
+     */
+    void nextDeadline(WakeDeadline &d) const;
+
+private:
+    static constexpr uint8_t SlotBits = 5;
+    static constexpr uint8_t Slots = 1U << SlotBits;
+    static constexpr uint32_t SlotMask = Slots - 1;
+    static constexpr uint8_t Levels = 3;
+    static constexpr uint8_t Capacity = TIMER_WHEEL_CAPACITY;
+    static constexpr uint8_t NoSlot = 0xFF;
+
+    static_assert(Capacity < InvalidId, "TimerWheel: Id должен помещаться в uint8_t");
+
+    /**
+     * @brief Таймер пула.
+     */
+    struct Timer {
+        uint32_t expires = 0;     ///< Момент срабатывания (мс, шкала g_msTicks).
+        uint32_t period = 0;      ///< Период повтора (мс), 0 — однократный.
+        Event event{};            ///< Что положить в очередь при срабатывании.
+        Id next = InvalidId;      ///< Следующий таймер в слоте.
+        Id prev = InvalidId;      ///< Предыдущий таймер в слоте.
+        uint8_t slot = NoSlot;    ///< level * Slots + index, NoSlot — не запущен.
+    };
+
+    static uint32_t slotIndex(uint32_t time, uint8_t level) {
+        return (time >> (level * SlotBits)) & SlotMask;
+    }
+
+    void insert(Id id);
+    void unlink(Id id);
+    Id detach(uint8_t slot);
+    void cascade(uint8_t level);
+    void step();
+    uint32_t blocksAhead(uint32_t time, uint8_t level) const;
+    uint32_t earliestIn(uint8_t slot, uint32_t cascadeAt, uint8_t shift) const;
+
+    EventQueue &m_queue;
+    uint32_t m_now;                         ///< Время колеса (мс), догоняет g_msTicks.
+    Timer m_timers[Capacity];
+    uint8_t m_count = 0;                    ///< Сколько таймеров выдано из пула.
+    uint8_t m_armed = 0;                    ///< Сколько таймеров запущено.
+    Id m_heads[Levels * Slots];             ///< Начало списка каждого слота.
+    uint32_t m_occupied[Levels] = {};       ///< Битовая карта непустых слотов по уровням.
+};
@@ -1,41 +1,57 @@
 #include "services_init.hpp"
 #include "AppContext.hpp"
 #include "fw_info.hpp"
+#include "Log.hpp"
 
-void print_fw_info(UsartDriver<> *uart) {
-    if (!uart) return;
+void print_fw_info() {
     // Проверим magic
-    if (fw_info.magic != 0xDEADBEEF) {
-        uart->write_str("FW info not valid\r\n");
+    if (fw_info.magic != FW_INFO_MAGIC) {
+        LOG("FW info not valid");
         return;
     }
 
-    uart->write_str("=== Firmware Info ===\r\n");
-
-    // Выводим тег без snprintf
-    uart->write_str("Tag: ");
-    uart->write_str(fw_info.tag);
-    uart->write_str("\r\n");
-
-    // Выводим коммит без snprintf
-    uart->write_str("Commit: ");
-    uart->write_str(fw_info.commit);
-    uart->write_str("\r\n");
-
-    uart->write_str("=====================\r\n");
+    // Тег и коммит копируются в запись журнала (длинный тег обрезается)
+    LOG("Firmware %s, commit %s", fw_info.tag, fw_info.commit);
 }
 
 void services_init(App &app) {
     // EventQueue already initialized in hardware_init
 
-    static BeepManager beep(app.piezo);
+    static BeepManager beep(app.piezo, *app.timers);
     app.beep = &beep;
 
-    static Controller ctrl(app.display, app.beep, app.heater);
+    // Мигание и бегущая строка индикатора (кадры по событию DisplayFrame)
+    static DisplayAnimator animator(app.display, *app.timers);
+    app.animator = &animator;
+
+    static Controller ctrl(app.display, app.animator, app.beep, app.heater, *app.timers);
     app.ctrl = &ctrl;
 
-    print_fw_info(app.uart);
+    // Снимки контура по подписке (период задаёт команда Subscribe)
+    static Telemetry telemetry(ctrl);
+    app.telemetry = &telemetry;
+
+    // Команды и телеметрия по USART1 (кадры COBS + CRC-16, клавиши '1'..'4' вне кадров)
+    static Protocol proto(*app.uart, ctrl, telemetry, *app.queue, *app.timers);
+    app.proto = &proto;
+
+    // Ключ-значение в двух последних страницах flash перед fw_info
+    static KvStore kv;
+    app.kv = &kv;
+    kv.begin();
+
+    // Уставка и PID из EEPROM (загрузка асинхронная, без EEPROM — из KvStore)
+    static Settings settings(ctrl, &kv);
+    app.settings = &settings;
+    settings.begin();
+
+    // Периодический Tick100ms (PID, индикация)
+    app.timers->arm(app.timers->create({EventType::Tick100ms, 0}), APP_TICK_PERIOD_MS, APP_TICK_PERIOD_MS);
+
+    print_fw_info();
+#if defined LOG_TEXT
     app.uart->flush();  // Wait for all TX data to be sent before continuing
-    
-    app.uart->write_str("System ready.\r\n");
+#endif
+
+    LOG("System ready.");
 }
@@ -4,7 +4,6 @@ struct App;
 
 /**
  *   Инициализация сервисного уровня:
- *   - EventQueue
  *   - BeepManager
  *   - Controller
  *   - логирование (print_fw_info)
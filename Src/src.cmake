@@ -10,12 +10,26 @@ set(EXCLUDE_FILES
         # ${CMAKE_CURRENT_LIST_DIR}/Legacy/chlib_stub.c
 )
 
+# В хост-сборке main() и системные вызовы newlib предоставляет Host/
+if (HOST_BUILD)
+    list(APPEND EXCLUDE_FILES
+            ${CMAKE_CURRENT_LIST_DIR}/main.cpp
+            ${CMAKE_CURRENT_LIST_DIR}/core/syscalls.c
+            ${CMAKE_CURRENT_LIST_DIR}/core/sysmem.c
+    )
+endif ()
+
+# Цель, в которую добавляются исходники (Host/ подставляет свою)
+if (NOT SRC_TARGET)
+    set(SRC_TARGET ${CMAKE_PROJECT_NAME})
+endif ()
+
 foreach (file ${EXCLUDE_FILES})
     list(REMOVE_ITEM SOURCES ${file})
 endforeach ()
 
 # Добавляем найденные исходники в target_sources
-target_sources(${CMAKE_PROJECT_NAME} PRIVATE ${SOURCES})
+target_sources(${SRC_TARGET} PRIVATE ${SOURCES})
 
 # Рекурсивно ищем все директории в Src
 file(GLOB_RECURSE ALL_ITEMS LIST_DIRECTORIES true ${CMAKE_SOURCE_DIR}/Src/*)
@@ -28,4 +42,4 @@ foreach (item ${ALL_ITEMS})
 endforeach ()
 
 # Добавляем в target_include_directories
-target_include_directories(${CMAKE_PROJECT_NAME} PUBLIC ${INCLUDE_DIRS})
\ No newline at end of file
+target_include_directories(${SRC_TARGET} PUBLIC ${INCLUDE_DIRS})
\ No newline at end of file
@@ -4,16 +4,17 @@
 #include "RccDriver.hpp"
 #include "GpioDriver.hpp"
 #include "Event.hpp"
+#include "WakeDeadline.hpp"
 
 /**
- * @brief Кнопка с программным антидребезгом и детектором удержания.
+ * @brief Кнопка с программным антидребезгом.
+ *
+ * События удержания генерирует ButtonsManager таймером TimerWheel.
  *
  * @tparam DebounceMs   Время (мс), в течение которого состояние должно оставаться
  *                      неизменным, чтобы считаться устойчивым.
- * @tparam HoldMs       Период (мс) генерации событий удержания.
  */
-template<uint16_t DebounceMs = 30,
-         uint16_t HoldMs = 100>
+template<uint16_t DebounceMs = 30>
 class Button : public GpioDriver {
 public:
     Button(GPIO_TypeDef *port, uint8_t pin) : GpioDriver(port, pin) {
@@ -21,7 +22,7 @@ public:
     }
 
     enum class Event {
-        None, Pressed, Released, Held
+        None, Pressed, Released
     };
 
     Event tick() {
@@ -35,31 +36,27 @@ public:
 
         Event e = Event::None;
 
-        if (m_rawState != m_stableState) {
-            if (hasElapsed(now, m_lastChange, DebounceMs)) {
-                m_stableState = m_rawState;
-                if (m_stableState) {
-                    m_holdDeadline = now + HoldMs;
-                    e = Event::Pressed;
-                } else {
-                    m_holdDeadline = 0;
-                    e = Event::Released;
-                }
-            }
-        } else if (m_stableState && HoldMs > 0 && m_holdDeadline != 0 &&
-                   timeReached(now, m_holdDeadline)) {
-            m_holdDeadline = now + HoldMs;
-            e = Event::Held;
+        if (m_rawState != m_stableState && hasElapsed(now, m_lastChange, DebounceMs)) {
+            m_stableState = m_rawState;
+            e = m_stableState ? Event::Pressed : Event::Released;
         }
 
         return e;
     }
 
-private:
-    static bool timeReached(uint32_t now, uint32_t deadline) {
-        return static_cast<int32_t>(now - deadline) >= 0;
+    /**
+     * @brief Ближайший момент, когда tick() может выдать событие
+     * @note Устойчивая кнопка дедлайна не имеет — её разбудит EXTI
+     */
+    void nextDeadline(WakeDeadline &d) const {
+        if (!Read() != m_rawState) {
+            d.at(RccDriver::GetMsTicks());   // Фронт ещё не замечен tick()
+        } else if (m_rawState != m_stableState) {
+            d.at(m_lastChange + DebounceMs);
+        }
     }
 
+private:
     static bool hasElapsed(uint32_t now, uint32_t since, uint32_t duration) {
         return static_cast<uint32_t>(now - since) >= duration;
     }
@@ -67,5 +64,4 @@ private:
     bool m_rawState = false;
     bool m_stableState = false;
     uint32_t m_lastChange = 0;
-    uint32_t m_holdDeadline = 0;
 };
\ No newline at end of file
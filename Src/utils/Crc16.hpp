@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief CRC-16/CCITT-FALSE: полином 0x1021, начальное значение 0xFFFF, без отражения и финального XOR
+ *
+ * Таблица на полбайта (16 слов, 32 байта flash): два обращения к таблице на байт,
+ * без делений и без таблицы на 512 байт. CRC, дописанная к данным старшим байтом
+ * вперёд, даёт остаток 0 — приёмник проверяет кадр на лету, не зная заранее,
+ * где кончаются данные.
+ */
+namespace Crc16 {
+    static constexpr uint16_t Init = 0xFFFF;
+    static constexpr uint16_t Poly = 0x1021;
+
+    inline constexpr std::array<uint16_t, 16> NibbleTable = [] {
+        std::array<uint16_t, 16> table{};
+        for (uint16_t n = 0; n < 16; ++n) {
+            uint16_t crc = static_cast<uint16_t>(n << 12);
+            for (uint8_t bit = 0; bit < 4; ++bit) {
+                crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ Poly : crc << 1);
+            }
+            table[n] = crc;
+        }
+        return table;
+    }();
+
+    /// Добавить байт к CRC
+    constexpr uint16_t update(uint16_t crc, uint8_t byte) {
+        crc = static_cast<uint16_t>((crc << 4) ^ NibbleTable[(crc >> 12) ^ (byte >> 4)]);
+        crc = static_cast<uint16_t>((crc << 4) ^ NibbleTable[(crc >> 12) ^ (byte & 0x0F)]);
+        return crc;
+    }
+
+    /// CRC блока (crc — для продолжения подсчёта по частям)
+    constexpr uint16_t compute(const uint8_t *data, size_t len, uint16_t crc = Init) {
+        for (size_t i = 0; i < len; ++i) crc = update(crc, data[i]);
+        return crc;
+    }
+
+    // Контрольное значение CRC-16/CCITT-FALSE для "123456789"
+    inline constexpr uint8_t CheckInput[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    static_assert(compute(CheckInput, sizeof(CheckInput)) == 0x29B1, "Crc16: неверная таблица");
+}
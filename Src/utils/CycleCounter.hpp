@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "stm32f0xx.h"
+#include "RccDriver.hpp"
+#include "PowerDriver.hpp"
+
+/**
+ * @brief Счётчик тактов ядра для замеров длительности
+ *
+ * У Cortex-M0 нет DWT->CYCCNT, поэтому метка строится из SysTick:
+ * g_msTicks даёт число полных периодов, а SysTick->VAL (счёт вниз от LOAD
+ * на частоте ядра) — такты внутри текущей миллисекунды. Разрешение — 1 такт,
+ * переполнение 32-битной метки — примерно через 89 с на 48 МГц, поэтому
+ * разности меток корректны для интервалов короче этого.
+ *
+ * В режиме APP_TICKLESS PowerDriver меняет LOAD: после раннего пробуждения
+ * период короче 1 мс. Любой период заканчивается на границе миллисекунды,
+ * поэтому такты внутри неё — CyclesPerMs - 1 - VAL (по LOAD метка сбивалась бы).
+ * Растянутый на время сна период идёт, пока прерывания запрещены, и метка
+ * в нём не берётся.
+ *
+ * В хост-сборке (HOST_BUILD) метку даёт host_cycle_stamp():
+ * выполненные инструкции (perf) или TSC.
+ */
+namespace CycleCounter {
+    inline uint32_t now() {
+#if defined HOST_BUILD
+        return host_cycle_stamp();
+#else
+        uint32_t ms, val;
+        // Повторяем, если между чтениями SysTick_Handler увеличил g_msTicks
+        do {
+            ms = RccDriver::g_msTicks;
+            val = SysTick->VAL;
+        } while (ms != RccDriver::g_msTicks);
+
+        constexpr uint32_t Period = PowerDriver::CyclesPerMs;
+        return ms * Period + (Period - 1 - val);
+#endif
+    }
+}
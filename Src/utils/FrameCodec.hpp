@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Crc16.hpp"
+
+/**
+ * @brief Кадры COBS с CRC-16: 0x00, COBS(данные + CRC старшим байтом вперёд), 0x00
+ *
+ * COBS убирает нули из кадра, поэтому 0x00 однозначно отделяет кадры: после
+ * обрыва или мусора в линии приёмник ловит начало следующего кадра с первого же нуля.
+ * Ведущий 0x00 отделяет кадр от текста, который идёт по той же линии вне кадров.
+ */
+namespace FrameCodec {
+    /// Байт-разделитель кадров
+    static constexpr uint8_t Delimiter = 0x00;
+
+    /// Размер CRC в конце кадра
+    static constexpr size_t CrcSize = 2;
+
+    /// Наибольшая длина кадра в линии для len байт данных (с CRC, COBS и двумя разделителями)
+    constexpr size_t encodedSize(size_t len) {
+        return 2 + (len + CrcSize) + (len + CrcSize) / 254 + 1;
+    }
+
+    /**
+     * @brief Закодировать кадр
+     * @param data Данные кадра (без CRC)
+     * @param len  Длина данных
+     * @param[out] out Буфер кадра, не меньше encodedSize(len)
+     * @param cap  Размер out
+     * @return Длина кадра в out или 0, если не помещается
+     */
+    inline size_t encode(const uint8_t *data, size_t len, uint8_t *out, size_t cap) {
+        if (cap < encodedSize(len)) return 0;
+
+        const uint16_t crc = Crc16::compute(data, len);
+        const uint8_t tail[CrcSize] = {static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)};
+
+        size_t pos = 0;
+        out[pos++] = Delimiter;
+        size_t codeAt = pos++;   // Место под код текущего блока
+        uint8_t code = 1;
+
+        for (size_t i = 0; i < len + CrcSize; ++i) {
+            const uint8_t byte = i < len ? data[i] : tail[i - len];
+            if (byte == 0) {
+                out[codeAt] = code;
+                codeAt = pos++;
+                code = 1;
+                continue;
+            }
+            out[pos++] = byte;
+            if (++code == 0xFF) {
+                out[codeAt] = code;
+                codeAt = pos++;
+                code = 1;
+            }
+        }
+        out[codeAt] = code;
+        out[pos++] = Delimiter;
+        return pos;
+    }
+
+    /**
+     * @brief Потоковый разбор кадров: по байту за вызов, постоянная работа на байт
+     *
+     * Каждый байт декодируется и сразу добавляется к CRC, так что к концу кадра
+     * проверка уже готова и кадр не просматривается повторно. Данные
+     * копятся в собственном буфере, без выделения памяти.
+     *
+     * @tparam MaxLen Наибольшая длина кадра после декодирования, включая CRC
+     */
+    template<size_t MaxLen>
+    class Decoder {
+    public:
+        static_assert(MaxLen > CrcSize, "FrameCodec: кадр должен вмещать CRC");
+
+        enum class Result : uint8_t {
+            None,   ///< Кадр ещё не закончен (или пустой кадр между двумя разделителями)
+            Frame,  ///< Принят целый кадр: data()/size() действительны до следующего feed()
+            Error,  ///< Кадр закончился, но испорчен: CRC, COBS или длина
+        };
+
+        /// Начать кадр заново (например, после ведущего разделителя)
+        void reset() {
+            m_len = 0;
+            m_left = 0;
+            m_zero = false;
+            m_overflow = false;
+            m_crc = Crc16::Init;
+        }
+
+        Result feed(uint8_t byte) {
+            if (byte == Delimiter) {
+                const bool empty = m_len == 0 && m_left == 0 && !m_zero;
+                const bool ok = !m_overflow && m_left == 0 && m_len > CrcSize && m_crc == 0;
+                m_size = ok ? m_len - CrcSize : 0;
+                reset();
+                if (empty) return Result::None;
+                return ok ? Result::Frame : Result::Error;
+            }
+
+            if (m_left == 0) {
+                // Код блока: за ним code - 1 байт данных, затем (если code < 0xFF) ноль
+                if (m_zero) put(0);
+                m_left = static_cast<uint8_t>(byte - 1);
+                m_zero = byte != 0xFF;
+            } else {
+                put(byte);
+                --m_left;
+            }
+            return Result::None;
+        }
+
+        const uint8_t *data() const { return m_buf; }
+
+        size_t size() const { return m_size; }
+
+    private:
+        void put(uint8_t byte) {
+            if (m_len < MaxLen) m_buf[m_len++] = byte;
+            else m_overflow = true;
+            m_crc = Crc16::update(m_crc, byte);
+        }
+
+        uint8_t m_buf[MaxLen]{};
+        size_t m_len = 0;           ///< Декодировано байт в текущем кадре
+        size_t m_size = 0;          ///< Длина данных последнего принятого кадра
+        uint16_t m_crc = Crc16::Init;
+        uint8_t m_left = 0;         ///< Сколько байт данных осталось в текущем блоке COBS
+        bool m_zero = false;        ///< После блока идёт неявный ноль
+        bool m_overflow = false;    ///< Кадр длиннее MaxLen
+    };
+}
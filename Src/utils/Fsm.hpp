@@ -0,0 +1,294 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Пустое событие для автоматов, которым нужен только сигнал (guard/action без аргументов)
+ */
+struct FsmNoEvent {};
+
+/// Сигнатуры guard/action: с событием или без него (FsmNoEvent)
+template<typename Owner, typename State, typename Event>
+struct FsmCallbacks {
+    using Guard = bool (Owner::*)(const Event &) const;
+    using Action = State (Owner::*)(const Event &);
+};
+
+template<typename Owner, typename State>
+struct FsmCallbacks<Owner, State, FsmNoEvent> {
+    using Guard = bool (Owner::*)() const;
+    using Action = void (Owner::*)();
+};
+
+/**
+ * @brief Табличный конечный автомат: строки «сигнал, состояние, guard, action, цель»
+ *
+ * Соглашения для перечислений: последний элемент State и Signal — Any, он же
+ * wildcard в таблице и число значений. Строки просматриваются сверху вниз,
+ * срабатывает первая подходящая, поэтому строки с wildcard должны стоять ниже
+ * более конкретных. Цель Compute — новое состояние возвращает action
+ * (только для автоматов с событием). fallthrough — после перехода сразу
+ * обработать тот же сигнал в новом состоянии (переход без ожидания).
+ *
+ * Table<Rows, Initial> при компиляции проверяет таблицу (перекрытые строки,
+ * недостижимые строки, состояния без строк) и строит таблицу обработчиков
+ * [состояние][сигнал]: в каждом остаются только подходящие строки в исходном
+ * порядке, guard/action вызываются напрямую. Поиск перехода — O(1) по индексу.
+ *
+ * @tparam Owner  Класс, которому принадлежат guard/action
+ * @tparam State  enum class состояний, последний элемент — Any
+ * @tparam Signal enum class сигналов, последний элемент — Any
+ * @tparam Event  Что передаётся в guard/action (FsmNoEvent — ничего)
+ */
+template<typename Owner, typename State, typename Signal, typename Event = FsmNoEvent>
+class Fsm {
+public:
+    template<typename E>
+    static constexpr size_t index(E value) {
+        return static_cast<size_t>(value);
+    }
+
+    using Guard = typename FsmCallbacks<Owner, State, Event>::Guard;
+    using Action = typename FsmCallbacks<Owner, State, Event>::Action;
+
+    static constexpr bool HasEvent = !std::is_same_v<Event, FsmNoEvent>;
+    static constexpr size_t States = static_cast<size_t>(State::Any);
+    static constexpr size_t Signals = static_cast<size_t>(Signal::Any);
+
+    /// Цель «вычислить через action»
+    static constexpr State Compute = static_cast<State>(std::numeric_limits<std::underlying_type_t<State>>::max());
+
+    static_assert(States > 0 && Signals > 0, "Fsm: перечисления должны заканчиваться элементом Any");
+    static_assert(static_cast<size_t>(Compute) > States, "Fsm: значение Compute занято состоянием");
+
+    /**
+     * @brief Строка таблицы переходов
+     */
+    struct Row {
+        Signal signal;              ///< Сигнал или Signal::Any
+        State source;               ///< Исходное состояние или State::Any
+        Guard guard;                ///< Условие (nullptr — без условий)
+        Action action;              ///< Действие (nullptr — без действия)
+        State target;               ///< Новое состояние или Compute
+        bool fallthrough = false;   ///< Сразу обработать тот же сигнал в новом состоянии
+    };
+
+    //=========================================================================
+    // Проверки таблицы (constexpr): номер первой ошибочной строки/состояния или -1
+    //=========================================================================
+
+    /// Строка, до которой не дойдёт поиск: выше есть строка без guard (или с тем же guard), покрывающая её
+    template<size_t N>
+    static constexpr int shadowedRow(const Row (&rows)[N]) {
+        for (size_t j = 0; j < N; ++j) {
+            for (size_t i = 0; i < j; ++i) {
+                const bool signal = rows[i].signal == Signal::Any || rows[i].signal == rows[j].signal;
+                const bool source = rows[i].source == State::Any || rows[i].source == rows[j].source;
+                const bool guard = rows[i].guard == nullptr || rows[i].guard == rows[j].guard;
+                if (signal && source && guard) return static_cast<int>(j);
+            }
+        }
+        return -1;
+    }
+
+    /// Строка с исходным состоянием, в которое автомат не попадает из initial
+    template<size_t N>
+    static constexpr int unreachableRow(const Row (&rows)[N], State initial) {
+        bool reached[States] = {};
+        reached[index(initial)] = true;
+
+        for (bool grew = true; grew;) {
+            grew = false;
+            for (const Row &r: rows) {
+                if (r.source != State::Any && !reached[index(r.source)]) continue;
+                for (size_t s = 0; s < States; ++s) {
+                    const bool target = r.target == Compute || index(r.target) == s;
+                    if (target && !reached[s]) reached[s] = grew = true;
+                }
+            }
+        }
+
+        for (size_t j = 0; j < N; ++j) {
+            if (rows[j].source != State::Any && !reached[index(rows[j].source)]) return static_cast<int>(j);
+        }
+        return -1;
+    }
+
+    /// Состояние, из которого нет ни одной строки (включая строки с State::Any)
+    template<size_t N>
+    static constexpr int missingState(const Row (&rows)[N]) {
+        for (size_t s = 0; s < States; ++s) {
+            bool covered = false;
+            for (const Row &r: rows) covered = covered || r.source == State::Any || index(r.source) == s;
+            if (!covered) return static_cast<int>(s);
+        }
+        return -1;
+    }
+
+    /// Строка с недопустимой целью: wildcard, значение вне перечисления или Compute без события/action
+    template<size_t N>
+    static constexpr int invalidTarget(const Row (&rows)[N]) {
+        for (size_t j = 0; j < N; ++j) {
+            const Row &r = rows[j];
+            if (r.target == Compute) {
+                if (!HasEvent || r.action == nullptr) return static_cast<int>(j);
+            } else if (index(r.target) >= States) {
+                return static_cast<int>(j);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Таблица Rows, проверенная и развёрнутая по [состояние][сигнал] при компиляции
+     * @tparam Rows    constexpr-массив Row (статический член владельца)
+     * @tparam Initial Начальное состояние (для проверки достижимости)
+     */
+    template<const auto &Rows, State Initial>
+    class Table {
+        static constexpr size_t N = std::size(Rows);
+
+        static_assert(invalidTarget(Rows) < 0, "Fsm: цель строки — Any, вне перечисления или Compute без action/события");
+        static_assert(shadowedRow(Rows) < 0, "Fsm: строка перекрыта вышестоящей (wildcard/без guard) и никогда не сработает");
+        static_assert(unreachableRow(Rows, Initial) < 0, "Fsm: исходное состояние строки недостижимо из начального");
+        static_assert(missingState(Rows) < 0, "Fsm: для состояния нет ни одной строки");
+
+        /// Результат обработчика: не сработал, сработал, сработал с fallthrough
+        enum Outcome : uint8_t { None, Fired, Fallthrough };
+
+        using Handler = Outcome (*)(Owner &, const Event &, State &);
+
+        static constexpr bool matches(const Row &r, size_t state, size_t signal) {
+            return (r.source == State::Any || index(r.source) == state) &&
+                   (r.signal == Signal::Any || index(r.signal) == signal);
+        }
+
+        static constexpr size_t countRows(size_t state, size_t signal) {
+            size_t count = 0;
+            for (const Row &r: Rows) {
+                if (matches(r, state, signal)) ++count;
+            }
+            return count;
+        }
+
+        /// Номера строк для состояния S и сигнала G в исходном порядке
+        template<size_t S, size_t G>
+        static constexpr auto rowsFor = [] {
+            std::array<size_t, countRows(S, G)> rows{};
+            size_t k = 0;
+            for (size_t i = 0; i < N; ++i) {
+                if (matches(Rows[i], S, G)) rows[k++] = i;
+            }
+            return rows;
+        }();
+
+        /// Одна строка: guard, action, цель (общая для всех пар, в которые строка входит)
+        template<size_t R>
+        static bool tryRow(Owner &owner, const Event &e, State &next, Outcome &outcome) {
+            constexpr Row r = Rows[R];
+
+            if constexpr (r.guard != nullptr) {
+                if constexpr (HasEvent) {
+                    if (!(owner.*r.guard)(e)) return false;
+                } else {
+                    if (!(owner.*r.guard)()) return false;
+                }
+            }
+
+            if constexpr (r.target == Compute) {
+                next = (owner.*r.action)(e);
+            } else {
+                next = r.target;
+                if constexpr (r.action != nullptr) {
+                    if constexpr (HasEvent) (owner.*r.action)(e);
+                    else (owner.*r.action)();
+                }
+            }
+
+            outcome = r.fallthrough ? Fallthrough : Fired;
+            return true;
+        }
+
+        /// Строки для состояния S и сигнала G по порядку, до первой сработавшей
+        template<size_t S, size_t G>
+        static Outcome handle(Owner &owner, const Event &e, State &next) {
+            Outcome outcome = None;
+            [&]<size_t... K>(std::index_sequence<K...>) {
+                (tryRow<rowsFor<S, G>[K]>(owner, e, next, outcome) || ...);
+            }(std::make_index_sequence<countRows(S, G)>{});
+            return outcome;
+        }
+
+        template<size_t I>
+        static constexpr Handler handlerFor() {
+            if constexpr (countRows(I / Signals, I % Signals) > 0) return &handle<I / Signals, I % Signals>;
+            else return nullptr;
+        }
+
+        /// Обработчик на каждую пару [состояние][сигнал]; nullptr — строк нет
+        static constexpr std::array<Handler, States * Signals> handlers =
+                []<size_t... I>(std::index_sequence<I...>) {
+                    return std::array<Handler, States * Signals>{handlerFor<I>()...};
+                }(std::make_index_sequence<States * Signals>{});
+
+    public:
+        /**
+         * @brief Обработать сигнал в состоянии state
+         * @param[out] next Новое состояние (после цепочки fallthrough), если переход найден
+         * @return false — подходящей строки нет, состояние не меняется
+         */
+        static bool dispatch(Owner &owner, State state, Signal signal, const Event &e, State &next) {
+            const size_t g = index(signal);
+            if (g >= Signals) return false;
+
+            bool fired = false;
+            // fallthrough не может пройти больше States переходов без зацикливания
+            for (size_t hop = 0; hop <= States; ++hop) {
+                const size_t s = index(state);
+                if (s >= States) break;
+
+                const Handler handler = handlers[s * Signals + g];
+                if (!handler) break;
+
+                const Outcome outcome = handler(owner, e, next);
+                if (outcome == None) break;
+
+                fired = true;
+                if (outcome != Fallthrough) break;
+                state = next;
+            }
+            return fired;
+        }
+
+        static bool dispatch(Owner &owner, State state, Signal signal, State &next) requires (!HasEvent) {
+            return dispatch(owner, state, signal, FsmNoEvent{}, next);
+        }
+
+        /**
+         * @brief Прежний перебор всей таблицы сверху вниз (для сравнения стоимости)
+         * @note fallthrough не поддерживается
+         */
+        static bool dispatchLinear(Owner &owner, State state, Signal signal, const Event &e, State &next)
+                requires HasEvent {
+            for (const Row &r: Rows) {
+                if (r.signal != signal && r.signal != Signal::Any) continue;
+                if (r.source != state && r.source != State::Any) continue;
+                if (r.guard && !(owner.*r.guard)(e)) continue;
+
+                if (r.target == Compute) {
+                    next = (owner.*r.action)(e);
+                } else {
+                    next = r.target;
+                    if (r.action) (owner.*r.action)(e);
+                }
+                return true;
+            }
+            return false;
+        }
+    };
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file IntFormat.hpp
+ * @brief Целые и фиксированная точка «x.y» в ASCII без деления
+ *
+ * У Cortex-M0 нет аппаратного деления: каждое `/ 10` и `% 10` — вызов
+ * __aeabi_uidiv(mod) из libgcc (цикл сдвигов и вычитаний). Здесь частное
+ * на 10 считается сдвигами и сложениями (Hacker's Delight, divu10) с одной
+ * поправкой по остатку, так что цифра стоит порядка десятка инструкций.
+ *
+ * Общий модуль для UsartDriver::write_int, HT1621B::ShowInt и
+ * Controller::displayTemperature; замеры — Host/bench/intfmt_bench.cpp.
+ */
+namespace IntFormat {
+    /// Буфер под любое int32_t со знаком и завершающим нулём
+    static constexpr size_t IntBufSize = 12;
+
+    /**
+     * @brief Частное и остаток от деления на 10 без деления
+     */
+    constexpr uint32_t div10(uint32_t n, uint32_t &rem) {
+        // q ≈ n * 0.8 / 8 = n / 10 снизу, ошибка не больше единицы
+        uint32_t q = (n >> 1) + (n >> 2);
+        q += q >> 4;
+        q += q >> 8;
+        q += q >> 16;
+        q >>= 3;
+        uint32_t r = n - ((q << 3) + (q << 1));
+        if (r > 9) {
+            ++q;
+            r -= 10;
+        }
+        rem = r;
+        return q;
+    }
+
+    namespace detail {
+        constexpr bool div10Matches(uint32_t n) {
+            uint32_t r = 0;
+            const uint32_t q = div10(n, r);
+            return q == n / 10 && r == n % 10;
+        }
+    }
+    static_assert(detail::div10Matches(9) && detail::div10Matches(10) && detail::div10Matches(99) &&
+                  detail::div10Matches(0x7FFF'FFFF) && detail::div10Matches(0xFFFF'FFFF),
+                  "IntFormat::div10");
+
+    /**
+     * @brief Десятичная запись без знака
+     * @return Число символов (без завершающего нуля)
+     */
+    inline size_t formatUnsigned(uint32_t value, char *out) {
+        char tmp[10];
+        size_t n = 0;
+        do {
+            uint32_t digit;
+            value = div10(value, digit);
+            tmp[n++] = static_cast<char>('0' + digit);
+        } while (value);
+
+        for (size_t i = 0; i < n; ++i) out[i] = tmp[n - 1 - i];
+        out[n] = '\0';
+        return n;
+    }
+
+    /**
+     * @brief Десятичная запись со знаком (INT32_MIN тоже)
+     * @return Число символов (без завершающего нуля)
+     */
+    inline size_t formatInt(int32_t value, char *out) {
+        if (value >= 0) return formatUnsigned(static_cast<uint32_t>(value), out);
+        *out = '-';
+        return 1 + formatUnsigned(0U - static_cast<uint32_t>(value), out + 1);
+    }
+
+    /**
+     * @brief Фиксированная точка с одним знаком после запятой: 455 → "45.5", -5 → "-0.5"
+     * @param tenths Значение в десятых долях
+     * @return Число символов (без завершающего нуля)
+     */
+    inline size_t formatFixed1(int32_t tenths, char *out) {
+        size_t n = 0;
+        uint32_t magnitude = static_cast<uint32_t>(tenths);
+        if (tenths < 0) {
+            out[n++] = '-';
+            magnitude = 0U - magnitude;
+        }
+        uint32_t frac;
+        const uint32_t whole = div10(magnitude, frac);
+        n += formatUnsigned(whole, out + n);
+        out[n++] = '.';
+        out[n++] = static_cast<char>('0' + frac);
+        out[n] = '\0';
+        return n;
+    }
+}
@@ -2,8 +2,6 @@
 
 #include <cstdint>
 
-// #define PRINT_PID
-
 /**
  * @brief Фиксированная-точность (integer-only) PID-регулятор.
  *
@@ -21,6 +19,17 @@
  */
 class PIDInt {
 public:
+    /**
+     * @brief Слагаемые последнего шага update() (для телеметрии), в единицах выхода.
+     */
+    struct Terms {
+        int32_t error = 0;  ///< Ошибка после мёртвой зоны (десятые °C)
+        int32_t p = 0;      ///< Kp * error / SCALE
+        int32_t i = 0;      ///< Ki * integral / SCALE
+        int32_t d = 0;      ///< Kd * derivative / SCALE
+        int32_t out = 0;    ///< Выход после ограничения
+    };
+
     /**
      * @brief Масштаб фиксированной точки.
      *
@@ -67,6 +76,7 @@ public:
      */
     void reset() {
         m_integral = 0;
+        m_integralRem = 0;
         m_prevError = 0;
         m_hasPrev = false;
     }
@@ -103,9 +113,11 @@ public:
             error = 0;
         }
 
-        // Интегральная часть
+        // Интегральная часть; остаток деления переносится на следующий шаг, иначе при dt
+        // меньше номинального малая ошибка (error * dt < baseDt) не накапливается совсем
         auto baseDt = static_cast<int32_t>(m_sampleTimeMs ? m_sampleTimeMs : 1U);
-        int64_t integralIncrement = (int64_t) error * (int64_t) dt_ms;
+        int64_t integralIncrement = (int64_t) error * (int64_t) dt_ms + m_integralRem;
+        m_integralRem = static_cast<int32_t>(integralIncrement % baseDt);
         integralIncrement /= baseDt;
         m_integral += static_cast<int32_t>(integralIncrement);
         clamp(m_integral, m_integrMin, m_integrMax);
@@ -120,7 +132,7 @@ public:
         }
         m_prevError = error;
 
-        // P, I, D термы отдельно (чтобы можно было печатать)
+        // P, I, D термы отдельно (сохраняются для телеметрии)
         int64_t p_term = (int64_t) m_kp * error;
         int64_t i_term = (int64_t) m_ki * m_integral;
         int64_t d_term = (int64_t) m_kd * derivative;
@@ -134,31 +146,19 @@ public:
         // Ограничиваем диапазон
         clamp(out, (int64_t) m_outMin, (int64_t) m_outMax);
 
-#if defined PRINT_PID
-        uart_write_str("err=");
-        uart_write_int(error);
-
-        uart_write_str(" P=");
-        uart_write_int((int32_t) (p_term / SCALE));
-
-        uart_write_str(" I=");
-        uart_write_int((int32_t) (i_term / SCALE));
-
-        uart_write_str(" D=");
-        uart_write_int((int32_t) (d_term / SCALE));
-
-        uart_write_str(" raw=");
-        uart_write_int((int32_t) (sum / SCALE));
-
-        uart_write_str(" out=");
-        uart_write_int((int32_t) out);
-
-        uart_write_str("\r\n");
-#endif
+        // Только сохранить: телеметрия заберёт их по своему расписанию, без вывода отсюда
+        m_terms.error = error;
+        m_terms.p = static_cast<int32_t>(p_term / SCALE);
+        m_terms.i = static_cast<int32_t>(i_term / SCALE);
+        m_terms.d = static_cast<int32_t>(d_term / SCALE);
+        m_terms.out = static_cast<int32_t>(out);
 
         return static_cast<int32_t>(out);
     }
 
+    /// Слагаемые последнего шага
+    const Terms &lastTerms() const { return m_terms; }
+
     void setSampleTimeMs(uint32_t sampleTimeMs) {
         if (sampleTimeMs == 0) sampleTimeMs = 1;
         m_sampleTimeMs = sampleTimeMs;
@@ -169,6 +169,20 @@ public:
         m_deadband = deadband_x10;
     }
 
+    /**
+     * @brief Заменить коэффициенты (×SCALE) и сбросить накопленное состояние.
+     */
+    void setGains(int32_t kp, int32_t ki, int32_t kd) {
+        m_kp = kp;
+        m_ki = ki;
+        m_kd = kd;
+        reset();
+    }
+
+    int32_t kp() const { return m_kp; }
+    int32_t ki() const { return m_ki; }
+    int32_t kd() const { return m_kd; }
+
 private:
     // Коэффициенты PID в формате fixed-point
     int32_t m_kp;    ///< Пропорциональная часть (×SCALE)
@@ -183,10 +197,12 @@ private:
 
     // Внутренние переменные
     int32_t m_integral = 0;     ///< Интегральная сумма ошибки
+    int32_t m_integralRem = 0;  ///< Остаток error * dt, не вошедший в m_integral (мс × десятые)
     int32_t m_prevError = 0;    ///< Ошибка прошлого шага
     bool m_hasPrev = false;  ///< Признак наличия предыдущей ошибки
     uint32_t m_sampleTimeMs;    ///< Номинальный интервал дискретизации (мс)
     int32_t m_deadband;         ///< Мёртвая зона по ошибке (в десятых градуса)
+    Terms m_terms;              ///< Слагаемые последнего шага
 
     /**
      * @brief Универсальная функция ограничения значения.
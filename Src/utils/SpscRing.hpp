@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Кольцевой буфер «один писатель — один читатель» без запрета прерываний
+ *
+ * Писатель (обработчик прерывания или основной цикл) меняет только m_head,
+ * читатель (основной цикл) — только m_tail. Индексы свободно бегущие,
+ * заполнение — их разность, поэтому N должно быть степенью двойки.
+ *
+ * Нужны лишь атомарные load/store 32-битного слова: на ARMv6-M это обычные
+ * LDR/STR, порядок относительно данных слота задают acquire/release (DMB).
+ * Ни LDREX/STREX (их нет у Cortex-M0), ни __disable_irq() не требуются.
+ *
+ * @tparam T Тип элемента (копируется целиком)
+ * @tparam N Ёмкость, степень двойки
+ */
+template<typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing: N должно быть степенью двойки");
+    static_assert(N <= 0x8000'0000UL, "SpscRing: N не помещается в разность индексов");
+
+public:
+    static constexpr size_t Capacity = N;
+
+    /**
+     * @brief Положить элемент (только писатель)
+     * @return false, если буфер полон
+     */
+    bool push(const T &item) {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= N) return false;
+
+        m_items[head & Mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Забрать самый старый элемент (только читатель)
+     * @return false, если буфер пуст
+     */
+    bool pop(T &item) {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == tail) return false;
+
+        item = m_items[tail & Mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Самый старый элемент без извлечения (только читатель); nullptr, если пусто
+    const T *front() const {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == tail) return nullptr;
+        return &m_items[tail & Mask];
+    }
+
+    /// Заполнение на момент вызова; у писателя и читателя может только устареть в безопасную сторону
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static constexpr uint32_t Mask = N - 1;
+
+    T m_items[N]{};
+    std::atomic<uint32_t> m_head{0};   ///< Сколько элементов положено (пишет только писатель)
+    std::atomic<uint32_t> m_tail{0};   ///< Сколько элементов забрано (пишет только читатель)
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Ближайший момент (мс, шкала g_msTicks), когда ядру нужно проснуться
+ *
+ * Каждый сервис вызывает at() со своим ближайшим дедлайном; в итоге value()
+ * хранит самый ранний. Сравнение — через разность со знаком, поэтому
+ * переполнение счётчика миллисекунд не мешает.
+ */
+class WakeDeadline {
+public:
+    /// @param limit Самый поздний допустимый момент пробуждения
+    explicit WakeDeadline(uint32_t limit) : m_at(limit) {}
+
+    void at(uint32_t deadline) {
+        if (static_cast<int32_t>(deadline - m_at) < 0) m_at = deadline;
+    }
+
+    uint32_t value() const { return m_at; }
+
+    /// Дедлайн уже наступил — спать нельзя
+    bool reached(uint32_t now) const {
+        return static_cast<int32_t>(now - m_at) >= 0;
+    }
+
+private:
+    uint32_t m_at;
+};
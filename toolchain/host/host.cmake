@@ -0,0 +1,17 @@
+# Хост-сборка (x86-64 Linux): прошивка + программные модели периферии из Host/
+# Используется пресетом Host, либо: cmake -S . -B build/Host -DCMAKE_TOOLCHAIN_FILE=toolchain/host/host.cmake
+
+set(CMAKE_C_COMPILER                gcc)
+set(CMAKE_CXX_COMPILER              g++)
+set(CMAKE_ASM_COMPILER              ${CMAKE_C_COMPILER})
+
+set(HOST_BUILD ON CACHE BOOL "Сборка прошивки под хост с моделями периферии" FORCE)
+
+set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -Wextra -fdata-sections -ffunction-sections")
+if(NOT CMAKE_BUILD_TYPE OR CMAKE_BUILD_TYPE MATCHES Debug)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -O0 -g3")
+else()
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -O2 -g")
+endif()
+
+set(CMAKE_CXX_FLAGS "${CMAKE_C_FLAGS} -fno-rtti -fno-exceptions -fno-threadsafe-statics")